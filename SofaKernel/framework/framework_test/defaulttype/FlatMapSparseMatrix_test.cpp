@@ -0,0 +1,127 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2016 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU General Public License as published by the Free  *
+* Software Foundation; either version 2 of the License, or (at your option)   *
+* any later version.                                                          *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for    *
+* more details.                                                               *
+*                                                                             *
+* You should have received a copy of the GNU General Public License along     *
+* with this program; if not, write to the Free Software Foundation, Inc., 51  *
+* Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA.                   *
+*******************************************************************************
+*                            SOFA :: Applications                             *
+*                                                                             *
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+
+#include <sofa/defaulttype/FlatMapSparseMatrix.h>
+#include <sofa/defaulttype/Vec.h>
+#include <gtest/gtest.h>
+
+using sofa::defaulttype::FlatMapSparseMatrix;
+using sofa::defaulttype::MapMapSparseMatrix;
+using sofa::defaulttype::Vec3d;
+
+namespace
+{
+
+/// Writes the same rows in both matrices, out of order and extending rows already written
+template<class Matrix>
+void fillMatrix(Matrix& m)
+{
+    for (unsigned int r = 0; r < 20; ++r)
+    {
+        typename Matrix::RowIterator rowIt = m.writeLine(2*r);
+        for (unsigned int c = 0; c < 4; ++c)
+            rowIt.addCol((7*r + 3*c) % 11, Vec3d(r, c, 1));
+    }
+    for (unsigned int r = 0; r < 20; r += 3)
+    {
+        typename Matrix::RowIterator rowIt = m.writeLine(2*r);
+        rowIt.addCol(100 + r, Vec3d(1, 1, 1));
+        rowIt.addCol((7*r) % 11, Vec3d(1, 0, 0));
+    }
+    m.writeLine(7).setCol(3, Vec3d(2, 2, 2));
+    m.newLine().addCol(1, Vec3d(5, 5, 5));
+    m.writeLine(4).row().erase(3);
+    m.writeLine(6).row()[42] = Vec3d(9, 9, 9);
+    m.addLine(2, m.readLine(6).row());
+}
+
+/// @return the entries of the matrix, sorted by row and column
+template<class Matrix>
+std::map< std::pair<unsigned int, unsigned int>, Vec3d > entries(const Matrix& m)
+{
+    std::map< std::pair<unsigned int, unsigned int>, Vec3d > e;
+    for (typename Matrix::RowConstIterator rowIt = m.begin(), rowItEnd = m.end(); rowIt != rowItEnd; ++rowIt)
+    {
+        for (typename Matrix::ColConstIterator colIt = rowIt.begin(), colItEnd = rowIt.end(); colIt != colItEnd; ++colIt)
+            e[std::make_pair(rowIt.index(), colIt.index())] = colIt.val();
+    }
+    return e;
+}
+
+}
+
+TEST(FlatMapSparseMatrixTest, sameEntriesAsMapMap)
+{
+    MapMapSparseMatrix<Vec3d> reference;
+    FlatMapSparseMatrix<Vec3d> m;
+    fillMatrix(reference);
+    fillMatrix(m);
+
+    EXPECT_EQ(reference.size(), m.size());
+    EXPECT_EQ(entries(reference), entries(m));
+
+    // rows are iterated in increasing order
+    const FlatMapSparseMatrix<Vec3d>& cm = m;
+    unsigned int previous = 0;
+    for (FlatMapSparseMatrix<Vec3d>::RowConstIterator rowIt = cm.begin(); rowIt != cm.end(); ++rowIt)
+    {
+        EXPECT_LE(previous, rowIt.index());
+        previous = rowIt.index();
+    }
+}
+
+TEST(FlatMapSparseMatrixTest, readLine)
+{
+    FlatMapSparseMatrix<Vec3d> m;
+    fillMatrix(m);
+    const FlatMapSparseMatrix<Vec3d>& cm = m;
+
+    EXPECT_TRUE(cm.readLine(5) == cm.end());
+    ASSERT_TRUE(cm.readLine(6) != cm.end());
+    EXPECT_EQ(6u, cm.readLine(6).index());
+    EXPECT_EQ(1u, cm.readLine(7).row().size());
+    EXPECT_EQ(1u, cm.readLine(39).row().count(1));
+}
+
+TEST(FlatMapSparseMatrixTest, copyAndClear)
+{
+    FlatMapSparseMatrix<Vec3d> m;
+    fillMatrix(m);
+
+    FlatMapSparseMatrix<Vec3d> copy(m);
+    const std::map< std::pair<unsigned int, unsigned int>, Vec3d > e = entries(m);
+    m.clear();
+    EXPECT_TRUE(m.empty());
+    EXPECT_EQ(e, entries(copy));
+
+    // the cleared matrix is filled again in the memory it kept
+    fillMatrix(m);
+    EXPECT_EQ(e, entries(m));
+
+    FlatMapSparseMatrix<Vec3d> assigned;
+    assigned = copy;
+    copy.clear();
+    EXPECT_EQ(e, entries(assigned));
+}
@@ -0,0 +1,126 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2016 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU General Public License as published by the Free  *
+* Software Foundation; either version 2 of the License, or (at your option)   *
+* any later version.                                                          *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for    *
+* more details.                                                               *
+*                                                                             *
+* You should have received a copy of the GNU General Public License along     *
+* with this program; if not, write to the Free Software Foundation, Inc., 51  *
+* Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA.                   *
+*******************************************************************************
+*                            SOFA :: Applications                             *
+*                                                                             *
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+
+#include <sofa/helper/LCPcalc.h>
+
+#include <gtest/gtest.h>
+
+using sofa::helper::LCPBlockMatrix33;
+
+/** The Gauss-Seidel solvers of LCPcalc give the same forces with a dense W and
+  with the same W stored as 3x3 blocks.
+  */
+struct LCPcalc_test : public ::testing::Test
+{
+    enum { NbObjects = 5, NbContactsPerObject = 6, NbContacts = NbObjects*NbContactsPerObject, N = 3*NbContacts };
+
+    std::vector<double> dfree;
+    std::vector<double> denseValues;
+    std::vector<double*> W;
+
+    std::vector<int> rowIndex, rowBegin, colsIndex;
+    std::vector<double> blocks;
+
+    LCPcalc_test()
+        : dfree(N), denseValues(N*N, 0.0), W(N)
+    {
+        for (int i=0; i<N; ++i)
+            W[i] = &denseValues[i*N];
+
+        // contacts of the objects are interleaved, contacts of different objects are not coupled
+        for (int i=0; i<N; ++i)
+        {
+            const int ci = i/3;
+            dfree[i] = (i%3) ? 0.01*(i%7) - 0.03 : ((ci%4==0) ? 0.2 : -0.5 - 0.01*i);
+            for (int j=0; j<N; ++j)
+            {
+                const int cj = j/3;
+                if (ci%NbObjects != cj%NbObjects) continue;
+                if (i == j) W[i][j] = 2.0 + 0.01*i;
+                else if (i%3 == j%3) W[i][j] = 0.3;
+                else if (ci == cj) W[i][j] = 0.05;
+            }
+        }
+
+        for (int bi=0; bi<NbContacts; ++bi)
+        {
+            rowIndex.push_back(bi);
+            rowBegin.push_back((int)colsIndex.size());
+            for (int bj=0; bj<NbContacts; ++bj)
+            {
+                if (bi%NbObjects != bj%NbObjects) continue;
+                colsIndex.push_back(bj);
+                for (int l=0; l<3; ++l)
+                    for (int c=0; c<3; ++c)
+                        blocks.push_back(W[3*bi+l][3*bj+c]);
+            }
+        }
+        rowBegin.push_back((int)colsIndex.size());
+    }
+
+    LCPBlockMatrix33 blockW() const
+    {
+        return LCPBlockMatrix33(NbContacts, &rowIndex[0], &rowBegin[0], &colsIndex[0], &blocks[0]);
+    }
+};
+
+TEST_F(LCPcalc_test, nlcpGaussSeidel)
+{
+    std::vector<double> fDense(N, 0.0), fSparse(N, 0.0);
+    std::vector<double> residualsDense, residualsSparse;
+
+    EXPECT_EQ(1, sofa::helper::nlcp_gaussseidel(N, &dfree[0], &W[0], &fDense[0], 0.6, 1e-10, 1000, false, false, 0.0, 0.0, &residualsDense));
+    EXPECT_EQ(1, sofa::helper::nlcp_gaussseidel(N, &dfree[0], blockW(), &fSparse[0], 0.6, 1e-10, 1000, false, false, 0.0, 0.0, &residualsSparse));
+
+    EXPECT_EQ(residualsDense.size(), residualsSparse.size());
+    for (int i=0; i<N; ++i)
+        EXPECT_NEAR(fDense[i], fSparse[i], 1e-12);
+}
+
+TEST_F(LCPcalc_test, nlcpGaussSeidelTimed)
+{
+    std::vector<double> fDense(N, 0.0), fSparse(N, 0.0);
+
+    EXPECT_EQ(1, sofa::helper::nlcp_gaussseidelTimed(N, &dfree[0], &W[0], &fDense[0], 0.6, 1e-10, 1000, false, 10.0));
+    EXPECT_EQ(1, sofa::helper::nlcp_gaussseidelTimed(N, &dfree[0], blockW(), &fSparse[0], 0.6, 1e-10, 1000, false, 10.0));
+
+    for (int i=0; i<N; ++i)
+        EXPECT_NEAR(fDense[i], fSparse[i], 1e-12);
+}
+
+TEST_F(LCPcalc_test, gaussSeidelLCP1)
+{
+    // the dense version stores the forces after the displacements
+    std::vector<double> resDense(2*N, 0.0), fSparse(N, 0.0);
+    std::vector<double> residualsDense, residualsSparse;
+
+    sofa::helper::gaussSeidelLCP1(N, &dfree[0], &W[0], &resDense[0], 1e-10, 1000, 0.0, 0.0, &residualsDense);
+    sofa::helper::gaussSeidelLCP1(N, &dfree[0], blockW(), &fSparse[0], 1e-10, 1000, 0.0, 0.0, &residualsSparse);
+
+    EXPECT_EQ(residualsDense.size(), residualsSparse.size());
+    EXPECT_LT(residualsSparse.back(), 1e-10);
+    for (int i=0; i<N; ++i)
+        EXPECT_NEAR(resDense[i], fSparse[i], 1e-12);
+}
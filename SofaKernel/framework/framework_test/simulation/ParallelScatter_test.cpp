@@ -0,0 +1,99 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2016 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This library is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This library is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this library; if not, write to the Free Software Foundation,     *
+* Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA.          *
+*******************************************************************************
+*                               SOFA :: Tests                                 *
+*                                                                             *
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+
+#include <sofa/simulation/ParallelScatter.h>
+#include <gtest/gtest.h>
+
+using sofa::simulation::TaskScheduler;
+using sofa::helper::vector;
+
+namespace
+{
+
+const std::size_t NbNodes = 97;
+
+/// Element e adds to two nodes
+struct AddElementFunctor
+{
+    void operator()(vector<double>& f, unsigned int e) const
+    {
+        f[e % NbNodes] += 1.0 / (1.0 + e);
+        f[(7*e) % NbNodes] += 0.5 / (3.0 + e);
+    }
+};
+
+vector<double> scatter(unsigned int nbThreads, std::size_t nbElements, bool deterministic, vector< vector<double> >& buffers)
+{
+    if (nbThreads)
+        TaskScheduler::getInstance().start(nbThreads);
+    vector<double> f(NbNodes, 1.0);
+    sofa::simulation::parallelScatterBuffered(f, nbElements, buffers, deterministic, AddElementFunctor());
+    if (nbThreads)
+        TaskScheduler::getInstance().stop();
+    return f;
+}
+
+}
+
+TEST(ParallelScatterTest, deterministicBlocks)
+{
+    // not a whole number of blocks
+    const std::size_t nbElements = 5*sofa::simulation::DeterministicScatterBlockSize + 10;
+
+    vector< vector<double> > buffers;
+    const vector<double> f0 = scatter(0, nbElements, false, buffers);
+    EXPECT_TRUE(buffers.empty());
+
+    const vector<double> f1 = scatter(1, nbElements, true, buffers);
+    EXPECT_EQ(6u, buffers.size());
+    for (std::size_t i=0; i<NbNodes; ++i)
+        EXPECT_NEAR(f0[i], f1[i], 1e-12);
+
+    const unsigned int threadCounts[] = { 2, 3, 8 };
+    for (unsigned int t=0; t<3; ++t)
+    {
+        const vector<double> f = scatter(threadCounts[t], nbElements, true, buffers);
+        for (std::size_t i=0; i<NbNodes; ++i)
+            EXPECT_EQ(f1[i], f[i]) << threadCounts[t] << " threads";
+
+        const vector<double> fThreads = scatter(threadCounts[t], nbElements, false, buffers);
+        EXPECT_LE(buffers.size(), threadCounts[t]);
+        for (std::size_t i=0; i<NbNodes; ++i)
+            EXPECT_NEAR(f0[i], fThreads[i], 1e-12) << threadCounts[t] << " threads";
+    }
+}
+
+TEST(ParallelScatterTest, singleBlock)
+{
+    // a single block is added directly to the result
+    const std::size_t nbElements = sofa::simulation::DeterministicScatterBlockSize;
+
+    vector< vector<double> > buffers;
+    const vector<double> f0 = scatter(0, nbElements, false, buffers);
+    const vector<double> f = scatter(4, nbElements, true, buffers);
+    EXPECT_TRUE(buffers.empty());
+    for (std::size_t i=0; i<NbNodes; ++i)
+        EXPECT_EQ(f0[i], f[i]);
+}
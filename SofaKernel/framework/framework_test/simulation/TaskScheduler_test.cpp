@@ -0,0 +1,207 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2016 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This library is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This library is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this library; if not, write to the Free Software Foundation,     *
+* Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA.          *
+*******************************************************************************
+*                               SOFA :: Tests                                 *
+*                                                                             *
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+
+#include <sofa/simulation/TaskScheduler.h>
+#include <sofa/simulation/ParallelFor.h>
+#include <sofa/simulation/WorkStealingQueue.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <vector>
+
+using sofa::simulation::Task;
+using sofa::simulation::TaskScheduler;
+using sofa::simulation::WorkerThread;
+using sofa::simulation::WorkStealingQueue;
+
+namespace
+{
+
+class CountTask : public Task
+{
+public:
+    CountTask(Task::Status* status, std::atomic<int>* counter)
+        : Task(status), m_counter(counter) {}
+
+    virtual bool run(WorkerThread*)
+    {
+        m_counter->fetch_add(1);
+        return true;
+    }
+
+    std::atomic<int>* m_counter;
+};
+
+class ReadCountTask : public Task
+{
+public:
+    ReadCountTask(Task::Status* status, std::atomic<int>* counter)
+        : Task(status), m_counter(counter), m_seen(-1) {}
+
+    virtual bool run(WorkerThread*)
+    {
+        m_seen = m_counter->load();
+        return true;
+    }
+
+    std::atomic<int>* m_counter;
+    int m_seen;
+};
+
+struct FillFunctor
+{
+    std::vector<double>& values;
+    FillFunctor(std::vector<double>& v) : values(v) {}
+    void operator()(std::size_t first, std::size_t last) const
+    {
+        for (std::size_t i=first; i<last; ++i)
+            values[i] = 1.0 / (1.0 + (double)i);
+    }
+};
+
+struct SumFunctor
+{
+    const std::vector<double>& values;
+    SumFunctor(const std::vector<double>& v) : values(v) {}
+    double operator()(std::size_t first, std::size_t last) const
+    {
+        double sum = 0;
+        for (std::size_t i=first; i<last; ++i)
+            sum += values[i];
+        return sum;
+    }
+};
+
+struct Add
+{
+    double operator()(double a, double b) const { return a + b; }
+};
+
+}
+
+TEST(WorkStealingQueueTest, pushPopSteal)
+{
+    WorkStealingQueue<int> queue(2);
+    int values[10];
+    for (int i=0; i<10; ++i)
+        queue.push(&values[i]);
+    EXPECT_EQ(queue.size(), 10u);
+    EXPECT_GE(queue.capacity(), 10u);
+
+    // owner pops the newest, thieves steal the oldest
+    EXPECT_EQ(queue.pop(), &values[9]);
+    EXPECT_EQ(queue.steal(), &values[0]);
+    EXPECT_EQ(queue.size(), 8u);
+
+    for (int i=0; i<8; ++i)
+        EXPECT_NE(queue.pop(), (int*)NULL);
+    EXPECT_EQ(queue.pop(), (int*)NULL);
+    EXPECT_EQ(queue.steal(), (int*)NULL);
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(TaskSchedulerTest, moreThreadsThanTheOldLimit)
+{
+    TaskScheduler& scheduler = TaskScheduler::getInstance();
+    ASSERT_TRUE(scheduler.start(20));
+    EXPECT_EQ(scheduler.getThreadCount(), 20u);
+    EXPECT_TRUE(WorkerThread::getCurrent() != NULL);
+
+    // far more tasks than the former 256 slots per thread
+    std::atomic<int> counter(0);
+    Task::Status status;
+    std::vector<CountTask*> tasks;
+    for (int i=0; i<2000; ++i)
+    {
+        tasks.push_back(new CountTask(&status, &counter));
+        WorkerThread::getCurrent()->addTask(tasks.back());
+    }
+    WorkerThread::getCurrent()->workUntilDone(&status);
+    EXPECT_EQ(counter.load(), 2000);
+
+    for (std::size_t i=0; i<tasks.size(); ++i)
+        delete tasks[i];
+    scheduler.stop();
+    EXPECT_EQ(scheduler.getThreadCount(), 0u);
+}
+
+TEST(TaskSchedulerTest, continuation)
+{
+    TaskScheduler& scheduler = TaskScheduler::getInstance();
+    scheduler.start(4);
+
+    std::atomic<int> counter(0);
+    Task::Status status, continuationStatus;
+    ReadCountTask join(&continuationStatus, &counter);
+    std::vector<CountTask*> tasks;
+    for (int i=0; i<100; ++i)
+    {
+        tasks.push_back(new CountTask(&status, &counter));
+        tasks.back()->setContinuation(&join);
+    }
+    EXPECT_TRUE(continuationStatus.IsBusy());
+
+    for (std::size_t i=0; i<tasks.size(); ++i)
+        WorkerThread::getCurrent()->addTask(tasks[i]);
+    WorkerThread::getCurrent()->workUntilDone(&continuationStatus);
+    WorkerThread::getCurrent()->workUntilDone(&status);
+
+    // the continuation ran after all its predecessors
+    EXPECT_EQ(join.m_seen, 100);
+
+    for (std::size_t i=0; i<tasks.size(); ++i)
+        delete tasks[i];
+    scheduler.stop();
+}
+
+TEST(TaskSchedulerTest, parallelForAndReduce)
+{
+    std::vector<double> values(100003);
+    double reference = 0;
+
+    const unsigned int threadCounts[] = { 1, 2, 3, 8 };
+    for (unsigned int t=0; t<4; ++t)
+    {
+        TaskScheduler::getInstance().start(threadCounts[t]);
+
+        std::fill(values.begin(), values.end(), 0.0);
+        sofa::simulation::parallelFor(0, values.size(), FillFunctor(values));
+        for (std::size_t i=0; i<values.size(); i+=1000)
+            ASSERT_EQ(values[i], 1.0 / (1.0 + (double)i));
+
+        // a fixed grain size gives the same rounding whatever the thread count
+        const double sum = sofa::simulation::parallelReduce(0, values.size(), 0.0, SumFunctor(values), Add(), 1000);
+        if (t == 0)
+            reference = sum;
+        EXPECT_EQ(sum, reference);
+
+        TaskScheduler::getInstance().stop();
+    }
+
+    // serial fallback when the scheduler is not running
+    std::fill(values.begin(), values.end(), 0.0);
+    sofa::simulation::parallelFor(0, values.size(), FillFunctor(values));
+    EXPECT_EQ(values.back(), 1.0 / (double)values.size());
+}
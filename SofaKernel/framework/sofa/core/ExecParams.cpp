@@ -73,6 +73,18 @@ bool ExecParams::checkValidStorage() const
     return false;
 }
 
+ExecParams::ThreadStorageScope::ThreadStorageScope(const ExecParams* params)
+{
+    ExecParams* local = defaultInstance();
+    previous = local->storage;
+    local->storage = params->storage;
+}
+
+ExecParams::ThreadStorageScope::~ThreadStorageScope()
+{
+    defaultInstance()->storage = previous;
+}
+
 /// Make sure this instance is up-to-date relative to the current thread
 void ExecParams::update()
 {
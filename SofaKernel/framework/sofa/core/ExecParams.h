@@ -92,6 +92,18 @@ private:
 public:
     bool checkValidStorage() const;
 
+    /// Let the calling thread use the storage of the given params while this object is alive,
+    /// so that work done on behalf of another thread (such as a task spawned by a visitor)
+    /// can use the params of that thread.
+    class SOFA_CORE_API ThreadStorageScope
+    {
+    public:
+        ThreadStorageScope(const ExecParams* params);
+        ~ThreadStorageScope();
+    private:
+        ExecParamsThreadStorage* previous;
+    };
+
     /// Mode of execution requested
     ExecMode execMode() const
     {
@@ -132,6 +132,7 @@ public:
         int nbLines; ///< how many dofs (i.e. lines in the matrix) are used by each constraint
         int nbGroups; ///< how many groups of constraints are active
         bool hasId; ///< true if this constraint has persistent ID information
+        bool hasGlobalId; ///< true if the persistent IDs are unique among all the constraints (such as keys computed from colliding elements), not only within this constraint
         bool hasPosition; ///< true if this constraint has coordinates information
         bool hasDirection; ///< true if this constraint has direction information
         bool hasArea; ///< true if this constraint has area information
@@ -139,7 +140,7 @@ public:
         int offsetPosition; ///< index of first constraint group info in vector of coordinates
         int offsetDirection; ///< index of first constraint info in vector of directions
         int offsetArea; ///< index of first constraint group info in vector of areas
-        ConstraintBlockInfo() : parent(NULL), const0(0), nbLines(1), nbGroups(0), hasId(false), hasPosition(false), hasDirection(false), hasArea(false), offsetId(0), offsetPosition(0), offsetDirection(0), offsetArea(0)
+        ConstraintBlockInfo() : parent(NULL), const0(0), nbLines(1), nbGroups(0), hasId(false), hasGlobalId(false), hasPosition(false), hasDirection(false), hasArea(false), offsetId(0), offsetPosition(0), offsetDirection(0), offsetArea(0)
         {}
     };
     typedef helper::vector<ConstraintBlockInfo> VecConstraintBlockInfo;
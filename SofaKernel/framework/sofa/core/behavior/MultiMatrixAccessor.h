@@ -26,6 +26,7 @@
 #define SOFA_CORE_BEHAVIOR_MULTIMATRIXACCESSOR_H
 
 #include <sofa/defaulttype/BaseMatrix.h>
+#include <sofa/defaulttype/Mat.h>
 #include <sofa/core/behavior/BaseMechanicalState.h>
 #include <sofa/core/BaseMapping.h>
 
@@ -47,6 +48,22 @@ class SOFA_CORE_API MultiMatrixAccessor
 public:
     virtual ~MultiMatrixAccessor();
 
+    /// Add the block m to the values of matrix starting at row i, column j.
+    /// 3x3 blocks are added with a single call to BaseMatrix::addBlock33, the other ones value per value.
+    template<int L, int C, class real>
+    static void addBlock(defaulttype::BaseMatrix* matrix, unsigned int i, unsigned int j, const defaulttype::Mat<L,C,real>& m)
+    {
+        for (int bi=0; bi<L; ++bi)
+            for (int bj=0; bj<C; ++bj)
+                matrix->add(i+bi, j+bj, m[bi][bj]);
+    }
+
+    template<class real>
+    static void addBlock(defaulttype::BaseMatrix* matrix, unsigned int i, unsigned int j, const defaulttype::Mat<3,3,real>& m)
+    {
+        matrix->addBlock33(i, j, m);
+    }
+
     /// Simple structure holding a reference to the submatrix related to one MechanicalState
     class MatrixRef
     {
@@ -58,6 +75,9 @@ public:
         bool operator!() const { return matrix == NULL; }
         operator bool() const { return matrix != NULL; }
         void operator =(const MatrixRef& b) {offset = b.offset; matrix = b.matrix;}
+        /// Add the block m at row i, column j of the submatrix
+        template<class TBlock>
+        void addBlock(unsigned int i, unsigned int j, const TBlock& m) const { MultiMatrixAccessor::addBlock(matrix, offset+i, offset+j, m); }
     };
 
     /// Simple structure holding a reference to the submatrix related to the interactions between two MechanicalStates
@@ -71,6 +91,9 @@ public:
         bool operator!() const { return matrix == NULL; }
         operator bool() const { return matrix != NULL; }
         void operator =(const InteractionMatrixRef& b) {offRow = b.offRow; offCol = b.offCol; matrix = b.matrix;}
+        /// Add the block m at row i, column j of the submatrix
+        template<class TBlock>
+        void addBlock(unsigned int i, unsigned int j, const TBlock& m) const { MultiMatrixAccessor::addBlock(matrix, offRow+i, offCol+j, m); }
     };
 
     virtual void addMechanicalState(const BaseMechanicalState* mstate);
@@ -85,6 +85,11 @@ public:
     /// Control the keepAlive flag of the contact. Note that not all contacts support this method
     virtual void setKeepAlive(bool /* val */) {}
 
+    /// Detach the response of a contact which is no longer active but kept for a later reuse by the contact manager,
+    /// releasing its contact points while keeping its mapped states and interaction components.
+    /// By default, the response is only removed.
+    virtual void deactivate() { removeResponse(); }
+
     //Todo adding TPtr parameter
     class Factory : public helper::Factory< std::string, Contact, std::pair<std::pair<core::CollisionModel*,core::CollisionModel*>,Intersection*>, Contact::SPtr >
     {
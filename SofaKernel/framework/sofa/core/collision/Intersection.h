@@ -87,6 +87,18 @@ public:
     /// Compute the intersection between 2 elements. Return the number of contacts written in the contacts vector.
     virtual int intersect(core::CollisionElementIterator elem1, core::CollisionElementIterator elem2, DetectionOutputVector* contacts) = 0;
 
+    /// Compute the intersections between an element and the elements of model2 with the given indices, in this order.
+    /// Return the number of contacts written in the contacts vector.
+    /// The contacts are the same as the ones of successive calls to intersect, but intersectors can test the elements
+    /// together, for instance to first reject the distant ones with vectorized code.
+    virtual int intersectBatch(core::CollisionElementIterator elem1, core::CollisionModel* model2, const helper::vector<int>& indices2, DetectionOutputVector* contacts)
+    {
+        int n = 0;
+        for (unsigned int i=0; i<indices2.size(); i++)
+            n += intersect(elem1, core::CollisionElementIterator(model2, indices2[i]), contacts);
+        return n;
+    }
+
     /// End intersection tests between two collision models. Return the number of contacts written in the contacts vector.
     virtual int endIntersect(core::CollisionModel* model1, core::CollisionModel* model2, DetectionOutputVector* contacts) = 0;
 
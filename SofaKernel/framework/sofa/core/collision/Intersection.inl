@@ -37,6 +37,33 @@ namespace core
 namespace collision
 {
 
+/// Calls T::computeIntersections(elem1, model2, indices2, contacts) for the intersectors which test an element
+/// against several ones at once, and T::computeIntersection on each pair of elements otherwise.
+template<class Elem1, class Elem2, class T>
+struct BatchIntersection
+{
+    typedef typename Elem2::Model Model2;
+
+    template<class Impl, class OutputVector>
+    static auto call(Impl* impl, Elem1& e1, Model2* model2, const helper::vector<int>& indices2, OutputVector* contacts, int)
+        -> decltype(impl->computeIntersections(e1, model2, indices2, contacts))
+    {
+        return impl->computeIntersections(e1, model2, indices2, contacts);
+    }
+
+    template<class Impl, class OutputVector>
+    static int call(Impl* impl, Elem1& e1, Model2* model2, const helper::vector<int>& indices2, OutputVector* contacts, long)
+    {
+        int n = 0;
+        for (unsigned int i=0; i<indices2.size(); i++)
+        {
+            Elem2 e2(core::CollisionElementIterator(model2, indices2[i]));
+            n += impl->computeIntersection(e1, e2, contacts);
+        }
+        return n;
+    }
+};
+
 template<class Elem1, class Elem2, class T>
 class MemberElementIntersector : public ElementIntersector
 {
@@ -73,6 +100,14 @@ public:
         return impl->computeIntersection(e1, e2, impl->getOutputVector(e1.getCollisionModel(), e2.getCollisionModel(), contacts));
     }
 
+    /// Compute the intersections between an element and several elements of model2.
+    int intersectBatch(core::CollisionElementIterator elem1, core::CollisionModel* model2, const helper::vector<int>& indices2, DetectionOutputVector* contacts)
+    {
+        Elem1 e1(elem1);
+        Model2* m2 = static_cast<Model2*>(model2);
+        return BatchIntersection<Elem1,Elem2,T>::call(impl, e1, m2, indices2, impl->getOutputVector(e1.getCollisionModel(), m2, contacts), 0);
+    }
+
     std::string name() const
     {
         return sofa::helper::gettypename(typeid(Elem1))+std::string("-")+sofa::helper::gettypename(typeid(Elem2));
@@ -0,0 +1,202 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2016 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This library is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This library is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this library; if not, write to the Free Software Foundation,     *
+* Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA.          *
+*******************************************************************************
+*                              SOFA :: Framework                              *
+*                                                                             *
+* Authors: The SOFA Team (see Authors.txt)                                    *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <sofa/core/collision/NarrowPhaseDetection.h>
+
+namespace sofa
+{
+
+namespace core
+{
+
+namespace collision
+{
+
+namespace
+{
+
+/// Task of a parallel narrow phase run by the current thread, and the detection it was run for
+thread_local NarrowPhaseDetection::TaskOutputs* s_currentTask = NULL;
+thread_local const NarrowPhaseDetection* s_currentTaskDetection = NULL;
+
+/// Makes a task current for the lifetime of the scope, restoring the previous one on exit
+/// so that a detection run in parallel from within a task does not reset the enclosing task
+class CurrentTaskScope
+{
+public:
+    CurrentTaskScope(NarrowPhaseDetection::TaskOutputs* task, const NarrowPhaseDetection* detection)
+        : m_previousTask(s_currentTask)
+        , m_previousDetection(s_currentTaskDetection)
+    {
+        s_currentTask = task;
+        s_currentTaskDetection = detection;
+    }
+
+    ~CurrentTaskScope()
+    {
+        s_currentTask = m_previousTask;
+        s_currentTaskDetection = m_previousDetection;
+    }
+
+private:
+    CurrentTaskScope(const CurrentTaskScope&);
+    CurrentTaskScope& operator=(const CurrentTaskScope&);
+
+    NarrowPhaseDetection::TaskOutputs* m_previousTask;
+    const NarrowPhaseDetection* m_previousDetection;
+};
+
+} // namespace
+
+DetectionOutputVector*& NarrowPhaseDetection::TaskOutputs::get(CollisionModel *cm1, CollisionModel *cm2)
+{
+    const ModelPair cm_pair = std::make_pair(cm1, cm2);
+
+    std::map<ModelPair, DetectionOutputVector*>::iterator it = outputs.find(cm_pair);
+
+    if (it == outputs.end())
+    {
+        it = outputs.insert( std::make_pair(cm_pair, static_cast< DetectionOutputVector * >(0)) ).first;
+        pairs.push_back(cm_pair);
+    }
+
+    return it->second;
+}
+
+DetectionOutputVector*& NarrowPhaseDetection::getDetectionOutputs(CollisionModel *cm1, CollisionModel *cm2)
+{
+    if (s_currentTask != NULL && s_currentTaskDetection == this)
+        return s_currentTask->get(cm1, cm2);
+
+    std::pair< CollisionModel*, CollisionModel* > cm_pair = std::make_pair(cm1, cm2);
+
+    DetectionOutputMap::iterator it = m_outputsMap.find(cm_pair);
+
+    if (it == m_outputsMap.end())
+    {
+        // new contact
+        it = m_outputsMap.insert( std::make_pair(cm_pair, static_cast< DetectionOutputVector * >(0)) ).first;
+    }
+
+    return it->second;
+}
+
+void NarrowPhaseDetection::splitCollisionPairs(const sofa::helper::vector<ModelPair>& v, sofa::helper::vector< sofa::helper::vector<ModelPair> >& taskPairs)
+{
+    std::map<ModelPair, std::size_t> taskIndex;
+    std::size_t nbTasks = 0;
+    for (sofa::helper::vector<ModelPair>::const_iterator it = v.begin(); it != v.end(); ++it)
+    {
+        CollisionModel* cm1 = it->first->getLast();
+        CollisionModel* cm2 = it->second->getLast();
+        if (cm2 < cm1) std::swap(cm1, cm2);
+        std::map<ModelPair, std::size_t>::iterator task = taskIndex.find(std::make_pair(cm1, cm2));
+        if (task == taskIndex.end())
+        {
+            task = taskIndex.insert(std::make_pair(std::make_pair(cm1, cm2), nbTasks)).first;
+            // the vectors of the previous steps are kept to reuse their memory
+            if (taskPairs.size() <= nbTasks)
+                taskPairs.resize(nbTasks+1);
+            taskPairs[nbTasks].clear();
+            ++nbTasks;
+        }
+        taskPairs[task->second].push_back(*it);
+    }
+    taskPairs.resize(nbTasks);
+}
+
+void NarrowPhaseDetection::beginParallelCollisionPairs(const sofa::helper::vector<ModelPair>& v)
+{
+    if (intersectionMethod == NULL)
+        return;
+
+    // fill the cache of intersectors, for the roots of the bounding trees and for the final models
+    bool swapModels = false;
+    for (sofa::helper::vector<ModelPair>::const_iterator it = v.begin(); it != v.end(); ++it)
+    {
+        intersectionMethod->findIntersector(it->first, it->second, swapModels);
+        intersectionMethod->findIntersector(it->first->getLast(), it->second->getLast(), swapModels);
+    }
+}
+
+void NarrowPhaseDetection::prepareTaskOutputs(const sofa::helper::vector< sofa::helper::vector<ModelPair> >& taskPairs, sofa::helper::vector<TaskOutputs>& taskOutputs)
+{
+    // task of each pair of final models, the models being possibly swapped by the detection
+    std::map<ModelPair, std::size_t> taskIndex;
+    for (std::size_t task = 0; task < taskPairs.size(); ++task)
+    {
+        for (sofa::helper::vector<ModelPair>::const_iterator it = taskPairs[task].begin(); it != taskPairs[task].end(); ++it)
+        {
+            taskIndex[std::make_pair(it->first->getLast(), it->second->getLast())] = task;
+            taskIndex[std::make_pair(it->second->getLast(), it->first->getLast())] = task;
+        }
+    }
+
+    taskOutputs.resize(taskPairs.size());
+    for (std::size_t task = 0; task < taskOutputs.size(); ++task)
+        taskOutputs[task].clear();
+
+    // the outputs are not looked up in m_outputsMap, as it would give ids to the new models in a different order than the tasks
+    for (DetectionOutputMap::const_iterator it = m_outputsMap.begin(); it != m_outputsMap.end(); ++it)
+    {
+        if (it->second == NULL)
+            continue;
+        std::map<ModelPair, std::size_t>::const_iterator task = taskIndex.find(it->first);
+        if (task != taskIndex.end())
+            taskOutputs[task->second].get(it->first.first, it->first.second) = it->second;
+    }
+}
+
+void NarrowPhaseDetection::addTaskCollisionPairs(const sofa::helper::vector<ModelPair>& v, TaskOutputs& task)
+{
+    CurrentTaskScope scope(&task, this);
+    for (sofa::helper::vector<ModelPair>::const_iterator it = v.begin(); it != v.end(); ++it)
+        addCollisionPair(*it);
+}
+
+void NarrowPhaseDetection::mergeTaskOutputs(sofa::helper::vector<TaskOutputs>& tasks)
+{
+    for (sofa::helper::vector<TaskOutputs>::iterator task = tasks.begin(); task != tasks.end(); ++task)
+    {
+        for (sofa::helper::vector<ModelPair>::const_iterator it = task->pairs.begin(); it != task->pairs.end(); ++it)
+        {
+            DetectionOutputVector* taskOutputs = task->outputs[*it];
+            if (taskOutputs == NULL)
+                continue;
+            DetectionOutputVector*& outputs = getDetectionOutputs(it->first, it->second);
+            if (outputs != taskOutputs)
+            {
+                if (outputs) outputs->release();
+                outputs = taskOutputs;
+            }
+        }
+        task->clear();
+    }
+}
+
+} // namespace collision
+
+} // namespace core
+
+} // namespace sofa
@@ -27,6 +27,7 @@
 
 #include <sofa/core/collision/Detection.h>
 #include <sofa/helper/map_ptr_stable_compare.h>
+#include <sofa/helper/vector.h>
 #include <vector>
 #include <map>
 #include <algorithm>
@@ -50,6 +51,27 @@ public:
     SOFA_ABSTRACT_CLASS(NarrowPhaseDetection, Detection);
 
     typedef sofa::helper::map_ptr_stable_compare< std::pair< core::CollisionModel*, core::CollisionModel* >, DetectionOutputVector* > DetectionOutputMap;
+    typedef std::pair< core::CollisionModel*, core::CollisionModel* > ModelPair;
+
+    /// Outputs written by one task of a parallel narrow phase (see addTaskCollisionPairs)
+    class SOFA_CORE_API TaskOutputs
+    {
+    public:
+        /// Output vector of the given pair of models, NULL if it was not created yet
+        DetectionOutputVector*& get(CollisionModel *cm1, CollisionModel *cm2);
+
+        void clear()
+        {
+            outputs.clear();
+            pairs.clear();
+        }
+
+    protected:
+        std::map<ModelPair, DetectionOutputVector*> outputs;
+        helper::vector<ModelPair> pairs; ///< pairs of models in the order their outputs were created
+
+        friend class NarrowPhaseDetection;
+    };
 
 protected:
     /// Destructor
@@ -100,6 +122,37 @@ public:
         }
     }
 
+    /// @name Parallel narrow phase
+    /// The pairs of models are split among tasks, each one writing its outputs in its own TaskOutputs,
+    /// which are then merged in the order of the tasks, so the result does not depend on the threads.
+    /// @{
+
+    /// Whether addCollisionPair can be called concurrently for different pairs of models, once
+    /// beginParallelCollisionPairs was called. Its outputs must then only be accessed with getDetectionOutputs.
+    virtual bool canAddCollisionPairsInParallel() const { return false; }
+
+    /// Split the pairs of models into the pairs of each task, in the order of their first pair.
+    /// The pairs with the same two final models, whatever their order, are put in the same task as they share their outputs.
+    static void splitCollisionPairs(const sofa::helper::vector<ModelPair>& v, sofa::helper::vector< sofa::helper::vector<ModelPair> >& taskPairs);
+
+    /// Prepare the parallel processing of the given pairs of models, from the main thread.
+    /// The intersectors of the pairs are looked up here, as the cache of the intersection method is not thread-safe.
+    virtual void beginParallelCollisionPairs(const sofa::helper::vector<ModelPair>& v);
+
+    /// Give to each task the output vectors kept from the previous steps for its pairs of models, so they are reused.
+    /// To call from the main thread, before the tasks are run.
+    void prepareTaskOutputs(const sofa::helper::vector< sofa::helper::vector<ModelPair> >& taskPairs, sofa::helper::vector<TaskOutputs>& taskOutputs);
+
+    /// Add the given pairs of models from any thread, writing the outputs in the task instead of the outputs of this detection.
+    /// All the pairs involving the same two models must be added by the same task.
+    void addTaskCollisionPairs(const sofa::helper::vector<ModelPair>& v, TaskOutputs& task);
+
+    /// Move the outputs written by the tasks to the outputs of this detection, in the order of the tasks.
+    /// To call from the main thread, once all the tasks are done.
+    void mergeTaskOutputs(sofa::helper::vector<TaskOutputs>& tasks);
+
+    /// @}
+
     //sofa::helper::vector<std::pair<core::CollisionElementIterator, core::CollisionElementIterator> >& getCollisionElementPairs() { return elemPairs; }
 
     const DetectionOutputMap& getDetectionOutputs()
@@ -107,20 +160,9 @@ public:
         return m_outputsMap;
     }
 
-    DetectionOutputVector*& getDetectionOutputs(CollisionModel *cm1, CollisionModel *cm2)
-    {
-        std::pair< CollisionModel*, CollisionModel* > cm_pair = std::make_pair(cm1, cm2);
-
-        DetectionOutputMap::iterator it = m_outputsMap.find(cm_pair);
-
-        if (it == m_outputsMap.end())
-        {
-            // new contact
-            it = m_outputsMap.insert( std::make_pair(cm_pair, static_cast< DetectionOutputVector * >(0)) ).first;
-        }
-
-        return it->second;
-    }
+    /// Output vector of the given pair of models, NULL if it was not created yet.
+    /// Within addTaskCollisionPairs, the output vector of the current task.
+    DetectionOutputVector*& getDetectionOutputs(CollisionModel *cm1, CollisionModel *cm2);
 
     //Returns true if the last narrow phase detected no collision, to use after endNarrowPhase.
     inline bool zeroCollision()const{
@@ -43,6 +43,20 @@ void BaseMatrix::compress() {
 //    std::cerr << "BaseMatrix::compress() : Do Nothing" << std::endl;
 }
 
+void BaseMatrix::addBlock33(Index i, Index j, const Mat<3,3,double>& b)
+{
+    for (Index bi=0; bi<3; ++bi)
+        for (Index bj=0; bj<3; ++bj)
+            add(i+bi, j+bj, b[bi][bj]);
+}
+
+void BaseMatrix::addBlock33(Index i, Index j, const Mat<3,3,float>& b)
+{
+    for (Index bi=0; bi<3; ++bi)
+        for (Index bj=0; bj<3; ++bj)
+            add(i+bi, j+bj, (double)b[bi][bj]);
+}
+
 
 
 static inline void opVresize(BaseVector& vec, BaseVector::Index n) { vec.resize(n); }
@@ -41,6 +41,8 @@ namespace sofa
 namespace defaulttype
 {
 
+template <int L, int C, class real> class Mat;
+
 /// Generic matrix API, allowing to fill and use a matrix independently of the linear algebra library in use.
 ///
 /// Note that accessing values using this class is rather slow and should only be used in codes where the
@@ -73,6 +75,12 @@ public:
     virtual void set(Index i, Index j, double v) = 0;
     /// Add v to the existing value of the element at row i, column j (using 0-based indices)
     virtual void add(Index i, Index j, double v) = 0;
+    /// Add the 3x3 block b to the elements starting at row i, column j.
+    /// The default implementation adds each value, matrix types storing blocks override it.
+    /// It is not an overload of add, which would be hidden by the add of the derived matrices.
+    virtual void addBlock33(Index i, Index j, const Mat<3,3,double>& b);
+    /// Add the 3x3 block b to the elements starting at row i, column j.
+    virtual void addBlock33(Index i, Index j, const Mat<3,3,float>& b);
     /*    /// Write the value of the element at row i, column j (using 0-based indices)
         virtual void set(Index i, Index j, float v) { set(i,j,(double)v); }
         /// Add v to the existing value of the element at row i, column j (using 0-based indices)
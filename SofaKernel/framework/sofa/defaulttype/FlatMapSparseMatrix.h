@@ -0,0 +1,880 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2016 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This library is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This library is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this library; if not, write to the Free Software Foundation,     *
+* Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA.          *
+*******************************************************************************
+*                              SOFA :: Framework                              *
+*                                                                             *
+* Authors: The SOFA Team (see Authors.txt)                                    *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#ifndef SOFA_DEFAULTTYPE_FLATMAPSPARSEMATRIX_H
+#define SOFA_DEFAULTTYPE_FLATMAPSPARSEMATRIX_H
+
+#include <iostream>
+#include <sofa/defaulttype/MapMapSparseMatrix.h>
+#include <vector>
+#include <algorithm>
+
+namespace sofa
+{
+
+namespace defaulttype
+{
+
+/// Sparse matrix with the interface of MapMapSparseMatrix, used to store the constraint Jacobians (DataTypes::MatrixDeriv).
+///
+/// The rows are kept in a vector sorted by index, and their entries in contiguous slices of a single arena (compressed row layout).
+/// Writing the rows in increasing order and their entries one after the other only appends to the arena,
+/// whose memory is kept when the matrix is cleared, so that the constraints rebuilt at each step do not allocate anymore.
+/// A row extended after another row was started is moved to the end of the arena.
+///
+/// Differences with MapMapSparseMatrix:
+/// - the entries of a row are kept in insertion order, not sorted by column index
+/// - inserting a row before existing ones or extending a row invalidates the iterators
+/// - RowType is a view on a slice of the arena, valid as long as the matrix is
+template <class T>
+class FlatMapSparseMatrix
+{
+public:
+    typedef T Data;
+    typedef unsigned int KeyType;
+    typedef std::pair< KeyType, T > ColEntry;
+
+    class RowType;
+    class ColConstIterator;
+    class RowConstIterator;
+    class ColIterator;
+    class RowIterator;
+
+protected:
+
+    typedef std::vector< ColEntry > ColArena;
+    typedef std::vector< std::pair< KeyType, RowType > > SparseMatrix;
+
+    /// Entries of all the rows
+    ColArena m_cols;
+
+    /// Rows, sorted by index
+    SparseMatrix m_rows;
+
+    ColEntry* colData()
+    {
+        return m_cols.empty() ? NULL : &m_cols[0];
+    }
+
+    const ColEntry* colData() const
+    {
+        return m_cols.empty() ? NULL : &m_cols[0];
+    }
+
+    static bool rowIndexLess(const std::pair< KeyType, RowType >& row, KeyType lIndex)
+    {
+        return row.first < lIndex;
+    }
+
+    /// @return the position of the row lIndex, or of the row following it if it does not exist
+    std::size_t findRow(KeyType lIndex) const
+    {
+        if (!m_rows.empty() && m_rows.back().first == lIndex)
+            return m_rows.size() - 1;
+        return std::lower_bound(m_rows.begin(), m_rows.end(), lIndex, rowIndexLess) - m_rows.begin();
+    }
+
+    RowType emptyRow()
+    {
+        RowType row;
+        row.m_matrix = this;
+        row.m_begin = m_cols.size();
+        return row;
+    }
+
+    /// @return the position of the row lIndex, created if it does not exist
+    std::size_t insertRow(KeyType lIndex)
+    {
+        if (m_rows.empty() || m_rows.back().first < lIndex)
+        {
+            m_rows.push_back(std::make_pair(lIndex, emptyRow()));
+            return m_rows.size() - 1;
+        }
+
+        std::size_t pos = findRow(lIndex);
+        if (m_rows[pos].first != lIndex)
+            m_rows.insert(m_rows.begin() + pos, std::make_pair(lIndex, emptyRow()));
+        return pos;
+    }
+
+    /// Appends an entry to a row, growing its slice in place if it ends the arena, or moving it to the end of the arena
+    ColEntry* appendCol(RowType& row, KeyType id, const T& value)
+    {
+        if (row.m_size == row.m_capacity)
+        {
+            if (row.m_begin + row.m_capacity == m_cols.size())
+            {
+                m_cols.push_back(ColEntry(id, value));
+                ++row.m_capacity;
+                ++row.m_size;
+                return &m_cols.back();
+            }
+
+            const std::size_t newBegin = m_cols.size();
+            const std::size_t newCapacity = std::max< std::size_t >(2 * row.m_capacity, 4);
+            m_cols.resize(newBegin + newCapacity);
+            std::copy(m_cols.begin() + row.m_begin, m_cols.begin() + row.m_begin + row.m_size, m_cols.begin() + newBegin);
+            row.m_begin = newBegin;
+            row.m_capacity = newCapacity;
+        }
+
+        ColEntry& entry = m_cols[row.m_begin + row.m_size];
+        entry.first = id;
+        entry.second = value;
+        ++row.m_size;
+        return &entry;
+    }
+
+    /// Rows are views on this matrix: point the copied rows to it
+    void attachRows()
+    {
+        for (typename SparseMatrix::iterator it = m_rows.begin(), itEnd = m_rows.end(); it != itEnd; ++it)
+            it->second.m_matrix = this;
+    }
+
+public:
+
+    /// Entries of a row of the matrix, with the interface of the std::map used by MapMapSparseMatrix
+    class RowType
+    {
+    public:
+        typedef KeyType key_type;
+        typedef T mapped_type;
+        typedef ColEntry value_type;
+        typedef ColEntry* iterator;
+        typedef const ColEntry* const_iterator;
+
+        friend class FlatMapSparseMatrix<T>;
+        friend class RowConstIterator;
+        friend class RowIterator;
+
+        RowType()
+            : m_matrix(NULL)
+            , m_begin(0)
+            , m_size(0)
+            , m_capacity(0)
+        {
+
+        }
+
+        iterator begin()
+        {
+            return m_matrix ? m_matrix->colData() + m_begin : NULL;
+        }
+
+        iterator end()
+        {
+            return begin() + m_size;
+        }
+
+        const_iterator begin() const
+        {
+            return m_matrix ? static_cast< const FlatMapSparseMatrix<T>* >(m_matrix)->colData() + m_begin : NULL;
+        }
+
+        const_iterator end() const
+        {
+            return begin() + m_size;
+        }
+
+        std::size_t size() const
+        {
+            return m_size;
+        }
+
+        bool empty() const
+        {
+            return m_size == 0;
+        }
+
+        /// Removes the entries of the row, keeping its slice of the arena
+        void clear()
+        {
+            m_size = 0;
+        }
+
+        iterator find(KeyType id)
+        {
+            iterator it = begin();
+            const iterator itEnd = end();
+            while (it != itEnd && it->first != id)
+                ++it;
+            return it;
+        }
+
+        const_iterator find(KeyType id) const
+        {
+            const_iterator it = begin();
+            const const_iterator itEnd = end();
+            while (it != itEnd && it->first != id)
+                ++it;
+            return it;
+        }
+
+        std::size_t count(KeyType id) const
+        {
+            return find(id) != end() ? 1 : 0;
+        }
+
+        /// @return the number of removed entries
+        std::size_t erase(KeyType id)
+        {
+            iterator it = find(id);
+            if (it == end())
+                return 0;
+            std::copy(it + 1, end(), it);
+            --m_size;
+            return 1;
+        }
+
+        /// @return the value of column id, inserted if it does not exist
+        T& operator[](KeyType id)
+        {
+            iterator it = find(id);
+            if (it != end())
+                return it->second;
+            return m_matrix->appendCol(*this, id, T())->second;
+        }
+
+    protected:
+
+        FlatMapSparseMatrix<T>* m_matrix;
+        std::size_t m_begin;
+        std::size_t m_size;
+        std::size_t m_capacity;
+    };
+
+    FlatMapSparseMatrix()
+    {
+
+    }
+
+    FlatMapSparseMatrix(const FlatMapSparseMatrix<T>& m)
+        : m_cols(m.m_cols)
+        , m_rows(m.m_rows)
+    {
+        attachRows();
+    }
+
+    FlatMapSparseMatrix<T>& operator=(const FlatMapSparseMatrix<T>& m)
+    {
+        if (&m != this)
+        {
+            m_cols = m.m_cols;
+            m_rows = m.m_rows;
+            attachRows();
+        }
+        return *this;
+    }
+
+    /// Removes every matrix elements, keeping the allocated memory
+    void clear()
+    {
+        m_cols.clear();
+        m_rows.clear();
+    }
+
+    /// @return true if the matrix is empty
+    bool empty() const
+    {
+        return m_rows.empty();
+    }
+
+    /// @return the number of rows
+    std::size_t size() const
+    {
+        return m_rows.size();
+    }
+
+    /// write to an output stream
+    inline friend std::ostream& operator << ( std::ostream& out, const FlatMapSparseMatrix<T>& sc)
+    {
+        for (typename SparseMatrix::const_iterator rowIt = sc.m_rows.begin(); rowIt !=  sc.m_rows.end(); ++rowIt)
+        {
+            out << rowIt->first;
+            out << " ";
+            out << rowIt->second.size();
+            out << " ";
+            for (typename RowType::const_iterator colIt = rowIt->second.begin(); colIt !=  rowIt->second.end(); ++colIt)
+            {
+                out << colIt->first << " " << colIt->second << "  ";
+            }
+            out << "\n";
+        }
+
+        return out;
+    }
+
+    /// read from an input stream
+    inline friend std::istream& operator >> ( std::istream& in, FlatMapSparseMatrix<T>& sc)
+    {
+        sc.clear();
+
+        unsigned int c_id;
+        unsigned int c_number;
+        unsigned int c_dofIndex;
+        T c_value;
+
+        while (!(in.rdstate() & std::istream::eofbit))
+        {
+            in >> c_id;
+            in >> c_number;
+
+            RowIterator c_it = sc.writeLine(c_id);
+
+            for (unsigned int i = 0; i < c_number; i++)
+            {
+                in >> c_dofIndex;
+                in >> c_value;
+                c_it.addCol(c_dofIndex, c_value);
+            }
+        }
+
+        return in;
+    }
+
+    /// Sparse Matrix columns constant Iterator
+    class ColConstIterator
+    {
+    public:
+
+        typedef KeyType KeyT;
+
+        friend class RowConstIterator;
+
+    protected:
+
+        ColConstIterator(const FlatMapSparseMatrix<T>* _matrix, std::size_t _internal, const KeyT _rowIndex)
+            : m_matrix(_matrix)
+            , m_internal(_internal)
+            , m_rowIndex(_rowIndex)
+        {
+
+        }
+
+    public:
+
+        /// @return the row index of the parsed row (ie constraint id)
+        KeyT row() const
+        {
+            return m_rowIndex;
+        }
+
+        /// @return the DOF index the constraint is applied on
+        KeyT index() const
+        {
+            return m_matrix->m_cols[m_internal].first;
+        }
+
+        /// @return the constraint value
+        const T &val() const
+        {
+            return m_matrix->m_cols[m_internal].second;
+        }
+
+        /// @return the DOF index the constraint is applied on and its value
+        const std::pair< KeyT, T >& operator*() const
+        {
+            return m_matrix->m_cols[m_internal];
+        }
+
+        /// @return the DOF index the constraint is applied on and its value
+        const std::pair< KeyT, T >& operator->() const
+        {
+            return m_matrix->m_cols[m_internal];
+        }
+
+        void operator++() // prefix
+        {
+            m_internal++;
+        }
+
+        void operator++(int) // postfix
+        {
+            m_internal++;
+        }
+
+        void operator--() // prefix
+        {
+            m_internal--;
+        }
+
+        void operator--(int) // postfix
+        {
+            m_internal--;
+        }
+
+        bool operator==(const ColConstIterator& it2) const
+        {
+            return m_internal == it2.m_internal;
+        }
+
+        bool operator!=(const ColConstIterator& it2) const
+        {
+            return !(m_internal == it2.m_internal);
+        }
+
+        bool operator<(const ColConstIterator& it2) const
+        {
+            return m_internal < it2.m_internal;
+        }
+
+        bool operator>(const ColConstIterator& it2) const
+        {
+            return m_internal > it2.m_internal;
+        }
+
+    private :
+
+        const FlatMapSparseMatrix<T>* m_matrix;
+        std::size_t m_internal;
+        KeyT m_rowIndex;
+    };
+
+
+    class RowConstIterator
+    {
+    public:
+
+        typedef KeyType KeyT;
+
+        friend class FlatMapSparseMatrix<T>;
+
+    protected:
+
+        RowConstIterator(const FlatMapSparseMatrix<T>* _matrix, std::size_t _internal)
+            : m_matrix(_matrix)
+            , m_internal(_internal)
+        {
+
+        }
+
+    public:
+
+        ColConstIterator begin()
+        {
+            return ColConstIterator(m_matrix, row().m_begin, index());
+        }
+
+        ColConstIterator end()
+        {
+            return ColConstIterator(m_matrix, row().m_begin + row().m_size, index());
+        }
+
+        const std::pair< KeyT, RowType >& operator*() const
+        {
+            return m_matrix->m_rows[m_internal];
+        }
+
+        ///@
+        KeyT index() const
+        {
+            return m_matrix->m_rows[m_internal].first;
+        }
+
+        const RowType& row() const
+        {
+            return m_matrix->m_rows[m_internal].second;
+        }
+
+        const std::pair< KeyT, RowType >& operator->() const
+        {
+            return m_matrix->m_rows[m_internal];
+        }
+
+        void operator++() // prefix
+        {
+            m_internal++;
+        }
+
+        void operator++(int) // postfix
+        {
+            m_internal++;
+        }
+
+        void operator--() // prefix
+        {
+            m_internal--;
+        }
+
+        void operator--(int) // postfix
+        {
+            m_internal--;
+        }
+
+        bool operator==(const RowConstIterator& it2) const
+        {
+            return m_internal == it2.m_internal;
+        }
+
+        bool operator!=(const RowConstIterator& it2) const
+        {
+            return !(m_internal == it2.m_internal);
+        }
+
+        bool operator<(const RowConstIterator& it2) const
+        {
+            return m_internal < it2.m_internal;
+        }
+
+        bool operator>(const RowConstIterator& it2) const
+        {
+            return m_internal > it2.m_internal;
+        }
+
+        template <class VecDeriv>
+        typename VecDeriv::Real operator*(const VecDeriv& v) const
+        {
+            return SparseMatrixVecDerivMult(row(), v);
+        }
+
+    private:
+
+        const FlatMapSparseMatrix<T>* m_matrix;
+        std::size_t m_internal;
+    };
+
+
+    RowConstIterator begin() const
+    {
+        return RowConstIterator(this, 0);
+    }
+
+    RowConstIterator end() const
+    {
+        return RowConstIterator(this, m_rows.size());
+    }
+
+    class ColIterator
+    {
+    public:
+
+        typedef KeyType KeyT;
+
+        friend class RowIterator;
+
+    protected:
+
+        ColIterator(FlatMapSparseMatrix<T>* _matrix, std::size_t _internal, const KeyT _rowIndex)
+            : m_matrix(_matrix)
+            , m_internal(_internal)
+            , m_rowIndex(_rowIndex)
+        {
+
+        }
+
+    public:
+
+        /// @return the row index of the parsed row (ie constraint id)
+        KeyT row() const
+        {
+            return m_rowIndex;
+        }
+
+        /// @return the DOF index the constraint is applied on
+        KeyT index() const
+        {
+            return m_matrix->m_cols[m_internal].first;
+        }
+
+        /// @return the constraint value
+        T &val()
+        {
+            return m_matrix->m_cols[m_internal].second;
+        }
+
+        /// @return the DOF index the constraint is applied on and its value
+        std::pair< KeyT, T >& operator*()
+        {
+            return m_matrix->m_cols[m_internal];
+        }
+
+        /// @return the DOF index the constraint is applied on and its value
+        std::pair< KeyT, T >& operator->()
+        {
+            return m_matrix->m_cols[m_internal];
+        }
+
+        void operator++() // prefix
+        {
+            m_internal++;
+        }
+
+        void operator++(int) // postfix
+        {
+            m_internal++;
+        }
+
+        void operator--() // prefix
+        {
+            m_internal--;
+        }
+
+        void operator--(int) // postfix
+        {
+            m_internal--;
+        }
+
+        bool operator==(const ColIterator& it2) const
+        {
+            return m_internal == it2.m_internal;
+        }
+
+        bool operator!=(const ColIterator& it2) const
+        {
+            return !(m_internal == it2.m_internal);
+        }
+
+        bool operator<(const ColIterator& it2) const
+        {
+            return m_internal < it2.m_internal;
+        }
+
+        bool operator>(const ColIterator& it2) const
+        {
+            return m_internal > it2.m_internal;
+        }
+
+    private :
+
+        FlatMapSparseMatrix<T>* m_matrix;
+        std::size_t m_internal;
+        KeyT m_rowIndex;
+    };
+
+
+    class RowIterator
+    {
+    public:
+
+        typedef KeyType KeyT;
+
+        friend class FlatMapSparseMatrix<T>;
+
+    protected:
+
+        RowIterator(FlatMapSparseMatrix<T>* _matrix, std::size_t _internal)
+            : m_matrix(_matrix)
+            , m_internal(_internal)
+        {
+
+        }
+
+    public:
+
+        ColIterator begin()
+        {
+            return ColIterator(m_matrix, row().m_begin, index());
+        }
+
+        ColIterator end()
+        {
+            return ColIterator(m_matrix, row().m_begin + row().m_size, index());
+        }
+
+        std::pair< KeyT, RowType >& operator*()
+        {
+            return m_matrix->m_rows[m_internal];
+        }
+
+        std::pair< KeyT, RowType >& operator->()
+        {
+            return m_matrix->m_rows[m_internal];
+        }
+
+        KeyT index()
+        {
+            return m_matrix->m_rows[m_internal].first;
+        }
+
+        RowType& row()
+        {
+            return m_matrix->m_rows[m_internal].second;
+        }
+
+        void operator++() // prefix
+        {
+            m_internal++;
+        }
+
+        void operator++(int) // postfix
+        {
+            m_internal++;
+        }
+
+        void operator--() // prefix
+        {
+            m_internal--;
+        }
+
+        void operator--(int) // postfix
+        {
+            m_internal--;
+        }
+
+        bool operator==(const RowIterator& it2) const
+        {
+            return m_internal == it2.m_internal;
+        }
+
+        bool operator!=(const RowIterator& it2) const
+        {
+            return !(m_internal == it2.m_internal);
+        }
+
+        bool operator<(const RowIterator& it2) const
+        {
+            return m_internal < it2.m_internal;
+        }
+
+        bool operator>(const RowIterator& it2) const
+        {
+            return m_internal > it2.m_internal;
+        }
+
+        void addCol(KeyT id, T value)
+        {
+            RowType& r = row();
+            typename RowType::iterator it = r.find(id);
+
+            if (it != r.end())
+            {
+                it->second += value;
+            }
+            else
+            {
+                m_matrix->appendCol(r, id, value);
+            }
+        }
+
+        void setCol(KeyT id, T value)
+        {
+            RowType& r = row();
+            typename RowType::iterator it = r.find(id);
+
+            if (it != r.end())
+            {
+                it->second = value;
+            }
+            else
+            {
+                m_matrix->appendCol(r, id, value);
+            }
+        }
+
+    private:
+
+        FlatMapSparseMatrix<T>* m_matrix;
+        std::size_t m_internal;
+    };
+
+    friend class RowType;
+    friend class ColConstIterator;
+    friend class RowConstIterator;
+    friend class ColIterator;
+    friend class RowIterator;
+
+    RowIterator begin()
+    {
+        return RowIterator(this, 0);
+    }
+
+    RowIterator end()
+    {
+        return RowIterator(this, m_rows.size());
+    }
+
+    /// @return Constant Iterator on specified row
+    /// @param lIndex row index
+    /// If lIndex row doesn't exist, returns end iterator
+    RowConstIterator readLine(KeyType lIndex) const
+    {
+        const std::size_t pos = findRow(lIndex);
+        if (pos < m_rows.size() && m_rows[pos].first == lIndex)
+            return RowConstIterator(this, pos);
+        return end();
+    }
+
+    /// @return Iterator on specified row
+    /// @param lIndex row index
+    /// If lIndex row doesn't exist, creates the line and returns an iterator on it
+    RowIterator writeLine(KeyType lIndex)
+    {
+        return RowIterator(this, insertRow(lIndex));
+    }
+
+    /// @return Pair of Iterator on specified row and boolean on true if insertion took place
+    /// @param lIndex row Index
+    /// @param row constraint itself
+    /// If lindex already exists, overwrite existing constraint
+    std::pair< RowIterator, bool > writeLine(KeyType lIndex, const RowType& row)
+    {
+        // copy the entries first, as row may be a row of this matrix
+        const ColArena entries(row.begin(), row.end());
+        RowIterator it = writeLine(lIndex);
+        it.row().clear();
+
+        for (typename ColArena::const_iterator colIt = entries.begin(), colItEnd = entries.end(); colIt != colItEnd; ++colIt)
+        {
+            appendCol(it.row(), colIt->first, colIt->second);
+        }
+
+        return std::make_pair(it, true);
+    }
+
+    /// @return Pair of Iterator on specified row and boolean on true if addition took place
+    /// @param lIndex row Index
+    /// @param row constraint itself
+    /// If lindex doesn't exists, creates the row
+    std::pair< RowIterator, bool > addLine(KeyType lIndex, const RowType& row)
+    {
+        const ColArena entries(row.begin(), row.end());
+        RowIterator it = writeLine(lIndex);
+
+        for (typename ColArena::const_iterator colIt = entries.begin(), colItEnd = entries.end(); colIt != colItEnd; ++colIt)
+        {
+            it.addCol(colIt->first, colIt->second);
+        }
+
+        return std::make_pair(it, true);
+    }
+
+    /// @return Iterator on new allocated row
+    /// Creates a new row in the sparse matrix with the last+1 key index
+    RowIterator newLine()
+    {
+        KeyType newId = m_rows.empty() ? 0 : (m_rows.back().first + 1);
+
+        m_rows.push_back(std::make_pair(newId, emptyRow()));
+        return RowIterator(this, m_rows.size() - 1);
+    }
+};
+
+
+
+} // namespace defaulttype
+
+} // namespace sofa
+
+#endif // SOFA_DEFAULTTYPE_FLATMAPSPARSEMATRIX_H
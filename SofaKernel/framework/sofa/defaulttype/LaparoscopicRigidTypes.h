@@ -26,6 +26,7 @@
 #define SOFA_DEFAULTTYPE_LAPAROSCOPICRIGIDTYPES_H
 
 #include <sofa/defaulttype/MapMapSparseMatrix.h>
+#include <sofa/defaulttype/FlatMapSparseMatrix.h>
 #include <sofa/defaulttype/RigidTypes.h>
 #include <sofa/defaulttype/Vec.h>
 #include <sofa/helper/vector.h>
@@ -313,7 +314,11 @@ public:
     static const DRot& getDRot(const Deriv& d) { return d.getVOrientation(); }
     static void setDRot(Deriv& d, const DRot& v) { d.getVOrientation() = v; }
 
+#ifdef SOFA_FLAT_MATRIXDERIV
+    typedef FlatMapSparseMatrix<Deriv> MatrixDeriv;
+#else
     typedef MapMapSparseMatrix<Deriv> MatrixDeriv;
+#endif
 
     typedef helper::vector<Coord> VecCoord;
     typedef helper::vector<Deriv> VecDeriv;
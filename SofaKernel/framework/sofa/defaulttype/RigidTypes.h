@@ -27,6 +27,7 @@
 
 #include <sofa/defaulttype/Vec.h>
 #include <sofa/defaulttype/MapMapSparseMatrix.h>
+#include <sofa/defaulttype/FlatMapSparseMatrix.h>
 #include <sofa/defaulttype/Mat.h>
 #include <sofa/defaulttype/Quat.h>
 #include <sofa/helper/vector.h>
@@ -819,7 +820,11 @@ public:
     static const DRot& getDRot(const Deriv& d) { return getVOrientation(d); }
     static void setDRot(Deriv& d, const DRot& v) { getVOrientation(d) = v; }
 
+#ifdef SOFA_FLAT_MATRIXDERIV
+    typedef FlatMapSparseMatrix<Deriv> MatrixDeriv;
+#else
     typedef MapMapSparseMatrix<Deriv> MatrixDeriv;
+#endif
 
     typedef helper::vector<Coord> VecCoord;
     typedef helper::vector<Deriv> VecDeriv;
@@ -1716,7 +1721,11 @@ public:
     typedef helper::vector<Deriv> VecDeriv;
     typedef helper::vector<Real> VecReal;
 
+#ifdef SOFA_FLAT_MATRIXDERIV
+    typedef FlatMapSparseMatrix<Deriv> MatrixDeriv;
+#else
     typedef MapMapSparseMatrix<Deriv> MatrixDeriv;
+#endif
 
     template<typename T>
     static void set(Coord& c, T x, T y, T)
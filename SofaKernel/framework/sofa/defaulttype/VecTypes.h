@@ -31,6 +31,7 @@
 #include <sofa/helper/vector.h>
 #include <sofa/helper/random.h>
 #include <sofa/defaulttype/MapMapSparseMatrix.h>
+#include <sofa/defaulttype/FlatMapSparseMatrix.h>
 #include <iostream>
 #include <algorithm>
 #include <memory>
@@ -65,7 +66,11 @@ public:
     static const DPos& getDPos(const Deriv& d) { return d; }
     static void setDPos(Deriv& d, const DPos& v) { d = v; }
 
+#ifdef SOFA_FLAT_MATRIXDERIV
+    typedef FlatMapSparseMatrix<Deriv> MatrixDeriv;
+#else
     typedef MapMapSparseMatrix<Deriv> MatrixDeriv;
+#endif
 
 
 protected:
@@ -440,7 +445,11 @@ public:
     static const DPos& getDPos(const Deriv& d) { return d; }
     static void setDPos(Deriv& d, const DPos& v) { d = v; }
 
+#ifdef SOFA_FLAT_MATRIXDERIV
+    typedef FlatMapSparseMatrix<Deriv> MatrixDeriv;
+#else
     typedef MapMapSparseMatrix<Deriv> MatrixDeriv;
+#endif
 
 
 protected:
@@ -2198,8 +2198,114 @@ int nlcp_multiGrid(int dim, double *dfree, double**W, double *f, double mu, doub
 
 }
 
-int nlcp_gaussseidel(int dim, double *dfree, double**W, double *f, double mu, double tol, int numItMax, bool useInitialF, bool verbose, double minW, double maxF, std::vector<double>* residuals, std::vector<double>* violations)
+namespace
+{
+
+/// Access to the lines of a dense W, as used by the Gauss-Seidel solvers below
+class DenseRows
+{
+public:
+    DenseRows(double** W, int dim) : W(W), dim(dim) {}
+
+    /// Add the product of the line i by f to d
+    void addLineProduct(int i, const double* f, double& d) const
+    {
+        const double* Wi = W[i];
+        for (int j=0; j<dim; j++)
+            d += Wi[j]*f[j];
+    }
+
+    /// Add the product of the lines 3*c to 3*c+2 by f to d[0..2]
+    void addRowProduct(int c, const double* f, double* d) const
+    {
+        const double* W0 = W[3*c];
+        const double* W1 = W[3*c+1];
+        const double* W2 = W[3*c+2];
+        for (int j=0; j<dim; j++)
+        {
+            d[0] += W0[j]*f[j];
+            d[1] += W1[j]*f[j];
+            d[2] += W2[j]*f[j];
+        }
+    }
+
+    /// Value (l,m) of the diagonal 3x3 block c
+    double diagonal(int c, int l, int m) const { return W[3*c+l][3*c+m]; }
+
+    void display(double* dfree, double* f) const { afficheLCP(dfree, W, f, dim); }
+
+protected:
+    double** W;
+    int dim;
+};
+
+/// Access to the lines of a LCPBlockMatrix33, only visiting its non-empty blocks.
+/// The vectors multiplied by it are padded to a whole number of blocks.
+class BlockRows33
+{
+public:
+    BlockRows33(const LCPBlockMatrix33& W, int nbBlockRows)
+        : W(W), row(nbBlockRows, -1), diag(nbBlockRows, -1)
+    {
+        for (int r=0; r<W.nbRows; r++)
+        {
+            const int i = W.rowIndex[r];
+            if (i >= nbBlockRows) continue;
+            row[i] = r;
+            for (int b=W.rowBegin[r]; b<W.rowBegin[r+1]; b++)
+                if (W.colsIndex[b] == i)
+                    diag[i] = b;
+        }
+    }
+
+    /// Add the product of the line i by f to d
+    void addLineProduct(int i, const double* f, double& d) const
+    {
+        const int r = row[i/3];
+        if (r < 0) return;
+        for (int b=W.rowBegin[r]; b<W.rowBegin[r+1]; b++)
+        {
+            const double* B = W.blocks + 9*b + 3*(i%3);
+            const double* fc = f + 3*W.colsIndex[b];
+            d += B[0]*fc[0];
+            d += B[1]*fc[1];
+            d += B[2]*fc[2];
+        }
+    }
+
+    /// Add the product of the block row c by f to d[0..2]
+    void addRowProduct(int c, const double* f, double* d) const
+    {
+        const int r = row[c];
+        if (r < 0) return;
+        for (int b=W.rowBegin[r]; b<W.rowBegin[r+1]; b++)
+        {
+            const double* B = W.blocks + 9*b;
+            const double* fc = f + 3*W.colsIndex[b];
+            for (int j=0; j<3; j++)
+            {
+                d[0] += B[j  ]*fc[j];
+                d[1] += B[j+3]*fc[j];
+                d[2] += B[j+6]*fc[j];
+            }
+        }
+    }
+
+    /// Value (l,m) of the diagonal block c (zero if it is empty)
+    double diagonal(int c, int l, int m) const { return (diag[c] < 0) ? 0.0 : W.blocks[9*diag[c]+3*l+m]; }
+
+    void display(double* /*dfree*/, double* /*f*/) const {}
+
+protected:
+    const LCPBlockMatrix33& W;
+    std::vector<int> row;
+    std::vector<int> diag;
+};
 
+/// Gauss-Seidel like algorithm for contacts on the lines given by W (DenseRows or BlockRows33).
+/// If timed, it stops after the given timeout.
+template<class Rows>
+int nlcp_gaussseidel_rows(int dim, double *dfree, const Rows& W, double *f, double mu, double tol, int numItMax, bool useInitialF, bool verbose, double minW, double maxF, std::vector<double>* residuals, std::vector<double>* violations, bool timed, double timeout)
 {
     const int numContacts =  dim/3;
 
@@ -2208,391 +2314,220 @@ int nlcp_gaussseidel(int dim, double *dfree, double**W, double *f, double mu, do
         printf("\n WARNING dim should be dividable by 3 in nlcp_gaussseidel");
         return 0;
     }
-    // iterators
-    int it,c1,i;
 
-    // memory allocation of vector d
-    double *d;
-    d = (double*)malloc(dim*sizeof(double));
+    ctime_t t0 = CTime::getTime();
+    ctime_t tdiff = (ctime_t)(timeout*CTime::getTicksPerSec());
+
     // put the vector force to zero
     if (!useInitialF)
         memset(f, 0, dim*sizeof(double));
 
     // previous value of the force and the displacment
     double f_1[3];
-    // double d_1b[3] = {0.0, 0.0, 0.0};
     double d_1[3];
 
-    // allocation of the inverted system 3x3
-    LocalBlock33 **W33;
-    W33 = (LocalBlock33 **) malloc (dim*sizeof(LocalBlock33));
-    for (c1=0; c1<numContacts; c1++)
-        W33[c1] = new LocalBlock33();
-    /*
-    std::vector<listElem> sortedList;
-    listElem buf;
-    sortedList.clear();
-    for (c1=0; c1<numContacts; c1++)
-    {
-    	buf.value = dfree[3*c1];
-    	buf.index = c1;
-    	sortedList.push_back(buf);
-    }
-    */
+    // inverted systems 3x3
+    std::vector<LocalBlock33> W33(numContacts);
 
     //////////////
     // Beginning of iterative computations
     //////////////
     double error = 0;
-    double dn, dt, ds, fn, ft, fs;
+    double d[3], fn, ft, fs;
+    int it;
 
     for (it=0; it<numItMax; it++)
     {
         error =0;
-        for (c1=0; c1<numContacts; c1++)
+        for (int c1=0; c1<numContacts; c1++)
         {
-            // index of contact
-            int index1 = c1;
-
             // put the previous value of the contact force in a buffer and put the current value to 0
-            f_1[0] = f[3*index1]; f_1[1] = f[3*index1+1]; f_1[2] = f[3*index1+2];
-            set3Dof(f,index1,0.0,0.0,0.0); //		f[3*index] = 0.0; f[3*index+1] = 0.0; f[3*index+2] = 0.0;
+            f_1[0] = f[3*c1]; f_1[1] = f[3*c1+1]; f_1[2] = f[3*c1+2];
+            set3Dof(f,c1,0.0,0.0,0.0);
 
             // computation of actual d due to contribution of other contacts
-            dn=dfree[3*index1]; dt=dfree[3*index1+1]; ds=dfree[3*index1+2];
-            for (i=0; i<dim; i++)
-            {
-                dn += W[3*index1  ][i]*f[i];
-                dt += W[3*index1+1][i]*f[i];
-                ds += W[3*index1+2][i]*f[i];
-            }
-            // if (maxF != 0.0)
-            // {
-            //     d_1b[0] = dn;
-            //     d_1b[1] = dt;
-            //     d_1b[2] = ds;
-            // }
-            d_1[0] = dn + W[3*index1  ][3*index1  ]*f_1[0]+W[3*index1  ][3*index1+1]*f_1[1]+W[3*index1  ][3*index1+2]*f_1[2];
-            d_1[1] = dt + W[3*index1+1][3*index1  ]*f_1[0]+W[3*index1+1][3*index1+1]*f_1[1]+W[3*index1+1][3*index1+2]*f_1[2];
-            d_1[2] = ds + W[3*index1+2][3*index1  ]*f_1[0]+W[3*index1+2][3*index1+1]*f_1[1]+W[3*index1+2][3*index1+2]*f_1[2];
-            if (minW != 0.0 && fabs(W[3*index1  ][3*index1  ]) <= minW)
+            d[0]=dfree[3*c1]; d[1]=dfree[3*c1+1]; d[2]=dfree[3*c1+2];
+            W.addRowProduct(c1, f, d);
+
+            for (int l=0; l<3; l++)
+                d_1[l] = d[l] + W.diagonal(c1,l,0)*f_1[0]+W.diagonal(c1,l,1)*f_1[1]+W.diagonal(c1,l,2)*f_1[2];
+            if (minW != 0.0 && fabs(W.diagonal(c1,0,0)) <= minW)
             {
                 // constraint compliance is too small
-                if (it == 0) std::cout<<"NLCP WARNING: compliance too small for contact " << index1 << ": |" << std::scientific << W[3*index1  ][3*index1  ] << "| < " << minW << std::fixed << std::endl;
+                if (it == 0) std::cout<<"NLCP WARNING: compliance too small for contact " << c1 << ": |" << std::scientific << W.diagonal(c1,0,0) << "| < " << minW << std::fixed << std::endl;
 
                 fn=0; ft=0; fs=0;
             }
             else
             {
-                if(W33[index1]->computed==false)
+                if(W33[c1].computed==false)
                 {
-                    W33[index1]->compute(W[3*index1][3*index1],W[3*index1][3*index1+1],W[3*index1][3*index1+2],
-                            W[3*index1+1][3*index1+1], W[3*index1+1][3*index1+2],W[3*index1+2][3*index1+2]);
+                    double w11 = W.diagonal(c1,0,0), w12 = W.diagonal(c1,0,1), w13 = W.diagonal(c1,0,2);
+                    double w22 = W.diagonal(c1,1,1), w23 = W.diagonal(c1,1,2), w33 = W.diagonal(c1,2,2);
+                    W33[c1].compute(w11, w12, w13, w22, w23, w33);
                 }
 
                 fn=f_1[0]; ft=f_1[1]; fs=f_1[2];
-                W33[index1]->GS_State(mu,dn,dt,ds,fn,ft,fs);
-                //W33[index1]->BiPotential(mu,dn,dt,ds,fn,ft,fs);
-                // if (maxF != 0.0 && it >= 3 && fabs(fn) >= maxF)
-                // { // constraint force is too large
-                //     std::cout<<"NLCP WARNING: force too large for contact " << index1 << " at iteration " << it << ": |" << std::scientific << fn << "| > " << maxF << std::fixed << std::endl;
-                //     fn=0; ft=0; fs=0;
-                //     dn = d_1b[0];
-                //     dt = d_1b[1];
-                //     ds = d_1b[2];
-                // }
+                W33[c1].GS_State(mu,d[0],d[1],d[2],fn,ft,fs);
             }
-            error += absError(dn,dt,ds,d_1[0],d_1[1],d_1[2]);
+            error += absError(d[0],d[1],d[2],d_1[0],d_1[1],d_1[2]);
 
+            set3Dof(f,c1,fn,ft,fs);
 
-            set3Dof(f,index1,fn,ft,fs);
-
+            if (timed && (CTime::getTime()-t0) > tdiff)
+                return 1;
         }
         if (residuals) residuals->push_back(error);
         if (violations)
         {
             double sum_d = 0;
-            for (int c=0;  c<numContacts ; c++)
+            for (int c=0; c<numContacts; c++)
             {
-                dn = dfree[3*c];  //dt = dfree[3*c+1]; ds = dfree[3*c+2];
-                for (int i=0; i<dim; i++)
-                {
-                    dn += W[3*c  ][i]*f[i];
-                    //dt += W[3*c+1][i]*f[i];
-                    //ds += W[3*c+2][i]*f[i];
-                }
+                double dn = dfree[3*c];
+                W.addLineProduct(3*c, f, dn);
                 if (dn < 0)
                     sum_d += -dn;
             }
             violations->push_back(sum_d);
         }
 
-        if (error < tol*(numContacts+1))
+        if (error < tol)
         {
-
-
             if (maxF != 0.0)
             {
-                for (c1=0; c1<numContacts; c1++)
+                for (int c1=0; c1<numContacts; c1++)
                 {
-                    // index of contact
-                    int index1 = c1;
-                    if (fabs(f[3*index1]) >= maxF)
+                    if (fabs(f[3*c1]) >= maxF)
                     {
                         // constraint force is too large
-                        std::cout<<"NLCP WARNING: force too large for contact " << index1 << " : |" << std::scientific << f[3*index1] << "| > " << maxF << std::fixed << std::endl;
-                        f[3*index1  ] = 0;
-                        f[3*index1+1] = 0;
-                        f[3*index1+2] = 0;
+                        std::cout<<"NLCP WARNING: force too large for contact " << c1 << " : |" << std::scientific << f[3*c1] << "| > " << maxF << std::fixed << std::endl;
+                        set3Dof(f,c1,0.0,0.0,0.0);
                     }
                 }
             }
 
-            free(d);
-            for (int i = 0; i < numContacts; i++)
-                delete W33[i];
-            free(W33);
             if (verbose)
                 printf("Convergence after %d iteration(s) with tolerance : %f and error : %f with dim : %d\n",it, tol, error, dim);
-            //afficheLCP(dfree,W,f,dim);
             sofa::helper::AdvancedTimer::valSet("GS iterations", it+1);
             return 1;
         }
     }
     sofa::helper::AdvancedTimer::valSet("GS iterations", it);
 
-    free(d);
-    for (int i = 0; i < numContacts; i++)
-        delete W33[i];
-    free(W33);
-
     if (verbose)
     {
         std::cerr<<"\n No convergence in  nlcp_gaussseidel function : error ="<<error <<" after"<< it<<" iterations"<<std::endl;
-        afficheLCP(dfree,W,f,dim);
-    }
-
-    return 0;
-
-}
-
-int nlcp_gaussseidelTimed(int dim, double *dfree, double**W, double *f, double mu, double tol, int numItMax, bool useInitialF, double timeout, bool verbose)
-{
-    double test = dim/3;
-    double zero = 0.0;
-    int numContacts =  (int) floor(test);
-    test = dim/3 - numContacts;
-
-    ctime_t t0 = CTime::getTime();
-    ctime_t tdiff = (ctime_t)(timeout*CTime::getTicksPerSec());
-
-    if (test>0.01)
-    {
-        printf("\n WARNING dim should be dividable by 3 in nlcp_gaussseidel");
-        return 0;
-    }
-    // iterators
-    int it,c1,i;
-
-    // memory allocation of vector d
-    double *d;
-    d = (double*)malloc(dim*sizeof(double));
-    // put the vector force to zero
-    if (!useInitialF)
-        memset(f, 0, dim*sizeof(double));
-
-    // previous value of the force and the displacment
-    double f_1[3];
-    double d_1[3];
-
-    // allocation of the inverted system 3x3
-    LocalBlock33 **W33;
-    W33 = (LocalBlock33 **) malloc (dim*sizeof(LocalBlock33));
-    for (c1=0; c1<numContacts; c1++)
-        W33[c1] = new LocalBlock33();
-    /*
-    std::vector<listElem> sortedList;
-    listElem buf;
-    sortedList.clear();
-    for (c1=0; c1<numContacts; c1++)
-    {
-    	buf.value = dfree[3*c1];
-    	buf.index = c1;
-    	sortedList.push_back(buf);
-    }
-    */
-
-    //////////////
-    // Beginning of iterative computations
-    //////////////
-    double error = 0;
-    double dn, dt, ds, fn, ft, fs;
-
-    for (it=0; it<numItMax; it++)
-    {
-        error =0;
-        for (c1=0; c1<numContacts; c1++)
-        {
-            // index of contact
-            int index1 = c1;
-
-            // put the previous value of the contact force in a buffer and put the current value to 0
-            f_1[0] = f[3*index1]; f_1[1] = f[3*index1+1]; f_1[2] = f[3*index1+2];
-            set3Dof(f,index1,zero,zero,zero); //		f[3*index] = 0.0; f[3*index+1] = 0.0; f[3*index+2] = 0.0;
-
-            // computation of actual d due to contribution of other contacts
-            dn=dfree[3*index1]; dt=dfree[3*index1+1]; ds=dfree[3*index1+2];
-            for (i=0; i<dim; i++)
-            {
-                dn += W[3*index1  ][i]*f[i];
-                dt += W[3*index1+1][i]*f[i];
-                ds += W[3*index1+2][i]*f[i];
-            }
-            d_1[0] = dn + W[3*index1  ][3*index1  ]*f_1[0]+W[3*index1  ][3*index1+1]*f_1[1]+W[3*index1  ][3*index1+2]*f_1[2];
-            d_1[1] = dt + W[3*index1+1][3*index1  ]*f_1[0]+W[3*index1+1][3*index1+1]*f_1[1]+W[3*index1+1][3*index1+2]*f_1[2];
-            d_1[2] = ds + W[3*index1+2][3*index1  ]*f_1[0]+W[3*index1+2][3*index1+1]*f_1[1]+W[3*index1+2][3*index1+2]*f_1[2];
-
-            if(W33[index1]->computed==false)
-            {
-                W33[index1]->compute(W[3*index1][3*index1],W[3*index1][3*index1+1],W[3*index1][3*index1+2],
-                        W[3*index1+1][3*index1+1], W[3*index1+1][3*index1+2],W[3*index1+2][3*index1+2]);
-            }
-
-
-            fn=f_1[0]; ft=f_1[1]; fs=f_1[2];
-            W33[index1]->GS_State(mu,dn,dt,ds,fn,ft,fs);
-            error += absError(dn,dt,ds,d_1[0],d_1[1],d_1[2]);
-
-
-            set3Dof(f,index1,fn,ft,fs);
-
-            ctime_t t1 = CTime::getTime();
-            if((t1-t0) > tdiff)
-            {
-                free(d);
-                for (int i = 0; i < numContacts; i++)
-                    delete W33[i];
-                free(W33);
-                //printf("Convergence after %d iteration(s) with tolerance : %f and error : %f with dim : %d\n",it, tol, error, dim);
-                //afficheLCP(dfree,W,f,dim);
-                return 1;
-            }
-        }
-
-        if (error < tol)
-        {
-            free(d);
-            for (int i = 0; i < numContacts; i++)
-                delete W33[i];
-            free(W33);
-            //printf("Convergence after %d iteration(s) with tolerance : %f and error : %f with dim : %d\n",it, tol, error, dim);
-            //afficheLCP(dfree,W,f,dim);
-            sofa::helper::AdvancedTimer::valSet("GS iterations", it+1);
-            return 1;
-        }
-    }
-    sofa::helper::AdvancedTimer::valSet("GS iterations", it);
-    free(d);
-    for (int i = 0; i < numContacts; i++)
-        delete W33[i];
-    free(W33);
-
-    if (verbose)
-    {
-        printf("\n No convergence in nlcp_gaussseidel function : error =%f after %d iterations", error, it);
-        afficheLCP(dfree,W,f,dim);
+        W.display(dfree, f);
     }
 
     return 0;
-
 }
 
-
 /* Resoud un LCP écrit sous la forme U = q + M.F
  * dim : dimension du pb
- * res[0..dim-1] = U
- * res[dim..2*dim-1] = F
+ * f[0..dim-1] = F, initial guess and result
  */
-void gaussSeidelLCP1(int dim, FemClipsReal * q, FemClipsReal ** M, FemClipsReal * res, double tol, int numItMax, double minW, double maxF, std::vector<double>* residuals)
+template<class Rows>
+void gaussSeidelLCP1_rows(int dim, const double * q, const Rows& M, double * f, double tol, int numItMax, double minW, double maxF, std::vector<double>* residuals)
 {
-    int compteur;	// compteur de boucle
-    int compteur2, compteur3;	// compteur de boucle
-
     double f_1;
     double error=0.0;
+    int it;
 
-    for (compteur=0; compteur<numItMax; compteur++)
+    for (it=0; it<numItMax; it++)
     {
-
         error=0.0;
-        for (compteur2=0; compteur2<dim; compteur2++)
+        for (int i=0; i<dim; i++)
         {
-            //res[compteur2]=(FemClipsReal)0.0;
-            res[compteur2]=q[compteur2];
-            for (compteur3=0; compteur3<dim; compteur3++)
-            {
-                res[compteur2]+=M[compteur2][compteur3]* res[dim+compteur3]/* + q[compteur2]*/;
-            }
-            res[compteur2] -= M[compteur2][compteur2]* res[dim+compteur2];
-            f_1 = res[dim+compteur2];
+            const double mii = M.diagonal(i/3, i%3, i%3);
 
-            if (minW != 0.0 && fabs(M[compteur2][compteur2]) <= minW)
+            double di = q[i];
+            M.addLineProduct(i, f, di);
+            di -= mii*f[i];
+            f_1 = f[i];
+
+            if (minW != 0.0 && fabs(mii) <= minW)
             {
                 // constraint compliance is too small
-                if (compteur == 0) std::cout<<"LCP WARNING: compliance too small for constraint " << compteur2 << ": |" << std::scientific << M[compteur2][compteur2] << "| < " << minW << std::fixed << std::endl;
-                res[dim+compteur2]=(FemClipsReal)0.0;
-            }
-            else if (res[compteur2]<0)
-            {
-                res[dim+compteur2]=-res[compteur2]/M[compteur2][compteur2];
-                // if (maxF != 0.0 && compteur >= 3 && fabs(res[dim+compteur2]) >= maxF)
-                // { // constraint force is too large
-                //     std::cout<<"LCP WARNING: force too large for constraint " << compteur2 << " at iteration " << compteur << " : |" << std::scientific << res[dim+compteur2] << "| > " << maxF << std::fixed << std::endl;
-                //     res[dim+compteur2]=(FemClipsReal)0.0;
-                // }
+                if (it == 0) std::cout<<"LCP WARNING: compliance too small for constraint " << i << ": |" << std::scientific << mii << "| < " << minW << std::fixed << std::endl;
+                f[i]=0.0;
             }
+            else if (di<0)
+                f[i]=-di/mii;
             else
-            {
-                res[dim+compteur2]=(FemClipsReal)0.0;
-            }
-
-            error +=fabs( M[compteur2][compteur2] * (res[dim+compteur2] - f_1) );
-
+                f[i]=0.0;
 
+            error +=fabs( mii * (f[i] - f_1) );
         }
         if (residuals) residuals->push_back(error);
         if (error < tol)
-        {
-            //	std::cout << "convergence in gaussSeidelLCP1 with " << compteur << " iterations\n";
             break;
-        }
-
     }
-    sofa::helper::AdvancedTimer::valSet("GS iterations", (compteur < numItMax) ? compteur+1 : compteur);
+    sofa::helper::AdvancedTimer::valSet("GS iterations", (it < numItMax) ? it+1 : it);
 
     if (maxF != 0.0)
     {
-        for (compteur2=0; compteur2<dim; compteur2++)
+        for (int i=0; i<dim; i++)
         {
-            if (fabs(res[dim+compteur2]) >= maxF)
+            if (fabs(f[i]) >= maxF)
             {
                 // constraint force is too large
-                std::cout<<"LCP WARNING: force too large for constraint " << compteur2 << " : |" << std::scientific << res[dim+compteur2] << "| > " << maxF << std::fixed << std::endl;
-                res[dim+compteur2]=(FemClipsReal)0.0;
+                std::cout<<"LCP WARNING: force too large for constraint " << i << " : |" << std::scientific << f[i] << "| > " << maxF << std::fixed << std::endl;
+                f[i]=0.0;
             }
         }
     }
 
-    for (compteur=0; compteur<dim; compteur++)
-        res[compteur] = res[compteur+dim];
-
     if (error >= tol)
-    {
         std::cout << "No convergence in gaussSeidelLCP1 : error = " << error << std::endl;
-        //	afficheLCP(q, M, res, dim);
-    }
 }
 
+} // anonymous namespace
+
+int nlcp_gaussseidel(int dim, double *dfree, double**W, double *f, double mu, double tol, int numItMax, bool useInitialF, bool verbose, double minW, double maxF, std::vector<double>* residuals, std::vector<double>* violations)
+{
+    return nlcp_gaussseidel_rows(dim, dfree, DenseRows(W, dim), f, mu, tol*(dim/3+1), numItMax, useInitialF, verbose, minW, maxF, residuals, violations, false, 0.0);
+}
+
+int nlcp_gaussseidelTimed(int dim, double *dfree, double**W, double *f, double mu, double tol, int numItMax, bool useInitialF, double timeout, bool verbose)
+{
+    return nlcp_gaussseidel_rows(dim, dfree, DenseRows(W, dim), f, mu, tol, numItMax, useInitialF, verbose, 0.0, 0.0, NULL, NULL, true, timeout);
+}
+
+int nlcp_gaussseidel(int dim, double *dfree, const LCPBlockMatrix33& W, double *f, double mu, double tol, int numItMax, bool useInitialF, bool verbose, double minW, double maxF, std::vector<double>* residuals, std::vector<double>* violations)
+{
+    return nlcp_gaussseidel_rows(dim, dfree, BlockRows33(W, dim/3), f, mu, tol*(dim/3+1), numItMax, useInitialF, verbose, minW, maxF, residuals, violations, false, 0.0);
+}
+
+int nlcp_gaussseidelTimed(int dim, double *dfree, const LCPBlockMatrix33& W, double *f, double mu, double tol, int numItMax, bool useInitialF, double timeout, bool verbose)
+{
+    return nlcp_gaussseidel_rows(dim, dfree, BlockRows33(W, dim/3), f, mu, tol, numItMax, useInitialF, verbose, 0.0, 0.0, NULL, NULL, true, timeout);
+}
+
+/* res[0..dim-1] = U, res[dim..2*dim-1] = F during the iterations, then res[0..dim-1] = F
+ */
+void gaussSeidelLCP1(int dim, FemClipsReal * q, FemClipsReal ** M, FemClipsReal * res, double tol, int numItMax, double minW, double maxF, std::vector<double>* residuals)
+{
+    gaussSeidelLCP1_rows(dim, q, DenseRows(M, dim), res+dim, tol, numItMax, minW, maxF, residuals);
+
+    for (int i=0; i<dim; i++)
+        res[i] = res[i+dim];
+}
+
+void gaussSeidelLCP1(int dim, double * q, const LCPBlockMatrix33& M, double * f, double tol, int numItMax, double minW, double maxF, std::vector<double>* residuals)
+{
+    const int numBlocks = (dim+2)/3;
+
+    // forces padded to a whole number of blocks
+    std::vector<double> force(3*numBlocks, 0.0);
+    std::copy(f, f+dim, force.begin());
+
+    gaussSeidelLCP1_rows(dim, q, BlockRows33(M, numBlocks), &force[0], tol, numItMax, minW, maxF, residuals);
+
+    std::copy(force.begin(), force.begin()+dim, f);
+}
+
+
 } // namespace helper
 
 } // namespace sofa
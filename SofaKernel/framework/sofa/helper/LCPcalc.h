@@ -166,6 +166,30 @@ SOFA_HELPER_API int nlcp_multiGrid_Nlevels(int dim, double *dfree, double**W, do
 SOFA_HELPER_API int nlcp_gaussseidel(int dim, double *dfree, double**W, double *f, double mu, double tol, int numItMax, bool useInitialF, bool verbose = false, double minW=0.0, double maxF=0.0, std::vector<double>* residuals = NULL, std::vector<double>* violations = NULL);
 // Timed Gauss-Seidel like algorithm for contacts
 SOFA_HELPER_API int nlcp_gaussseidelTimed(int, double *, double**, double *, double, double, int, bool, double timeout, bool verbose=false);
+
+/// Compliance matrix stored as compressed rows of 3x3 blocks, each block being 9 values
+/// stored row by row (as in CompressedRowSparseMatrix< Mat<3,3,double> >).
+/// Only the non-empty block rows are given: the blocks of the block row rowIndex[r] are
+/// the ones of indices rowBegin[r] to rowBegin[r+1]-1 in colsIndex and blocks.
+class SOFA_HELPER_API LCPBlockMatrix33
+{
+public:
+    LCPBlockMatrix33() : nbRows(0), rowIndex(NULL), rowBegin(NULL), colsIndex(NULL), blocks(NULL) {}
+    LCPBlockMatrix33(int nbRows, const int* rowIndex, const int* rowBegin, const int* colsIndex, const double* blocks)
+        : nbRows(nbRows), rowIndex(rowIndex), rowBegin(rowBegin), colsIndex(colsIndex), blocks(blocks) {}
+
+    int nbRows;
+    const int* rowIndex;
+    const int* rowBegin;
+    const int* colsIndex;
+    const double* blocks;
+};
+
+// Same algorithms with a block-sparse W, only iterating over its non-empty blocks
+SOFA_HELPER_API int nlcp_gaussseidel(int dim, double *dfree, const LCPBlockMatrix33& W, double *f, double mu, double tol, int numItMax, bool useInitialF, bool verbose = false, double minW=0.0, double maxF=0.0, std::vector<double>* residuals = NULL, std::vector<double>* violations = NULL);
+SOFA_HELPER_API int nlcp_gaussseidelTimed(int dim, double *dfree, const LCPBlockMatrix33& W, double *f, double mu, double tol, int numItMax, bool useInitialF, double timeout, bool verbose=false);
+// the initial guess is given in f, which receives the result
+SOFA_HELPER_API void gaussSeidelLCP1(int dim, double * q, const LCPBlockMatrix33& M, double * f, double tol, int numItMax, double minW=0.0, double maxF=0.0, std::vector<double>* residuals = NULL);
 } // namespace helper
 
 } // namespace sofa
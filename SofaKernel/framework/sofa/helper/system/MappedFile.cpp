@@ -0,0 +1,164 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2016 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This library is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This library is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this library; if not, write to the Free Software Foundation,     *
+* Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA.          *
+*******************************************************************************
+*                              SOFA :: Framework                              *
+*                                                                             *
+* Authors: The SOFA Team (see Authors.txt)                                    *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <sofa/helper/system/MappedFile.h>
+#include <sofa/helper/logging/Messaging.h>
+#include <sofa/helper/Utils.h>
+
+#ifdef WIN32
+# include <windows.h>
+#else
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <fcntl.h>
+# include <errno.h>
+# include <string.h>            // for strerror()
+# include <unistd.h>
+#endif
+
+namespace sofa
+{
+namespace helper
+{
+namespace system
+{
+
+MappedFile::MappedFile()
+    : m_data(NULL), m_size(0)
+#if defined(WIN32)
+    , m_file(INVALID_HANDLE_VALUE), m_mapping(NULL)
+#endif
+{
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+#if defined(WIN32)
+
+bool MappedFile::open(const std::string& filename)
+{
+    close();
+
+    HANDLE file = CreateFileW(Utils::widenString(filename).c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                             OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMapping(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping == NULL)
+    {
+        msg_error("MappedFile::open()") << filename << ": " << Utils::GetLastError();
+        CloseHandle(file);
+        return false;
+    }
+
+    const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (view == NULL)
+    {
+        msg_error("MappedFile::open()") << filename << ": " << Utils::GetLastError();
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    m_file = file;
+    m_mapping = mapping;
+    m_data = (const char*)view;
+    m_size = (std::size_t)size.QuadPart;
+    m_filename = filename;
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (m_data != NULL)
+        UnmapViewOfFile(m_data);
+    if (m_mapping != NULL)
+        CloseHandle(m_mapping);
+    if (m_file != INVALID_HANDLE_VALUE)
+        CloseHandle(m_file);
+    m_data = NULL;
+    m_mapping = NULL;
+    m_file = INVALID_HANDLE_VALUE;
+    m_size = 0;
+    m_filename.clear();
+}
+
+#else
+
+bool MappedFile::open(const std::string& filename)
+{
+    close();
+
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    void* view = mmap(NULL, (std::size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    // the mapping stays valid once the file descriptor is closed
+    ::close(fd);
+    if (view == MAP_FAILED)
+    {
+        msg_error("MappedFile::open()") << filename << ": " << strerror(errno);
+        return false;
+    }
+
+    m_data = (const char*)view;
+    m_size = (std::size_t)st.st_size;
+    m_filename = filename;
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (m_data != NULL)
+        munmap((void*)m_data, m_size);
+    m_data = NULL;
+    m_size = 0;
+    m_filename.clear();
+}
+
+#endif
+
+
+} // namespace system
+} // namespace helper
+} // namespace sofa
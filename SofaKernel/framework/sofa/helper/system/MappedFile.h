@@ -0,0 +1,87 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2016 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This library is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This library is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this library; if not, write to the Free Software Foundation,     *
+* Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA.          *
+*******************************************************************************
+*                              SOFA :: Framework                              *
+*                                                                             *
+* Authors: The SOFA Team (see Authors.txt)                                    *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#ifndef SOFA_HELPER_SYSTEM_MAPPEDFILE_H
+#define SOFA_HELPER_SYSTEM_MAPPEDFILE_H
+
+#include <sofa/helper/helper.h>
+
+#include <string>
+#include <cstddef>
+
+namespace sofa
+{
+namespace helper
+{
+namespace system
+{
+
+/// @brief Read-only view of the content of a file, mapped in memory.
+///
+/// The pages are loaded on demand by the operating system and are shared by
+/// all the processes mapping the same file, so large precomputed data can be
+/// used by several simulations without being read nor duplicated.
+/// The file must not be modified while it is mapped.
+class SOFA_HELPER_API MappedFile
+{
+public:
+    MappedFile();
+    ~MappedFile();
+
+    /// @brief Map the whole content of a file, after closing the current one.
+    /// @return true on success
+    bool open(const std::string& filename);
+
+    /// @brief Unmap the file.
+    void close();
+
+    bool isOpen() const { return m_data != NULL; }
+
+    /// First byte of the file, or NULL if no file is mapped.
+    const char* data() const { return m_data; }
+
+    /// Size of the file in bytes.
+    std::size_t size() const { return m_size; }
+
+    const std::string& getFilename() const { return m_filename; }
+
+private:
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+
+    const char* m_data;
+    std::size_t m_size;
+    std::string m_filename;
+#if defined(WIN32)
+    void* m_file;
+    void* m_mapping;
+#endif
+};
+
+
+} // namespace system
+} // namespace helper
+} // namespace sofa
+
+#endif
@@ -48,6 +48,7 @@
 #include <sofa/helper/Factory.inl>
 #include <sofa/helper/cast.h>
 #include <iostream>
+#include <atomic>
 
 #include <boost/graph/adjacency_list.hpp>
 #include <boost/graph/topological_sort.hpp>
@@ -65,6 +66,16 @@ using std::endl;
 using core::objectmodel::BaseNode;
 using core::objectmodel::BaseObject;
 
+namespace
+{
+std::atomic<unsigned int> graphRevision(0);
+}
+
+unsigned int Node::getGraphRevision()
+{
+    return graphRevision;
+}
+
 Node::Node(const std::string& name)
     : core::objectmodel::BaseNode()
     , sofa::core::objectmodel::Context()
@@ -101,6 +112,8 @@ Node::Node(const std::string& name)
     , collisionModel(initLink("collisionModel", "The CollisionModel(s) attached to this node"))
     , collisionPipeline(initLink("collisionPipeline", "The collision Pipeline attached to this node"))
 
+    , visitorScheduler(initLink("visitorScheduler", "The VisitorScheduler executing the visitors started from this node"))
+
     , unsorted(initLink("unsorted", "The remaining objects attached to this node"))
 
     , debug_(false)
@@ -237,6 +250,7 @@ void Node::moveObject(BaseObject::SPtr obj)
 
 void Node::notifyAddChild(Node::SPtr node)
 {
+    ++graphRevision;
     for (helper::vector<MutationListener*>::const_iterator it = listener.begin(); it != listener.end(); ++it)
         (*it)->addChild(this, node.get());
 }
@@ -244,6 +258,7 @@ void Node::notifyAddChild(Node::SPtr node)
 
 void Node::notifyRemoveChild(Node::SPtr node)
 {
+    ++graphRevision;
     for (helper::vector<MutationListener*>::const_iterator it = listener.begin(); it != listener.end(); ++it)
         (*it)->removeChild(this, node.get());
 }
@@ -251,6 +266,7 @@ void Node::notifyRemoveChild(Node::SPtr node)
 
 void Node::notifyMoveChild(Node::SPtr node, Node* prev)
 {
+    ++graphRevision;
     for (helper::vector<MutationListener*>::const_iterator it = listener.begin(); it != listener.end(); ++it)
         (*it)->moveChild(prev, this, node.get());
 }
@@ -258,18 +274,21 @@ void Node::notifyMoveChild(Node::SPtr node, Node* prev)
 
 void Node::notifyAddObject(core::objectmodel::BaseObject::SPtr obj)
 {
+    ++graphRevision;
     for (helper::vector<MutationListener*>::const_iterator it = listener.begin(); it != listener.end(); ++it)
         (*it)->addObject(this, obj.get());
 }
 
 void Node::notifyRemoveObject(core::objectmodel::BaseObject::SPtr obj)
 {
+    ++graphRevision;
     for (helper::vector<MutationListener*>::const_iterator it = listener.begin(); it != listener.end(); ++it)
         (*it)->removeObject(this, obj.get());
 }
 
 void Node::notifyMoveObject(core::objectmodel::BaseObject::SPtr obj, Node* prev)
 {
+    ++graphRevision;
     for (helper::vector<MutationListener*>::const_iterator it = listener.begin(); it != listener.end(); ++it)
         (*it)->moveObject(prev, this, obj.get());
 }
@@ -861,7 +880,10 @@ void Node::executeVisitor(Visitor* action, bool precomputedOrder)
     ++level;
 #endif
 
-    doExecuteVisitor(action, precomputedOrder);
+    if (visitorScheduler)
+        visitorScheduler->executeVisitor(this, action);
+    else
+        doExecuteVisitor(action, precomputedOrder);
 
 #ifdef DEBUG_VISITOR
     --level;
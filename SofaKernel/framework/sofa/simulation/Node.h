@@ -296,6 +296,8 @@ public:
     Sequence<sofa::core::CollisionModel> collisionModel;
     Single<sofa::core::collision::Pipeline> collisionPipeline;
 
+    Single<VisitorScheduler> visitorScheduler;
+
     Sequence<sofa::core::objectmodel::BaseObject> unsorted;
 
     /// @}
@@ -482,6 +484,10 @@ public:
 
     static Node::SPtr create( const std::string& name );
 
+    /// Counter incremented each time a child or an object is added to, removed from or moved between nodes,
+    /// in any graph. Caches built from the structure of the graph compare it to know whether they are outdated.
+    static unsigned int getGraphRevision();
+
     /// return the smallest common parent between this and node2 (returns NULL if separated sub-graphes)
     virtual Node* findCommonParent( simulation::Node* node2 ) = 0;
 
@@ -570,6 +576,7 @@ public:
     NODE_ADD_IN_SEQUENCE( sofa::core::visual::VisualManager, VisualManager, visualManager )
     NODE_ADD_IN_SEQUENCE( sofa::core::CollisionModel, CollisionModel, collisionModel )
     NODE_ADD_IN_SEQUENCE( sofa::core::collision::Pipeline, CollisionPipeline, collisionPipeline )
+    NODE_ADD_IN_SEQUENCE( VisitorScheduler, VisitorScheduler, visitorScheduler )
 
 #undef NODE_ADD_IN_SEQUENCE
 
@@ -0,0 +1,288 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2016 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This library is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This library is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this library; if not, write to the Free Software Foundation,     *
+* Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA.          *
+*******************************************************************************
+*                               SOFA :: Modules                               *
+*                                                                             *
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#ifndef SOFA_SIMULATION_PARALLELFOR_H
+#define SOFA_SIMULATION_PARALLELFOR_H
+
+#include <sofa/simulation/TaskScheduler.h>
+
+#include <vector>
+#include <cstddef>
+
+
+namespace sofa
+{
+
+namespace simulation
+{
+
+/// Helpers distributing a loop over the threads of the TaskScheduler.
+///
+/// The range [begin,end) is cut into chunks of grainSize indices (or, if
+/// grainSize is 0, into about four chunks per thread). Each chunk is processed
+/// by a call to functor(first,last). When the scheduler is not started, has a
+/// single thread, or is called from a thread which is not one of its workers,
+/// the whole range is processed serially by the calling thread.
+///
+/// Chunk boundaries only depend on the range and on grainSize, so with an
+/// explicit grainSize parallelReduce gives the same result whatever the number
+/// of threads.
+
+namespace parallel
+{
+
+/// Number of indices per chunk when splitting a range of size n
+inline std::size_t chunkSize(std::size_t n, std::size_t grainSize)
+{
+    if (grainSize > 0)
+        return grainSize;
+
+    const std::size_t nbChunks = 4 * (std::size_t)TaskScheduler::getInstance().getThreadCount();
+    const std::size_t size = (n + nbChunks - 1) / (nbChunks ? nbChunks : 1);
+    return size ? size : 1;
+}
+
+/// Whether the calling thread can spread work over the scheduler threads
+inline WorkerThread* getParallelWorker()
+{
+    if (TaskScheduler::getInstance().getThreadCount() < 2)
+        return NULL;
+    return WorkerThread::getCurrent();
+}
+
+template<class Functor>
+class ForTask : public Task
+{
+public:
+    ForTask(const Functor& functor, std::size_t first, std::size_t last, Task::Status* status)
+        : Task(status), m_functor(functor), m_first(first), m_last(last)
+    {
+    }
+
+    virtual bool run(WorkerThread*)
+    {
+        m_functor(m_first, m_last);
+        return true;
+    }
+
+private:
+    const Functor& m_functor;
+    const std::size_t m_first;
+    const std::size_t m_last;
+};
+
+template<class T, class Functor>
+class ReduceTask : public Task
+{
+public:
+    ReduceTask(const Functor& functor, std::size_t first, std::size_t last, T& result, Task::Status* status)
+        : Task(status), m_functor(functor), m_first(first), m_last(last), m_result(result)
+    {
+    }
+
+    virtual bool run(WorkerThread*)
+    {
+        m_result = m_functor(m_first, m_last);
+        return true;
+    }
+
+private:
+    const Functor& m_functor;
+    const std::size_t m_first;
+    const std::size_t m_last;
+    T& m_result;
+};
+
+/// Compute the partial result of each chunk of a tree reduction
+template<class T, class Functor>
+class TreeLeafFunctor
+{
+public:
+    TreeLeafFunctor(const Functor& functor, std::vector<T>& partials, std::size_t begin, std::size_t end, std::size_t chunk)
+        : m_functor(functor), m_partials(partials), m_begin(begin), m_end(end), m_chunk(chunk)
+    {
+    }
+
+    void operator()(std::size_t firstChunk, std::size_t lastChunk) const
+    {
+        for (std::size_t i=firstChunk; i<lastChunk; ++i)
+        {
+            const std::size_t first = m_begin + i*m_chunk;
+            const std::size_t last = (first + m_chunk < m_end) ? first + m_chunk : m_end;
+            m_partials[i] = m_functor(first, last);
+        }
+    }
+
+private:
+    const Functor& m_functor;
+    std::vector<T>& m_partials;
+    const std::size_t m_begin;
+    const std::size_t m_end;
+    const std::size_t m_chunk;
+};
+
+/// Merge the pairs of partial results of one level of a tree reduction
+template<class T, class Merge>
+class TreeMergeFunctor
+{
+public:
+    TreeMergeFunctor(const Merge& merge, std::vector<T>& partials, std::size_t step)
+        : m_merge(merge), m_partials(partials), m_step(step)
+    {
+    }
+
+    void operator()(std::size_t firstPair, std::size_t lastPair) const
+    {
+        for (std::size_t p=firstPair; p<lastPair; ++p)
+        {
+            const std::size_t i = 2*m_step*p;
+            if (i + m_step < m_partials.size())
+                m_merge(m_partials[i], m_partials[i+m_step]);
+        }
+    }
+
+private:
+    const Merge& m_merge;
+    std::vector<T>& m_partials;
+    const std::size_t m_step;
+};
+
+} // namespace parallel
+
+
+/// Call functor(first,last) on sub-ranges of [begin,end) from all the scheduler threads,
+/// and return once every sub-range has been processed.
+template<class Functor>
+void parallelFor(std::size_t begin, std::size_t end, const Functor& functor, std::size_t grainSize = 0)
+{
+    if (end <= begin)
+        return;
+
+    const std::size_t n = end - begin;
+    const std::size_t chunk = parallel::chunkSize(n, grainSize);
+    WorkerThread* thread = parallel::getParallelWorker();
+    if (!thread || chunk >= n)
+    {
+        functor(begin, end);
+        return;
+    }
+
+    typedef parallel::ForTask<Functor> ForTask;
+    const std::size_t nbChunks = (n + chunk - 1) / chunk;
+    std::vector<ForTask*> tasks(nbChunks);
+
+    Task::Status status;
+    for (std::size_t i=0; i<nbChunks; ++i)
+    {
+        const std::size_t first = begin + i*chunk;
+        const std::size_t last = (first + chunk < end) ? first + chunk : end;
+        tasks[i] = new ForTask(functor, first, last, &status);
+        thread->addTask(tasks[i]);
+    }
+    thread->workUntilDone(&status);
+
+    for (std::size_t i=0; i<nbChunks; ++i)
+        delete tasks[i];
+}
+
+/// Compute reduce(...reduce(reduce(init, functor(b0,e0)), functor(b1,e1))..., functor(bn,en))
+/// where the functor calls on each sub-range [bi,ei) of [begin,end) are run in parallel,
+/// and the partial results are always combined in the order of the sub-ranges.
+template<class T, class Functor, class Reduce>
+T parallelReduce(std::size_t begin, std::size_t end, const T& init, const Functor& functor, const Reduce& reduce, std::size_t grainSize = 0)
+{
+    if (end <= begin)
+        return init;
+
+    const std::size_t n = end - begin;
+    const std::size_t chunk = parallel::chunkSize(n, grainSize);
+    const std::size_t nbChunks = (n + chunk - 1) / chunk;
+    std::vector<T> partials(nbChunks, init);
+
+    WorkerThread* thread = parallel::getParallelWorker();
+    if (!thread || nbChunks == 1)
+    {
+        // same chunking as the parallel path, so the rounding does not depend on the thread count
+        for (std::size_t i=0; i<nbChunks; ++i)
+        {
+            const std::size_t first = begin + i*chunk;
+            const std::size_t last = (first + chunk < end) ? first + chunk : end;
+            partials[i] = functor(first, last);
+        }
+    }
+    else
+    {
+        typedef parallel::ReduceTask<T,Functor> ReduceTask;
+        std::vector<ReduceTask*> tasks(nbChunks);
+
+        Task::Status status;
+        for (std::size_t i=0; i<nbChunks; ++i)
+        {
+            const std::size_t first = begin + i*chunk;
+            const std::size_t last = (first + chunk < end) ? first + chunk : end;
+            tasks[i] = new ReduceTask(functor, first, last, partials[i], &status);
+            thread->addTask(tasks[i]);
+        }
+        thread->workUntilDone(&status);
+
+        for (std::size_t i=0; i<nbChunks; ++i)
+            delete tasks[i];
+    }
+
+    T result = init;
+    for (std::size_t i=0; i<nbChunks; ++i)
+        result = reduce(result, partials[i]);
+    return result;
+}
+
+/// Same as parallelReduce, for partial results which are expensive to combine (e.g. arrays):
+/// merge(a,b) accumulates b into a, and the partial results of the sub-ranges are merged
+/// pairwise in a binary tree whose levels are also spread over the scheduler threads.
+/// As for parallelReduce, the order of the merges only depends on the chunking.
+template<class T, class Functor, class Merge>
+T parallelTreeReduce(std::size_t begin, std::size_t end, const T& init, const Functor& functor, const Merge& merge, std::size_t grainSize = 0)
+{
+    T result = init;
+    if (end <= begin)
+        return result;
+
+    const std::size_t n = end - begin;
+    const std::size_t chunk = parallel::chunkSize(n, grainSize);
+    const std::size_t nbChunks = (n + chunk - 1) / chunk;
+    std::vector<T> partials(nbChunks, init);
+
+    parallelFor(0, nbChunks, parallel::TreeLeafFunctor<T,Functor>(functor, partials, begin, end, chunk), 1);
+    for (std::size_t step=1; step<nbChunks; step*=2)
+        parallelFor(0, (nbChunks + 2*step - 1) / (2*step), parallel::TreeMergeFunctor<T,Merge>(merge, partials, step), 1);
+
+    merge(result, partials[0]);
+    return result;
+}
+
+
+} // namespace simulation
+
+} // namespace sofa
+
+#endif // SOFA_SIMULATION_PARALLELFOR_H
@@ -0,0 +1,282 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2016 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This library is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This library is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this library; if not, write to the Free Software Foundation,     *
+* Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA.          *
+*******************************************************************************
+*                               SOFA :: Modules                               *
+*                                                                             *
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#ifndef SOFA_SIMULATION_PARALLELSCATTER_H
+#define SOFA_SIMULATION_PARALLELSCATTER_H
+
+#include <sofa/simulation/ParallelFor.h>
+#include <sofa/helper/vector.h>
+
+#include <algorithm>
+
+namespace sofa
+{
+
+namespace simulation
+{
+
+/// Helpers running a loop over mesh elements on the TaskScheduler threads, when
+/// each element adds contributions to the vector entries of its nodes.
+///
+/// Two ways of avoiding concurrent writes to the same entry are provided:
+/// - parallelScatterColored visits the elements color by color, the elements of
+///   a color sharing no node (see computeElementColors), so they can write
+///   directly to the result;
+/// - parallelScatterBuffered lets each thread write to its own buffer, then
+///   adds the buffers to the result.
+///
+/// The functor is called as functor(f, elementIndex), where f is the vector the
+/// element must add its contributions to.
+
+/// Number of elements of each block of parallelScatterBuffered in deterministic mode
+enum { DeterministicScatterBlockSize = 1024 };
+
+/// Greedy coloring of elements (any random-access container of fixed-size
+/// arrays of node indices), such that two elements of the same color share no node.
+/// Colors list element indices in increasing order, and only depend on the elements.
+template<class VecElement>
+void computeElementColors(const VecElement& elements, helper::vector< helper::vector<unsigned int> >& colors)
+{
+    colors.clear();
+
+    std::size_t nbNodes = 0;
+    for (std::size_t e=0; e<elements.size(); ++e)
+        for (std::size_t k=0; k<elements[e].size(); ++k)
+            if ((std::size_t)elements[e][k] >= nbNodes)
+                nbNodes = elements[e][k]+1;
+
+    // last color given to an element using each node
+    helper::vector<unsigned int> nodeColor(nbNodes, (unsigned int)-1);
+
+    helper::vector<unsigned int> remaining(elements.size());
+    for (std::size_t e=0; e<elements.size(); ++e)
+        remaining[e] = (unsigned int)e;
+    helper::vector<unsigned int> next;
+    next.reserve(remaining.size());
+
+    while (!remaining.empty())
+    {
+        const unsigned int c = (unsigned int)colors.size();
+        colors.push_back(helper::vector<unsigned int>());
+        helper::vector<unsigned int>& color = colors.back();
+        next.clear();
+
+        for (std::size_t r=0; r<remaining.size(); ++r)
+        {
+            const unsigned int e = remaining[r];
+            bool isFree = true;
+            for (std::size_t k=0; k<elements[e].size() && isFree; ++k)
+                isFree = (nodeColor[elements[e][k]] != c);
+
+            if (isFree)
+            {
+                for (std::size_t k=0; k<elements[e].size(); ++k)
+                    nodeColor[elements[e][k]] = c;
+                color.push_back(e);
+            }
+            else
+                next.push_back(e);
+        }
+        remaining.swap(next);
+    }
+}
+
+namespace parallel
+{
+
+/// Resize a buffer to the given size, filled with zeros
+template<class VecDeriv>
+void clearBuffer(VecDeriv& buffer, std::size_t size)
+{
+    buffer.resize(size);
+    std::fill(buffer.begin(), buffer.end(), typename VecDeriv::value_type());
+}
+
+template<class VecDeriv, class ElementFunctor>
+class ColorScatterFunctor
+{
+public:
+    ColorScatterFunctor(VecDeriv& f, const helper::vector<unsigned int>& elements, const ElementFunctor& functor)
+        : f(f), elements(elements), functor(functor)
+    {
+    }
+
+    void operator()(std::size_t first, std::size_t last) const
+    {
+        for (std::size_t i=first; i<last; ++i)
+            functor(f, elements[i]);
+    }
+
+private:
+    VecDeriv& f;
+    const helper::vector<unsigned int>& elements;
+    const ElementFunctor& functor;
+};
+
+/// Elements processed by the calling thread are added to its own buffer, cleared
+/// by the thread the first time it is used
+template<class VecDeriv, class ElementFunctor>
+class ThreadBufferScatterFunctor
+{
+public:
+    ThreadBufferScatterFunctor(helper::vector<VecDeriv>& buffers, helper::vector<unsigned char>& used, std::size_t size, const ElementFunctor& functor)
+        : buffers(buffers), used(used), size(size), functor(functor)
+    {
+    }
+
+    void operator()(std::size_t first, std::size_t last) const
+    {
+        const std::size_t t = WorkerThread::getCurrent()->getIndex();
+        VecDeriv& f = buffers[t];
+        if (!used[t])
+        {
+            clearBuffer(f, size);
+            used[t] = 1;
+        }
+        for (std::size_t i=first; i<last; ++i)
+            functor(f, (unsigned int)i);
+    }
+
+private:
+    helper::vector<VecDeriv>& buffers;
+    helper::vector<unsigned char>& used;
+    const std::size_t size;
+    const ElementFunctor& functor;
+};
+
+/// Each block of DeterministicScatterBlockSize elements is added to its own buffer
+template<class VecDeriv, class ElementFunctor>
+class BlockBufferScatterFunctor
+{
+public:
+    BlockBufferScatterFunctor(helper::vector<VecDeriv>& buffers, std::size_t size, std::size_t nbElements, const ElementFunctor& functor)
+        : buffers(buffers), size(size), nbElements(nbElements), functor(functor)
+    {
+    }
+
+    void operator()(std::size_t firstBlock, std::size_t lastBlock) const
+    {
+        for (std::size_t b=firstBlock; b<lastBlock; ++b)
+        {
+            VecDeriv& f = buffers[b];
+            clearBuffer(f, size);
+            const std::size_t first = b * DeterministicScatterBlockSize;
+            const std::size_t last = std::min<std::size_t>(first + DeterministicScatterBlockSize, nbElements);
+            for (std::size_t i=first; i<last; ++i)
+                functor(f, (unsigned int)i);
+        }
+    }
+
+private:
+    helper::vector<VecDeriv>& buffers;
+    const std::size_t size;
+    const std::size_t nbElements;
+    const ElementFunctor& functor;
+};
+
+/// Add the used buffers to the result, always in the same order
+template<class VecDeriv>
+class ReduceBuffersFunctor
+{
+public:
+    ReduceBuffersFunctor(VecDeriv& f, const helper::vector<VecDeriv>& buffers, const helper::vector<unsigned char>& used)
+        : f(f), buffers(buffers), used(used)
+    {
+    }
+
+    void operator()(std::size_t first, std::size_t last) const
+    {
+        for (std::size_t b=0; b<buffers.size(); ++b)
+        {
+            if (!used[b]) continue;
+            const VecDeriv& buffer = buffers[b];
+            for (std::size_t i=first; i<last; ++i)
+                f[i] += buffer[i];
+        }
+    }
+
+private:
+    VecDeriv& f;
+    const helper::vector<VecDeriv>& buffers;
+    const helper::vector<unsigned char>& used;
+};
+
+} // namespace parallel
+
+
+/// Call functor(f, e) for each element e listed in colors, one color after the
+/// other, the elements of a color being processed in parallel.
+/// As the contributions to each entry are added in the order of the colors,
+/// the result does not depend on the number of threads.
+template<class VecDeriv, class ElementFunctor>
+void parallelScatterColored(VecDeriv& f, const helper::vector< helper::vector<unsigned int> >& colors, const ElementFunctor& functor)
+{
+    typedef parallel::ColorScatterFunctor<VecDeriv,ElementFunctor> ColorFunctor;
+    for (std::size_t c=0; c<colors.size(); ++c)
+        parallelFor(0, colors[c].size(), ColorFunctor(f, colors[c], functor));
+}
+
+/// Call functor(buffer, e) for each element e in [0,nbElements) in parallel,
+/// then add the buffers to f.
+/// With deterministic = false, there is one buffer per thread, and the result
+/// depends on the way the elements were distributed over the threads. Otherwise
+/// the elements are split into blocks of DeterministicScatterBlockSize elements,
+/// each with its own buffer, so the result does not depend on the number of
+/// threads; the memory used then grows with the number of blocks.
+/// Only the buffers which receive contributions are cleared and added to f, and
+/// the elements are added directly to f when there is a single thread or block.
+template<class VecDeriv, class ElementFunctor>
+void parallelScatterBuffered(VecDeriv& f, std::size_t nbElements, helper::vector<VecDeriv>& buffers, bool deterministic, const ElementFunctor& functor)
+{
+    const std::size_t nbBlocks = (nbElements + DeterministicScatterBlockSize - 1) / DeterministicScatterBlockSize;
+    if ((deterministic && nbBlocks <= 1) || (!deterministic && !parallel::getParallelWorker()))
+    {
+        for (std::size_t i=0; i<nbElements; ++i)
+            functor(f, (unsigned int)i);
+        return;
+    }
+
+    helper::vector<unsigned char> used;
+    if (deterministic)
+    {
+        buffers.resize(nbBlocks);
+        used.assign(nbBlocks, 1);
+        parallelFor(0, nbBlocks, parallel::BlockBufferScatterFunctor<VecDeriv,ElementFunctor>(buffers, f.size(), nbElements, functor), 1);
+    }
+    else
+    {
+        const std::size_t nbThreads = TaskScheduler::getInstance().getThreadCount();
+        buffers.resize(nbThreads);
+        used.assign(nbThreads, 0);
+        parallelFor(0, nbElements, parallel::ThreadBufferScatterFunctor<VecDeriv,ElementFunctor>(buffers, used, f.size(), functor));
+    }
+
+    parallelFor(0, f.size(), parallel::ReduceBuffersFunctor<VecDeriv>(f, buffers, used));
+}
+
+} // namespace simulation
+
+} // namespace sofa
+
+#endif // SOFA_SIMULATION_PARALLELSCATTER_H
@@ -40,6 +40,8 @@ namespace simulation
 class SOFA_SIMULATION_CORE_API ParallelVisitorScheduler : public simulation::VisitorScheduler
 {
 public:
+    SOFA_ABSTRACT_CLASS(ParallelVisitorScheduler, simulation::VisitorScheduler);
+
     ParallelVisitorScheduler(bool propagate=false);
 
     /// Specify whether this scheduler is multi-threaded.
@@ -0,0 +1,110 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2016 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This library is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This library is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this library; if not, write to the Free Software Foundation,     *
+* Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA.          *
+*******************************************************************************
+*                               SOFA :: Modules                               *
+*                                                                             *
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <sofa/simulation/Task.h>
+#include <sofa/simulation/TaskScheduler.h>
+
+#include <thread>
+
+
+namespace sofa
+{
+
+namespace simulation
+{
+
+Task::Status::Status()
+    : mBusy(0)
+{
+}
+
+bool Task::Status::IsBusy() const
+{
+    return mBusy.load(std::memory_order_acquire) != 0;
+}
+
+void Task::Status::MarkBusy(bool bBusy)
+{
+    if (bBusy)
+        mBusy.fetch_add(1, std::memory_order_relaxed);
+    else
+        mBusy.fetch_sub(1, std::memory_order_release);
+}
+
+
+
+Task::Task(const Task::Status* status)
+    : m_Status(status)
+    , m_continuation(NULL)
+    , m_pendingPredecessors(0)
+{
+}
+
+Task::~Task()
+{
+}
+
+void Task::setContinuation(Task* continuation)
+{
+    m_continuation = continuation;
+    if (continuation->m_pendingPredecessors.fetch_add(1, std::memory_order_relaxed) == 0)
+        continuation->getStatus()->MarkBusy(true);
+}
+
+
+
+ThreadSpecificTask::ThreadSpecificTask(std::atomic<int>* atomicCounter, std::mutex* mutex, Task::Status* pStatus)
+    : Task(pStatus)
+    , mAtomicCounter(atomicCounter)
+    , mThreadSpecificMutex(mutex)
+{
+}
+
+ThreadSpecificTask::~ThreadSpecificTask()
+{
+}
+
+bool ThreadSpecificTask::run(WorkerThread*)
+{
+    runThreadSpecific();
+
+    {
+        std::lock_guard<std::mutex> lock(*mThreadSpecificMutex);
+        runCriticalThreadSpecific();
+    }
+
+    // make sure every thread takes exactly one of these tasks
+    mAtomicCounter->fetch_sub(1);
+    while (mAtomicCounter->load() > 0)
+    {
+        std::this_thread::yield();
+    }
+
+    return false;
+}
+
+
+} // namespace simulation
+
+} // namespace sofa
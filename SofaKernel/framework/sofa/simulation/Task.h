@@ -0,0 +1,138 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2016 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This library is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This library is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this library; if not, write to the Free Software Foundation,     *
+* Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA.          *
+*******************************************************************************
+*                               SOFA :: Modules                               *
+*                                                                             *
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#ifndef SOFA_SIMULATION_TASK_H
+#define SOFA_SIMULATION_TASK_H
+
+#include <sofa/simulation/simulationcore.h>
+
+#include <atomic>
+#include <mutex>
+
+
+namespace sofa
+{
+
+namespace simulation
+{
+
+class WorkerThread;
+class TaskScheduler;
+
+
+/// Unit of work executed by the TaskScheduler.
+///
+/// A task does not own its memory: the code which spawns it is responsible
+/// for keeping it alive until the Status it was created with is no longer busy.
+class SOFA_SIMULATION_CORE_API Task
+{
+public:
+
+    /// Counter of the tasks still pending on a synchronization point.
+    class SOFA_SIMULATION_CORE_API Status
+    {
+    public:
+        Status();
+
+        bool IsBusy() const;
+
+    private:
+        void MarkBusy(bool bBusy);
+
+        std::atomic<int> mBusy;
+
+        friend class Task;
+        friend class WorkerThread;
+    };
+
+protected:
+
+    Task(const Task::Status* status);
+
+public:
+
+    virtual ~Task();
+
+    virtual bool run(WorkerThread* thread) = 0;
+
+    /// Set the task to spawn once this task, and every other task sharing the
+    /// same continuation, has been run. The continuation Status is kept busy
+    /// from now on, so waiting on it also waits for its predecessors.
+    void setContinuation(Task* continuation);
+
+    Task* getContinuation() const { return m_continuation; }
+
+private:
+
+    Task(const Task& /*task*/) {}
+    Task& operator= (const Task& /*task*/) { return *this; }
+
+protected:
+
+    inline Task::Status* getStatus(void) const
+    {
+        return const_cast<Task::Status*>(m_Status);
+    }
+
+    const Task::Status* m_Status;
+
+    Task* m_continuation;
+
+    /// number of tasks which still have to complete before this one is spawned
+    std::atomic<int> m_pendingPredecessors;
+
+    friend class WorkerThread;
+};
+
+
+
+/// This task is called once by each thread used by the TaskScheduler
+/// this is useful to initialize the thread specific variables
+class SOFA_SIMULATION_CORE_API ThreadSpecificTask : public Task
+{
+public:
+
+    ThreadSpecificTask(std::atomic<int>* atomicCounter, std::mutex* mutex, Task::Status* pStatus);
+
+    virtual ~ThreadSpecificTask();
+
+    virtual bool runThreadSpecific() { return true; }
+
+    virtual bool runCriticalThreadSpecific() { return true; }
+
+private:
+
+    virtual bool run(WorkerThread*);
+
+    std::atomic<int>* mAtomicCounter;
+
+    std::mutex* mThreadSpecificMutex;
+};
+
+
+} // namespace simulation
+
+} // namespace sofa
+
+#endif // SOFA_SIMULATION_TASK_H
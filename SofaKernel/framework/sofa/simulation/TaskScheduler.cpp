@@ -0,0 +1,423 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2016 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This library is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This library is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this library; if not, write to the Free Software Foundation,     *
+* Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA.          *
+*******************************************************************************
+*                               SOFA :: Modules                               *
+*                                                                             *
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <sofa/simulation/TaskScheduler.h>
+
+#include <cassert>
+
+
+namespace sofa
+{
+
+namespace simulation
+{
+
+namespace
+{
+
+/// worker attached to the current thread
+thread_local WorkerThread* s_currentWorkerThread = NULL;
+
+/// number of failed steal rounds before an idle worker goes to sleep
+const int IdleSpinCount = 64;
+
+}
+
+
+TaskScheduler& TaskScheduler::getInstance()
+{
+    static TaskScheduler instance;
+
+    return instance;
+}
+
+TaskScheduler::TaskScheduler()
+    : mPendingTaskCount(0)
+    , mSleepingWorkerCount(0)
+    , mIsInitialized(false)
+    , mIsClosing(false)
+    , mThreadCount(0)
+    , mWorkerCount(0)
+{
+}
+
+TaskScheduler::~TaskScheduler()
+{
+    if (mIsInitialized)
+    {
+        stop();
+    }
+}
+
+unsigned TaskScheduler::GetHardwareThreadsCount()
+{
+    return std::thread::hardware_concurrency();
+}
+
+const WorkerThread* TaskScheduler::getWorkerThread(const unsigned int index)
+{
+    if (index >= mThreads.size())
+    {
+        return NULL;
+    }
+    return mThreads[index];
+}
+
+bool TaskScheduler::start(const unsigned int NbThread)
+{
+    if (mIsInitialized)
+    {
+        // keep the running threads unless another count is explicitly requested
+        if (NbThread == 0 || NbThread == mThreadCount)
+            return true;
+
+        stop();
+    }
+
+    mIsClosing = false;
+    mPendingTaskCount = 0;
+    mSleepingWorkerCount = 0;
+
+    // only physical cores. no advantage from hyperthreading.
+    mThreadCount = GetHardwareThreadsCount() / 2;
+    if (mThreadCount == 0)
+    {
+        mThreadCount = 1;
+    }
+
+    if (NbThread > 0)
+    {
+        mThreadCount = NbThread;
+    }
+
+    mThreads.resize(mThreadCount);
+    for (unsigned int iThread=0; iThread<mThreadCount; ++iThread)
+    {
+        mThreads[iThread] = new WorkerThread(this, iThread);
+    }
+
+    // the calling thread takes part in the work
+    mThreads[0]->attachToThisThread();
+
+    /* start worker threads */
+    for (unsigned int iThread=1; iThread<mThreadCount; ++iThread)
+    {
+        mThreads[iThread]->start();
+    }
+
+    mWorkerCount = mThreadCount;
+    mIsInitialized = true;
+    return true;
+}
+
+bool TaskScheduler::stop()
+{
+    if (!mIsInitialized)
+    {
+        return true;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mWakeUpMutex);
+        mIsClosing = true;
+    }
+    mWakeUpEvent.notify_all();
+
+    for (unsigned int iThread=1; iThread<mThreads.size(); ++iThread)
+    {
+        mThreads[iThread]->join();
+    }
+
+    if (s_currentWorkerThread == mThreads[0])
+    {
+        s_currentWorkerThread = NULL;
+    }
+
+    for (unsigned int iThread=0; iThread<mThreads.size(); ++iThread)
+    {
+        delete mThreads[iThread];
+    }
+    mThreads.clear();
+
+    mIsInitialized = false;
+    mThreadCount = 0;
+    mWorkerCount = 0;
+
+    return true;
+}
+
+void TaskScheduler::notifyTaskPushed()
+{
+    mPendingTaskCount.fetch_add(1, std::memory_order_seq_cst);
+
+    // the seq_cst pair (pending count / sleeping count) guarantees that either
+    // we see the sleeping worker here, or it sees the new task before waiting
+    if (mSleepingWorkerCount.load(std::memory_order_seq_cst) > 0)
+    {
+        std::lock_guard<std::mutex> lock(mWakeUpMutex);
+        mWakeUpEvent.notify_one();
+    }
+}
+
+void TaskScheduler::waitForWork()
+{
+    std::unique_lock<std::mutex> lock(mWakeUpMutex);
+
+    mSleepingWorkerCount.fetch_add(1, std::memory_order_seq_cst);
+    while (mPendingTaskCount.load(std::memory_order_seq_cst) <= 0 && !isClosing())
+    {
+        mWakeUpEvent.wait(lock);
+    }
+    mSleepingWorkerCount.fetch_sub(1, std::memory_order_relaxed);
+}
+
+
+
+WorkerThread::WorkerThread(TaskScheduler* const& pScheduler, unsigned int index)
+    : mCurrentStatus(NULL)
+    , mTaskScheduler(pScheduler)
+    , mIndex(index)
+    , mThread(NULL)
+    , mRandomSeed(index * 2654435761u + 1)
+    , mTaskRunCount(0)
+    , mTaskStolenCount(0)
+{
+    assert(pScheduler);
+}
+
+WorkerThread::~WorkerThread()
+{
+    join();
+}
+
+WorkerThread* WorkerThread::getCurrent()
+{
+    return s_currentWorkerThread;
+}
+
+bool WorkerThread::attachToThisThread()
+{
+    s_currentWorkerThread = this;
+    return true;
+}
+
+void WorkerThread::start()
+{
+    mThread = new std::thread(&WorkerThread::run, this);
+}
+
+void WorkerThread::join()
+{
+    if (mThread)
+    {
+        mThread->join();
+        delete mThread;
+        mThread = NULL;
+    }
+}
+
+void WorkerThread::run()
+{
+    attachToThisThread();
+
+    int idleRounds = 0;
+    while (!mTaskScheduler->isClosing())
+    {
+        Task* task = popTask();
+        if (!task)
+        {
+            task = stealTask();
+        }
+
+        if (task)
+        {
+            idleRounds = 0;
+            runTask(task);
+        }
+        else if (++idleRounds < IdleSpinCount)
+        {
+            std::this_thread::yield();
+        }
+        else
+        {
+            idleRounds = 0;
+            mTaskScheduler->waitForWork();
+        }
+    }
+
+    s_currentWorkerThread = NULL;
+}
+
+void WorkerThread::pushTask(Task* task)
+{
+    mTasks.push(task);
+    mTaskScheduler->notifyTaskPushed();
+}
+
+Task* WorkerThread::popTask()
+{
+    Task* task = mTasks.pop();
+    if (task)
+    {
+        mTaskScheduler->notifyTaskPopped();
+    }
+    return task;
+}
+
+Task* WorkerThread::stealTask()
+{
+    const std::vector<WorkerThread*>& threads = mTaskScheduler->mThreads;
+    const unsigned int nbThreads = (unsigned int)threads.size();
+    if (nbThreads < 2)
+    {
+        return NULL;
+    }
+
+    // start from a random victim to spread the contention
+    mRandomSeed ^= mRandomSeed << 13;
+    mRandomSeed ^= mRandomSeed >> 17;
+    mRandomSeed ^= mRandomSeed << 5;
+    const unsigned int first = mRandomSeed % nbThreads;
+
+    for (unsigned int i=0; i<nbThreads; ++i)
+    {
+        WorkerThread* victim = threads[(first + i) % nbThreads];
+        if (victim == this)
+            continue;
+
+        Task* task = victim->mTasks.steal();
+        if (task)
+        {
+            mTaskScheduler->notifyTaskPopped();
+            mTaskStolenCount.fetch_add(1, std::memory_order_relaxed);
+            return task;
+        }
+    }
+    return NULL;
+}
+
+void WorkerThread::runTask(Task* task)
+{
+    Task::Status* status = task->getStatus();
+
+    Task::Status* prevStatus = mCurrentStatus;
+    mCurrentStatus = status;
+
+    task->run(this);
+    mTaskRunCount.fetch_add(1, std::memory_order_relaxed);
+
+    // spawn the continuation before releasing our status, so that a thread
+    // waiting on a status shared by both never sees it idle in between
+    Task* continuation = task->getContinuation();
+    if (continuation && continuation->m_pendingPredecessors.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        // its status was marked busy by Task::setContinuation
+        if (mTaskScheduler->getThreadCount() < 2)
+            runTask(continuation);
+        else
+            pushTask(continuation);
+    }
+
+    status->MarkBusy(false);
+    mCurrentStatus = prevStatus;
+}
+
+bool WorkerThread::addTask(Task* task)
+{
+    task->getStatus()->MarkBusy(true);
+
+    // if we're single threaded run it now
+    if (mTaskScheduler->getThreadCount() < 2)
+    {
+        runTask(task);
+        return false;
+    }
+
+    pushTask(task);
+    return true;
+}
+
+void WorkerThread::workUntilDone(Task::Status* status)
+{
+    while (status->IsBusy())
+    {
+        Task* task = popTask();
+        if (!task)
+        {
+            task = stealTask();
+        }
+
+        if (task)
+        {
+            runTask(task);
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+
+
+// called once by each thread used
+// by the TaskScheduler
+bool runThreadSpecificTask(WorkerThread* thread, const Task * /*task*/ )
+{
+    const int nbThread = TaskScheduler::getInstance().size();
+
+    std::atomic<int> atomicCounter(nbThread);
+
+    std::mutex InitThreadSpecificMutex;
+
+    Task::Status status;
+
+    std::vector<ThreadSpecificTask*> tasks(nbThread);
+    for (int i=0; i<nbThread; ++i)
+    {
+        tasks[i] = new ThreadSpecificTask(&atomicCounter, &InitThreadSpecificMutex, &status);
+        thread->addTask(tasks[i]);
+    }
+
+    thread->workUntilDone(&status);
+
+    for (int i=0; i<nbThread; ++i)
+    {
+        delete tasks[i];
+    }
+
+    return true;
+}
+
+// called once by each thread used
+// by the TaskScheduler
+bool runThreadSpecificTask(const Task *task )
+{
+    return runThreadSpecificTask(WorkerThread::getCurrent(), task);
+}
+
+
+} // namespace simulation
+
+} // namespace sofa
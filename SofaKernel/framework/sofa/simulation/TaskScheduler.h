@@ -0,0 +1,195 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2016 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This library is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This library is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this library; if not, write to the Free Software Foundation,     *
+* Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA.          *
+*******************************************************************************
+*                               SOFA :: Modules                               *
+*                                                                             *
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#ifndef SOFA_SIMULATION_TASKSCHEDULER_H
+#define SOFA_SIMULATION_TASKSCHEDULER_H
+
+#include <sofa/simulation/simulationcore.h>
+#include <sofa/simulation/Task.h>
+#include <sofa/simulation/WorkStealingQueue.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace sofa
+{
+
+namespace simulation
+{
+
+class TaskScheduler;
+
+
+/// Thread of the TaskScheduler, owning a work-stealing deque of tasks.
+///
+/// The thread which calls TaskScheduler::start() becomes worker 0, the other
+/// workers are created by the scheduler. Idle workers steal tasks from the
+/// others and go to sleep when no task is pending anywhere.
+class SOFA_SIMULATION_CORE_API WorkerThread
+{
+public:
+
+    WorkerThread(TaskScheduler* const& taskScheduler, unsigned int index);
+
+    ~WorkerThread();
+
+    /// Worker attached to the calling thread, or NULL if the calling thread is not part of the scheduler
+    static WorkerThread* getCurrent();
+
+    /// Queue the task, or run it right away if the scheduler has a single thread.
+    /// Returns true if the task was queued.
+    bool addTask(Task* pTask);
+
+    /// Run tasks (queued here or stolen from other workers) until status is no longer busy
+    void workUntilDone(Task::Status* status);
+
+    Task::Status* getCurrentStatus() const { return mCurrentStatus; }
+
+    unsigned int getIndex() const { return mIndex; }
+
+    /// Number of tasks this worker ran, and stole from the others, since the scheduler was started
+    unsigned long getTaskCount() const { return mTaskRunCount.load(std::memory_order_relaxed); }
+    unsigned long getStolenTaskCount() const { return mTaskStolenCount.load(std::memory_order_relaxed); }
+
+private:
+
+    void start();
+
+    void join();
+
+    bool attachToThisThread();
+
+    void pushTask(Task* pTask);
+
+    Task* popTask();
+
+    Task* stealTask();
+
+    void runTask(Task* pTask);
+
+    /// thread main loop
+    void run();
+
+private:
+
+    WorkStealingQueue<Task> mTasks;
+
+    Task::Status* mCurrentStatus;
+
+    TaskScheduler* mTaskScheduler;
+
+    const unsigned int mIndex;
+
+    std::thread* mThread;
+
+    unsigned int mRandomSeed;
+
+    std::atomic<unsigned long> mTaskRunCount;
+    std::atomic<unsigned long> mTaskStolenCount;
+
+    friend class TaskScheduler;
+};
+
+
+
+/// Work-stealing task scheduler shared by every component.
+///
+/// Each thread owns a lock-free deque (see WorkStealingQueue), so there is no
+/// limit on the number of threads nor on the number of queued tasks.
+/// See ParallelFor.h for loop helpers built on top of it.
+class SOFA_SIMULATION_CORE_API TaskScheduler
+{
+public:
+
+    static TaskScheduler& getInstance();
+
+    /// Start NbThread threads (including the calling thread).
+    /// With NbThread = 0, keep the running scheduler if any, or use one thread per physical core.
+    bool start(const unsigned int NbThread = 0);
+
+    bool stop(void);
+
+    bool isInitialized(void) const { return mIsInitialized; }
+
+    bool isClosing(void) const { return mIsClosing.load(std::memory_order_relaxed); }
+
+    unsigned int getThreadCount(void) const { return mThreadCount; }
+
+    static unsigned GetHardwareThreadsCount();
+
+    unsigned size() const { return mWorkerCount; }
+
+    const WorkerThread* getWorkerThread(const unsigned int index);
+
+private:
+
+    TaskScheduler();
+
+    TaskScheduler(const TaskScheduler&);
+
+    ~TaskScheduler();
+
+    /// a task was queued: wake up a sleeping worker if there is one
+    void notifyTaskPushed();
+
+    /// a queued task was taken by a worker
+    void notifyTaskPopped() { mPendingTaskCount.fetch_sub(1, std::memory_order_relaxed); }
+
+    /// block the calling worker until some task is queued or the scheduler stops
+    void waitForWork();
+
+    std::vector<WorkerThread*> mThreads;
+
+    std::atomic<int> mPendingTaskCount;
+    std::atomic<int> mSleepingWorkerCount;
+
+    std::mutex mWakeUpMutex;
+    std::condition_variable mWakeUpEvent;
+
+    bool mIsInitialized;
+    std::atomic<bool> mIsClosing;
+
+    unsigned mThreadCount;
+    unsigned mWorkerCount;
+
+    friend class WorkerThread;
+};
+
+
+
+/// Run ThreadSpecificTask once on each thread of the scheduler
+SOFA_SIMULATION_CORE_API bool runThreadSpecificTask(WorkerThread* pThread, const Task *pTask);
+
+SOFA_SIMULATION_CORE_API bool runThreadSpecificTask(const Task *pTask);
+
+
+} // namespace simulation
+
+} // namespace sofa
+
+#endif // SOFA_SIMULATION_TASKSCHEDULER_H
@@ -0,0 +1,290 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2016 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This library is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This library is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this library; if not, write to the Free Software Foundation,     *
+* Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA.          *
+*******************************************************************************
+*                               SOFA :: Modules                               *
+*                                                                             *
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <sofa/simulation/TaskVisitorScheduler.h>
+#include <sofa/simulation/MechanicalVisitor.h>
+#include <sofa/simulation/ParallelFor.h>
+#include <sofa/simulation/TaskScheduler.h>
+#include <sofa/core/ObjectFactory.h>
+
+#include <algorithm>
+
+namespace sofa
+{
+
+namespace simulation
+{
+
+SOFA_DECL_CLASS(TaskVisitorScheduler)
+
+int TaskVisitorSchedulerClass = core::RegisterObject("Execute the mechanical visitors started from its node by visiting independent child subtrees in parallel")
+        .add< TaskVisitorScheduler >()
+        ;
+
+namespace
+{
+
+typedef TaskVisitorScheduler::Footprint Footprint;
+
+/// Whether Node::executeVisitor would visit node
+bool isVisited(Node* node, Visitor* action)
+{
+    return node->isActive() && (!node->isSleeping() || action->canAccessSleepingNode);
+}
+
+void addUsedObject(const core::objectmodel::Base* obj, Footprint& footprint)
+{
+    // nodes are only used to reach the objects they contain
+    if (obj && !dynamic_cast<const core::objectmodel::BaseNode*>(obj))
+        footprint.push_back(obj);
+}
+
+/// Both footprints must be sorted
+bool intersect(const Footprint& a, const Footprint& b)
+{
+    Footprint::const_iterator ia = a.begin(), ib = b.begin();
+    while (ia != a.end() && ib != b.end())
+    {
+        if (*ia < *ib) ++ia;
+        else if (*ib < *ia) ++ib;
+        else return true;
+    }
+    return false;
+}
+
+unsigned int findGroup(helper::vector<unsigned int>& group, unsigned int i)
+{
+    while (group[i] != i)
+    {
+        group[i] = group[group[i]];
+        i = group[i];
+    }
+    return i;
+}
+
+/// Visit a range of groups of children, each group sequentially
+class VisitGroupsFunctor
+{
+public:
+    VisitGroupsFunctor(const helper::vector<Node*>& children, const helper::vector< helper::vector<unsigned int> >& groups, Visitor* action)
+        : children(children), groups(groups), action(action)
+    {
+    }
+
+    void operator()(std::size_t first, std::size_t last) const
+    {
+        // the visitor params belong to the thread which started the traversal
+        core::ExecParams::ThreadStorageScope storageScope(action->execParams());
+
+        for (std::size_t g=first; g<last; ++g)
+        {
+            const helper::vector<unsigned int>& group = groups[g];
+            for (unsigned int i=0; i<group.size(); ++i)
+                children[group[i]]->executeVisitor(action);
+        }
+    }
+
+private:
+    const helper::vector<Node*>& children;
+    const helper::vector< helper::vector<unsigned int> >& groups;
+    Visitor* action;
+};
+
+} // anonymous namespace
+
+TaskVisitorScheduler::TaskVisitorScheduler()
+    : ParallelVisitorScheduler(false)
+    , d_nbThreads(initData(&d_nbThreads, (unsigned int)0, "nbThreads", "Number of threads of the TaskScheduler (0 to keep the running scheduler, or use one thread per core)"))
+    , m_graphRevision(Node::getGraphRevision())
+{
+}
+
+TaskVisitorScheduler::~TaskVisitorScheduler()
+{
+}
+
+void TaskVisitorScheduler::init()
+{
+    TaskScheduler::getInstance().start(d_nbThreads.getValue());
+}
+
+ParallelVisitorScheduler* TaskVisitorScheduler::clone()
+{
+    TaskVisitorScheduler* scheduler = new TaskVisitorScheduler;
+    scheduler->d_nbThreads.setValue(d_nbThreads.getValue());
+    return scheduler;
+}
+
+bool TaskVisitorScheduler::collectFootprint(Node* node, Footprint& footprint)
+{
+    if (node->getNbParents() > 1)
+        return false;
+
+    for (Node::ObjectIterator it = node->object.begin(); it != node->object.end(); ++it)
+    {
+        const core::objectmodel::BaseObject* obj = it->get();
+        footprint.push_back(obj);
+
+        const core::objectmodel::Base::VecLink& links = obj->getLinks();
+        for (unsigned int l=0; l<links.size(); ++l)
+        {
+            for (unsigned int i=0; i<links[l]->getSize(); ++i)
+                addUsedObject(links[l]->getLinkedBase(i), footprint);
+        }
+
+        const core::objectmodel::Base::VecData& data = obj->getDataFields();
+        for (unsigned int d=0; d<data.size(); ++d)
+        {
+            if (const core::objectmodel::BaseData* parent = data[d]->getParent())
+                addUsedObject(parent->getOwner(), footprint);
+        }
+    }
+
+    for (Node::ChildIterator it = node->child.begin(); it != node->child.end(); ++it)
+    {
+        if (!collectFootprint(it->get(), footprint))
+            return false;
+    }
+    return true;
+}
+
+bool TaskVisitorScheduler::groupIndependentChildren(const helper::vector<Node*>& children, helper::vector< helper::vector<unsigned int> >& groups)
+{
+    const unsigned int n = (unsigned int)children.size();
+    helper::vector<Footprint> footprints(n);
+    for (unsigned int i=0; i<n; ++i)
+    {
+        Footprint& footprint = footprints[i];
+        if (!collectFootprint(children[i], footprint))
+            return false;
+        std::sort(footprint.begin(), footprint.end());
+        footprint.erase(std::unique(footprint.begin(), footprint.end()), footprint.end());
+    }
+
+    // union-find, the representative of a group being its first child
+    helper::vector<unsigned int> group(n);
+    for (unsigned int i=0; i<n; ++i)
+        group[i] = i;
+    for (unsigned int i=1; i<n; ++i)
+    {
+        for (unsigned int j=0; j<i; ++j)
+        {
+            const unsigned int gi = findGroup(group, i);
+            const unsigned int gj = findGroup(group, j);
+            if (gi != gj && intersect(footprints[i], footprints[j]))
+                group[std::max(gi,gj)] = std::min(gi,gj);
+        }
+    }
+
+    groups.clear();
+    helper::vector<unsigned int> groupIndex((std::size_t)n, n);
+    for (unsigned int i=0; i<n; ++i)
+    {
+        const unsigned int g = findGroup(group, i);
+        if (groupIndex[g] == n)
+        {
+            groupIndex[g] = (unsigned int)groups.size();
+            groups.push_back(helper::vector<unsigned int>());
+        }
+        groups[groupIndex[g]].push_back(i);
+    }
+    return true;
+}
+
+const TaskVisitorScheduler::ChildGroups& TaskVisitorScheduler::getChildGroups(Node* node, bool reversed, const helper::vector<Node*>& children)
+{
+    const unsigned int revision = Node::getGraphRevision();
+    if (revision != m_graphRevision)
+    {
+        m_childGroups.clear();
+        m_graphRevision = revision;
+    }
+
+    ChildGroups& cached = m_childGroups[std::make_pair(node, reversed)];
+    if (cached.children.empty() || cached.children != children)
+    {
+        cached.children = children;
+        cached.independent = groupIndependentChildren(children, cached.groups);
+    }
+    return cached;
+}
+
+void TaskVisitorScheduler::executeParallelVisitor(Node* node, Visitor* action)
+{
+#ifdef SOFA_DUMP_VISITOR_INFO
+    // the visitor log is written as the graph is visited
+    doExecuteVisitor(node, action);
+#else
+    // the node data reductions assume a sequential traversal
+    BaseMechanicalVisitor* mechanicalVisitor = dynamic_cast<BaseMechanicalVisitor*>(action);
+    if (!mechanicalVisitor || mechanicalVisitor->writeNodeData() || !parallel::getParallelWorker())
+        doExecuteVisitor(node, action);
+    else
+        traverse(node, action);
+#endif
+}
+
+void TaskVisitorScheduler::traverse(Node* node, Visitor* action)
+{
+    if (action->processNodeTopDown(node) != Visitor::RESULT_PRUNE)
+    {
+        helper::vector<Node*> children;
+        children.reserve(node->child.size());
+        const bool reversed = action->childOrderReversed(node);
+        for (unsigned int i=0; i<node->child.size(); ++i)
+        {
+            Node* child = node->child[reversed ? node->child.size()-1-i : i].get();
+            if (isVisited(child, action))
+                children.push_back(child);
+        }
+
+        const ChildGroups* childGroups = (children.size() < 2) ? NULL : &getChildGroups(node, reversed, children);
+        if (!childGroups || !childGroups->independent)
+        {
+            for (unsigned int i=0; i<children.size(); ++i)
+                children[i]->executeVisitor(action);
+        }
+        else if (childGroups->groups.size() == 1)
+        {
+            // nothing to run in parallel at this level, look for independent subtrees below
+            for (unsigned int i=0; i<children.size(); ++i)
+            {
+                if (children[i]->visitorScheduler)
+                    children[i]->executeVisitor(action);
+                else
+                    traverse(children[i], action);
+            }
+        }
+        else
+        {
+            parallelFor(0, childGroups->groups.size(), VisitGroupsFunctor(children, childGroups->groups, action), 1);
+        }
+    }
+
+    action->processNodeBottomUp(node);
+}
+
+} // namespace simulation
+
+} // namespace sofa
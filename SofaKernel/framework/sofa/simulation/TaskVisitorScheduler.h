@@ -0,0 +1,116 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2016 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This library is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This library is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this library; if not, write to the Free Software Foundation,     *
+* Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA.          *
+*******************************************************************************
+*                               SOFA :: Modules                               *
+*                                                                             *
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#ifndef SOFA_SIMULATION_TASKVISITORSCHEDULER_H
+#define SOFA_SIMULATION_TASKVISITORSCHEDULER_H
+
+#include <sofa/simulation/ParallelVisitorScheduler.h>
+#include <sofa/helper/vector.h>
+
+#include <map>
+#include <utility>
+
+namespace sofa
+{
+
+namespace simulation
+{
+
+/// Visitor scheduler running independent child subtrees of its node in parallel on the TaskScheduler.
+///
+/// It applies to the thread-safe mechanical visitors started from the node it
+/// is attached to (typically the node of an OdeSolver animating several
+/// objects). For each traversal, the children of the node are grouped by the
+/// objects they use: the components of a subtree, the components they are
+/// linked to (mechanical states of mappings and interaction forcefields, ...)
+/// and the owners of the Data they are connected to. Children sharing any of
+/// them, such as several subtrees mapped from the same state, are visited
+/// one after the other in the usual order, so the accumulation of applyJT in
+/// their common input state stays the same as in a sequential traversal. The
+/// groups are visited in parallel, and the bottom-up pass of the node is done
+/// once all of them are done.
+///
+/// The groups of the children of each node are kept until the graph changes
+/// (Node::getGraphRevision) or other children are visited (sleeping nodes).
+/// Links and Data connections are expected to be set up with the graph, they
+/// are not watched once the groups are computed.
+///
+/// When all the children form a single group, the same is done one level
+/// deeper. Visitors which are not thread-safe, visitors using node data for
+/// reductions, and graphs where a node has several parents are executed
+/// sequentially.
+class SOFA_SIMULATION_CORE_API TaskVisitorScheduler : public ParallelVisitorScheduler
+{
+public:
+    SOFA_CLASS(TaskVisitorScheduler, ParallelVisitorScheduler);
+
+    Data<unsigned int> d_nbThreads; ///< number of threads of the TaskScheduler, 0 to keep the running one or use one per core
+
+    /// Start the TaskScheduler
+    virtual void init();
+
+    /// Objects used when visiting a subtree, sorted by address
+    typedef helper::vector<const core::objectmodel::Base*> Footprint;
+
+    /// Collect the objects used by the subtree of node.
+    /// Returns false if the subtree contains a node with several parents.
+    static bool collectFootprint(Node* node, Footprint& footprint);
+
+    /// Group the children, listed in visit order, which use common objects.
+    /// Each group lists child indices in visit order, groups are sorted by their first child.
+    /// Returns false if a child cannot be visited separately from the others.
+    static bool groupIndependentChildren(const helper::vector<Node*>& children, helper::vector< helper::vector<unsigned int> >& groups);
+
+protected:
+    TaskVisitorScheduler();
+    virtual ~TaskVisitorScheduler();
+
+    virtual ParallelVisitorScheduler* clone();
+    virtual void executeParallelVisitor(Node* node, Visitor* action);
+
+    /// Visit node, processing its children in parallel if they can be
+    void traverse(Node* node, Visitor* action);
+
+    /// Groups of the visited children of a node, with groupIndependentChildren's result
+    struct ChildGroups
+    {
+        ChildGroups() : independent(false) {}
+        helper::vector<Node*> children;
+        helper::vector< helper::vector<unsigned int> > groups;
+        bool independent;
+    };
+
+    /// Groups of children, computed when they are first visited in this order since the last change of the graph
+    const ChildGroups& getChildGroups(Node* node, bool reversed, const helper::vector<Node*>& children);
+
+    /// Cached groups, per node and visit order
+    std::map< std::pair<Node*, bool>, ChildGroups > m_childGroups;
+    unsigned int m_graphRevision;
+};
+
+} // namespace simulation
+
+} // namespace sofa
+
+#endif // SOFA_SIMULATION_TASKVISITORSCHEDULER_H
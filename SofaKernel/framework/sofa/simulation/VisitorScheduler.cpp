@@ -37,6 +37,26 @@ void VisitorScheduler::doExecuteVisitor(simulation::Node* node, Visitor* act)
     node->doExecuteVisitor(act);
 }
 
+bool VisitorScheduler::insertInNode( core::objectmodel::BaseNode* node )
+{
+    simulation::Node* gnode = dynamic_cast<simulation::Node*>(node);
+    if (!gnode)
+        return false;
+    gnode->addVisitorScheduler(this);
+    Inherit1::insertInNode(node);
+    return true;
+}
+
+bool VisitorScheduler::removeInNode( core::objectmodel::BaseNode* node )
+{
+    simulation::Node* gnode = dynamic_cast<simulation::Node*>(node);
+    if (!gnode)
+        return false;
+    gnode->removeVisitorScheduler(this);
+    Inherit1::removeInNode(node);
+    return true;
+}
+
 } // namespace simulation
 
 } // namespace sofa
@@ -49,6 +49,10 @@ public:
     /// Specify whether this scheduler is multi-threaded.
     virtual bool isMultiThreaded() const { return false; }
 
+    /// Register the scheduler in the node, so that it executes the visitors started from this node
+    virtual bool insertInNode( core::objectmodel::BaseNode* node );
+    virtual bool removeInNode( core::objectmodel::BaseNode* node );
+
 protected:
 
     VisitorScheduler() {}
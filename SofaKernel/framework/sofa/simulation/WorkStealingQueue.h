@@ -0,0 +1,205 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2016 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This library is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This library is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this library; if not, write to the Free Software Foundation,     *
+* Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA.          *
+*******************************************************************************
+*                               SOFA :: Modules                               *
+*                                                                             *
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#ifndef SOFA_SIMULATION_WORKSTEALINGQUEUE_H
+#define SOFA_SIMULATION_WORKSTEALINGQUEUE_H
+
+#include <atomic>
+#include <vector>
+#include <cstddef>
+
+
+namespace sofa
+{
+
+namespace simulation
+{
+
+
+/// Lock-free Chase-Lev work-stealing deque of pointers.
+///
+/// The owner thread pushes and pops at the bottom, any other thread may steal
+/// from the top. The circular buffer grows when full, so there is no limit on
+/// the number of queued items. Retired buffers are kept until destruction, as
+/// a concurrent thief might still be reading from them.
+///
+/// See D. Chase and Y. Lev, "Dynamic Circular Work-Stealing Deque", SPAA 2005,
+/// and N.M. Le et al., "Correct and Efficient Work-Stealing for Weak Memory
+/// Models", PPoPP 2013, for the memory ordering used here.
+template<class T>
+class WorkStealingQueue
+{
+public:
+
+    WorkStealingQueue(std::ptrdiff_t initialCapacity = 256)
+        : m_top(0)
+        , m_bottom(0)
+    {
+        std::ptrdiff_t capacity = 1;
+        while (capacity < initialCapacity) capacity <<= 1;
+        m_array.store(new Array(capacity), std::memory_order_relaxed);
+    }
+
+    ~WorkStealingQueue()
+    {
+        for (std::size_t i=0; i<m_garbage.size(); ++i)
+            delete m_garbage[i];
+        delete m_array.load(std::memory_order_relaxed);
+    }
+
+    /// Owner only: add an item at the bottom of the deque.
+    void push(T* item)
+    {
+        std::ptrdiff_t b = m_bottom.load(std::memory_order_relaxed);
+        std::ptrdiff_t t = m_top.load(std::memory_order_acquire);
+        Array* a = m_array.load(std::memory_order_relaxed);
+        if (b - t > a->capacity() - 1)
+        {
+            a = grow(a, t, b);
+        }
+        a->put(b, item);
+        m_bottom.store(b + 1, std::memory_order_release);
+    }
+
+    /// Owner only: take the most recently pushed item, or NULL if empty.
+    T* pop()
+    {
+        std::ptrdiff_t b = m_bottom.load(std::memory_order_relaxed) - 1;
+        Array* a = m_array.load(std::memory_order_relaxed);
+        m_bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::ptrdiff_t t = m_top.load(std::memory_order_relaxed);
+
+        T* item = NULL;
+        if (t <= b)
+        {
+            item = a->get(b);
+            if (t == b)
+            {
+                // last item: race against thieves
+                if (!m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                    item = NULL;
+                m_bottom.store(b + 1, std::memory_order_relaxed);
+            }
+        }
+        else
+        {
+            m_bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return item;
+    }
+
+    /// Any thread: take the oldest item, or NULL if empty or if another thread won the race.
+    T* steal()
+    {
+        std::ptrdiff_t t = m_top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::ptrdiff_t b = m_bottom.load(std::memory_order_acquire);
+
+        T* item = NULL;
+        if (t < b)
+        {
+            Array* a = m_array.load(std::memory_order_acquire);
+            item = a->get(t);
+            if (!m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                return NULL;
+        }
+        return item;
+    }
+
+    /// Approximate number of queued items.
+    std::size_t size() const
+    {
+        std::ptrdiff_t b = m_bottom.load(std::memory_order_relaxed);
+        std::ptrdiff_t t = m_top.load(std::memory_order_relaxed);
+        return b > t ? (std::size_t)(b - t) : 0;
+    }
+
+    bool empty() const { return size() == 0; }
+
+    std::size_t capacity() const { return (std::size_t)m_array.load(std::memory_order_relaxed)->capacity(); }
+
+private:
+
+    class Array
+    {
+    public:
+        Array(std::ptrdiff_t capacity)
+            : m_capacity(capacity)
+            , m_mask(capacity - 1)
+            , m_buffer(new std::atomic<T*>[capacity])
+        {
+        }
+
+        ~Array() { delete[] m_buffer; }
+
+        std::ptrdiff_t capacity() const { return m_capacity; }
+
+        void put(std::ptrdiff_t i, T* item) { m_buffer[i & m_mask].store(item, std::memory_order_relaxed); }
+
+        T* get(std::ptrdiff_t i) const { return m_buffer[i & m_mask].load(std::memory_order_relaxed); }
+
+        Array* resize(std::ptrdiff_t top, std::ptrdiff_t bottom) const
+        {
+            Array* a = new Array(2 * m_capacity);
+            for (std::ptrdiff_t i = top; i != bottom; ++i)
+                a->put(i, get(i));
+            return a;
+        }
+
+    private:
+        std::ptrdiff_t m_capacity;
+        std::ptrdiff_t m_mask;
+        std::atomic<T*>* m_buffer;
+
+        Array(const Array&);
+        Array& operator=(const Array&);
+    };
+
+    Array* grow(Array* a, std::ptrdiff_t top, std::ptrdiff_t bottom)
+    {
+        Array* bigger = a->resize(top, bottom);
+        m_garbage.push_back(a);
+        m_array.store(bigger, std::memory_order_release);
+        return bigger;
+    }
+
+    // top and bottom are written by different threads, keep them on separate cache lines
+    std::atomic<std::ptrdiff_t> m_top;
+    char m_padTop[64 - sizeof(std::atomic<std::ptrdiff_t>)];
+    std::atomic<std::ptrdiff_t> m_bottom;
+    char m_padBottom[64 - sizeof(std::atomic<std::ptrdiff_t>)];
+    std::atomic<Array*> m_array;
+    std::vector<Array*> m_garbage; ///< retired buffers, only touched by the owner
+
+    WorkStealingQueue(const WorkStealingQueue&);
+    WorkStealingQueue& operator=(const WorkStealingQueue&);
+};
+
+
+} // namespace simulation
+
+} // namespace sofa
+
+#endif // SOFA_SIMULATION_WORKSTEALINGQUEUE_H
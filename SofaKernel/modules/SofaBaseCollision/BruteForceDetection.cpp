@@ -28,6 +28,7 @@
 #include <sofa/helper/FnDispatcher.h>
 #include <sofa/core/ObjectFactory.h>
 #include <map>
+#include <algorithm>
 #include <queue>
 #include <stack>
 #include <sofa/helper/AdvancedTimer.h>
@@ -252,6 +253,7 @@ void BruteForceDetection::addCollisionPair(const std::pair<core::CollisionModel*
     //core::collision::ElementIntersector* intersector = intersectionMethod->findIntersector(cm1, cm2);
     core::collision::ElementIntersector* intersector = NULL;
     MirrorIntersector mirror;
+    helper::vector<int> indices2; // elements of finalcm2 tested against the same element of finalcm1
     cm1 = NULL; // force later init of intersector
     cm2 = NULL;
 
@@ -297,11 +299,14 @@ void BruteForceDetection::addCollisionPair(const std::pair<core::CollisionModel*
                 // Final collision pairs
                 for (core::CollisionElementIterator it1 = begin1; it1 != end1; ++it1)
                 {
+                    indices2.clear();
                     for (core::CollisionElementIterator it2 = begin2; it2 != end2; ++it2)
                     {
                         if (!self || it1.canCollideWith(it2))
-                            intersector->intersect(it1,it2,outputs);
+                            indices2.push_back(it2.getIndex());
                     }
+                    if (!indices2.empty())
+                        intersector->intersectBatch(it1, finalcm2, indices2, outputs);
                 }
             }
             else
@@ -360,13 +365,16 @@ void BruteForceDetection::addCollisionPair(const std::pair<core::CollisionModel*
                                                 core::CollisionElementIterator end2 = newExternalTests.second.second;
                                                 for (core::CollisionElementIterator it1 = begin1; it1 != end1; ++it1)
                                                 {
+                                                    indices2.clear();
                                                     for (core::CollisionElementIterator it2 = begin2; it2 != end2; ++it2)
                                                     {
                                                         //if (!it1->canCollideWith(it2)) continue;
                                                         // Final collision pair
                                                         if (!self || it1.canCollideWith(it2))
-                                                            finalintersector->intersect(it1,it2,outputs);
+                                                            indices2.push_back(it2.getIndex());
                                                     }
+                                                    if (!indices2.empty())
+                                                        finalintersector->intersectBatch(it1, finalcm2, indices2, outputs);
                                                 }
                                             }
                                             else
@@ -410,6 +418,41 @@ void BruteForceDetection::addCollisionPair(const std::pair<core::CollisionModel*
     //sout << "Narrow phase "<<cm1->getLast()->getName()<<"("<<gettypename(typeid(*cm1->getLast()))<<") - "<<cm2->getLast()->getName()<<"("<<gettypename(typeid(*cm2->getLast()))<<"): "<<elemPairs.size()-size0<<" contacts."<<sendl;
 }
 
+void BruteForceDetection::intersectCubePairs(core::collision::ElementIntersector* intersector, core::CollisionModel* finalcm1, core::CollisionModel* finalcm2,
+                                             helper::vector< std::pair<int,int> >& pairs, core::collision::DetectionOutputVector* outputs)
+{
+    const CubeModel* cubes1 = static_cast<CubeModel*>(finalcm1->getPrevious());
+    const CubeModel* cubes2 = static_cast<CubeModel*>(finalcm2->getPrevious());
+    const bool self = (finalcm1->getContext() == finalcm2->getContext());
+
+    for (unsigned int i=0; i<pairs.size(); i++)
+    {
+        int index1 = cubes1->getLeafIndex(pairs[i].first);
+        int index2 = cubes2->getLeafIndex(pairs[i].second);
+        if (finalcm1 == finalcm2 && index2 < index1)
+            std::swap(index1, index2);
+        pairs[i] = std::make_pair(index1, index2);
+    }
+
+    // group the pairs by element of finalcm1, to test each one against all its candidates at once
+    std::sort(pairs.begin(), pairs.end());
+
+    helper::vector<int> indices2;
+    for (unsigned int i=0; i<pairs.size();)
+    {
+        core::CollisionElementIterator it1(finalcm1, pairs[i].first);
+        indices2.clear();
+        for (; i<pairs.size() && pairs[i].first == it1.getIndex(); i++)
+        {
+            core::CollisionElementIterator it2(finalcm2, pairs[i].second);
+            if (!self || it1.canCollideWith(it2))
+                indices2.push_back(pairs[i].second);
+        }
+        if (!indices2.empty())
+            intersector->intersectBatch(it1, finalcm2, indices2, outputs);
+    }
+}
+
 } // namespace collision
 
 } // namespace component
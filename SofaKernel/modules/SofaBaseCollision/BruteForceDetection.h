@@ -105,6 +105,12 @@ protected:
 
     virtual bool keepCollisionBetween(core::CollisionModel *cm1, core::CollisionModel *cm2);
 
+    /// Test the candidate pairs (i,j) of leaf cubes of finalcm1 and finalcm2, found by a detection working on the cubes
+    /// of a bounding tree of depth 0. The pairs are sorted so that each element of finalcm1 is tested against all its
+    /// candidates at once, in a fixed order.
+    void intersectCubePairs(core::collision::ElementIntersector* intersector, core::CollisionModel* finalcm1, core::CollisionModel* finalcm2,
+                            helper::vector< std::pair<int,int> >& pairs, core::collision::DetectionOutputVector* outputs);
+
 public:
 
     void init();
@@ -122,6 +128,11 @@ public:
     void draw(const core::visual::VisualParams* /* vparams */) { }
 
     inline virtual bool needsDeepBoundingTree()const{return true;}
+
+    /// addCollisionPair only uses local data, once the intersectors are found. Not inherited:
+    /// a derived detection (e.g. CudaCollisionDetection) may share data between the pairs, so
+    /// it has to opt in itself
+    virtual bool canAddCollisionPairsInParallel() const { return this->getClass() == BruteForceDetection::GetClass(); }
 };
 
 } // namespace collision
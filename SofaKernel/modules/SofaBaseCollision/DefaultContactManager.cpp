@@ -47,7 +47,15 @@ int DefaultContactManagerClass = core::RegisterObject("Default class to create r
 DefaultContactManager::DefaultContactManager()
     : response(initData(&response, "response", "contact response class"))
     , responseParams(initData(&responseParams, "responseParams", "contact response parameters (syntax: name1=value1&name2=value2&...)"))
+    , d_poolContacts(initData(&d_poolContacts, false, "poolContacts", "Keep the contacts becoming inactive, with their mapped states and response components, to reuse them when their models collide again"))
+    , d_poolMaxAge(initData(&d_poolMaxAge, 100u, "poolMaxAge", "Number of steps after which an inactive contact not reused is destroyed"))
+    , d_nbPooledContacts(initData(&d_nbPooledContacts, 0, "nbPooledContacts", "OUTPUT: number of inactive contacts kept in the pool"))
+    , d_nbReusedContacts(initData(&d_nbReusedContacts, 0, "nbReusedContacts", "OUTPUT: number of contacts taken back from the pool during the last step"))
 {
+    d_nbPooledContacts.setReadOnly(true);
+    d_nbPooledContacts.setGroup("Stats");
+    d_nbReusedContacts.setReadOnly(true);
+    d_nbReusedContacts.setGroup("Stats");
 }
 
 DefaultContactManager::~DefaultContactManager()
@@ -96,6 +104,54 @@ void DefaultContactManager::cleanup()
     }
     contacts.clear();
     contactMap.clear();
+    clearContactPool();
+}
+
+void DefaultContactManager::clearContactPool()
+{
+    for (ContactPool::iterator it = contactPool.begin(); it != contactPool.end(); ++it)
+    {
+        // the response was already removed when the contact was pooled
+        it->second.contact->cleanup();
+        it->second.contact.reset();
+    }
+    contactPool.clear();
+    d_nbPooledContacts.setValue(0);
+}
+
+void DefaultContactManager::agePooledContacts()
+{
+    const bool pool = d_poolContacts.getValue();
+    const unsigned int maxAge = d_poolMaxAge.getValue();
+    for (ContactPool::iterator it = contactPool.begin(); it != contactPool.end();)
+    {
+        if (!pool || ++it->second.age > maxAge)
+        {
+            it->second.contact->cleanup();
+            it->second.contact.reset();
+            ContactPool::iterator eraseIt = it;
+            ++it;
+            contactPool.erase(eraseIt);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+core::collision::Contact::SPtr DefaultContactManager::takePooledContact(const std::pair<core::CollisionModel*,core::CollisionModel*>& models, const std::string& responseUsed)
+{
+    core::collision::Contact::SPtr contact;
+    ContactPool::iterator it = contactPool.find(models);
+    if (it == contactPool.end())
+        return contact;
+    if (it->second.response == responseUsed)
+        contact = it->second.contact;
+    else
+        it->second.contact->cleanup(); // the response changed since the contact was pooled
+    contactPool.erase(it);
+    return contact;
 }
 
 void DefaultContactManager::reset()
@@ -109,6 +165,10 @@ void DefaultContactManager::createContacts(const DetectionOutputMap& outputsMap)
     using core::collision::Contact;
 
     int nbContact = 0;
+    int nbReused = 0;
+    const bool pool = d_poolContacts.getValue();
+
+    agePooledContacts();
 
 	// First iterate on the collision detection outputs and look for existing or new contacts
 	for (DetectionOutputMap::const_iterator outputsIt = outputsMap.begin(),
@@ -132,8 +192,11 @@ void DefaultContactManager::createContacts(const DetectionOutputMap& outputsMap)
             }
 			else
 			{
-				Contact::SPtr contact = Contact::Create(responseUsed, model1, model2, intersectionMethod,
-					this->f_printLog.getValue());
+				Contact::SPtr contact = takePooledContact(outputsIt->first, responseUsed);
+				const bool reused = (contact != NULL);
+				if (!reused)
+					contact = Contact::Create(responseUsed, model1, model2, intersectionMethod,
+						this->f_printLog.getValue());
 
 				if (contact == NULL)
 				{
@@ -161,6 +224,14 @@ void DefaultContactManager::createContacts(const DetectionOutputMap& outputsMap)
 					}
 					contactMap.erase(contactIt);
 				}
+				else if (reused)
+				{
+					// the pooled contact is already initialized, only its outputs are updated
+					contactIt->second = contact;
+					contact->setDetectionOutputs(outputsIt->second);
+					++nbContact;
+					++nbReused;
+				}
 				else
 				{
 					contactIt->second = contact;
@@ -205,8 +276,19 @@ void DefaultContactManager::createContacts(const DetectionOutputMap& outputsMap)
 		{
 			if (contactIt->second)
 			{
-                contactIt->second->removeResponse();
-                contactIt->second->cleanup();
+                if (pool)
+                {
+                    contactIt->second->deactivate();
+                    PooledContact& pooled = contactPool[contactIt->first];
+                    pooled.contact = contactIt->second;
+                    pooled.response = getContactResponse(contactIt->first.first, contactIt->first.second);
+                    pooled.age = 0;
+                }
+                else
+                {
+                    contactIt->second->removeResponse();
+                    contactIt->second->cleanup();
+                }
                 contactIt->second.reset();
 			}
 			ContactMap::iterator eraseIt = contactIt;
@@ -228,6 +310,9 @@ void DefaultContactManager::createContacts(const DetectionOutputMap& outputsMap)
         contacts.push_back(contactIt->second);
     }
 
+    d_nbPooledContacts.setValue((int)contactPool.size());
+    d_nbReusedContacts.setValue(nbReused);
+
     // compute number of contacts attached to each collision model
     std::map< CollisionModel*, int > nbContactsMap;
     for (unsigned int i = 0; i < contacts.size(); ++i)
@@ -331,6 +416,24 @@ void DefaultContactManager::removeContacts(const ContactVector &c)
             }
         }
 
+        // Pooled contacts
+        for (ContactPool::iterator pool_it = contactPool.begin(); pool_it != contactPool.end();)
+        {
+            if (pool_it->second.contact == *remove_it)
+            {
+                ContactPool::iterator erase_it = pool_it;
+                ++pool_it;
+
+                erase_it->second.contact->cleanup();
+                erase_it->second.contact.reset();
+                contactPool.erase(erase_it);
+            }
+            else
+            {
+                ++pool_it;
+            }
+        }
+
         ++remove_it;
     }
 }
@@ -51,14 +51,34 @@ protected:
     typedef sofa::helper::map_ptr_stable_compare<std::pair<core::CollisionModel*,core::CollisionModel*>,core::collision::Contact::SPtr> ContactMap;
     ContactMap contactMap;
 
+    /// Inactive contact kept with its mapped states and response components, to be reused if its models collide again
+    struct PooledContact
+    {
+        core::collision::Contact::SPtr contact;
+        std::string response;
+        unsigned int age;
+    };
+    typedef sofa::helper::map_ptr_stable_compare<std::pair<core::CollisionModel*,core::CollisionModel*>,PooledContact> ContactPool;
+    ContactPool contactPool;
+
 public:
     Data<sofa::helper::OptionsGroup> response;
     Data<std::string> responseParams;
+    Data<bool> d_poolContacts;
+    Data<unsigned int> d_poolMaxAge;
+    Data<int> d_nbPooledContacts;
+    Data<int> d_nbReusedContacts;
 protected:
     DefaultContactManager();
     ~DefaultContactManager();
     void setContactTags(core::CollisionModel* model1, core::CollisionModel* model2, core::collision::Contact::SPtr contact);
 
+    /// Remove from the pool the contact stored for the given pair of models, returning it if it uses the given response
+    core::collision::Contact::SPtr takePooledContact(const std::pair<core::CollisionModel*,core::CollisionModel*>& models, const std::string& responseUsed);
+    /// Age the pooled contacts, destroying the ones not reused for more than poolMaxAge steps (all of them if pooling is disabled)
+    void agePooledContacts();
+    void clearContactPool();
+
 public:
 
     /// outputsVec fixes the reproducibility problems by storing contacts in the collision detection saved order
@@ -122,12 +142,15 @@ protected:
     static sofa::helper::OptionsGroup initializeResponseOptions(core::collision::Pipeline *pipeline);
 
     std::map<Instance,ContactMap> storedContactMap;
+    std::map<Instance,ContactPool> storedContactPool;
 
     virtual void changeInstance(Instance inst)
     {
         core::collision::ContactManager::changeInstance(inst);
         storedContactMap[instance].swap(contactMap);
         contactMap.swap(storedContactMap[inst]);
+        storedContactPool[instance].swap(contactPool);
+        contactPool.swap(storedContactPool[inst]);
     }
 
     // count failure messages, so we don't continuously repeat them
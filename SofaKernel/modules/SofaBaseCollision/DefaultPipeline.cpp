@@ -33,6 +33,7 @@
 #include <sofa/core/visual/VisualParams.h>
 
 #include <sofa/simulation/Node.h>
+#include <sofa/simulation/ParallelFor.h>
 
 #ifdef SOFA_DUMP_VISITOR_INFO
 #include <sofa/simulation/Visitor.h>
@@ -67,9 +68,18 @@ DefaultPipeline::DefaultPipeline()
     : bVerbose(initData(&bVerbose, false, "verbose","Display current step information"))
     , bDraw(initData(&bDraw, false, "draw","Draw detected collisions"))
     , depth(initData(&depth, 6, "depth","Max depth of bounding trees"))
+    , d_parallelNarrowPhase(initData(&d_parallelNarrowPhase, false, "parallelNarrowPhase","Compute the intersections of the different pairs of models on several threads, if the narrow phase detection supports it"))
 {
 }
 
+void DefaultPipeline::init()
+{
+    PipelineImpl::init();
+
+    if (d_parallelNarrowPhase.getValue())
+        simulation::TaskScheduler::getInstance().start();
+}
+
 #ifdef SOFA_DUMP_VISITOR_INFO
 typedef simulation::Visitor::ctime_t ctime_t;
 #endif
@@ -165,7 +175,10 @@ void DefaultPipeline::doCollisionDetection(const sofa::helper::vector<core::Coll
     narrowPhaseDetection->beginNarrowPhase();
     sofa::helper::vector<std::pair<CollisionModel*, CollisionModel*> >& vectCMPair = broadPhaseDetection->getCollisionModelPairs();
     VERBOSE(sout << "DefaultPipeline::doCollisionDetection, "<< vectCMPair.size()<<" colliding model pairs"<<sendl);
-    narrowPhaseDetection->addCollisionPairs(vectCMPair);
+    if (d_parallelNarrowPhase.getValue() && vectCMPair.size() > 1 && narrowPhaseDetection->canAddCollisionPairsInParallel())
+        addCollisionPairsInParallel(vectCMPair);
+    else
+        narrowPhaseDetection->addCollisionPairs(vectCMPair);
     narrowPhaseDetection->endNarrowPhase();
     intersectionMethod->endNarrowPhase();
     sofa::helper::AdvancedTimer::stepEnd  ("NarrowPhase");
@@ -177,6 +190,46 @@ void DefaultPipeline::doCollisionDetection(const sofa::helper::vector<core::Coll
     sofa::helper::AdvancedTimer::stepEnd("doCollisionDetection");
 }
 
+namespace
+{
+
+/// Narrow phase of the pairs of models of each task
+class NarrowPhaseTaskFunctor
+{
+public:
+    NarrowPhaseTaskFunctor(NarrowPhaseDetection* detection,
+                           const helper::vector< helper::vector<NarrowPhaseDetection::ModelPair> >& taskPairs,
+                           helper::vector<NarrowPhaseDetection::TaskOutputs>& taskOutputs)
+        : detection(detection), taskPairs(taskPairs), taskOutputs(taskOutputs)
+    {
+    }
+
+    void operator()(std::size_t first, std::size_t last) const
+    {
+        for (std::size_t i=first; i<last; i++)
+            detection->addTaskCollisionPairs(taskPairs[i], taskOutputs[i]);
+    }
+
+protected:
+    NarrowPhaseDetection* detection;
+    const helper::vector< helper::vector<NarrowPhaseDetection::ModelPair> >& taskPairs;
+    helper::vector<NarrowPhaseDetection::TaskOutputs>& taskOutputs;
+};
+
+} // namespace
+
+void DefaultPipeline::addCollisionPairsInParallel(const sofa::helper::vector<NarrowPhaseDetection::ModelPair>& pairs)
+{
+    NarrowPhaseDetection::splitCollisionPairs(pairs, taskPairs);
+    narrowPhaseDetection->beginParallelCollisionPairs(pairs);
+    narrowPhaseDetection->prepareTaskOutputs(taskPairs, taskOutputs);
+
+    NarrowPhaseTaskFunctor functor(narrowPhaseDetection, taskPairs, taskOutputs);
+    simulation::parallelFor(0, taskPairs.size(), functor, 1);
+
+    narrowPhaseDetection->mergeTaskOutputs(taskOutputs);
+}
+
 void DefaultPipeline::doCollisionResponse()
 {
     core::objectmodel::BaseContext* scene = getContext();
@@ -27,6 +27,7 @@
 #include "config.h"
 
 #include <sofa/simulation/PipelineImpl.h>
+#include <sofa/core/collision/NarrowPhaseDetection.h>
 
 namespace sofa
 {
@@ -45,9 +46,19 @@ public:
     Data<bool> bVerbose;
     Data<bool> bDraw;
     Data<int> depth;
+    Data<bool> d_parallelNarrowPhase;
 protected:
     DefaultPipeline();
+
+    /// Pairs of models processed by each task of a parallel narrow phase, and their outputs
+    sofa::helper::vector< sofa::helper::vector<core::collision::NarrowPhaseDetection::ModelPair> > taskPairs;
+    sofa::helper::vector<core::collision::NarrowPhaseDetection::TaskOutputs> taskOutputs;
+
+    /// Split the pairs of models among tasks run on the TaskScheduler threads
+    void addCollisionPairsInParallel(const sofa::helper::vector<core::collision::NarrowPhaseDetection::ModelPair>& pairs);
 public:
+    void init();
+
     void draw(const core::visual::VisualParams* vparams);
 
     /// get the set of response available with the current collision pipeline
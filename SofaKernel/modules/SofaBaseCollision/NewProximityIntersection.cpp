@@ -55,6 +55,8 @@ int NewProximityIntersectionClass = core::RegisterObject("Optimized Proximity In
 NewProximityIntersection::NewProximityIntersection()
     : BaseProximityIntersection()
     , useLineLine(initData(&useLineLine, false, "useLineLine", "Line-line collision detection enabled"))
+    , d_vectorized(initData(&d_vectorized, false, "vectorized", "Reject the distant pairs of mesh elements by batches, with plain loops over their packed coordinates, before the exact proximity tests"))
+    , d_continuous(initData(&d_continuous, false, "continuous", "Continuous collision detection of the triangle, line and point models: the pairs of elements without contact at the current positions are swept to their free positions (or along their velocities without free motion), and a contact is created at the first time of impact of each vertex-face and edge-edge pair"))
 {
 }
 
@@ -50,6 +50,8 @@ public:
     SOFA_CLASS(NewProximityIntersection,BaseProximityIntersection);
 
     Data<bool> useLineLine;
+    Data<bool> d_vectorized; ///< reject the distant pairs of mesh elements by batches before the exact tests
+    Data<bool> d_continuous; ///< also detect the contacts of the mesh elements during their motion to their free positions
 protected:
     NewProximityIntersection();
 public:
@@ -58,6 +60,9 @@ public:
 
     virtual void init();
 
+    /// returns true if the mesh elements are tested along their motion during the step (Data continuous)
+    virtual bool useContinuous() const { return d_continuous.getValue(); }
+
     static inline int doIntersectionPointPoint(SReal dist2, const defaulttype::Vector3& p, const defaulttype::Vector3& q, OutputVector* contacts, int id);
 
 };
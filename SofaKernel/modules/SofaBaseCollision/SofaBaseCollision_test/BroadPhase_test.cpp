@@ -4,6 +4,7 @@
 typedef BroadPhaseTest<sofa::component::collision::BruteForceDetection> Brut;
 TEST_F(Brut, rand_sparse_test ) { ASSERT_TRUE( randSparse()); }
 TEST_F(Brut, rand_dense_test ) { ASSERT_TRUE( randDense()); }
+TEST_F(Brut, rand_parallel_test ) { ASSERT_TRUE( randParallel()); }
 
 typedef BroadPhaseTest<sofa::component::collision::IncrSAP> IncrSAPTest;
 TEST_F(IncrSAPTest, rand_sparse_test ) { ASSERT_TRUE( randSparse()); }
@@ -12,3 +13,28 @@ TEST_F(IncrSAPTest, rand_dense_test ) { ASSERT_TRUE( randDense()); }
 typedef BroadPhaseTest<sofa::component::collision::DirectSAP> DirectSAPTest;
 TEST_F(DirectSAPTest, rand_sparse_test ) { ASSERT_TRUE( randSparse()); }
 TEST_F(DirectSAPTest, rand_dense_test ) { ASSERT_TRUE( randDense()); }
+
+typedef BroadPhaseTest<sofa::component::collision::BVHDetection> BVHDetectionTest;
+TEST_F(BVHDetectionTest, rand_sparse_test ) { ASSERT_TRUE( randSparse()); }
+TEST_F(BVHDetectionTest, rand_dense_test ) { ASSERT_TRUE( randDense()); }
+TEST_F(BVHDetectionTest, rand_parallel_test ) { ASSERT_TRUE( randParallel()); }
+TEST_F(BVHDetectionTest, rand_nested_parallel_test ) { ASSERT_TRUE( randParallel(true)); }
+
+typedef BroadPhaseTest<sofa::component::collision::SpatialHashDetection> SpatialHashDetectionTest;
+TEST_F(SpatialHashDetectionTest, rand_sparse_test ) { ASSERT_TRUE( randSparse()); }
+TEST_F(SpatialHashDetectionTest, rand_dense_test ) { ASSERT_TRUE( randDense()); }
+TEST_F(SpatialHashDetectionTest, rand_parallel_test ) { ASSERT_TRUE( randParallel()); }
+TEST_F(SpatialHashDetectionTest, rand_nested_parallel_test ) { ASSERT_TRUE( randParallel(true)); }
+
+//a detection derived from BruteForceDetection, like CudaCollisionDetection, has to opt in to the parallel narrow phase itself
+class DerivedBruteForceDetection : public sofa::component::collision::BruteForceDetection{
+public:
+    SOFA_CLASS(DerivedBruteForceDetection, sofa::component::collision::BruteForceDetection);
+};
+
+TEST(ParallelNarrowPhase, opt_in_not_inherited){
+    EXPECT_TRUE(New<sofa::component::collision::BruteForceDetection>()->canAddCollisionPairsInParallel());
+    EXPECT_TRUE(New<sofa::component::collision::BVHDetection>()->canAddCollisionPairsInParallel());
+    EXPECT_TRUE(New<sofa::component::collision::SpatialHashDetection>()->canAddCollisionPairsInParallel());
+    EXPECT_FALSE(New<DerivedBruteForceDetection>()->canAddCollisionPairsInParallel());
+}
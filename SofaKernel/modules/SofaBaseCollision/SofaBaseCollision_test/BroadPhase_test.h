@@ -3,8 +3,12 @@
 
 #include <SofaGeneralMeshCollision/DirectSAP.h>
 #include <SofaGeneralMeshCollision/IncrSAP.h>
+#include <SofaGeneralMeshCollision/BVHDetection.h>
+#include <SofaBaseCollision/SpatialHashDetection.h>
 #include <sofa/component/typedef/Sofa_typedef.h>
 #include <SofaSimulationTree/GNode.h>
+#include <sofa/simulation/TaskScheduler.h>
+#include <sofa/simulation/ParallelFor.h>
 
 #include <gtest/gtest.h>
 
@@ -65,6 +69,11 @@ struct BroadPhaseTest: public ::testing::Test{
     static bool randTest3();
 
     static bool randTest(int seed,int nb1,int nb2,const Vector3 & min,const Vector3 & max);
+
+    //compares the outputs of the narrow phase done serially and split among tasks on several threads,
+    //nested runs the parallel detection with its own "parallel" data on, spawning tasks from within the tasks
+    static bool randParallel(bool nested = false);
+    static bool parallelTest(int seed,int nbModels,int nb,const Vector3 & min,const Vector3 & max,bool nested);
 };
 
 struct InitIntersection{
@@ -484,4 +493,123 @@ bool BroadPhaseTest<BroadPhase>::randSparse(){
     return true;
 }
 
+
+typedef std::vector< std::pair<sofa::core::collision::DetectionOutput::ContactId,std::pair<sofa::core::CollisionElementIterator,sofa::core::CollisionElementIterator> > > OrderedOutputs;
+
+//all the outputs of the detection, in its order
+template<class Detection>
+OrderedOutputs orderedOutputs(Detection & col_detection){
+    OrderedOutputs outputs;
+    const sofa::core::collision::NarrowPhaseDetection::DetectionOutputMap & outputsMap = col_detection.getDetectionOutputs();
+    for(sofa::core::collision::NarrowPhaseDetection::DetectionOutputMap::const_iterator it = outputsMap.begin() ; it != outputsMap.end() ; ++it){
+        sofa::helper::vector<sofa::core::collision::DetectionOutput> * res = dynamic_cast<sofa::helper::vector<sofa::core::collision::DetectionOutput> *>(it->second);
+        if(res != 0x0)
+            for(unsigned int i = 0 ; i < res->size() ; ++i)
+                outputs.push_back(std::make_pair((*res)[i].id,(*res)[i].elem));
+    }
+    return outputs;
+}
+
+template<class Detection>
+struct ParallelNarrowPhaseFunctor{
+    ParallelNarrowPhaseFunctor(Detection & col_detection,const sofa::helper::vector<sofa::helper::vector<sofa::core::collision::NarrowPhaseDetection::ModelPair> > & taskPairs,
+                               sofa::helper::vector<sofa::core::collision::NarrowPhaseDetection::TaskOutputs> & taskOutputs)
+        : col_detection(col_detection),taskPairs(taskPairs),taskOutputs(taskOutputs){}
+
+    void operator()(std::size_t first,std::size_t last)const{
+        for(std::size_t i = first ; i < last ; ++i)
+            col_detection.addTaskCollisionPairs(taskPairs[i],taskOutputs[i]);
+    }
+
+    Detection & col_detection;
+    const sofa::helper::vector<sofa::helper::vector<sofa::core::collision::NarrowPhaseDetection::ModelPair> > & taskPairs;
+    sofa::helper::vector<sofa::core::collision::NarrowPhaseDetection::TaskOutputs> & taskOutputs;
+};
+
+template<class Detection>
+void detect(const std::vector<sofa::core::CollisionModel*> & models,Detection & col_detection,bool parallel){
+    col_detection.setIntersectionMethod(proxIntersection.get());
+    col_detection.beginBroadPhase();
+    for(unsigned int i = 0 ; i < models.size() ; ++i)
+        col_detection.addCollisionModel(models[i]->getFirst());
+    col_detection.endBroadPhase();
+
+    col_detection.beginNarrowPhase();
+    if(!parallel){
+        col_detection.addCollisionPairs(col_detection.getCollisionModelPairs());
+    }
+    else{
+        sofa::helper::vector<sofa::helper::vector<sofa::core::collision::NarrowPhaseDetection::ModelPair> > taskPairs;
+        sofa::core::collision::NarrowPhaseDetection::splitCollisionPairs(col_detection.getCollisionModelPairs(),taskPairs);
+        sofa::helper::vector<sofa::core::collision::NarrowPhaseDetection::TaskOutputs> taskOutputs;
+
+        col_detection.beginParallelCollisionPairs(col_detection.getCollisionModelPairs());
+        col_detection.prepareTaskOutputs(taskPairs,taskOutputs);
+
+        sofa::simulation::parallelFor(0,taskPairs.size(),ParallelNarrowPhaseFunctor<Detection>(col_detection,taskPairs,taskOutputs),1);
+        col_detection.mergeTaskOutputs(taskOutputs);
+    }
+    col_detection.endNarrowPhase();
+}
+
+template <class BroadPhase>
+bool BroadPhaseTest<BroadPhase>::parallelTest(int seed,int nbModels,int nb,const Vector3 & min,const Vector3 & max,bool nested){
+    sofa::helper::srand(seed);
+
+    sofa::simulation::Node::SPtr scn = New<sofa::simulation::tree::GNode>();
+    std::vector<sofa::component::collision::OBBModel::SPtr> obbms;
+    std::vector<sofa::core::CollisionModel*> models;
+    for(int m = 0 ; m < nbModels ; ++m){
+        std::vector<Vector3> positions;
+        for(int i = 0 ; i < nb ; ++i)
+            positions.push_back(randVect(min,max));
+        obbms.push_back(makeOBBModel(positions,scn,getExtent()));
+        obbms.back()->setSelfCollision(true);
+        models.push_back(obbms.back().get());
+    }
+
+    typename BroadPhase::SPtr serial = New<BroadPhase>();
+    typename BroadPhase::SPtr parallel = New<BroadPhase>();
+    if(!parallel->canAddCollisionPairsInParallel())
+        return true;
+    if(nested){
+        sofa::core::objectmodel::BaseData * parallelData = parallel->findData("parallel");
+        if(parallelData == 0x0)
+            return true;
+        parallelData->read("true");
+    }
+
+    //several steps, the output vectors of the previous ones being reused
+    for(int step = 0 ; step < 3 ; ++step){
+        detect(models,*serial,false);
+        detect(models,*parallel,true);
+
+        OrderedOutputs serialOutputs = orderedOutputs(*serial);
+        OrderedOutputs parallelOutputs = orderedOutputs(*parallel);
+        if(serialOutputs.empty() || serialOutputs != parallelOutputs){
+            ADD_FAILURE() <<"step "<<step<<": "<<serialOutputs.size()<<" serial outputs, "<<parallelOutputs.size()<<" parallel outputs"<<std::endl;
+            return false;
+        }
+
+        for(int m = 0 ; m < nbModels ; ++m)
+            randMoving(obbms[m].get(),min,max);
+    }
+
+    return true;
+}
+
+template <class BroadPhase>
+bool BroadPhaseTest<BroadPhase>::randParallel(bool nested){
+    sofa::simulation::TaskScheduler::getInstance().start(4);
+    bool result = true;
+    for(int i = 0 ; i < 10 && result ; ++i){
+        if(!parallelTest(i,6,20,Vector3(-3,-3,-3),Vector3(3,3,3),nested)){
+            ADD_FAILURE() <<"FAIL seed number "<<i<< std::endl;
+            result = false;
+        }
+    }
+    sofa::simulation::TaskScheduler::getInstance().stop();
+    return result;
+}
+
 #endif
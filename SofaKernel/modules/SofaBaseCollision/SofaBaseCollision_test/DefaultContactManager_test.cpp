@@ -0,0 +1,131 @@
+#include <SofaTest/Sofa_test.h>
+#include <SofaSimulationGraph/DAGSimulation.h>
+#include <SofaSimulationCommon/SceneLoaderXML.h>
+#include <SofaBaseCollision/DefaultContactManager.h>
+#include <SofaBaseMechanics/MechanicalObject.h>
+#include <sofa/defaulttype/VecTypes.h>
+
+#include <sstream>
+
+namespace sofa {
+
+using sofa::simulation::Node;
+using sofa::simulation::SceneLoaderXML;
+using sofa::component::collision::DefaultContactManager;
+typedef sofa::component::container::MechanicalObject<defaulttype::Vec3dTypes> MechanicalObject3d;
+
+/// A sphere touching a triangle, moved away and back, to check the pool of inactive contacts
+struct DefaultContactManager_test : public Sofa_test<double>
+{
+    static const unsigned int s_poolMaxAge = 2;
+
+    Node::SPtr root;
+    DefaultContactManager* contactManager;
+    MechanicalObject3d* sphereState;
+
+    void SetUp()
+    {
+        sofa::simulation::setSimulation(new sofa::simulation::graph::DAGSimulation());
+
+        std::stringstream scene;
+        scene << "<?xml version='1.0'?>                                                          \n"
+                 "<Node name='Root' gravity='0 0 0' dt='0.01'>                                  \n"
+                 "  <DefaultPipeline/>                                                          \n"
+                 "  <BruteForceDetection/>                                                      \n"
+                 "  <NewProximityIntersection alarmDistance='0.2' contactDistance='0.1'/>       \n"
+                 "  <DefaultContactManager response='default' poolContacts='true' poolMaxAge='" << s_poolMaxAge << "'/> \n"
+                 "  <Node name='Triangle'>                                                      \n"
+                 "    <MeshTopology position='0 0 0  1 0 0  0 1 0' triangles='0 1 2'/>         \n"
+                 "    <MechanicalObject/>                                                       \n"
+                 "    <TriangleModel/>                                                          \n"
+                 "  </Node>                                                                     \n"
+                 "  <Node name='Sphere'>                                                        \n"
+                 "    <MechanicalObject position='0.25 0.25 0.5'/>                              \n"
+                 "    <SphereModel radius='0.55'/>                                              \n"
+                 "  </Node>                                                                     \n"
+                 "</Node>                                                                       \n";
+
+        root = SceneLoaderXML::loadFromMemory("testscene", scene.str().c_str(), scene.str().size());
+        ASSERT_NE(root.get(), nullptr);
+        sofa::simulation::getSimulation()->init(root.get());
+
+        contactManager = root->getTreeObject<DefaultContactManager>();
+        ASSERT_NE(contactManager, nullptr);
+        sphereState = root->getChild("Sphere")->get<MechanicalObject3d>();
+        ASSERT_NE(sphereState, nullptr);
+    }
+
+    void TearDown()
+    {
+        if (root)
+            sofa::simulation::getSimulation()->unload(root);
+    }
+
+    /// Move the sphere above the triangle, touching it or not, and run one step
+    void step(bool touching)
+    {
+        {
+            helper::WriteAccessor< Data<MechanicalObject3d::VecCoord> > x = sphereState->writePositions();
+            x[0] = defaulttype::Vec3d(0.25, 0.25, touching ? 0.5 : 5.0);
+        }
+        sofa::simulation::getSimulation()->animate(root.get(), 0.01);
+    }
+
+    /// Number of nodes in the scene, including the ones created by the contact responses
+    static unsigned int countNodes(Node* node)
+    {
+        unsigned int nb = 1;
+        for (Node::ChildIterator it = node->child.begin(); it != node->child.end(); ++it)
+            nb += countNodes(it->get());
+        return nb;
+    }
+
+    int nbPooled() const { return contactManager->d_nbPooledContacts.getValue(); }
+    int nbReused() const { return contactManager->d_nbReusedContacts.getValue(); }
+};
+
+TEST_F(DefaultContactManager_test, reuseAndFreePooledContact)
+{
+    const unsigned int nbNodesWithoutContact = countNodes(root.get());
+
+    // the pair appears
+    step(true);
+    ASSERT_EQ(contactManager->getContacts().size(), 1u);
+    core::collision::Contact* contact = contactManager->getContacts()[0].get();
+    const unsigned int nbNodesWithContact = countNodes(root.get());
+    EXPECT_GT(nbNodesWithContact, nbNodesWithoutContact);
+    EXPECT_EQ(nbPooled(), 0);
+    EXPECT_EQ(nbReused(), 0);
+
+    // it disappears: the contact is kept in the pool, with its response nodes
+    step(false);
+    EXPECT_EQ(contactManager->getContacts().size(), 0u);
+    EXPECT_EQ(nbPooled(), 1);
+    EXPECT_EQ(countNodes(root.get()), nbNodesWithContact);
+
+    // it reappears within the pool age: the same contact is reused, without new response nodes
+    step(true);
+    ASSERT_EQ(contactManager->getContacts().size(), 1u);
+    EXPECT_EQ(contactManager->getContacts()[0].get(), contact);
+    EXPECT_EQ(nbReused(), 1);
+    EXPECT_EQ(nbPooled(), 0);
+    EXPECT_EQ(countNodes(root.get()), nbNodesWithContact);
+
+    // it disappears for longer than the pool age: the pooled contact and its nodes are freed
+    for (unsigned int i = 0; i <= s_poolMaxAge; ++i)
+    {
+        step(false);
+        EXPECT_EQ(nbPooled(), 1) << "step " << i;
+    }
+    step(false);
+    EXPECT_EQ(nbPooled(), 0);
+    EXPECT_EQ(countNodes(root.get()), nbNodesWithoutContact);
+
+    // a new contact is then created
+    step(true);
+    ASSERT_EQ(contactManager->getContacts().size(), 1u);
+    EXPECT_EQ(nbReused(), 0);
+    EXPECT_EQ(countNodes(root.get()), nbNodesWithContact);
+}
+
+}// namespace sofa
@@ -0,0 +1,91 @@
+#include <SofaBaseCollision/SpatialHashDetection.h>
+#include <sofa/simulation/TaskScheduler.h>
+#include <sofa/helper/random.h>
+#include <gtest/gtest.h>
+#include <algorithm>
+
+using sofa::defaulttype::Vector3;
+using sofa::component::collision::SpatialHashGrid;
+
+namespace sofa{
+
+struct SpatialHashGridTest : public ::testing::Test{
+    typedef SpatialHashGrid::IndexPair IndexPair;
+
+    static void randBoxes(int nb,double maxSize,helper::vector<Vector3> & minBBox,helper::vector<Vector3> & maxBBox){
+        minBBox.resize(nb);
+        maxBBox.resize(nb);
+        for(int i = 0 ; i < nb ; ++i){
+            //a few boxes much larger than the cells
+            const double size = (i % 50 == 0) ? 8 * maxSize : helper::drandpos(maxSize);
+            for(int c = 0 ; c < 3 ; ++c){
+                minBBox[i][c] = helper::drand(5.0);
+                maxBBox[i][c] = minBBox[i][c] + size * helper::drand();
+            }
+        }
+    }
+
+    static bool overlap(const Vector3 & min0,const Vector3 & max0,const Vector3 & min1,const Vector3 & max1,double alarmDist){
+        for(int c = 0 ; c < 3 ; ++c)
+            if(min0[c] > max1[c] + alarmDist || min1[c] > max0[c] + alarmDist)
+                return false;
+        return true;
+    }
+
+    //pairs of a grid against another one (or itself) compared to the test of all the pairs of boxes
+    static bool compare(int seed,int nb1,int nb2,double maxSize,double cellSize,double alarmDist,bool parallel){
+        helper::srand(seed);
+        helper::vector<Vector3> min1,max1,min2,max2;
+        randBoxes(nb1,maxSize,min1,max1);
+        randBoxes(nb2,maxSize,min2,max2);
+
+        SpatialHashGrid grid1,grid2;
+        grid1.build(min1,max1,cellSize,alarmDist,parallel);
+        grid2.build(min2,max2,cellSize,alarmDist,parallel);
+
+        helper::vector<IndexPair> pairs,selfPairs,expected,expectedSelf;
+        grid1.collide(grid2,pairs,parallel);
+        grid1.selfCollide(selfPairs,parallel);
+
+        for(unsigned int i = 0 ; i < min1.size() ; ++i){
+            for(unsigned int j = 0 ; j < min2.size() ; ++j)
+                if(overlap(min1[i],max1[i],min2[j],max2[j],alarmDist))
+                    expected.push_back(IndexPair(i,j));
+            for(unsigned int j = i + 1 ; j < min1.size() ; ++j)
+                if(overlap(min1[i],max1[i],min1[j],max1[j],alarmDist))
+                    expectedSelf.push_back(IndexPair(i,j));
+        }
+
+        //each pair is reported once
+        std::sort(pairs.begin(),pairs.end());
+        std::sort(selfPairs.begin(),selfPairs.end());
+        if(pairs != expected || selfPairs != expectedSelf){
+            ADD_FAILURE() <<"seed "<<seed<<": "<<pairs.size()<<" pairs instead of "<<expected.size()<<", "
+                         <<selfPairs.size()<<" self pairs instead of "<<expectedSelf.size()<<std::endl;
+            return false;
+        }
+        return !grid1.getLargePrimitives().empty();
+    }
+
+    static bool randGrids(){
+        for(int i = 0 ; i < 20 ; ++i)
+            if(!compare(i,300,200,1.0,1.0,0.1,false) || !compare(i,300,200,1.0,0.3,0.0,false))
+                return false;
+        return true;
+    }
+
+    static bool randParallelGrids(){
+        sofa::simulation::TaskScheduler::getInstance().start(4);
+        bool result = true;
+        //enough entries to be sorted by several tasks
+        for(int i = 0 ; i < 5 && result ; ++i)
+            result = compare(i,3000,2000,0.3,0.15,0.05,true);
+        sofa::simulation::TaskScheduler::getInstance().stop();
+        return result;
+    }
+};
+
+TEST_F(SpatialHashGridTest, rand_grids_test ) { ASSERT_TRUE( randGrids()); }
+TEST_F(SpatialHashGridTest, rand_parallel_grids_test ) { ASSERT_TRUE( randParallelGrids()); }
+
+}
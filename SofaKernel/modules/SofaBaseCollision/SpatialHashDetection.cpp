@@ -0,0 +1,648 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2016 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This library is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This library is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this library; if not, write to the Free Software Foundation,     *
+* Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA.          *
+*******************************************************************************
+*                               SOFA :: Modules                               *
+*                                                                             *
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <SofaBaseCollision/SpatialHashDetection.h>
+#include <sofa/core/ObjectFactory.h>
+#include <sofa/helper/AdvancedTimer.h>
+#include <sofa/simulation/ParallelFor.h>
+#include <algorithm>
+#include <cmath>
+
+namespace sofa
+{
+
+namespace component
+{
+
+namespace collision
+{
+
+using defaulttype::Vector3;
+
+namespace
+{
+
+/// cell coordinates are stored on 21 bits in the keys
+const int CELL_COORD_BITS = 21;
+const int CELL_COORD_OFFSET = 1 << (CELL_COORD_BITS-1);
+
+/// number of boxes per task when computing the entries of a grid
+const std::size_t BOXES_PER_TASK = 1024;
+
+/// number of entries sorted by each task, before the sorted runs are merged
+const std::size_t ENTRIES_PER_SORT = 16384;
+
+/// number of pairs of cells per task when colliding grids
+const std::size_t CELLS_PER_TASK = 256;
+
+inline bool boxOverlap(const Vector3& min0, const Vector3& max0, const Vector3& min1, const Vector3& max1, double alarmDist)
+{
+    for (int c=0; c<3; c++)
+    {
+        if (min0[c] > max1[c] + alarmDist || min1[c] > max0[c] + alarmDist)
+            return false;
+    }
+    return true;
+}
+
+/// Range of entries of both grids in a cell
+struct CellPair
+{
+    SpatialHashGrid::Key key;
+    int begin1, end1, begin2, end2;
+};
+
+/// Number of cells covered by each box and lower cell of each box
+class CellCountFunctor
+{
+public:
+    CellCountFunctor(const SpatialHashGrid& grid, helper::vector<int>& minCell, helper::vector<int>& counts)
+        : grid(grid), minCell(minCell), counts(counts)
+    {
+    }
+
+    void operator()(std::size_t first, std::size_t last) const
+    {
+        int cmin[3], cmax[3];
+        for (std::size_t i=first; i<last; i++)
+        {
+            counts[i] = grid.cellRange((int)i, cmin, cmax);
+            for (int c=0; c<3; c++)
+                minCell[3*i+c] = cmin[c];
+        }
+    }
+
+protected:
+    const SpatialHashGrid& grid;
+    helper::vector<int>& minCell;
+    helper::vector<int>& counts;
+};
+
+/// Entries of each box, written from its offset
+class CellFillFunctor
+{
+public:
+    CellFillFunctor(const SpatialHashGrid& grid, const helper::vector<int>& offsets, helper::vector<SpatialHashGrid::Entry>& entries)
+        : grid(grid), offsets(offsets), entries(entries)
+    {
+    }
+
+    void operator()(std::size_t first, std::size_t last) const
+    {
+        int cmin[3], cmax[3], cell[3];
+        for (std::size_t i=first; i<last; i++)
+        {
+            int e = offsets[i];
+            if (e == offsets[i+1])
+                continue;
+            grid.cellRange((int)i, cmin, cmax);
+            for (cell[2]=cmin[2]; cell[2]<=cmax[2]; cell[2]++)
+                for (cell[1]=cmin[1]; cell[1]<=cmax[1]; cell[1]++)
+                    for (cell[0]=cmin[0]; cell[0]<=cmax[0]; cell[0]++)
+                    {
+                        entries[e].key = SpatialHashGrid::cellKey(cell);
+                        entries[e].index = (int)i;
+                        ++e;
+                    }
+        }
+    }
+
+protected:
+    const SpatialHashGrid& grid;
+    const helper::vector<int>& offsets;
+    helper::vector<SpatialHashGrid::Entry>& entries;
+};
+
+/// Sort runs of ENTRIES_PER_SORT entries
+class SortRunsFunctor
+{
+public:
+    SortRunsFunctor(helper::vector<SpatialHashGrid::Entry>& entries) : entries(entries) {}
+
+    void operator()(std::size_t first, std::size_t last) const
+    {
+        for (std::size_t i=first; i<last; i++)
+        {
+            const std::size_t begin = i*ENTRIES_PER_SORT;
+            const std::size_t end = std::min(begin+ENTRIES_PER_SORT, entries.size());
+            std::sort(entries.begin()+begin, entries.begin()+end);
+        }
+    }
+
+protected:
+    helper::vector<SpatialHashGrid::Entry>& entries;
+};
+
+/// Merge pairs of consecutive sorted runs of the given width
+class MergeRunsFunctor
+{
+public:
+    MergeRunsFunctor(helper::vector<SpatialHashGrid::Entry>& entries, std::size_t width) : entries(entries), width(width) {}
+
+    void operator()(std::size_t first, std::size_t last) const
+    {
+        for (std::size_t i=first; i<last; i++)
+        {
+            const std::size_t begin = 2*i*width;
+            const std::size_t middle = std::min(begin+width, entries.size());
+            const std::size_t end = std::min(begin+2*width, entries.size());
+            if (middle < end)
+                std::inplace_merge(entries.begin()+begin, entries.begin()+middle, entries.begin()+end);
+        }
+    }
+
+protected:
+    helper::vector<SpatialHashGrid::Entry>& entries;
+    const std::size_t width;
+};
+
+void sortEntries(helper::vector<SpatialHashGrid::Entry>& entries, bool parallel)
+{
+    const std::size_t n = entries.size();
+    if (!parallel || n <= ENTRIES_PER_SORT)
+    {
+        std::sort(entries.begin(), entries.end());
+        return;
+    }
+
+    simulation::parallelFor(0, (n + ENTRIES_PER_SORT - 1) / ENTRIES_PER_SORT, SortRunsFunctor(entries), 1);
+    for (std::size_t width=ENTRIES_PER_SORT; width<n; width*=2)
+        simulation::parallelFor(0, (n + 2*width - 1) / (2*width), MergeRunsFunctor(entries, width), 1);
+}
+
+/// Collision of a list of pairs of cells, each task writing its own output
+class CellCollisionFunctor
+{
+public:
+    CellCollisionFunctor(const SpatialHashGrid& grid1, const SpatialHashGrid& grid2, bool self,
+                         const helper::vector<CellPair>& cells, helper::vector< helper::vector<SpatialHashGrid::IndexPair> >& results)
+        : grid1(grid1), grid2(grid2), self(self), cells(cells), results(results)
+    {
+    }
+
+    void operator()(std::size_t first, std::size_t last) const
+    {
+        helper::vector<SpatialHashGrid::IndexPair>& pairs = results[first / CELLS_PER_TASK];
+        for (std::size_t i=first; i<last; i++)
+            grid1.collideCell(grid2, self, cells[i].key, cells[i].begin1, cells[i].end1, cells[i].begin2, cells[i].end2, pairs);
+    }
+
+protected:
+    const SpatialHashGrid& grid1;
+    const SpatialHashGrid& grid2;
+    const bool self;
+    const helper::vector<CellPair>& cells;
+    helper::vector< helper::vector<SpatialHashGrid::IndexPair> >& results;
+};
+
+} // namespace
+
+
+SpatialHashGrid::SpatialHashGrid()
+    : cellSize(0)
+    , alarmDist(0)
+{
+}
+
+int SpatialHashGrid::cellCoord(double x) const
+{
+    const double c = std::floor(x / cellSize);
+    if (!(c >= -CELL_COORD_OFFSET))
+        return -CELL_COORD_OFFSET;
+    if (c > CELL_COORD_OFFSET-1)
+        return CELL_COORD_OFFSET-1;
+    return (int)c;
+}
+
+SpatialHashGrid::Key SpatialHashGrid::cellKey(const int cell[3])
+{
+    return  (Key)(cell[0] + CELL_COORD_OFFSET)
+         | ((Key)(cell[1] + CELL_COORD_OFFSET) << CELL_COORD_BITS)
+         | ((Key)(cell[2] + CELL_COORD_OFFSET) << (2*CELL_COORD_BITS));
+}
+
+int SpatialHashGrid::cellRange(int i, int cmin[3], int cmax[3]) const
+{
+    // boxes grown by half the alarm distance overlap if the boxes are closer than the alarm distance
+    const double margin = 0.5 * alarmDist;
+    long long count = 1;
+    for (int c=0; c<3; c++)
+    {
+        cmin[c] = cellCoord(primMin[i][c] - margin);
+        cmax[c] = std::max(cmin[c], cellCoord(primMax[i][c] + margin));
+        count *= (long long)(cmax[c] - cmin[c] + 1);
+    }
+    return count > MaxCellsPerBox ? MaxCellsPerBox+1 : (int)count;
+}
+
+void SpatialHashGrid::build(const helper::vector<Vector3>& minBBox, const helper::vector<Vector3>& maxBBox, double cellSize, double alarmDist, bool parallel)
+{
+    const int n = (int)minBBox.size();
+    primMin = minBBox;
+    primMax = maxBBox;
+    this->cellSize = cellSize;
+    this->alarmDist = alarmDist;
+
+    minCell.resize(3*n);
+    helper::vector<int> counts(n);
+    const CellCountFunctor countFunctor(*this, minCell, counts);
+    if (parallel)
+        simulation::parallelFor(0, n, countFunctor, BOXES_PER_TASK);
+    else
+        countFunctor(0, n);
+
+    helper::vector<int> offsets(n+1);
+    large.clear();
+    isLarge.assign(n, false);
+    offsets[0] = 0;
+    for (int i=0; i<n; i++)
+    {
+        if (counts[i] > MaxCellsPerBox)
+        {
+            large.push_back(i);
+            isLarge[i] = true;
+            counts[i] = 0;
+        }
+        offsets[i+1] = offsets[i] + counts[i];
+    }
+
+    entries.resize(offsets[n]);
+    const CellFillFunctor fillFunctor(*this, offsets, entries);
+    if (parallel)
+        simulation::parallelFor(0, n, fillFunctor, BOXES_PER_TASK);
+    else
+        fillFunctor(0, n);
+
+    sortEntries(entries, parallel);
+}
+
+void SpatialHashGrid::collideCell(const SpatialHashGrid& other, bool self, Key key, int begin1, int end1, int begin2, int end2, helper::vector<IndexPair>& pairs) const
+{
+    for (int i=begin1; i<end1; i++)
+    {
+        const int p = entries[i].index;
+        // in a self cell, entries are sorted by primitive, so p<q
+        for (int j=(self ? i+1 : begin2); j<end2; j++)
+        {
+            const int q = other.entries[j].index;
+
+            // only reported in the lower cell of the intersection of the grown boxes
+            int cell[3];
+            for (int c=0; c<3; c++)
+                cell[c] = std::max(minCell[3*p+c], other.minCell[3*q+c]);
+            if (cellKey(cell) != key)
+                continue;
+
+            if (boxOverlap(primMin[p], primMax[p], other.primMin[q], other.primMax[q], alarmDist))
+                pairs.push_back(std::make_pair(p, q));
+        }
+    }
+}
+
+void SpatialHashGrid::collideLarge(const SpatialHashGrid& other, bool self, helper::vector<IndexPair>& pairs) const
+{
+    // large primitives of this grid against all the primitives of the other one
+    for (unsigned int i=0; i<large.size(); i++)
+    {
+        const int p = large[i];
+        for (int q=0; q<other.size(); q++)
+        {
+            if (self && (q == p || (isLarge[q] && q < p)))
+                continue;
+            if (boxOverlap(primMin[p], primMax[p], other.primMin[q], other.primMax[q], alarmDist))
+                pairs.push_back(self && q < p ? std::make_pair(q, p) : std::make_pair(p, q));
+        }
+    }
+
+    if (self)
+        return;
+
+    // large primitives of the other grid against the ones of this grid in the cells
+    for (unsigned int j=0; j<other.large.size(); j++)
+    {
+        const int q = other.large[j];
+        for (int p=0; p<size(); p++)
+        {
+            if (isLarge[p])
+                continue;
+            if (boxOverlap(primMin[p], primMax[p], other.primMin[q], other.primMax[q], alarmDist))
+                pairs.push_back(std::make_pair(p, q));
+        }
+    }
+}
+
+void SpatialHashGrid::traverse(const SpatialHashGrid& other, bool self, helper::vector<IndexPair>& pairs, bool parallel) const
+{
+    // cells holding entries of both grids, found by merging the sorted entries
+    helper::vector<CellPair> cells;
+    const int n1 = (int)entries.size();
+    const int n2 = (int)other.entries.size();
+    int i = 0, j = 0;
+    while (i < n1 && j < n2)
+    {
+        const Key key1 = entries[i].key;
+        const Key key2 = other.entries[j].key;
+        if (key1 < key2 && !self) { ++i; continue; }
+        if (key2 < key1 && !self) { ++j; continue; }
+
+        CellPair cell;
+        cell.key = key1;
+        cell.begin1 = i;
+        while (i < n1 && entries[i].key == key1) ++i;
+        cell.end1 = i;
+        if (self)
+        {
+            cell.begin2 = cell.begin1;
+            cell.end2 = cell.end1;
+            if (cell.end1 - cell.begin1 < 2)
+                continue;
+        }
+        else
+        {
+            cell.begin2 = j;
+            while (j < n2 && other.entries[j].key == key1) ++j;
+            cell.end2 = j;
+        }
+        cells.push_back(cell);
+    }
+
+    if (parallel && cells.size() > CELLS_PER_TASK)
+    {
+        helper::vector< helper::vector<IndexPair> > results((cells.size() + CELLS_PER_TASK - 1) / CELLS_PER_TASK);
+        simulation::parallelFor(0, cells.size(), CellCollisionFunctor(*this, other, self, cells, results), CELLS_PER_TASK);
+
+        // gathered in the order of the cells, whatever the thread which processed them
+        for (unsigned int r=0; r<results.size(); r++)
+            pairs.insert(pairs.end(), results[r].begin(), results[r].end());
+    }
+    else
+    {
+        for (unsigned int c=0; c<cells.size(); c++)
+            collideCell(other, self, cells[c].key, cells[c].begin1, cells[c].end1, cells[c].begin2, cells[c].end2, pairs);
+    }
+
+    collideLarge(other, self, pairs);
+}
+
+void SpatialHashGrid::collide(const SpatialHashGrid& other, helper::vector<IndexPair>& pairs, bool parallel) const
+{
+    traverse(other, false, pairs, parallel);
+}
+
+void SpatialHashGrid::selfCollide(helper::vector<IndexPair>& pairs, bool parallel) const
+{
+    traverse(*this, true, pairs, parallel);
+}
+
+
+SOFA_DECL_CLASS(SpatialHashDetection)
+
+int SpatialHashDetectionClass = core::RegisterObject("Collision detection using a uniform grid, stored as sorted cell keys, per collision model")
+        .add< SpatialHashDetection >()
+        ;
+
+SpatialHashDetection::SpatialHashDetection()
+    : d_cellSize(initData(&d_cellSize, 0.0, "cellSize", "Size of the cells of the grids, or 0 to compute it from the mean size of the elements"))
+    , d_cellSizeFactor(initData(&d_cellSizeFactor, 1.0, "cellSizeFactor", "Automatic cell size, as a ratio of the mean size of the elements, the alarm distance being added to it"))
+    , d_parallel(initData(&d_parallel, false, "parallel", "Build and collide the grids on several threads"))
+    , d_currentCellSize(initData(&d_currentCellSize, 0.0, "currentCellSize", "OUTPUT: cell size used during the last step"))
+    , d_nbUpdatedGrids(initData(&d_nbUpdatedGrids, 0, "nbUpdatedGrids", "OUTPUT: number of grids rebuilt during the last step, the ones of the models neither moving nor simulated being kept"))
+    , step(0)
+    , cellSize(0)
+{
+    d_currentCellSize.setReadOnly(true);
+    d_currentCellSize.setGroup("Stats");
+    d_nbUpdatedGrids.setReadOnly(true);
+    d_nbUpdatedGrids.setGroup("Stats");
+}
+
+SpatialHashDetection::~SpatialHashDetection()
+{
+}
+
+void SpatialHashDetection::init()
+{
+    BruteForceDetection::init();
+
+    if (d_parallel.getValue())
+        simulation::TaskScheduler::getInstance().start();
+}
+
+void SpatialHashDetection::reinit()
+{
+    BruteForceDetection::reinit();
+    grids.clear();
+    cellSize = 0;
+}
+
+void SpatialHashDetection::beginBroadPhase()
+{
+    BruteForceDetection::beginBroadPhase();
+    hashedModels.clear();
+}
+
+void SpatialHashDetection::addCollisionModel(core::CollisionModel *cm)
+{
+    BruteForceDetection::addCollisionModel(cm);
+    if (!cm->empty())
+        hashedModels.push_back(cm->getLast());
+}
+
+void SpatialHashDetection::endBroadPhase()
+{
+    BruteForceDetection::endBroadPhase();
+
+    if (d_cellSize.getValue() > 0)
+        cellSize = d_cellSize.getValue();
+    else
+    {
+        // only follow the element sizes by large changes, so that the grids of the static models are kept
+        const double s = computeCellSize(hashedModels);
+        if (s > 0 && (cellSize <= 0 || s > 2*cellSize || 2*s < cellSize))
+            cellSize = s;
+    }
+    d_currentCellSize.setValue(cellSize);
+}
+
+void SpatialHashDetection::beginNarrowPhase()
+{
+    BruteForceDetection::beginNarrowPhase();
+    ++step;
+    d_nbUpdatedGrids.setValue(0);
+}
+
+CubeModel* SpatialHashDetection::getElementCubes(core::CollisionModel* finalcm)
+{
+    CubeModel* cubes = dynamic_cast<CubeModel*>(finalcm->getPrevious());
+    if (cubes == NULL || cubes->getPrevious() == NULL || cubes->getSize() != finalcm->getSize())
+        return NULL;
+    return cubes;
+}
+
+double SpatialHashDetection::computeCellSize(const helper::vector<core::CollisionModel*>& models) const
+{
+    double sumSize = 0;
+    int count = 0;
+    Vector3 minBox, maxBox;
+    for (unsigned int m=0; m<models.size(); m++)
+    {
+        const CubeModel* cubes = getElementCubes(models[m]);
+        if (cubes == NULL)
+            continue;
+        for (int i=0; i<cubes->getSize(); i++)
+        {
+            const CubeModel::CubeData& c = cubes->getCubeData(i);
+            const Vector3 d = c.maxBBox - c.minBBox;
+            sumSize += std::max(d[0], std::max(d[1], d[2]));
+            if (count++ == 0)
+            {
+                minBox = c.minBBox;
+                maxBox = c.maxBBox;
+            }
+            for (int k=0; k<3; k++)
+            {
+                minBox[k] = std::min(minBox[k], c.minBBox[k]);
+                maxBox[k] = std::max(maxBox[k], c.maxBBox[k]);
+            }
+        }
+    }
+    if (count == 0)
+        return 0;
+
+    const double alarmDist = intersectionMethod->getAlarmDistance();
+    double s = d_cellSizeFactor.getValue() * sumSize / count + alarmDist;
+    if (!(s > 0))
+    {
+        // points without proximity: as many cells as elements in the bounding box of the scene
+        const Vector3 d = maxBox - minBox;
+        s = std::max(d[0], std::max(d[1], d[2])) / std::pow((double)count, 1.0/3.0);
+    }
+    return s > 0 ? s : 1.0;
+}
+
+SpatialHashGrid* SpatialHashDetection::getGrid(core::CollisionModel* finalcm)
+{
+    CubeModel* cubes = getElementCubes(finalcm);
+    if (cubes == NULL)
+        return NULL;
+
+    std::map<core::CollisionModel*, ModelGrid>::iterator it = grids.find(finalcm);
+    if (it != grids.end() && it->second.step == step)
+        return &it->second.grid;
+
+    if (cellSize <= 0)
+    {
+        // the broad phase did not see the model
+        cellSize = computeCellSize(helper::vector<core::CollisionModel*>(1, finalcm));
+        d_currentCellSize.setValue(cellSize);
+    }
+
+    ModelGrid& g = grids[finalcm];
+    g.step = step;
+    const int n = cubes->getSize();
+    const double alarmDist = intersectionMethod->getAlarmDistance();
+    const bool isStatic = !finalcm->isMoving() && !finalcm->isSimulated();
+    if (isStatic && g.grid.size() == n && g.grid.getCellSize() == cellSize && g.grid.getAlarmDistance() == alarmDist)
+        return &g.grid;
+
+    minBBox.resize(n);
+    maxBBox.resize(n);
+    for (int i=0; i<n; i++)
+    {
+        const CubeModel::CubeData& c = cubes->getCubeData(i);
+        minBBox[i] = c.minBBox;
+        maxBBox[i] = c.maxBBox;
+    }
+    g.grid.build(minBBox, maxBBox, cellSize, alarmDist, d_parallel.getValue());
+    d_nbUpdatedGrids.setValue(d_nbUpdatedGrids.getValue() + 1);
+    return &g.grid;
+}
+
+void SpatialHashDetection::beginParallelCollisionPairs(const sofa::helper::vector<ModelPair>& v)
+{
+    BruteForceDetection::beginParallelCollisionPairs(v);
+
+    for (sofa::helper::vector<ModelPair>::const_iterator it = v.begin(); it != v.end(); ++it)
+    {
+        getGrid(it->first->getLast());
+        getGrid(it->second->getLast());
+    }
+}
+
+void SpatialHashDetection::addCollisionPair(const std::pair<core::CollisionModel*, core::CollisionModel*>& cmPair)
+{
+    sofa::helper::AdvancedTimer::StepVar hashTimer("SpatialHashDetection::addCollisionPair");
+
+    core::CollisionModel *cm1 = cmPair.first;
+    core::CollisionModel *cm2 = cmPair.second;
+
+    if (!cm1->isSimulated() && !cm2->isSimulated())
+        return;
+
+    if (cm1->empty() || cm2->empty())
+        return;
+
+    core::CollisionModel *finalcm1 = cm1->getLast();
+    core::CollisionModel *finalcm2 = cm2->getLast();
+
+    SpatialHashGrid* grid1 = getGrid(finalcm1);
+    SpatialHashGrid* grid2 = getGrid(finalcm2);
+    if (grid1 == NULL || grid2 == NULL)
+    {
+        // no cube per element to build the grids on
+        BruteForceDetection::addCollisionPair(cmPair);
+        return;
+    }
+
+    bool swapModels = false;
+    core::collision::ElementIntersector* finalintersector = intersectionMethod->findIntersector(finalcm1, finalcm2, swapModels);
+    if (finalintersector == NULL)
+        return;
+    if (swapModels)
+    {
+        std::swap(finalcm1, finalcm2);
+        std::swap(grid1, grid2);
+    }
+
+    sofa::core::collision::DetectionOutputVector*& outputs = this->getDetectionOutputs(finalcm1, finalcm2);
+
+    finalintersector->beginIntersect(finalcm1, finalcm2, outputs);//creates outputs if null
+
+    helper::vector<IndexPair> pairs;
+    {
+        sofa::helper::AdvancedTimer::StepVar gridTimer("SpatialHashDetection::grids");
+        if (grid1 == grid2)
+            grid1->selfCollide(pairs, d_parallel.getValue());
+        else
+            grid1->collide(*grid2, pairs, d_parallel.getValue());
+    }
+
+    intersectCubePairs(finalintersector, finalcm1, finalcm2, pairs, outputs);
+}
+
+} // namespace collision
+
+} // namespace component
+
+} // namespace sofa
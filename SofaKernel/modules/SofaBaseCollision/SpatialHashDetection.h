@@ -0,0 +1,207 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2016 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This library is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This library is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this library; if not, write to the Free Software Foundation,     *
+* Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA.          *
+*******************************************************************************
+*                               SOFA :: Modules                               *
+*                                                                             *
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#ifndef SOFA_COMPONENT_COLLISION_SPATIALHASHDETECTION_H
+#define SOFA_COMPONENT_COLLISION_SPATIALHASHDETECTION_H
+#include "config.h"
+
+#include <SofaBaseCollision/BruteForceDetection.h>
+#include <sofa/defaulttype/Vec.h>
+#include <sofa/helper/vector.h>
+#include <map>
+
+
+namespace sofa
+{
+
+namespace component
+{
+
+namespace collision
+{
+
+/**
+  *Uniform grid over a set of primitives given by their boxes.
+  *
+  *Each box, grown by half the alarm distance, is inserted in all the cells it
+  *overlaps. The grid is stored as the list of (cell, primitive) entries sorted
+  *by cell key, so two grids are collided by merging their lists, and the
+  *entries of all the primitives can be computed and sorted in parallel.
+  *
+  *A pair of primitives sharing several cells is only reported in the first
+  *one, i.e. the cell of the lower corner of the intersection of their grown
+  *boxes, so no pair needs to be removed afterwards. Boxes covering more than
+  *MaxCellsPerBox cells are kept out of the grid and tested against all the
+  *primitives of the other grid.
+  */
+class SOFA_BASE_COLLISION_API SpatialHashGrid
+{
+public:
+    typedef defaulttype::Vector3 Vector3;
+    typedef std::pair<int,int> IndexPair;
+    typedef unsigned long long Key;
+
+    enum { MaxCellsPerBox = 64 };
+
+    struct Entry
+    {
+        Key key;
+        int index;
+        bool operator<(const Entry& e) const { return key < e.key || (key == e.key && index < e.index); }
+    };
+
+    SpatialHashGrid();
+
+    /// Insert the boxes in the cells of the given size. If parallel is set, the entries are computed and sorted by the threads of the TaskScheduler.
+    void build(const helper::vector<Vector3>& minBBox, const helper::vector<Vector3>& maxBBox, double cellSize, double alarmDist, bool parallel = false);
+
+    /// Pairs (i,j) of primitives of this grid and of the other one whose boxes are closer than alarmDist along each axis.
+    /// Both grids must have been built with the same cell size and alarm distance.
+    void collide(const SpatialHashGrid& other, helper::vector<IndexPair>& pairs, bool parallel = false) const;
+
+    /// Pairs (i,j), i<j, of primitives of this grid whose boxes are closer than alarmDist along each axis
+    void selfCollide(helper::vector<IndexPair>& pairs, bool parallel = false) const;
+
+    int size() const { return (int)primMin.size(); }
+
+    double getCellSize() const { return cellSize; }
+    double getAlarmDistance() const { return alarmDist; }
+
+    const helper::vector<Entry>& getEntries() const { return entries; }
+
+    /// Primitives kept out of the grid because they cover too many cells
+    const helper::vector<int>& getLargePrimitives() const { return large; }
+
+    /// Append the pairs of primitives of this grid and the other one found in the cell key, from the entries [begin1,end1) and [begin2,end2)
+    void collideCell(const SpatialHashGrid& other, bool self, Key key, int begin1, int end1, int begin2, int end2, helper::vector<IndexPair>& pairs) const;
+
+    /// Append the pairs of the primitives of this grid which are not in its cells
+    void collideLarge(const SpatialHashGrid& other, bool self, helper::vector<IndexPair>& pairs) const;
+
+    /// Cell range [cmin,cmax] covered by the box i, return the number of cells
+    int cellRange(int i, int cmin[3], int cmax[3]) const;
+
+    static Key cellKey(const int cell[3]);
+
+protected:
+    helper::vector<Vector3> primMin, primMax;
+    helper::vector<int> minCell;   ///< lower cell of each box, 3 per box
+    helper::vector<Entry> entries; ///< sorted by key, then by primitive
+    helper::vector<int> large;
+    helper::vector<bool> isLarge;
+    double cellSize;
+    double alarmDist;
+
+    void traverse(const SpatialHashGrid& other, bool self, helper::vector<IndexPair>& pairs, bool parallel) const;
+
+    int cellCoord(double x) const;
+};
+
+/**
+  *Collision detection using a uniform grid per collision model.
+  *
+  *The broad phase between the models is the one of BruteForceDetection. For
+  *each pair of models, the narrow phase collides the grids of their elements
+  *instead of traversing their CubeModel hierarchies, which makes it linear in
+  *the number of elements when they are evenly sized. All the grids share the
+  *same cell size, by default computed from the mean size of the elements of
+  *the models of the scene.
+  *
+  *The grids of the models that are neither moving nor simulated are kept
+  *across steps, the others are rebuilt at each step, in parallel if requested.
+  *The candidate pairs of elements are finally tested in a fixed order, so that
+  *the contacts do not depend on the number of threads.
+  */
+class SOFA_BASE_COLLISION_API SpatialHashDetection : public BruteForceDetection
+{
+public:
+    SOFA_CLASS(SpatialHashDetection, BruteForceDetection);
+
+    typedef SpatialHashGrid::IndexPair IndexPair;
+
+    Data<double> d_cellSize;
+    Data<double> d_cellSizeFactor;
+    Data<bool> d_parallel;
+    Data<double> d_currentCellSize;
+    Data<int> d_nbUpdatedGrids;
+
+protected:
+    SpatialHashDetection();
+
+    ~SpatialHashDetection();
+
+    struct ModelGrid
+    {
+        ModelGrid() : step(-1) {}
+        SpatialHashGrid grid;
+        int step; ///< last step the grid was updated
+    };
+
+    std::map<core::CollisionModel*, ModelGrid> grids;
+    helper::vector<core::CollisionModel*> hashedModels; ///< final models added during the broad phase
+    int step;
+    double cellSize;
+    helper::vector<SpatialHashGrid::Vector3> minBBox, maxBBox;
+
+    /// The cube per element computed by the model for a bounding tree of depth 0, or NULL
+    static CubeModel* getElementCubes(core::CollisionModel* finalcm);
+
+    /// Cell size from the Data, or from the mean size of the elements of the given models
+    double computeCellSize(const helper::vector<core::CollisionModel*>& models) const;
+
+    /// Grid over the elements of the given final model, updated once per step.
+    /// Only looked up if it is already updated, so it can be called from several threads after beginParallelCollisionPairs.
+    SpatialHashGrid* getGrid(core::CollisionModel* finalcm);
+
+public:
+
+    void init();
+    void reinit();
+
+    virtual void beginBroadPhase();
+
+    void addCollisionModel (core::CollisionModel *cm);
+
+    virtual void endBroadPhase();
+
+    virtual void beginNarrowPhase();
+
+    void addCollisionPair (const std::pair<core::CollisionModel*, core::CollisionModel*>& cmPair);
+
+    /// Update the grids of the models of the pairs, before they are processed in parallel
+    virtual void beginParallelCollisionPairs(const sofa::helper::vector<ModelPair>& v);
+
+    /// addCollisionPair only reads the grids updated by beginParallelCollisionPairs
+    virtual bool canAddCollisionPairsInParallel() const { return true; }
+
+    inline virtual bool needsDeepBoundingTree()const{return false;}
+};
+
+} // namespace collision
+
+} // namespace component
+
+} // namespace sofa
+
+#endif
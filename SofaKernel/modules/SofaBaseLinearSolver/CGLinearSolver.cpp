@@ -27,6 +27,7 @@
 #include <SofaBaseLinearSolver/CGLinearSolver.inl>
 
 #include <sofa/core/ObjectFactory.h>
+#include <sofa/simulation/ParallelFor.h>
 #include <iostream>
 
 namespace sofa
@@ -67,6 +68,130 @@ inline void CGLinearSolver<component::linearsolver::GraphScatteredMatrix,compone
 #endif
 }
 
+namespace
+{
+
+typedef helper::vector<core::behavior::BaseMechanicalState*> MechanicalStates;
+
+/// Gather the independent mechanical states, i.e. the ones MechanicalVMultiOpVisitor and MechanicalVDotVisitor work on
+class CollectMechanicalStatesVisitor : public simulation::BaseMechanicalVisitor
+{
+public:
+    MechanicalStates& states;
+
+    CollectMechanicalStatesVisitor(const core::ExecParams* params, MechanicalStates& states)
+        : simulation::BaseMechanicalVisitor(params), states(states)
+    {
+    }
+
+    virtual Result fwdMechanicalState(VisitorContext* /*ctx*/, core::behavior::BaseMechanicalState* mm)
+    {
+        states.push_back(mm);
+        return RESULT_CONTINUE;
+    }
+
+    virtual const char* getClassName() const { return "CollectMechanicalStatesVisitor"; }
+};
+
+/// Apply the same VMultiOp to a range of mechanical states
+class StatesVMultiOp
+{
+public:
+    const core::ExecParams* params;
+    const MechanicalStates& states;
+    const core::behavior::BaseMechanicalState::VMultiOp& ops;
+
+    StatesVMultiOp(const core::ExecParams* params, const MechanicalStates& states, const core::behavior::BaseMechanicalState::VMultiOp& ops)
+        : params(params), states(states), ops(ops)
+    {
+    }
+
+    void operator()(std::size_t first, std::size_t last) const
+    {
+        for (std::size_t i = first; i < last; ++i)
+            states[i]->vMultiOp(params, ops);
+    }
+};
+
+/// Compute (r.r, w.r) over a range of mechanical states
+class StatesVDot2
+{
+public:
+    const core::ExecParams* params;
+    const MechanicalStates& states;
+    core::ConstMultiVecDerivId r, w;
+
+    StatesVDot2(const core::ExecParams* params, const MechanicalStates& states, core::ConstMultiVecDerivId r, core::ConstMultiVecDerivId w)
+        : params(params), states(states), r(r), w(w)
+    {
+    }
+
+    Vec<2,SReal> operator()(std::size_t first, std::size_t last) const
+    {
+        Vec<2,SReal> d;
+        for (std::size_t i = first; i < last; ++i)
+        {
+            core::behavior::BaseMechanicalState* mm = states[i];
+            d[0] += mm->vDot(params, r.getId(mm), r.getId(mm));
+            d[1] += mm->vDot(params, w.getId(mm), r.getId(mm));
+        }
+        return d;
+    }
+};
+
+class SumVec2
+{
+public:
+    Vec<2,SReal> operator()(const Vec<2,SReal>& a, const Vec<2,SReal>& b) const { return a + b; }
+};
+
+/// Number of mechanical states per task in the dot products. It is fixed so that
+/// the sums are the same whatever the number of threads.
+enum { DOT_GRAIN_SIZE = 4 };
+
+} // namespace
+
+/// The independent mechanical states are gathered once per solve. The vector
+/// operations of the iterations are then applied to them directly, without
+/// traversing the graph, and spread over the TaskScheduler threads when it is running.
+template<> SOFA_BASE_LINEAR_SOLVER_API
+inline void CGLinearSolver<component::linearsolver::GraphScatteredMatrix,component::linearsolver::GraphScatteredVector>::cgbegin_pipelined(const core::ExecParams* params)
+{
+    pipelinedStates.clear();
+    this->executeVisitor(CollectMechanicalStatesVisitor(params, pipelinedStates));
+}
+
+template<> SOFA_BASE_LINEAR_SOLVER_API
+inline void CGLinearSolver<component::linearsolver::GraphScatteredMatrix,component::linearsolver::GraphScatteredVector>::cgstep_pipelined(const core::ExecParams* params, Vector& x, Vector& r, Vector& p, Vector& s, Vector& w, SReal alpha, SReal beta)
+{
+    // p = p*beta + r, s = s*beta + w, x = x + alpha p, r = r - alpha s, in a single pass
+    typedef sofa::core::behavior::BaseMechanicalState::VMultiOp VMultiOp;
+    VMultiOp ops;
+    ops.resize(4);
+    ops[0].first = (MultiVecDerivId)p;
+    ops[0].second.push_back(std::make_pair((MultiVecDerivId)p,beta));
+    ops[0].second.push_back(std::make_pair((MultiVecDerivId)r,1.0));
+    ops[1].first = (MultiVecDerivId)s;
+    ops[1].second.push_back(std::make_pair((MultiVecDerivId)s,beta));
+    ops[1].second.push_back(std::make_pair((MultiVecDerivId)w,1.0));
+    ops[2].first = (MultiVecDerivId)x;
+    ops[2].second.push_back(std::make_pair((MultiVecDerivId)x,1.0));
+    ops[2].second.push_back(std::make_pair((MultiVecDerivId)p,alpha));
+    ops[3].first = (MultiVecDerivId)r;
+    ops[3].second.push_back(std::make_pair((MultiVecDerivId)r,1.0));
+    ops[3].second.push_back(std::make_pair((MultiVecDerivId)s,-alpha));
+    simulation::parallelFor(0, pipelinedStates.size(), StatesVMultiOp(params, pipelinedStates, ops));
+}
+
+template<> SOFA_BASE_LINEAR_SOLVER_API
+inline void CGLinearSolver<component::linearsolver::GraphScatteredMatrix,component::linearsolver::GraphScatteredVector>::cgdot_pipelined(const core::ExecParams* params, Vector& r, Vector& w, SReal& gamma, SReal& delta)
+{
+    Vec<2,SReal> d = simulation::parallelReduce(0, pipelinedStates.size(), Vec<2,SReal>(),
+            StatesVDot2(params, pipelinedStates, (MultiVecDerivId)r, (MultiVecDerivId)w), SumVec2(), (std::size_t)DOT_GRAIN_SIZE);
+    gamma = d[0];
+    delta = d[1];
+}
+
 SOFA_DECL_CLASS(CGLinearSolver)
 
 int CGLinearSolverClass = core::RegisterObject("Linear system solver using the conjugate gradient iterative algorithm")
@@ -60,6 +60,8 @@ public:
     Data<bool> f_warmStart;
     Data<bool> f_verbose;
     Data<std::map < std::string, sofa::helper::vector<SReal> > > f_graph;
+    Data<bool> d_parallel; ///< compute the products of assembled matrices with vectors on several threads
+    Data<bool> d_pipelined; ///< use the single-reduction (Chronopoulos-Gear) variant of the algorithm
 #ifdef DISPLAY_TIME
     SReal time1;
     SReal time2;
@@ -76,7 +78,25 @@ protected:
     /// It computes: x += p*alpha, r -= q*alpha
     inline void cgstep_alpha(const core::ExecParams* params, Vector& x, Vector& r, Vector& p, Vector& q, SReal alpha);
 
+    /// Called once before the iterations of the pipelined variant, to prepare the fused vector operations.
+    inline void cgbegin_pipelined(const core::ExecParams* params);
+    /// This method is separated from the rest to be able to use custom/optimized versions depending on the types of vectors.
+    /// It computes: p = p*beta + r, s = s*beta + w, x += p*alpha, r -= s*alpha
+    inline void cgstep_pipelined(const core::ExecParams* params, Vector& x, Vector& r, Vector& p, Vector& s, Vector& w, SReal alpha, SReal beta);
+    /// This method is separated from the rest to be able to use custom/optimized versions depending on the types of vectors.
+    /// It computes: gamma = r.r, delta = w.r
+    inline void cgdot_pipelined(const core::ExecParams* params, Vector& r, Vector& w, SReal& gamma, SReal& delta);
+
+    /// Solve Mx=b with the pipelined variant: the vector updates of one iteration are fused
+    /// in a single operation, and its two dot products are computed in a single pass.
+    void solvePipelined(Matrix& M, Vector& x, Vector& b);
+
+    /// Independent mechanical states the fused operations are directly applied to (GraphScatteredVector only)
+    helper::vector<core::behavior::BaseMechanicalState*> pipelinedStates;
+
 public:
+    void init();
+
     void resetSystem();
 
     void setSystemMBKMatrix(const sofa::core::MechanicalParams* mparams);
@@ -92,6 +112,15 @@ inline void CGLinearSolver<component::linearsolver::GraphScatteredMatrix,compone
 template<>
 inline void CGLinearSolver<component::linearsolver::GraphScatteredMatrix,component::linearsolver::GraphScatteredVector>::cgstep_alpha(const core::ExecParams* params, Vector& x, Vector& r, Vector& p, Vector& q, SReal alpha);
 
+template<>
+inline void CGLinearSolver<component::linearsolver::GraphScatteredMatrix,component::linearsolver::GraphScatteredVector>::cgbegin_pipelined(const core::ExecParams* params);
+
+template<>
+inline void CGLinearSolver<component::linearsolver::GraphScatteredMatrix,component::linearsolver::GraphScatteredVector>::cgstep_pipelined(const core::ExecParams* params, Vector& x, Vector& r, Vector& p, Vector& s, Vector& w, SReal alpha, SReal beta);
+
+template<>
+inline void CGLinearSolver<component::linearsolver::GraphScatteredMatrix,component::linearsolver::GraphScatteredVector>::cgdot_pipelined(const core::ExecParams* params, Vector& r, Vector& w, SReal& gamma, SReal& delta);
+
 #if defined(SOFA_EXTERN_TEMPLATE) && !defined(SOFA_COMPONENT_LINEARSOLVER_CGLINEARSOLVER_CPP)
 extern template class SOFA_BASE_LINEAR_SOLVER_API CGLinearSolver< GraphScatteredMatrix, GraphScatteredVector >;
 #ifndef SOFA_FLOAT
@@ -31,6 +31,7 @@
 #include <SofaBaseLinearSolver/SparseMatrix.h>
 #include <SofaBaseLinearSolver/CompressedRowSparseMatrix.h>
 #include <sofa/simulation/MechanicalVisitor.h>
+#include <sofa/simulation/TaskScheduler.h>
 #include <sofa/helper/system/thread/CTime.h>
 #include <sofa/helper/AdvancedTimer.h>
 
@@ -55,6 +56,8 @@ CGLinearSolver<TMatrix,TVector>::CGLinearSolver()
     , f_warmStart( initData(&f_warmStart,false,"warmStart","Use previous solution as initial solution") )
     , f_verbose( initData(&f_verbose,false,"verbose","Dump system state at each iteration") )
     , f_graph( initData(&f_graph,"graph","Graph of residuals at each iteration") )
+    , d_parallel( initData(&d_parallel,false,"parallel","start the TaskScheduler threads, so that the products of large assembled matrices with vectors are computed on several threads") )
+    , d_pipelined( initData(&d_pipelined,false,"pipelined","use the single-reduction (Chronopoulos-Gear) variant: one fused vector update and one fused pass for both dot products per iteration") )
 {
     f_graph.setWidget("graph");
 //    f_graph.setReadOnly(true);
@@ -67,6 +70,15 @@ CGLinearSolver<TMatrix,TVector>::CGLinearSolver()
 	f_smallDenominatorThreshold.setRequired(true);
 }
 
+template<class TMatrix, class TVector>
+void CGLinearSolver<TMatrix,TVector>::init()
+{
+    Inherit::init();
+
+    if (d_parallel.getValue())
+        simulation::TaskScheduler::getInstance().start();
+}
+
 template<class TMatrix, class TVector>
 void CGLinearSolver<TMatrix,TVector>::resetSystem()
 {
@@ -95,6 +107,12 @@ void CGLinearSolver<TMatrix,TVector>::setSystemMBKMatrix(const sofa::core::Mecha
 template<class TMatrix, class TVector>
 void CGLinearSolver<TMatrix,TVector>::solve(Matrix& M, Vector& x, Vector& b)
 {
+    if (d_pipelined.getValue())
+    {
+        solvePipelined(M, x, b);
+        return;
+    }
+
 #ifdef SOFA_DUMP_VISITOR_INFO
     simulation::Visitor::printComment("ConjugateGradient");
 #endif
@@ -261,6 +279,157 @@ void CGLinearSolver<TMatrix,TVector>::solve(Matrix& M, Vector& x, Vector& b)
     vtmp.deleteTempVector(&r);
 }
 
+/// Solve Mx=b with the Chronopoulos-Gear formulation of the conjugate gradient.
+///
+/// Using w = M r and s = M p, the recurrences
+///   gamma = r.r, delta = w.r, beta = gamma / gamma_1, p.Mp = delta - beta*gamma/alpha_1
+/// give both dot products of an iteration from the same pair of vectors, and the
+/// updates of p, s, x and r can be done at once. Each iteration is then one
+/// matrix-vector product, one fused vector update and one fused pass for the dot
+/// products, instead of the two separate reductions and updates of solve().
+/// The price is one more temporary vector, and one more product at the start.
+template<class TMatrix, class TVector>
+void CGLinearSolver<TMatrix,TVector>::solvePipelined(Matrix& M, Vector& x, Vector& b)
+{
+#ifdef SOFA_DUMP_VISITOR_INFO
+    simulation::Visitor::printComment("ConjugateGradient");
+#endif
+
+#ifdef SOFA_DUMP_VISITOR_INFO
+    simulation::Visitor::printNode("VectorAllocation");
+#endif
+    const core::ExecParams* params = core::ExecParams::defaultInstance();
+    typename Inherit::TempVectorContainer vtmp(this, params, M, x, b);
+    Vector& p = *vtmp.createTempVector();
+    Vector& s = *vtmp.createTempVector();
+    Vector& r = *vtmp.createTempVector();
+    Vector& w = *vtmp.createTempVector();
+
+    const bool printLog = this->f_printLog.getValue();
+    const bool verbose  = f_verbose.getValue();
+
+    cgbegin_pipelined(params);
+
+    if( verbose )
+        sout<<"CGLinearSolver, b = "<< b <<sendl;
+
+    if( f_warmStart.getValue() )
+    {
+        r = M * x;
+        r.eq( b, r, -1.0 );   //  initial residual r = b - Ax;
+    }
+    else
+    {
+        x.clear();
+        r = b; // initial residual
+    }
+
+    w = M*r;
+    SReal gamma = 0, gamma_1, delta = 0, alpha = 0, beta = 0;
+    cgdot_pipelined(params, r, w, gamma, delta);
+    // with beta = 0, the first step gives p = r and s = w
+    p = r;
+    s = w;
+
+    double normb = b.norm();
+    std::map < std::string, sofa::helper::vector<SReal> >& graph = *f_graph.beginEdit();
+    sofa::helper::vector<SReal>& graph_error = graph[(this->isMultiGroup()) ? this->currentNode->getName()+std::string("-Error") : std::string("Error")];
+    graph_error.clear();
+    sofa::helper::vector<SReal>& graph_den = graph[(this->isMultiGroup()) ? this->currentNode->getName()+std::string("-Denominator") : std::string("Denominator")];
+    graph_den.clear();
+    graph_error.push_back(1);
+    unsigned nb_iter;
+    const char* endcond = "iterations";
+
+#ifdef SOFA_DUMP_VISITOR_INFO
+    simulation::Visitor::printCloseNode("VectorAllocation");
+#endif
+    for( nb_iter=1; nb_iter<=f_maxIter.getValue(); nb_iter++ )
+    {
+#ifdef SOFA_DUMP_VISITOR_INFO
+        std::ostringstream comment;
+        if (simulation::Visitor::isPrintActivated())
+        {
+            comment << "Iteration_" << nb_iter;
+            simulation::Visitor::printNode(comment.str());
+        }
+#endif
+        if (nb_iter>1)
+        {
+            double err = sqrt(gamma)/normb;
+            graph_error.push_back(err);
+            if (err <= f_tolerance.getValue())
+            {
+                endcond = "tolerance";
+
+#ifdef SOFA_DUMP_VISITOR_INFO
+                if (simulation::Visitor::isPrintActivated())
+                    simulation::Visitor::printCloseNode(comment.str());
+#endif
+                break;
+            }
+        }
+
+        // p.Mp, from the dot products of the previous pass
+        double den = (nb_iter==1) ? delta : delta - beta*gamma/alpha;
+
+        graph_den.push_back(den);
+
+        if( fabs(den)<f_smallDenominatorThreshold.getValue() )
+        {
+            endcond = "threshold";
+            if( verbose )
+            {
+                sout<<"CGLinearSolver, den = "<<den<<", smallDenominatorThreshold = "<<f_smallDenominatorThreshold.getValue()<<sendl;
+            }
+#ifdef SOFA_DUMP_VISITOR_INFO
+            if (simulation::Visitor::isPrintActivated())
+                simulation::Visitor::printCloseNode(comment.str());
+#endif
+            break;
+        }
+        alpha = gamma/den;
+
+        // p = p*beta + r, s = s*beta + w, x = x + alpha p, r = r - alpha s
+        cgstep_pipelined(params, x, r, p, s, w, alpha, beta);
+        if( verbose )
+        {
+            sout<<"den = "<<den<<", alpha = "<<alpha<<", beta = "<<beta<<sendl;
+            sout<<"x : "<<x<<sendl;
+            sout<<"r : "<<r<<sendl;
+        }
+
+        // matrix-vector product
+        w = M*r;
+
+        gamma_1 = gamma;
+        cgdot_pipelined(params, r, w, gamma, delta);
+        beta = gamma/gamma_1;
+#ifdef SOFA_DUMP_VISITOR_INFO
+        if (simulation::Visitor::isPrintActivated())
+            simulation::Visitor::printCloseNode(comment.str());
+#endif
+    }
+
+    f_graph.endEdit();
+
+    sofa::helper::AdvancedTimer::valSet("CG iterations", nb_iter);
+
+    // x is the solution of the system
+    if( printLog )
+    {
+        sout<<"CGLinearSolver::solvePipelined, nbiter = "<<nb_iter<<" stop because of "<<endcond<<sendl;
+    }
+    if( verbose )
+    {
+        sout<<"CGLinearSolver::solvePipelined, solution = "<<x<<sendl;
+    }
+    vtmp.deleteTempVector(&p);
+    vtmp.deleteTempVector(&s);
+    vtmp.deleteTempVector(&r);
+    vtmp.deleteTempVector(&w);
+}
+
 template<class TMatrix, class TVector>
 inline void CGLinearSolver<TMatrix,TVector>::cgstep_beta(const core::ExecParams* /*params*/, Vector& p, Vector& r, SReal beta)
 {
@@ -275,6 +444,29 @@ inline void CGLinearSolver<TMatrix,TVector>::cgstep_alpha(const core::ExecParams
     r.peq(q,-alpha);                // r = r - alpha q
 }
 
+template<class TMatrix, class TVector>
+inline void CGLinearSolver<TMatrix,TVector>::cgbegin_pipelined(const core::ExecParams* /*params*/)
+{
+}
+
+template<class TMatrix, class TVector>
+inline void CGLinearSolver<TMatrix,TVector>::cgstep_pipelined(const core::ExecParams* /*params*/, Vector& x, Vector& r, Vector& p, Vector& s, Vector& w, SReal alpha, SReal beta)
+{
+    p *= beta;
+    p += r;
+    s *= beta;
+    s += w;
+    x.peq(p,alpha);                 // x = x + alpha p
+    r.peq(s,-alpha);                // r = r - alpha s
+}
+
+template<class TMatrix, class TVector>
+inline void CGLinearSolver<TMatrix,TVector>::cgdot_pipelined(const core::ExecParams* /*params*/, Vector& r, Vector& w, SReal& gamma, SReal& delta)
+{
+    gamma = r.dot(r);
+    delta = w.dot(r);
+}
+
 } // namespace linearsolver
 
 } // namespace component
@@ -30,6 +30,7 @@
 #include <SofaBaseLinearSolver/MatrixExpr.h>
 #include <SofaBaseLinearSolver/matrix_bloc_traits.h>
 #include "FullVector.h"
+#include <sofa/simulation/ParallelFor.h>
 #include <algorithm>
 
 namespace sofa
@@ -164,9 +165,22 @@ public :
     VecIndex oldRowBegin;
     VecIndex oldColsIndex;
     VecBloc  oldColsValue;
+
+    // Assembly cache, see beginAssembly()
+    enum AssemblyState { ASSEMBLY_NONE, ASSEMBLY_RECORD, ASSEMBLY_REPLAY };
+    AssemblyState assemblyState;
+    bool assemblyValid;              ///< true if assemblySlots matches the current pattern
+    std::size_t assemblyPos;         ///< index of the next add call during a replay
+    VecIndex assemblyRows;           ///< row of each recorded add call
+    VecIndex assemblyCols;           ///< column of each recorded add call, or -1-column for the add of a whole bloc
+    VecIndex assemblySlots;          ///< scalar index in colsValue of each recorded add call
+    VecIndex assemblyRowIndex;       ///< rowIndex when the slots were computed
+    VecIndex assemblyRowBegin;       ///< rowBegin when the slots were computed
+    VecIndex assemblyColsIndex;      ///< colsIndex when the slots were computed
 public:
     CompressedRowSparseMatrix()
         : nRow(0), nCol(0), nBlocRow(0), nBlocCol(0), compressed(true)
+        , assemblyState(ASSEMBLY_NONE), assemblyValid(false), assemblyPos(0)
     {
     }
 
@@ -174,6 +188,7 @@ public:
         : nRow(nbRow), nCol(nbCol),
           nBlocRow((nbRow + NL-1) / NL), nBlocCol((nbCol + NC-1) / NC),
           compressed(true)
+        , assemblyState(ASSEMBLY_NONE), assemblyValid(false), assemblyPos(0)
     {
     }
 
@@ -210,6 +225,8 @@ public:
 #ifdef SPARSEMATRIX_VERBOSE
             std::cout << /* this->Name()  <<  */": resize("<<nbBRow<<"*"<<NL<<","<<nbBCol<<"*"<<NC<<")"<<std::endl;
 #endif
+            if (assemblyState == ASSEMBLY_REPLAY) assemblyState = ASSEMBLY_NONE;
+            assemblyValid = false;
             nRow = nbBRow*NL;
             nCol = nbBCol*NC;
             nBlocRow = nbBRow;
@@ -226,6 +243,12 @@ public:
     virtual void compress()
     {
         if (compressed && btemp.empty()) return;
+        // the blocs are moved, the slots of a replayed assembly are not valid anymore
+        if (assemblyState == ASSEMBLY_REPLAY && !btemp.empty())
+        {
+            assemblyState = ASSEMBLY_NONE;
+            assemblyValid = false;
+        }
         if (!btemp.empty())
         {
 #ifdef SPARSEMATRIX_VERBOSE
@@ -740,6 +763,7 @@ public:
             return;
         }
 #endif
+        if (assemblyState != ASSEMBLY_NONE && assemblyAdd(i, j, v)) return;
         Index bi=0, bj=0; split_row_index(i, bi); split_col_index(j, bj);
 #ifdef SPARSEMATRIX_VERBOSE
         std::cout << /* this->Name()  <<  */"("<<rowBSize()<<"*"<<NL<<","<<colBSize()<<"*"<<NC<<"): bloc("<<i<<","<<j<<")["<<bi<<","<<bj<<"] += "<<v<<std::endl;
@@ -747,6 +771,17 @@ public:
         traits::v(*wbloc(i,j,true), bi, bj) += (Real)v;
     }
 
+    /// Add a whole 3x3 block, in a single bloc of the matrix if its blocs are 3x3 and the indices are aligned on them
+    void addBlock33(Index i, Index j, const defaulttype::Mat3x3d& b)
+    {
+        addBloc3x3(i, j, b);
+    }
+
+    void addBlock33(Index i, Index j, const defaulttype::Mat3x3f& b)
+    {
+        addBloc3x3(i, j, b);
+    }
+
     void clear(Index i, Index j)
     {
 #ifdef SPARSEMATRIX_VERBOSE
@@ -885,6 +920,116 @@ public:
         btemp.clear();
     }
 
+    /// @name Assembly cache
+    /// The first assembly between beginAssembly() and endAssembly() records the
+    /// sequence of add(i,j,v) calls, and endAssembly() computes the place of each
+    /// of them in the compressed values. The next assemblies replay this sequence:
+    /// each add call directly accumulates its value in the recorded slot, without
+    /// searching the bloc. As soon as a call differs from the recorded one, or if
+    /// the pattern of the matrix changed in between, the matrix goes back to the
+    /// usual insertion and the next assembly records a new sequence.
+    /// @{
+
+    void beginAssembly()
+    {
+        if (assemblyValid && btemp.empty() && rowIndex == assemblyRowIndex && rowBegin == assemblyRowBegin && colsIndex == assemblyColsIndex)
+        {
+            assemblyState = ASSEMBLY_REPLAY;
+        }
+        else
+        {
+            assemblyState = ASSEMBLY_RECORD;
+            assemblyValid = false;
+            assemblyRows.clear();
+            assemblyCols.clear();
+        }
+        assemblyPos = 0;
+    }
+
+    void endAssembly()
+    {
+        if (assemblyState == ASSEMBLY_RECORD)
+        {
+            compress();
+            assemblySlots.resize(assemblyRows.size());
+            assemblyValid = true;
+            for (std::size_t k=0; k<assemblyRows.size() && assemblyValid; ++k)
+            {
+                Index i = assemblyRows[k], j = assemblyCols[k] < 0 ? -1-assemblyCols[k] : assemblyCols[k];
+                Index bi=0, bj=0; split_row_index(i, bi); split_col_index(j, bj);
+                Bloc* b = wbloc(i,j,false);
+                if (b) assemblySlots[k] = (Index)(b - &colsValue[0])*NL*NC + bi*NC + bj;
+                else assemblyValid = false;
+            }
+            assemblyRowIndex = rowIndex;
+            assemblyRowBegin = rowBegin;
+            assemblyColsIndex = colsIndex;
+        }
+        assemblyState = ASSEMBLY_NONE;
+    }
+
+    /// @return true while the recorded assembly can be replayed
+    bool isAssemblyCached() const { return assemblyValid; }
+
+    /// @}
+
+protected:
+
+    /// @return true if the value was added in its recorded slot
+    bool assemblyAdd(Index i, Index j, double v)
+    {
+        if (assemblyState == ASSEMBLY_RECORD)
+        {
+            assemblyRows.push_back(i);
+            assemblyCols.push_back(j);
+            return false;
+        }
+        if (assemblyPos < assemblyRows.size() && assemblyRows[assemblyPos] == i && assemblyCols[assemblyPos] == j)
+        {
+            const Index slot = assemblySlots[assemblyPos++];
+            traits::v(colsValue[slot / (NL*NC)], (slot / NC) % NL, slot % NC) += (Real)v;
+            return true;
+        }
+        assemblyState = ASSEMBLY_NONE;
+        assemblyValid = false;
+        return false;
+    }
+
+    /// @return the recorded bloc for the add of a whole bloc at (i,j), or NULL if it is not known yet
+    Bloc* assemblyBloc(Index i, Index j)
+    {
+        if (assemblyState == ASSEMBLY_RECORD)
+        {
+            assemblyRows.push_back(i);
+            assemblyCols.push_back(-1-j);
+            return NULL;
+        }
+        if (assemblyPos < assemblyRows.size() && assemblyRows[assemblyPos] == i && assemblyCols[assemblyPos] == -1-j)
+            return &colsValue[assemblySlots[assemblyPos++] / (NL*NC)];
+        assemblyState = ASSEMBLY_NONE;
+        assemblyValid = false;
+        return NULL;
+    }
+
+    template<class real>
+    void addBloc3x3(Index i, Index j, const defaulttype::Mat<3,3,real>& b)
+    {
+        if (NL != 3 || NC != 3 || i % 3 != 0 || j % 3 != 0)
+        {
+            for (Index bi=0; bi<3; ++bi)
+                for (Index bj=0; bj<3; ++bj)
+                    Matrix::add(i+bi, j+bj, (double)b[bi][bj]);
+            return;
+        }
+        Bloc* dst = (assemblyState != ASSEMBLY_NONE) ? assemblyBloc(i, j) : NULL;
+        if (!dst) dst = wbloc(i / 3, j / 3, true);
+        for (Index bi=0; bi<3; ++bi)
+            for (Index bj=0; bj<3; ++bj)
+                traits::v(*dst, bi, bj) += (Real)b[bi][bj];
+    }
+
+public:
+
     /// @name Get information about the content and structure of this matrix (diagonal, band, sparse, full, block size, ...)
     /// @{
 
@@ -1269,15 +1414,29 @@ protected:
 
 
 
-      /** Product of the matrix with a templated vector res = this * vec*/
-      template<class Real2, class V1, class V2>
-      void tmul(V1& res, const V2& vec) const
+    /// whether different entries of the vector can be accessed by several threads at the same time
+    template<class Vec> static bool vthreadsafe(const Vec&) { return false; }
+    template<class Vec> static bool vthreadsafe(const helper::vector<Vec>&) { return true; }
+    template<class Real2> static bool vthreadsafe(const FullVector<Real2>&) { return true; }
+
+
+      /// Number of scalar non-zero entries above which the products are computed on several threads
+      enum { ParallelProductMinNonZeros = 16384 };
+
+      /// Whether a product with the given vectors can be split over the TaskScheduler threads
+      template<class V1, class V2>
+      bool useParallelProduct(const V1& res, const V2& vec) const
       {
-          assert( vec.size()%bColSize() == 0 ); // vec.size() must be a multiple of block size.
+          return (std::size_t)colsValue.size()*NL*NC >= (std::size_t)ParallelProductMinNonZeros
+                  && vthreadsafe(res) && vthreadsafe(vec)
+                  && simulation::parallel::getParallelWorker() != NULL;
+      }
 
-          ((Matrix*)this)->compress();
-          vresize( res, rowBSize(), rowSize() );
-          for (Index xi = 0; xi < (Index)rowIndex.size(); ++xi)  // for each non-empty block row
+      /** Product of the non-empty block rows [xBegin,xEnd) with a templated vector: res = this * vec, or res += this * vec if add is true */
+      template<class Real2, class V1, class V2, bool add>
+      void tmulRows(V1& res, const V2& vec, Index xBegin, Index xEnd) const
+      {
+          for (Index xi = xBegin; xi < xEnd; ++xi)  // for each non-empty block row
           {
               defaulttype::Vec<NL,Real2> r;  // local block-sized vector to accumulate the product of the block row  with the large vector
 
@@ -1292,54 +1451,69 @@ protected:
                       v[bj] = vget(vec,colsIndex[xj],NC,bj);
 
                   // multiply the block with the local vector
-                  const Bloc& b = colsValue[xj];    // non-null block has block-indices (rowIndex[xi],colsIndex[xj]) and value colsValue[xj]
-                  for (Index bi = 0; bi < NL; ++bi)
-                      for (Index bj = 0; bj < NC; ++bj)
-                          r[bi] += traits::v(b, bi, bj) * v[bj];
+                  // non-null block has block-indices (rowIndex[xi],colsIndex[xj]) and value colsValue[xj]
+                  bloc_mul_add<Bloc,Real2>::apply(r, colsValue[xj], v);
               }
 
               // transfer the local result  to the large result vector
               //Index iN = rowIndex[xi] * NL;                      // scalar row index
               for (Index bi = 0; bi < NL; ++bi)
-                  vset(res, rowIndex[xi], NL, bi, r[bi]);
+              {
+                  if (add)
+                      vadd(res, rowIndex[xi], NL, bi, r[bi]);
+                  else
+                      vset(res, rowIndex[xi], NL, bi, r[bi]);
+              }
           }
       }
 
+      template<class Real2, class V1, class V2, bool add>
+      class MulRowsFunctor
+      {
+      public:
+          MulRowsFunctor(const Matrix& m, V1& res, const V2& vec) : m(m), res(res), vec(vec) {}
+          void operator()(std::size_t first, std::size_t last) const
+          {
+              m.template tmulRows<Real2,V1,V2,add>(res, vec, (Index)first, (Index)last);
+          }
+      private:
+          const Matrix& m;
+          V1& res;
+          const V2& vec;
+      };
+
+      /** Product of all the block rows, split over the TaskScheduler threads for large matrices.
+          Each row is computed by a single thread, so the result does not depend on the number of threads. */
+      template<class Real2, class V1, class V2, bool add>
+      void tmulAllRows(V1& res, const V2& vec) const
+      {
+          if (useParallelProduct(res, vec))
+              simulation::parallelFor(0, rowIndex.size(), MulRowsFunctor<Real2,V1,V2,add>(*this, res, vec));
+          else
+              tmulRows<Real2,V1,V2,add>(res, vec, 0, (Index)rowIndex.size());
+      }
 
-      /** Product of the matrix with a templated vector res += this * vec*/
+      /** Product of the matrix with a templated vector res = this * vec*/
       template<class Real2, class V1, class V2>
-      void taddMul(V1& res, const V2& vec) const
+      void tmul(V1& res, const V2& vec) const
       {
           assert( vec.size()%bColSize() == 0 ); // vec.size() must be a multiple of block size.
 
           ((Matrix*)this)->compress();
           vresize( res, rowBSize(), rowSize() );
-          for (Index xi = 0; xi < (Index)rowIndex.size(); ++xi)  // for each non-empty block row
-          {
-              defaulttype::Vec<NL,Real2> r;  // local block-sized vector to accumulate the product of the block row  with the large vector
+          tmulAllRows<Real2,V1,V2,false>(res, vec);
+      }
 
-              // multiply the non-null blocks with the corresponding chunks of the large vector
-              Range rowRange(rowBegin[xi], rowBegin[xi+1]);
-              for (Index xj = rowRange.begin(); xj < rowRange.end(); ++xj)
-              {
-                  // transfer a chunk of large vector to a local block-sized vector
-                  defaulttype::Vec<NC,Real2> v;
-                  //Index jN = colsIndex[xj] * NC;    // scalar column index
-                  for (Index bj = 0; bj < NC; ++bj)
-                      v[bj] = vget(vec,colsIndex[xj],NC,bj);
 
-                  // multiply the block with the local vector
-                  const Bloc& b = colsValue[xj];    // non-null block has block-indices (rowIndex[xi],colsIndex[xj]) and value colsValue[xj]
-                  for (Index bi = 0; bi < NL; ++bi)
-                      for (Index bj = 0; bj < NC; ++bj)
-                          r[bi] += traits::v(b, bi, bj) * v[bj];
-              }
+      /** Product of the matrix with a templated vector res += this * vec*/
+      template<class Real2, class V1, class V2>
+      void taddMul(V1& res, const V2& vec) const
+      {
+          assert( vec.size()%bColSize() == 0 ); // vec.size() must be a multiple of block size.
 
-              // transfer the local result  to the large result vector
-              //Index iN = rowIndex[xi] * NL;                      // scalar row index
-              for (Index bi = 0; bi < NL; ++bi)
-                  vadd(res, rowIndex[xi], NL, bi, r[bi]);
-          }
+          ((Matrix*)this)->compress();
+          vresize( res, rowBSize(), rowSize() );
+          tmulAllRows<Real2,V1,V2,true>(res, vec);
       }
 
 
@@ -115,6 +115,18 @@ public:
     Real* ptr() { return data; }
     const Real* ptr() const { return data; }
 
+    /// Use p as storage for a nbRow x nbCol matrix. The buffer is neither copied nor freed by this matrix.
+    void setptr(Real* p, Index nbRow, Index nbCol)
+    {
+        if (allocsize > 0)
+            delete[] data;
+        data = p;
+        nRow = nbRow;
+        nCol = nbCol;
+        pitch = nbCol;
+        allocsize = -nbRow*nbCol;
+    }
+
     LineIterator begin() { return LineIterator(data, 0, nCol, pitch); }
     LineIterator end()   { return LineIterator(data, nRow, nCol, pitch);   }
     LineConstIterator begin() const { return LineConstIterator(data, 0, nCol, pitch); }
@@ -166,6 +166,20 @@ private :
 //    ResMatrixType res_data;
 };
 
+/// Start the assembly of a system matrix, for the matrix types able to cache it (see CompressedRowSparseMatrix::beginAssembly)
+template<class TMatrix>
+inline void beginSystemMatrixAssembly(TMatrix* /*matrix*/) {}
+
+template<class TBloc, class TVecBloc, class TVecIndex>
+inline void beginSystemMatrixAssembly(CompressedRowSparseMatrix<TBloc,TVecBloc,TVecIndex>* matrix) { matrix->beginAssembly(); }
+
+/// End the assembly of a system matrix started with beginSystemMatrixAssembly
+template<class TMatrix>
+inline void endSystemMatrixAssembly(TMatrix* /*matrix*/) {}
+
+template<class TBloc, class TVecBloc, class TVecIndex>
+inline void endSystemMatrixAssembly(CompressedRowSparseMatrix<TBloc,TVecBloc,TVecIndex>* matrix) { matrix->endAssembly(); }
+
 template<class Matrix, class Vector, class ThreadManager = NoThreadManager>
 class MatrixLinearSolver;
 
@@ -183,6 +197,7 @@ public:
     typedef typename MatrixLinearSolverInternalData<Vector>::ResMatrixType ResMatrixType;
 
     Data<bool> multiGroup;
+    Data<bool> d_assemblyCache;
 
     MatrixLinearSolver();
     virtual ~MatrixLinearSolver();
@@ -38,6 +38,7 @@ template<class Matrix, class Vector>
 MatrixLinearSolver<Matrix,Vector>::MatrixLinearSolver()
     : Inherit()
     , multiGroup( initData( &multiGroup, false, "multiGroup", "activate multiple system solve, one for each child node" ) )
+    , d_assemblyCache( initData( &d_assemblyCache, false, "assemblyCache", "record the insertions in the system matrix during the first assembly, and add the values directly at their recorded place in the next ones while the insertions are the same (only for CompressedRowSparseMatrix)" ) )
 //, needInvert(true), systemMatrix(NULL), systemRHVector(NULL), systemLHVector(NULL)
     , currentGroup(&defaultGroup)
 {
@@ -172,11 +173,13 @@ void MatrixLinearSolver<Matrix,Vector>::setSystemMBKMatrix(const core::Mechanica
             currentGroup->matrixAccessor.setupMatrices();
             resizeSystem(currentGroup->matrixAccessor.getGlobalDimension());
             currentGroup->systemMatrix->clear();
+            if (d_assemblyCache.getValue()) beginSystemMatrixAssembly(currentGroup->systemMatrix);
             //unsigned int offset = 0;
             //MechanicalAddMBK_ToMatrixVisitor(currentGroup->systemMatrix, mFact, bFact, kFact, offset).execute( getContext() );
             mops.addMBK_ToMatrix(&(currentGroup->matrixAccessor), mparams->mFactor(), mparams->bFactor(), mparams->kFactor());
             //this->addMBK_ToMatrix(&(currentGroup->matrixAccessor), mFact, bFact, kFact);
             currentGroup->matrixAccessor.computeGlobalMatrix();
+            if (d_assemblyCache.getValue()) endSystemMatrixAssembly(currentGroup->systemMatrix);
         }
     }
 }
@@ -202,8 +205,10 @@ void MatrixLinearSolver<Matrix,Vector>::rebuildSystem(double massFactor, double
             currentGroup->matrixAccessor.setupMatrices();
             resizeSystem(currentGroup->matrixAccessor.getGlobalDimension());
             currentGroup->systemMatrix->clear();
+            if (d_assemblyCache.getValue()) beginSystemMatrixAssembly(currentGroup->systemMatrix);
             mops.addMBK_ToMatrix(&(currentGroup->matrixAccessor), mparams.mFactor(), mparams.bFactor(), mparams.kFactor());
             currentGroup->matrixAccessor.computeGlobalMatrix();
+            if (d_assemblyCache.getValue()) endSystemMatrixAssembly(currentGroup->systemMatrix);
         }
     }
     this->invertSystem();
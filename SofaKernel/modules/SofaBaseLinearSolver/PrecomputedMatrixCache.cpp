@@ -0,0 +1,313 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2016 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This library is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This library is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this library; if not, write to the Free Software Foundation,     *
+* Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA.          *
+*******************************************************************************
+*                               SOFA :: Modules                               *
+*                                                                             *
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <SofaBaseLinearSolver/PrecomputedMatrixCache.h>
+
+#include <sofa/core/objectmodel/BaseContext.h>
+#include <sofa/core/objectmodel/BaseData.h>
+#include <sofa/core/behavior/BaseMechanicalState.h>
+#include <sofa/core/behavior/BaseMass.h>
+#include <sofa/core/behavior/BaseForceField.h>
+#include <sofa/core/behavior/BaseProjectiveConstraintSet.h>
+#include <sofa/core/behavior/OdeSolver.h>
+#include <sofa/core/behavior/LinearSolver.h>
+#include <sofa/core/topology/BaseMeshTopology.h>
+#include <sofa/helper/vector.h>
+#include <sofa/helper/Utils.h>
+
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstdio>
+#include <cstring>
+#include <atomic>
+
+#ifdef WIN32
+# include <windows.h>
+# include <process.h>
+#else
+# include <unistd.h>
+#endif
+
+namespace sofa
+{
+
+namespace component
+{
+
+namespace linearsolver
+{
+
+namespace
+{
+
+/// Name under which a cache file is written before being renamed, unique to the process and the call
+/// so that the simulations sharing the cache never write into the same temporary file
+std::string temporaryName(const std::string& filename)
+{
+    static std::atomic<unsigned int> counter(0);
+#ifdef WIN32
+    const int pid = _getpid();
+#else
+    const int pid = (int)getpid();
+#endif
+    std::ostringstream name;
+    name << filename << "." << pid << "." << counter++ << ".tmp";
+    return name.str();
+}
+
+/// Replace filename by tmpname
+bool replaceFile(const std::string& tmpname, const std::string& filename)
+{
+#ifdef WIN32
+    // fails while another process maps the existing file: it is then kept
+    return MoveFileExW(helper::Utils::widenString(tmpname).c_str(), helper::Utils::widenString(filename).c_str(),
+                       MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return std::rename(tmpname.c_str(), filename.c_str()) == 0;
+#endif
+}
+
+const char CACHE_MAGIC[8] = { 'S', 'O', 'F', 'A', 'P', 'M', 'C', '\0' };
+
+/// Header of the cache files, followed by the values at dataOffset
+struct CacheHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t scalarSize;
+    uint64_t key;
+    uint64_t rows;
+    uint64_t cols;
+    uint64_t dataOffset;
+};
+
+/// Offset of the values in the files written by this version, keeping them aligned
+enum { DATA_OFFSET = 64 };
+
+/// Data without effect on the precomputed matrices
+bool isIgnoredData(const std::string& name)
+{
+    static const char* ignored[] = { "name", "tags", "printLog", "listening", "bbox", NULL };
+    for (const char** n = ignored; *n != NULL; ++n)
+        if (name == *n)
+            return true;
+    return false;
+}
+
+template<class T>
+void addObjects(PrecomputedMatrixCache::Key& key, const core::objectmodel::BaseContext* context, const core::objectmodel::Base* exclude, core::objectmodel::BaseContext::SearchDirection dir)
+{
+    helper::vector<T*> objects;
+    context->get<T>(&objects, dir);
+    for (std::size_t i = 0; i < objects.size(); ++i)
+        if (objects[i] != exclude)
+            key.addObject(objects[i]);
+}
+
+} // namespace
+
+PrecomputedMatrixCache::Key::Key()
+    : m_value(14695981039346656037ULL) // FNV-1a offset basis
+{
+}
+
+void PrecomputedMatrixCache::Key::add(const void* data, std::size_t size)
+{
+    const unsigned char* p = (const unsigned char*)data;
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        m_value ^= p[i];
+        m_value *= 1099511628211ULL; // FNV-1a prime
+    }
+}
+
+void PrecomputedMatrixCache::Key::add(const std::string& s)
+{
+    add((long long)s.size());
+    add(s.data(), s.size());
+}
+
+void PrecomputedMatrixCache::Key::add(double v)
+{
+    add(&v, sizeof(v));
+}
+
+void PrecomputedMatrixCache::Key::add(long long v)
+{
+    add(&v, sizeof(v));
+}
+
+void PrecomputedMatrixCache::Key::addData(const core::objectmodel::BaseData* data)
+{
+    add(data->getName());
+    const defaulttype::AbstractTypeInfo* typeinfo = data->getValueTypeInfo();
+    const void* value = data->getValueVoidPtr();
+    if (typeinfo->ValidInfo() && (typeinfo->Integer() || typeinfo->Scalar()))
+    {
+        // use the exact binary values, and avoid the conversion of large vectors to strings
+        const std::size_t n = typeinfo->size(value);
+        add((long long)n);
+        if (typeinfo->Integer())
+            for (std::size_t i = 0; i < n; ++i)
+                add(typeinfo->getIntegerValue(value, i));
+        else
+            for (std::size_t i = 0; i < n; ++i)
+                add(typeinfo->getScalarValue(value, i));
+    }
+    else
+        add(data->getValueString());
+}
+
+void PrecomputedMatrixCache::Key::addObject(const core::objectmodel::Base* object)
+{
+    add(object->getClassName());
+    add(object->getTemplateName());
+
+    if (dynamic_cast<const core::behavior::BaseMechanicalState*>(object))
+    {
+        // the other state vectors change during the simulation
+        if (const core::objectmodel::BaseData* rest = object->findData("rest_position"))
+            addData(rest);
+        return;
+    }
+
+    const core::objectmodel::Base::VecData& fields = object->getDataFields();
+    for (std::size_t i = 0; i < fields.size(); ++i)
+    {
+        const core::objectmodel::BaseData* data = fields[i];
+        if ((data->isSet() || data->getParent() != NULL) && !data->isReadOnly() && !isIgnoredData(data->getName()))
+            addData(data);
+    }
+}
+
+void PrecomputedMatrixCache::Key::addMechanicalContext(const core::objectmodel::BaseContext* context, const core::objectmodel::Base* exclude)
+{
+    typedef core::objectmodel::BaseContext BaseContext;
+    addObjects<core::behavior::BaseMechanicalState>(*this, context, exclude, BaseContext::SearchDown);
+    addObjects<core::topology::BaseMeshTopology>(*this, context, exclude, BaseContext::SearchDown);
+    addObjects<core::behavior::BaseMass>(*this, context, exclude, BaseContext::SearchDown);
+    addObjects<core::behavior::BaseForceField>(*this, context, exclude, BaseContext::SearchDown);
+    addObjects<core::behavior::BaseProjectiveConstraintSet>(*this, context, exclude, BaseContext::SearchDown);
+
+    core::behavior::OdeSolver* odeSolver = NULL;
+    context->get(odeSolver);
+    if (odeSolver && odeSolver != exclude)
+        addObject(odeSolver);
+    core::behavior::LinearSolver* linearSolver = NULL;
+    context->get(linearSolver);
+    if (linearSolver && linearSolver != exclude)
+        addObject(linearSolver);
+}
+
+std::string PrecomputedMatrixCache::Key::str() const
+{
+    std::ostringstream ss;
+    ss << std::hex << std::setw(16) << std::setfill('0') << m_value;
+    return ss.str();
+}
+
+PrecomputedMatrixCache::PrecomputedMatrixCache()
+    : m_values(NULL)
+{
+}
+
+PrecomputedMatrixCache::Status PrecomputedMatrixCache::open(const std::string& filename, const Key& key, unsigned rows, unsigned cols, unsigned scalarSize)
+{
+    close();
+
+    if (!file.open(filename))
+        return MISSING;
+
+    const uint64_t valuesSize = (uint64_t)rows * cols * scalarSize;
+
+    if (file.size() >= sizeof(CacheHeader) && memcmp(file.data(), CACHE_MAGIC, sizeof(CACHE_MAGIC)) == 0)
+    {
+        CacheHeader header;
+        memcpy(&header, file.data(), sizeof(header));
+        if (header.version == VERSION && header.scalarSize == scalarSize && header.key == key.value()
+                && header.rows == rows && header.cols == cols
+                && header.dataOffset >= sizeof(CacheHeader) && header.dataOffset + valuesSize <= file.size())
+        {
+            m_values = file.data() + header.dataOffset;
+            return VALID;
+        }
+    }
+    else if (file.size() >= valuesSize)
+    {
+        m_values = file.data();
+        return LEGACY;
+    }
+
+    close();
+    return OUTDATED;
+}
+
+void PrecomputedMatrixCache::close()
+{
+    file.close();
+    m_values = NULL;
+}
+
+bool PrecomputedMatrixCache::write(const std::string& filename, const Key& key, unsigned rows, unsigned cols, unsigned scalarSize, const void* values)
+{
+    CacheHeader header;
+    memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header.version = VERSION;
+    header.scalarSize = scalarSize;
+    header.key = key.value();
+    header.rows = rows;
+    header.cols = cols;
+    header.dataOffset = DATA_OFFSET;
+
+    const std::string tmpname = temporaryName(filename);
+    {
+        std::ofstream out(tmpname.c_str(), std::fstream::out | std::fstream::binary);
+        if (!out.is_open())
+            return false;
+        char padding[DATA_OFFSET - sizeof(CacheHeader)];
+        memset(padding, 0, sizeof(padding));
+        out.write((const char*)&header, sizeof(header));
+        out.write(padding, sizeof(padding));
+        out.write((const char*)values, (std::streamsize)rows * cols * scalarSize);
+        if (!out.good())
+        {
+            out.close();
+            std::remove(tmpname.c_str());
+            return false;
+        }
+    }
+    if (!replaceFile(tmpname, filename))
+    {
+        std::remove(tmpname.c_str());
+        return false;
+    }
+    return true;
+}
+
+} // namespace linearsolver
+
+} // namespace component
+
+} // namespace sofa
@@ -0,0 +1,157 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2016 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This library is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This library is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this library; if not, write to the Free Software Foundation,     *
+* Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA.          *
+*******************************************************************************
+*                               SOFA :: Modules                               *
+*                                                                             *
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#ifndef SOFA_COMPONENT_LINEARSOLVER_PRECOMPUTEDMATRIXCACHE_H
+#define SOFA_COMPONENT_LINEARSOLVER_PRECOMPUTEDMATRIXCACHE_H
+#include "config.h"
+
+#include <sofa/helper/system/config.h>
+#include <sofa/helper/system/MappedFile.h>
+
+#include <string>
+
+namespace sofa
+{
+
+namespace core
+{
+namespace objectmodel
+{
+class Base;
+class BaseData;
+class BaseContext;
+}
+}
+
+namespace component
+{
+
+namespace linearsolver
+{
+
+/// File cache for large dense precomputed matrices (compliances, inverses).
+///
+/// The file starts with a header giving the format version, the scalar size,
+/// the dimensions of the matrix and a key identifying the inputs it was
+/// computed from (mesh, material and solver parameters), followed by the
+/// values in row-major order. It is mapped read-only, so that the matrix is
+/// neither read nor copied at startup and is shared by all the simulations
+/// using it on the same host. A file whose header does not match the
+/// expected key or dimensions is reported as outdated, so that the matrix is
+/// recomputed instead of silently reused.
+class SOFA_BASE_LINEAR_SOLVER_API PrecomputedMatrixCache
+{
+public:
+    enum { VERSION = 1 };
+
+    /// Incremental 64 bits hash (FNV-1a) of the inputs of a precomputation
+    class SOFA_BASE_LINEAR_SOLVER_API Key
+    {
+    public:
+        Key();
+
+        void add(const void* data, std::size_t size);
+        void add(const std::string& s);
+        void add(double v);
+        void add(long long v);
+
+        /// Add the value of a Data, element by element for scalar or integer containers
+        void addData(const core::objectmodel::BaseData* data);
+
+        /// Add the class name and the Data of an object which are set or linked, except
+        /// read-only ones (outputs) and the ones without effect on the mechanics (name, tags, ...).
+        /// Only the rest positions of mechanical states are taken into account.
+        void addObject(const core::objectmodel::Base* object);
+
+        /// Add the objects a precomputed mechanical response depends on: mechanical states,
+        /// topologies, masses, force fields and projective constraints of the context and its
+        /// children, and the ODE and linear solvers applying to it.
+        /// @param exclude object to ignore, usually the one calling this method
+        void addMechanicalContext(const core::objectmodel::BaseContext* context, const core::objectmodel::Base* exclude = NULL);
+
+        uint64_t value() const { return m_value; }
+
+        /// Hexadecimal representation, to be used in file names
+        std::string str() const;
+
+    protected:
+        uint64_t m_value;
+    };
+
+    enum Status
+    {
+        MISSING,  ///< file not found or empty
+        OUTDATED, ///< header does not match the expected version, key, dimensions or scalar size
+        LEGACY,   ///< raw values without header, as written by older versions, which cannot be validated
+        VALID
+    };
+
+    PrecomputedMatrixCache();
+
+    /// Map a cache file and check it stores a rows x cols matrix of scalars of the given size
+    /// computed for the given key. The values are available if VALID or LEGACY is returned.
+    Status open(const std::string& filename, const Key& key, unsigned rows, unsigned cols, unsigned scalarSize);
+
+    template<class Real>
+    Status open(const std::string& filename, const Key& key, unsigned rows, unsigned cols)
+    {
+        return open(filename, key, rows, cols, sizeof(Real));
+    }
+
+    /// Unmap the file
+    void close();
+
+    /// Values of the matrix, in row-major order, valid while the file is mapped
+    template<class Real>
+    const Real* values() const { return (const Real*)m_values; }
+
+    /// Write a cache file. The file is written under a temporary name unique to the process
+    /// and the call, and then renamed, so that other processes never see a partial file, and
+    /// processes mapping the previous version keep a valid mapping. On Windows a file mapped
+    /// by another process cannot be replaced: it is then kept and false is returned.
+    /// @return true on success
+    static bool write(const std::string& filename, const Key& key, unsigned rows, unsigned cols, unsigned scalarSize, const void* values);
+
+    template<class Real>
+    static bool write(const std::string& filename, const Key& key, unsigned rows, unsigned cols, const Real* values)
+    {
+        return write(filename, key, rows, cols, sizeof(Real), values);
+    }
+
+protected:
+    helper::system::MappedFile file;
+    const char* m_values;
+
+private:
+    PrecomputedMatrixCache(const PrecomputedMatrixCache&);
+    PrecomputedMatrixCache& operator=(const PrecomputedMatrixCache&);
+};
+
+} // namespace linearsolver
+
+} // namespace component
+
+} // namespace sofa
+
+#endif
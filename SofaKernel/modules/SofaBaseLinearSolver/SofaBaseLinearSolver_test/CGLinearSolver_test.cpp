@@ -0,0 +1,113 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2016 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU General Public License as published by the Free  *
+* Software Foundation; either version 2 of the License, or (at your option)   *
+* any later version.                                                          *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for    *
+* more details.                                                               *
+*                                                                             *
+* You should have received a copy of the GNU General Public License along     *
+* with this program; if not, write to the Free Software Foundation, Inc., 51  *
+* Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA.                   *
+*******************************************************************************
+*                            SOFA :: Applications                             *
+*                                                                             *
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+
+#include <SofaTest/Sofa_test.h>
+
+#include <SofaBaseLinearSolver/CGLinearSolver.h>
+
+#include <gtest/gtest.h>
+
+namespace sofa {
+
+using component::linearsolver::CGLinearSolver;
+using component::linearsolver::CompressedRowSparseMatrix;
+using component::linearsolver::FullVector;
+
+/** The pipelined variant of the conjugate gradient gives the same iterates as
+  the classical one, up to rounding errors.
+  */
+struct CGLinearSolver_test : public Sofa_test<double>
+{
+    typedef CompressedRowSparseMatrix<double> Matrix;
+    typedef FullVector<double> Vector;
+    typedef CGLinearSolver<Matrix,Vector> Solver;
+
+    enum { N = 200 };
+
+    Matrix M;
+    Vector b;
+    Solver::SPtr solver;
+
+    CGLinearSolver_test()
+    {
+        // symmetric positive definite matrix
+        M.resize(N, N);
+        for (int i=0; i<N; ++i)
+        {
+            M.add(i, i, 4.0 + 0.01*i);
+            if (i > 0)
+            {
+                M.add(i, i-1, -1.0);
+                M.add(i-1, i, -1.0);
+            }
+            if (i >= 10)
+            {
+                M.add(i, i-10, -0.5);
+                M.add(i-10, i, -0.5);
+            }
+        }
+        M.compress();
+
+        b.resize(N);
+        for (int i=0; i<N; ++i)
+            b[i] = 1.0 + sin(0.3*i);
+
+        solver = core::objectmodel::New<Solver>();
+        solver->f_maxIter.setValue(500);
+        solver->f_tolerance.setValue(1e-12);
+        solver->f_smallDenominatorThreshold.setValue(1e-30);
+    }
+
+    /// Solve the system and return the residuals of the iterations
+    helper::vector<SReal> solve(Vector& x, bool pipelined)
+    {
+        solver->d_pipelined.setValue(pipelined);
+        x.resize(N);
+        solver->solve(M, x, b);
+        return solver->f_graph.getValue().find("Error")->second;
+    }
+};
+
+TEST_F(CGLinearSolver_test, pipelined)
+{
+    Vector x0, x1;
+    helper::vector<SReal> error0 = solve(x0, false);
+    helper::vector<SReal> error1 = solve(x1, true);
+
+    ASSERT_EQ(error0.size(), error1.size());
+    for (std::size_t i=0; i<error0.size(); ++i)
+        EXPECT_NEAR(error0[i], error1[i], 1e-6*error0[i]) << "iteration " << i;
+
+    Vector r;
+    r.resize(N);
+    M.mul(r, x1);
+    for (int i=0; i<N; ++i)
+    {
+        EXPECT_NEAR(x0[i], x1[i], 1e-10);
+        EXPECT_NEAR(r[i], b[i], 1e-10);
+    }
+}
+
+} // namespace sofa
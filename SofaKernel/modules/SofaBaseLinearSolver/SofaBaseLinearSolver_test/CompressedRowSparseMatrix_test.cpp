@@ -0,0 +1,257 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2016 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU General Public License as published by the Free  *
+* Software Foundation; either version 2 of the License, or (at your option)   *
+* any later version.                                                          *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for    *
+* more details.                                                               *
+*                                                                             *
+* You should have received a copy of the GNU General Public License along     *
+* with this program; if not, write to the Free Software Foundation, Inc., 51  *
+* Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA.                   *
+*******************************************************************************
+*                            SOFA :: Applications                             *
+*                                                                             *
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+
+#include <SofaTest/Sofa_test.h>
+
+#include <SofaBaseLinearSolver/CompressedRowSparseMatrix.h>
+#include <SofaBaseLinearSolver/FullVector.h>
+#include <SofaBaseLinearSolver/FullMatrix.h>
+#include <sofa/simulation/TaskScheduler.h>
+
+#include <gtest/gtest.h>
+
+namespace sofa {
+
+using component::linearsolver::CompressedRowSparseMatrix;
+using component::linearsolver::FullVector;
+using component::linearsolver::FullMatrix;
+using simulation::TaskScheduler;
+
+/** Products of large CompressedRowSparseMatrix with vectors, computed on several threads
+  and using the symmetric storage, compared to the sequential products.
+  */
+struct CompressedRowSparseMatrix_test : public Sofa_test<double>
+{
+    typedef defaulttype::Mat<3,3,double> Bloc;
+    typedef CompressedRowSparseMatrix<Bloc> BlocMatrix;
+    typedef CompressedRowSparseMatrix<double> ScalarMatrix;
+
+    enum { N = 2000 }; ///< number of block rows
+
+    BlocMatrix full;   ///< symmetric matrix
+    ScalarMatrix scalar; ///< same matrix with scalar entries
+    FullVector<double> x;
+
+    CompressedRowSparseMatrix_test()
+    {
+        // random symmetric matrix, with a few blocks per row around the diagonal
+        full.resize(3*N, 3*N);
+        for (int i=0; i<N; ++i)
+        {
+            for (int k=0; k<6; ++k)
+            {
+                const int j = (i + (k ? helper::irand()%60 : 0)) % N;
+                Bloc b;
+                for (int r=0; r<3; ++r)
+                    for (int c=0; c<3; ++c)
+                        b[r][c] = helper::drand();
+                if (i == j)
+                    *full.wbloc(i, i, true) += b + b.transposed();
+                else
+                {
+                    *full.wbloc(i, j, true) += b;
+                    *full.wbloc(j, i, true) += b.transposed();
+                }
+            }
+        }
+        full.compress();
+
+        scalar.resize(3*N, 3*N);
+        const BlocMatrix::VecIndex& rowIndex = full.getRowIndex();
+        const BlocMatrix::VecIndex& rowBegin = full.getRowBegin();
+        for (unsigned int xi=0; xi<rowIndex.size(); ++xi)
+        {
+            for (int xj=rowBegin[xi]; xj<rowBegin[xi+1]; ++xj)
+            {
+                const int i = rowIndex[xi];
+                const int j = full.getColsIndex()[xj];
+                const Bloc& b = full.getColsValue()[xj];
+                for (int r=0; r<3; ++r)
+                    for (int c=0; c<3; ++c)
+                        scalar.add(3*i+r, 3*j+c, b[r][c]);
+            }
+        }
+        scalar.compress();
+
+        x.resize(3*N);
+        for (int i=0; i<3*N; ++i)
+            x[i] = helper::drand() - 0.5;
+    }
+
+    /// Assemble factor*full in m by scalar additions, plus an entry outside the pattern of full if extra is set
+    void assemble(BlocMatrix& m, double factor, bool extra)
+    {
+        m.clear();
+        m.beginAssembly();
+        const BlocMatrix::VecIndex& rowIndex = full.getRowIndex();
+        const BlocMatrix::VecIndex& rowBegin = full.getRowBegin();
+        for (unsigned int xi=0; xi<rowIndex.size(); ++xi)
+            for (int xj=rowBegin[xi]; xj<rowBegin[xi+1]; ++xj)
+                for (int r=0; r<3; ++r)
+                    for (int c=0; c<3; ++c)
+                        m.add(3*rowIndex[xi]+r, 3*full.getColsIndex()[xj]+c, factor*full.getColsValue()[xj][r][c]);
+        if (extra)
+            m.add(0, 3*N-1, 1.0);
+        m.endAssembly();
+    }
+
+    /// Check that m is factor*full, plus the extra entry if set
+    void checkAssembly(BlocMatrix& m, double factor, bool extra)
+    {
+        FullVector<double> y, yRef;
+        m.mul(y, x);
+        full.mul(yRef, x);
+        for (int i=0; i<3*N; ++i)
+            yRef[i] *= factor;
+        if (extra)
+            yRef[0] += x[3*N-1];
+        EXPECT_LT(this->vectorMaxDiff(y, yRef), 1e-10);
+    }
+
+    ~CompressedRowSparseMatrix_test()
+    {
+        TaskScheduler::getInstance().stop();
+    }
+};
+
+TEST_F(CompressedRowSparseMatrix_test, blocAndScalarProducts)
+{
+    FullVector<double> yBloc, yScalar;
+    full.mul(yBloc, x);
+    scalar.mul(yScalar, x);
+    ASSERT_EQ(yBloc.size(), yScalar.size());
+    for (int i=0; i<yBloc.size(); ++i)
+        EXPECT_EQ(yScalar[i], yBloc[i]);
+}
+
+TEST_F(CompressedRowSparseMatrix_test, parallelProducts)
+{
+    FullVector<double> yBloc, yScalar, yAdd;
+    full.mul(yBloc, x);
+    scalar.mul(yScalar, x);
+    yAdd = x;
+    full.addMul(yAdd, x);
+
+    TaskScheduler::getInstance().start(4);
+    FullVector<double> pBloc, pScalar, pAdd;
+    full.mul(pBloc, x);
+    scalar.mul(pScalar, x);
+    pAdd = x;
+    full.addMul(pAdd, x);
+
+    // each row is computed by a single thread: the results are identical
+    for (int i=0; i<3*N; ++i)
+    {
+        EXPECT_EQ(yBloc[i], pBloc[i]);
+        EXPECT_EQ(yScalar[i], pScalar[i]);
+        EXPECT_EQ(yAdd[i], pAdd[i]);
+    }
+}
+
+TEST_F(CompressedRowSparseMatrix_test, assemblyCache)
+{
+    BlocMatrix m;
+    m.resize(3*N, 3*N);
+
+    // the first assembly is recorded, the next ones are replayed
+    assemble(m, 1.0, false);
+    EXPECT_TRUE(m.isAssemblyCached());
+    checkAssembly(m, 1.0, false);
+    assemble(m, 2.0, false);
+    EXPECT_TRUE(m.isAssemblyCached());
+    checkAssembly(m, 2.0, false);
+
+    // a different sequence of insertions falls back to the usual insertion, then is recorded
+    assemble(m, 3.0, true);
+    EXPECT_FALSE(m.isAssemblyCached());
+    checkAssembly(m, 3.0, true);
+    assemble(m, 4.0, true);
+    EXPECT_TRUE(m.isAssemblyCached());
+    checkAssembly(m, 4.0, true);
+    assemble(m, 5.0, true);
+    EXPECT_TRUE(m.isAssemblyCached());
+    checkAssembly(m, 5.0, true);
+
+    // a resize drops the recorded slots
+    m.resize(3*N+3, 3*N+3);
+    m.resize(3*N, 3*N);
+    EXPECT_FALSE(m.isAssemblyCached());
+    assemble(m, 6.0, false);
+    checkAssembly(m, 6.0, false);
+}
+
+TEST_F(CompressedRowSparseMatrix_test, blockAdd)
+{
+    // the blocks of full added as whole 3x3 blocks, twice to go through the assembly cache
+    BlocMatrix blocs;
+    ScalarMatrix scalars;
+    blocs.resize(3*N, 3*N);
+    scalars.resize(3*N, 3*N);
+    defaulttype::BaseMatrix* matrices[2] = { &blocs, &scalars };
+    const BlocMatrix::VecIndex& rowIndex = full.getRowIndex();
+    const BlocMatrix::VecIndex& rowBegin = full.getRowBegin();
+    for (int pass=0; pass<2; ++pass)
+    {
+        for (int m=0; m<2; ++m)
+        {
+            matrices[m]->clear();
+            if (m == 0) blocs.beginAssembly();
+            for (unsigned int xi=0; xi<rowIndex.size(); ++xi)
+                for (int xj=rowBegin[xi]; xj<rowBegin[xi+1]; ++xj)
+                    matrices[m]->addBlock33(3*rowIndex[xi], 3*full.getColsIndex()[xj], full.getColsValue()[xj]);
+            if (m == 0) blocs.endAssembly();
+        }
+        EXPECT_TRUE(blocs.isAssemblyCached());
+        checkAssembly(blocs, 1.0, false);
+
+        FullVector<double> y, yScalar;
+        blocs.mul(y, x);
+        scalars.mul(yScalar, x);
+        EXPECT_LT(this->vectorMaxDiff(y, yScalar), 1e-12);
+    }
+
+    // a block which is not aligned on the blocs of the matrix is added value per value
+    BlocMatrix unaligned;
+    unaligned.resize(3*N, 3*N);
+    defaulttype::Mat3x3f b;
+    for (int r=0; r<3; ++r)
+        for (int c=0; c<3; ++c)
+            b[r][c] = (float)(3*r+c+1);
+    unaligned.addBlock33(1, 2, b);
+    for (int r=0; r<3; ++r)
+        for (int c=0; c<3; ++c)
+            EXPECT_EQ((double)(3*r+c+1), unaligned.element(1+r, 2+c));
+
+    // the default implementation, on a matrix which does not override it
+    FullMatrix<double> dense;
+    dense.resize(3*N, 3*N);
+    dense.clear();
+    dense.addBlock33(3, 1, b);
+    for (int r=0; r<3; ++r)
+        for (int c=0; c<3; ++c)
+            EXPECT_EQ((double)(3*r+c+1), dense.element(3+r, 1+c));
+}
+
+}// namespace sofa
@@ -0,0 +1,165 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2016 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU General Public License as published by the Free  *
+* Software Foundation; either version 2 of the License, or (at your option)   *
+* any later version.                                                          *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for    *
+* more details.                                                               *
+*                                                                             *
+* You should have received a copy of the GNU General Public License along     *
+* with this program; if not, write to the Free Software Foundation, Inc., 51  *
+* Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA.                   *
+*******************************************************************************
+*                            SOFA :: Applications                             *
+*                                                                             *
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+
+#include <SofaTest/Sofa_test.h>
+
+#include <SofaBaseLinearSolver/PrecomputedMatrixCache.h>
+#include <sofa/core/objectmodel/Data.h>
+#include <sofa/helper/vector.h>
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <cstdio>
+#include <thread>
+
+namespace sofa {
+
+using component::linearsolver::PrecomputedMatrixCache;
+
+/** Versioned, memory-mapped files of precomputed matrices.
+  */
+struct PrecomputedMatrixCache_test : public Sofa_test<double>
+{
+    enum { ROWS = 30, COLS = 20 };
+
+    std::string filename;
+    helper::vector<double> values;
+    PrecomputedMatrixCache::Key key;
+
+    PrecomputedMatrixCache_test()
+        : filename("PrecomputedMatrixCache_test.comp")
+    {
+        values.resize(ROWS*COLS);
+        for (std::size_t i=0; i<values.size(); ++i)
+            values[i] = 0.5*i - 1.0;
+        key.add(std::string("PrecomputedMatrixCache_test"));
+        key.add(0.01);
+    }
+
+    ~PrecomputedMatrixCache_test()
+    {
+        std::remove(filename.c_str());
+    }
+};
+
+TEST_F(PrecomputedMatrixCache_test, writeAndMap)
+{
+    ASSERT_TRUE(PrecomputedMatrixCache::write<double>(filename, key, ROWS, COLS, &values[0]));
+
+    PrecomputedMatrixCache cache;
+    ASSERT_EQ(PrecomputedMatrixCache::VALID, cache.open<double>(filename, key, ROWS, COLS));
+    const double* mapped = cache.values<double>();
+    ASSERT_TRUE(mapped != NULL);
+    for (std::size_t i=0; i<values.size(); ++i)
+        ASSERT_EQ(values[i], mapped[i]);
+}
+
+TEST_F(PrecomputedMatrixCache_test, rejectOutdated)
+{
+    ASSERT_TRUE(PrecomputedMatrixCache::write<double>(filename, key, ROWS, COLS, &values[0]));
+
+    PrecomputedMatrixCache cache;
+    PrecomputedMatrixCache::Key otherKey = key;
+    otherKey.add(1.0);
+    EXPECT_EQ(PrecomputedMatrixCache::OUTDATED, cache.open<double>(filename, otherKey, ROWS, COLS));
+    EXPECT_EQ(PrecomputedMatrixCache::OUTDATED, cache.open<double>(filename, key, COLS, ROWS));
+    EXPECT_EQ(PrecomputedMatrixCache::OUTDATED, cache.open<float>(filename, key, ROWS, COLS));
+    EXPECT_EQ(PrecomputedMatrixCache::MISSING, cache.open<double>("PrecomputedMatrixCache_test_missing.comp", key, ROWS, COLS));
+}
+
+/// Writes of the same file at the same time, as done by simulations sharing the cache
+static void writeSeveralTimes(const std::string& filename, const PrecomputedMatrixCache::Key& key, const helper::vector<double>* values, bool* success)
+{
+    *success = true;
+    for (int i=0; i<20; ++i)
+        *success = PrecomputedMatrixCache::write<double>(filename, key, PrecomputedMatrixCache_test::ROWS, PrecomputedMatrixCache_test::COLS, &(*values)[0]) && *success;
+}
+
+TEST_F(PrecomputedMatrixCache_test, concurrentWrites)
+{
+    enum { NbWriters = 4 };
+    bool success[NbWriters];
+    std::thread writers[NbWriters];
+    for (int w=0; w<NbWriters; ++w)
+        writers[w] = std::thread(writeSeveralTimes, filename, key, &values, &success[w]);
+    for (int w=0; w<NbWriters; ++w)
+        writers[w].join();
+    for (int w=0; w<NbWriters; ++w)
+        EXPECT_TRUE(success[w]) << "writer " << w;
+
+    PrecomputedMatrixCache cache;
+    ASSERT_EQ(PrecomputedMatrixCache::VALID, cache.open<double>(filename, key, ROWS, COLS));
+    EXPECT_EQ(values[ROWS*COLS-1], cache.values<double>()[ROWS*COLS-1]);
+}
+
+#ifndef WIN32
+TEST_F(PrecomputedMatrixCache_test, replaceMappedFile)
+{
+    ASSERT_TRUE(PrecomputedMatrixCache::write<double>(filename, key, ROWS, COLS, &values[0]));
+    PrecomputedMatrixCache cache;
+    ASSERT_EQ(PrecomputedMatrixCache::VALID, cache.open<double>(filename, key, ROWS, COLS));
+
+    // the mapping of the previous version stays valid
+    helper::vector<double> otherValues(values.size(), 2.0);
+    ASSERT_TRUE(PrecomputedMatrixCache::write<double>(filename, key, ROWS, COLS, &otherValues[0]));
+    EXPECT_EQ(values[ROWS*COLS-1], cache.values<double>()[ROWS*COLS-1]);
+
+    PrecomputedMatrixCache newCache;
+    ASSERT_EQ(PrecomputedMatrixCache::VALID, newCache.open<double>(filename, key, ROWS, COLS));
+    EXPECT_EQ(2.0, newCache.values<double>()[ROWS*COLS-1]);
+}
+#endif
+
+TEST_F(PrecomputedMatrixCache_test, legacyFile)
+{
+    {
+        std::ofstream out(filename.c_str(), std::fstream::out | std::fstream::binary);
+        out.write((const char*)&values[0], values.size()*sizeof(double));
+    }
+    PrecomputedMatrixCache cache;
+    ASSERT_EQ(PrecomputedMatrixCache::LEGACY, cache.open<double>(filename, key, ROWS, COLS));
+    EXPECT_EQ(values[ROWS*COLS-1], cache.values<double>()[ROWS*COLS-1]);
+}
+
+TEST_F(PrecomputedMatrixCache_test, dataKey)
+{
+    core::objectmodel::Data< helper::vector<double> > data("data");
+    helper::vector<double> v(3, 1.0);
+    data.setValue(v);
+
+    PrecomputedMatrixCache::Key k0, k1, k2;
+    k0.addData(&data);
+    k1.addData(&data);
+    EXPECT_EQ(k0.value(), k1.value());
+
+    v[2] += 1e-12;
+    data.setValue(v);
+    k2.addData(&data);
+    EXPECT_NE(k0.value(), k2.value());
+    EXPECT_EQ(16u, k0.str().size());
+}
+
+} // namespace sofa
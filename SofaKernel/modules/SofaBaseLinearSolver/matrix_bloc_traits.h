@@ -29,6 +29,10 @@
 #include <sofa/defaulttype/Mat.h>
 #include <sofa/defaulttype/BaseMatrix.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 namespace sofa
 {
 
@@ -237,6 +241,49 @@ public:
     static const char* Name() { return "f"; }
 };
 
+
+/// Block-vector product accumulated in r: r += b * v
+template<class TBloc, class Real2>
+class bloc_mul_add
+{
+public:
+    typedef matrix_bloc_traits<TBloc> traits;
+    enum { NL = traits::NL };
+    enum { NC = traits::NC };
+
+    static void apply(defaulttype::Vec<NL,Real2>& r, const TBloc& b, const defaulttype::Vec<NC,Real2>& v)
+    {
+        for (int bi = 0; bi < NL; ++bi)
+            for (int bj = 0; bj < NC; ++bj)
+                r[bi] += traits::v(b, bi, bj) * v[bj];
+    }
+};
+
+#if defined(__SSE2__)
+/// 3x3 blocks of doubles: the first two rows are computed together in a SSE2 register.
+/// Each entry of r accumulates the same products in the same order as the generic version.
+template<>
+class bloc_mul_add< defaulttype::Mat<3,3,double>, double >
+{
+public:
+    enum { NL = 3 };
+    enum { NC = 3 };
+
+    static void apply(defaulttype::Vec<3,double>& r, const defaulttype::Mat<3,3,double>& b, const defaulttype::Vec<3,double>& v)
+    {
+        __m128d r01 = _mm_loadu_pd(r.ptr());
+        double r2 = r[2];
+        for (int bj = 0; bj < 3; ++bj)
+        {
+            r01 = _mm_add_pd(r01, _mm_mul_pd(_mm_setr_pd(b[0][bj], b[1][bj]), _mm_set1_pd(v[bj])));
+            r2 += b[2][bj] * v[bj];
+        }
+        _mm_storeu_pd(r.ptr(), r01);
+        r[2] = r2;
+    }
+};
+#endif
+
 } // namespace linearsolver
 
 } // namespace component
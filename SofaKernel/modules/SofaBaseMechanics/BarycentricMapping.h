@@ -167,6 +167,21 @@ public:
     typedef MappingData<3,0> MappingData3D;
 
 protected:
+    /// Weights of the corners of a hexahedron, given in the order (0,0,0) (1,0,0) (0,1,0) (1,1,0) (0,0,1) (1,0,1) (0,1,1) (1,1,1)
+    static void getCubeWeights( unsigned int c000, unsigned int c100, unsigned int c010, unsigned int c110,
+                                unsigned int c001, unsigned int c101, unsigned int c011, unsigned int c111,
+                                Real fx, Real fy, Real fz, unsigned int* index, Real* weight )
+    {
+        index[0] = c000; weight[0] = ( 1-fx ) * ( 1-fy ) * ( 1-fz );
+        index[1] = c100; weight[1] = ( fx ) * ( 1-fy ) * ( 1-fz );
+        index[2] = c010; weight[2] = ( 1-fx ) * ( fy ) * ( 1-fz );
+        index[3] = c110; weight[3] = ( fx ) * ( fy ) * ( 1-fz );
+        index[4] = c001; weight[4] = ( 1-fx ) * ( 1-fy ) * ( fz );
+        index[5] = c101; weight[5] = ( fx ) * ( 1-fy ) * ( fz );
+        index[6] = c011; weight[6] = ( 1-fx ) * ( fy ) * ( fz );
+        index[7] = c111; weight[7] = ( fx ) * ( fy ) * ( fz );
+    }
+
     BarycentricMapper() {}
     virtual ~BarycentricMapper() {}
 	
@@ -187,6 +202,19 @@ public:
     virtual void applyJT( typename In::VecDeriv& out, const typename Out::VecDeriv& in ) = 0;
     virtual void applyJT( typename In::MatrixDeriv& out, const typename Out::MatrixDeriv& in ) = 0;
 
+    /// @name Interpolation weights, used by BarycentricMapping to compute the mapping on several threads
+    /// @{
+
+    /// Maximum number of parents of a mapped point, or 0 if getPointWeights is not implemented.
+    /// Called from a single thread before any call to getPointWeights.
+    virtual unsigned int getMaxPointWeights() { return 0; }
+
+    /// Write the parents of the mapped point i and their weights, in the order they are summed by apply,
+    /// and return their number, at most getMaxPointWeights(). May be called concurrently from several threads.
+    virtual unsigned int getPointWeights( unsigned int /*i*/, unsigned int* /*index*/, Real* /*weight*/ ) const { return 0; }
+
+    /// @}
+
     using core::objectmodel::BaseObject::draw;
     virtual void draw(const core::visual::VisualParams*, const typename Out::VecCoord& out, const typename In::VecCoord& in) = 0;
 
@@ -339,6 +367,9 @@ public:
     void applyJ( typename Out::VecDeriv& out, const typename In::VecDeriv& in );
     void applyJT( typename In::VecDeriv& out, const typename Out::VecDeriv& in );
     void applyJT( typename In::MatrixDeriv& out, const typename Out::MatrixDeriv& in );
+
+    virtual unsigned int getMaxPointWeights();
+    virtual unsigned int getPointWeights( unsigned int i, unsigned int* index, Real* weight ) const;
     const sofa::defaulttype::BaseMatrix* getJ(int outSize, int inSize);
     void draw(const core::visual::VisualParams*,const typename Out::VecCoord& out, const typename In::VecCoord& in);
     virtual void resize( core::State<Out>* toModel );
@@ -463,6 +494,9 @@ public:
     void applyJ( typename Out::VecDeriv& out, const typename In::VecDeriv& in );
     void applyJT( typename In::VecDeriv& out, const typename Out::VecDeriv& in );
     void applyJT( typename In::MatrixDeriv& out, const typename Out::MatrixDeriv& in );
+
+    virtual unsigned int getMaxPointWeights();
+    virtual unsigned int getPointWeights( unsigned int i, unsigned int* index, Real* weight ) const;
     const sofa::defaulttype::BaseMatrix* getJ(int outSize, int inSize);
     void draw(const core::visual::VisualParams*,const typename Out::VecCoord& out, const typename In::VecCoord& in);
     virtual void resize( core::State<Out>* toModel );
@@ -541,6 +575,9 @@ public:
     void applyJ( typename Out::VecDeriv& out, const typename In::VecDeriv& in );
     void applyJT( typename In::VecDeriv& out, const typename Out::VecDeriv& in );
     void applyJT( typename In::MatrixDeriv& out, const typename Out::MatrixDeriv& in );
+
+    virtual unsigned int getMaxPointWeights();
+    virtual unsigned int getPointWeights( unsigned int i, unsigned int* index, Real* weight ) const;
     const sofa::defaulttype::BaseMatrix* getJ(int outSize, int inSize);
     void draw(const core::visual::VisualParams*,const typename Out::VecCoord& out, const typename In::VecCoord& in);
     virtual void resize( core::State<Out>* toModel );
@@ -613,6 +650,9 @@ public:
     void applyJT( typename In::VecDeriv& out, const typename Out::VecDeriv& in );
     void applyJT( typename In::MatrixDeriv& out, const typename Out::MatrixDeriv& in );
 
+    virtual unsigned int getMaxPointWeights();
+    virtual unsigned int getPointWeights( unsigned int i, unsigned int* index, Real* weight ) const;
+
     virtual const sofa::defaulttype::BaseMatrix* getJ(int outSize, int inSize);
 
     void draw(const core::visual::VisualParams*,const typename Out::VecCoord& out, const typename In::VecCoord& in);
@@ -702,6 +742,9 @@ public:
     void applyJT( typename In::VecDeriv& out, const typename Out::VecDeriv& in );
     void applyJT( typename In::MatrixDeriv& out, const typename Out::MatrixDeriv& in );
 
+    virtual unsigned int getMaxPointWeights();
+    virtual unsigned int getPointWeights( unsigned int i, unsigned int* index, Real* weight ) const;
+
     virtual const sofa::defaulttype::BaseMatrix* getJ(int outSize, int inSize);
 
     void draw(const core::visual::VisualParams*,const typename Out::VecCoord& out, const typename In::VecCoord& in);
@@ -791,6 +834,9 @@ public:
     void applyJT( typename In::VecDeriv& out, const typename Out::VecDeriv& in );
     void applyJT( typename In::MatrixDeriv& out, const typename Out::MatrixDeriv& in );
 
+    virtual unsigned int getMaxPointWeights();
+    virtual unsigned int getPointWeights( unsigned int i, unsigned int* index, Real* weight ) const;
+
     virtual const sofa::defaulttype::BaseMatrix* getJ(int outSize, int inSize);
 
     void draw(const core::visual::VisualParams*,const typename Out::VecCoord& out, const typename In::VecCoord& in);
@@ -882,6 +928,9 @@ public:
     void applyJT( typename In::VecDeriv& out, const typename Out::VecDeriv& in );
     void applyJT( typename In::MatrixDeriv& out, const typename Out::MatrixDeriv& in );
 
+    virtual unsigned int getMaxPointWeights();
+    virtual unsigned int getPointWeights( unsigned int i, unsigned int* index, Real* weight ) const;
+
     virtual const sofa::defaulttype::BaseMatrix* getJ(int outSize, int inSize);
 
     void draw(const core::visual::VisualParams*,const typename Out::VecCoord& out, const typename In::VecCoord& in);
@@ -954,6 +1003,9 @@ public:
     void applyJT( typename In::VecDeriv& out, const typename Out::VecDeriv& in );
     void applyJT( typename In::MatrixDeriv& out, const typename Out::MatrixDeriv& in );
 
+    virtual unsigned int getMaxPointWeights();
+    virtual unsigned int getPointWeights( unsigned int i, unsigned int* index, Real* weight ) const;
+
     virtual const sofa::defaulttype::BaseMatrix* getJ(int outSize, int inSize);
 
     void draw(const core::visual::VisualParams*,const typename Out::VecCoord& out, const typename In::VecCoord& in);
@@ -1000,6 +1052,64 @@ public:
 
 
 
+/// Interpolation weights of a BarycentricMapper, stored in flat arrays with a fixed number of parents
+/// per mapped point, and transposed per parent point. apply and applyJ compute each mapped point
+/// independently, and applyJT lets each parent point gather the contributions of its own children,
+/// so that the three can be spread over the TaskScheduler threads without any write conflict.
+template<class In, class Out>
+class BarycentricWeightTable
+{
+public:
+    typedef typename In::Real Real;
+    typedef typename Out::Real OutReal;
+    typedef BarycentricMapper<In,Out> Mapper;
+    typedef typename core::behavior::BaseMechanicalState::ForceMask ForceMask;
+
+    BarycentricWeightTable() : stride(0), nbParents(0), dirty(true) {}
+
+    /// Read the weights of nbPoints mapped points from the mapper if they were invalidated or the
+    /// numbers of points changed, the transposed table being rebuilt only if a weight changed.
+    /// Return false if the mapper does not provide its weights.
+    bool update( Mapper& mapper, std::size_t nbPoints, std::size_t nbParents );
+
+    /// Mark the weights of the mapper as changed, so that the next update reads them again
+    void invalidate() { dirty = true; }
+
+    /// Whether the table was built for these numbers of mapped and parent points
+    bool isValid( std::size_t nbPoints, std::size_t nbParents ) const
+    {
+        return stride > 0 && index.size() == nbPoints*stride && this->nbParents == nbParents;
+    }
+
+    /// Number of mapped points
+    std::size_t size() const { return stride ? index.size() / stride : 0; }
+
+    void apply( typename Out::VecCoord& out, const typename In::VecCoord& in ) const;
+    void applyJ( typename Out::VecDeriv& out, const typename In::VecDeriv& in, const ForceMask& maskTo ) const;
+    void applyJT( typename In::VecDeriv& out, const typename Out::VecDeriv& in, const ForceMask& maskTo, ForceMask& maskFrom );
+
+protected:
+    enum { POINTS_PER_TASK = 256 };
+
+    class UpdateFunctor;
+    class ApplyFunctor;
+    class ApplyJFunctor;
+    class ApplyJTFunctor;
+
+    void transpose();
+
+    unsigned int stride;                        ///< number of parents per mapped point
+    std::size_t nbParents;
+    bool dirty;                                 ///< the weights of the mapper may have changed since the last update
+    helper::vector<unsigned int> index;         ///< parents of the mapped point i, in [i*stride,(i+1)*stride)
+    helper::vector<Real> weight;
+    helper::vector<unsigned int> nbWeights;     ///< number of parents of the mapped point i, the next entries being padding
+    helper::vector<unsigned int> childBegin;    ///< children of the parent point j, in [childBegin[j],childBegin[j+1])
+    helper::vector<unsigned int> childIndex;
+    helper::vector<Real> childWeight;
+    helper::vector<unsigned char> activeParents; ///< parents reached by applyJT, inserted afterwards in maskFrom, even with a null weight
+};
+
 template <class TIn, class TOut>
 class BarycentricMapping : public core::Mapping<TIn, TOut>
 {
@@ -1037,6 +1147,7 @@ protected:
 public:
 
     Data< bool > useRestPosition;
+    Data< bool > d_parallel;
 
 #ifdef SOFA_DEV
     //--- partial mapping test
@@ -1077,6 +1188,8 @@ protected:
     eigen_type eigen;
     helper::vector< defaulttype::BaseMatrix* > js;
 
+    BarycentricWeightTable<InDataTypes,OutDataTypes> weightTable;
+
     virtual void updateForceMask();
 
 public:
@@ -1086,6 +1199,9 @@ public:
     // handle topology changes depending on the topology
     virtual void handleTopologyChange(core::topology::Topology* t);
 
+    /// Mark the weights of the mapper as changed, for the mappers filled outside of init (e.g. by the contact mappers)
+    void invalidateWeights() { weightTable.invalidate(); }
+
     // interface for continuous friction contact
 
 
@@ -50,8 +50,10 @@
 #include <sofa/helper/system/config.h>
 
 #include <sofa/simulation/Simulation.h>
+#include <sofa/simulation/ParallelFor.h>
 
 #include <algorithm>
+#include <functional>
 #include <iostream>
 
 //#include <SofaMeshCollision/MeshIntTool.h>
@@ -71,6 +73,7 @@ BarycentricMapping<TIn, TOut>::BarycentricMapping()
     : Inherit()
     , mapper(initLink("mapper","Internal mapper created depending on the type of topology"))
     , useRestPosition(core::objectmodel::Base::initData(&useRestPosition, false, "useRestPosition", "Use the rest position of the input and output models to initialize the mapping"))
+    , d_parallel(core::objectmodel::Base::initData(&d_parallel, false, "parallel", "Compute the mapping on several threads, from a table of the interpolation weights read again after init, reinit or a topology change"))
 #ifdef SOFA_DEV
     , sleeping(core::objectmodel::Base::initData(&sleeping, false, "sleeping", "is the mapping sleeping (not computed)"))
 #endif
@@ -81,6 +84,7 @@ template <class TIn, class TOut>
 BarycentricMapping<TIn, TOut>::BarycentricMapping(core::State<In>* from, core::State<Out>* to, typename Mapper::SPtr mapper)
     : Inherit ( from, to )
     , mapper(initLink("mapper","Internal mapper created depending on the type of topology"), mapper)
+    , d_parallel(core::objectmodel::Base::initData(&d_parallel, false, "parallel", "Compute the mapping on several threads, from a table of the interpolation weights read again after init, reinit or a topology change"))
 #ifdef SOFA_DEV
     , sleeping(core::objectmodel::Base::initData(&sleeping, false, "sleeping", "is the mapping sleeping (not computed)"))
 #endif
@@ -93,6 +97,7 @@ template <class TIn, class TOut>
 BarycentricMapping<TIn, TOut>::BarycentricMapping (core::State<In>* from, core::State<Out>* to, BaseMeshTopology * topology )
     : Inherit ( from, to )
     , mapper (initLink("mapper","Internal mapper created depending on the type of topology"))
+    , d_parallel(core::objectmodel::Base::initData(&d_parallel, false, "parallel", "Compute the mapping on several threads, from a table of the interpolation weights read again after init, reinit or a topology change"))
 #ifdef SOFA_DEV
     , sleeping(core::objectmodel::Base::initData(&sleeping, false, "sleeping", "is the mapping sleeping (not computed)"))
 #endif
@@ -1150,6 +1155,7 @@ void BarycentricMapping<TIn, TOut>::init()
         serr << "ERROR: Barycentric mapping does not understand topology."<<sendl;
     }
 
+    weightTable.invalidate();
 }
 
 template <class TIn, class TOut>
@@ -1160,6 +1166,7 @@ void BarycentricMapping<TIn, TOut>::reinit()
         mapper->clear();
         mapper->init (((const core::State<Out> *)this->toModel)->read(core::ConstVecCoordId::position())->getValue(), ((const core::State<In> *)this->fromModel)->read(core::ConstVecCoordId::position())->getValue() );
     }
+    weightTable.invalidate();
 }
 
 template <class TIn, class TOut>
@@ -1172,7 +1179,11 @@ void BarycentricMapping<TIn, TOut>::apply(const core::MechanicalParams * /*mpara
         mapper != NULL)
     {
         mapper->resize( this->toModel );
-        mapper->apply(*out.beginWriteOnly(), in.getValue());
+        const typename In::VecCoord& x = in.getValue();
+        if (d_parallel.getValue() && weightTable.update(*mapper, this->toModel->getSize(), x.size()))
+            weightTable.apply(*out.beginWriteOnly(), x);
+        else
+            mapper->apply(*out.beginWriteOnly(), x);
         out.endEdit();
     }
 }
@@ -1539,6 +1550,459 @@ void BarycentricMapperHexahedronSetTopology<In,Out>::applyOnePoint( const unsign
 }
 //--
 
+template <class In, class Out>
+unsigned int BarycentricMapperMeshTopology<In,Out>::getMaxPointWeights()
+{
+    // the elements are requested once here, as the topology may compute them on demand
+    this->fromTopology->getLines();
+    this->fromTopology->getTriangles();
+    this->fromTopology->getQuads();
+    const int c0 = this->fromTopology->getTetrahedra().size();
+#ifdef SOFA_NEW_HEXA
+    this->fromTopology->getHexahedra();
+#else
+    this->fromTopology->getCubes();
+#endif
+    for ( unsigned int i=0; i<map3d.size(); i++ )
+        if ( map3d[i].in_index >= c0 )
+            return 8;
+    return ( map2d.empty() && map3d.empty() ) ? 2 : 4;
+}
+
+template <class In, class Out>
+unsigned int BarycentricMapperMeshTopology<In,Out>::getPointWeights( unsigned int i, unsigned int* index, Real* weight ) const
+{
+    if ( i < map1d.size() )
+    {
+        const Real fx = map1d[i].baryCoords[0];
+        const sofa::core::topology::BaseMeshTopology::Line& line = this->fromTopology->getLines()[map1d[i].in_index];
+        index[0] = line[0]; weight[0] = 1-fx;
+        index[1] = line[1]; weight[1] = fx;
+        return 2;
+    }
+    i -= map1d.size();
+    if ( i < map2d.size() )
+    {
+        const Real fx = map2d[i].baryCoords[0];
+        const Real fy = map2d[i].baryCoords[1];
+        const int c0 = this->fromTopology->getTriangles().size();
+        const int elem = map2d[i].in_index;
+        if ( elem<c0 )
+        {
+            const sofa::core::topology::BaseMeshTopology::Triangle& triangle = this->fromTopology->getTriangles()[elem];
+            index[0] = triangle[0]; weight[0] = 1-fx-fy;
+            index[1] = triangle[1]; weight[1] = fx;
+            index[2] = triangle[2]; weight[2] = fy;
+            return 3;
+        }
+        const sofa::core::topology::BaseMeshTopology::SeqQuads& quads = this->fromTopology->getQuads();
+        if ( quads.empty() )
+            return 0;
+        const sofa::core::topology::BaseMeshTopology::Quad& quad = quads[elem-c0];
+        index[0] = quad[0]; weight[0] = ( 1-fx ) * ( 1-fy );
+        index[1] = quad[1]; weight[1] = ( fx ) * ( 1-fy );
+        index[2] = quad[3]; weight[2] = ( 1-fx ) * ( fy );
+        index[3] = quad[2]; weight[3] = ( fx ) * ( fy );
+        return 4;
+    }
+    i -= map2d.size();
+    const Real fx = map3d[i].baryCoords[0];
+    const Real fy = map3d[i].baryCoords[1];
+    const Real fz = map3d[i].baryCoords[2];
+    const int c0 = this->fromTopology->getTetrahedra().size();
+    const int elem = map3d[i].in_index;
+    if ( elem<c0 )
+    {
+        const sofa::core::topology::BaseMeshTopology::Tetra& tetra = this->fromTopology->getTetrahedra()[elem];
+        index[0] = tetra[0]; weight[0] = 1-fx-fy-fz;
+        index[1] = tetra[1]; weight[1] = fx;
+        index[2] = tetra[2]; weight[2] = fy;
+        index[3] = tetra[3]; weight[3] = fz;
+        return 4;
+    }
+#ifdef SOFA_NEW_HEXA
+    const sofa::core::topology::BaseMeshTopology::Hexa& cube = this->fromTopology->getHexahedra()[elem-c0];
+    this->getCubeWeights( cube[0], cube[1], cube[3], cube[2], cube[4], cube[5], cube[7], cube[6], fx, fy, fz, index, weight );
+#else
+    const sofa::core::topology::BaseMeshTopology::Cube& cube = this->fromTopology->getCubes()[elem-c0];
+    this->getCubeWeights( cube[0], cube[1], cube[2], cube[3], cube[4], cube[5], cube[6], cube[7], fx, fy, fz, index, weight );
+#endif
+    return 8;
+}
+
+template <class In, class Out>
+unsigned int BarycentricMapperRegularGridTopology<In,Out>::getMaxPointWeights()
+{
+    return 8;
+}
+
+template <class In, class Out>
+unsigned int BarycentricMapperRegularGridTopology<In,Out>::getPointWeights( unsigned int i, unsigned int* index, Real* weight ) const
+{
+    const Real fx = map[i].baryCoords[0];
+    const Real fy = map[i].baryCoords[1];
+    const Real fz = map[i].baryCoords[2];
+#ifdef SOFA_NEW_HEXA
+    const topology::RegularGridTopology::Hexa cube = this->fromTopology->getHexaCopy ( map[i].in_index );
+    this->getCubeWeights( cube[0], cube[1], cube[3], cube[2], cube[4], cube[5], cube[7], cube[6], fx, fy, fz, index, weight );
+#else
+    const topology::RegularGridTopology::Cube cube = this->fromTopology->getCubeCopy ( map[i].in_index );
+    this->getCubeWeights( cube[0], cube[1], cube[2], cube[3], cube[4], cube[5], cube[6], cube[7], fx, fy, fz, index, weight );
+#endif
+    return 8;
+}
+
+template <class In, class Out>
+unsigned int BarycentricMapperSparseGridTopology<In,Out>::getMaxPointWeights()
+{
+#ifdef SOFA_NEW_HEXA
+    this->fromTopology->getHexahedra();
+#else
+    this->fromTopology->getCubes();
+#endif
+    return 8;
+}
+
+template <class In, class Out>
+unsigned int BarycentricMapperSparseGridTopology<In,Out>::getPointWeights( unsigned int i, unsigned int* index, Real* weight ) const
+{
+    const Real fx = map[i].baryCoords[0];
+    const Real fy = map[i].baryCoords[1];
+    const Real fz = map[i].baryCoords[2];
+#ifdef SOFA_NEW_HEXA
+    const topology::SparseGridTopology::Hexa& cube = this->fromTopology->getHexahedra()[map[i].in_index];
+    this->getCubeWeights( cube[0], cube[1], cube[3], cube[2], cube[4], cube[5], cube[7], cube[6], fx, fy, fz, index, weight );
+#else
+    const topology::SparseGridTopology::Cube& cube = this->fromTopology->getCubes()[map[i].in_index];
+    this->getCubeWeights( cube[0], cube[1], cube[2], cube[3], cube[4], cube[5], cube[6], cube[7], fx, fy, fz, index, weight );
+#endif
+    return 8;
+}
+
+template <class In, class Out>
+unsigned int BarycentricMapperEdgeSetTopology<In,Out>::getMaxPointWeights()
+{
+    this->fromTopology->getEdges();
+    return 2;
+}
+
+template <class In, class Out>
+unsigned int BarycentricMapperEdgeSetTopology<In,Out>::getPointWeights( unsigned int i, unsigned int* index, Real* weight ) const
+{
+    const Real fx = map.getValue()[i].baryCoords[0];
+    const core::topology::BaseMeshTopology::Edge& edge = this->fromTopology->getEdges()[map.getValue()[i].in_index];
+    index[0] = edge[0]; weight[0] = 1-fx;
+    index[1] = edge[1]; weight[1] = fx;
+    return 2;
+}
+
+template <class In, class Out>
+unsigned int BarycentricMapperTriangleSetTopology<In,Out>::getMaxPointWeights()
+{
+    this->fromTopology->getTriangles();
+    return 3;
+}
+
+template <class In, class Out>
+unsigned int BarycentricMapperTriangleSetTopology<In,Out>::getPointWeights( unsigned int i, unsigned int* index, Real* weight ) const
+{
+    const Real fx = map.getValue()[i].baryCoords[0];
+    const Real fy = map.getValue()[i].baryCoords[1];
+    const core::topology::BaseMeshTopology::Triangle& triangle = this->fromTopology->getTriangles()[map.getValue()[i].in_index];
+    index[0] = triangle[0]; weight[0] = 1-fx-fy;
+    index[1] = triangle[1]; weight[1] = fx;
+    index[2] = triangle[2]; weight[2] = fy;
+    return 3;
+}
+
+template <class In, class Out>
+unsigned int BarycentricMapperQuadSetTopology<In,Out>::getMaxPointWeights()
+{
+    this->fromTopology->getQuads();
+    return 4;
+}
+
+template <class In, class Out>
+unsigned int BarycentricMapperQuadSetTopology<In,Out>::getPointWeights( unsigned int i, unsigned int* index, Real* weight ) const
+{
+    const Real fx = map.getValue()[i].baryCoords[0];
+    const Real fy = map.getValue()[i].baryCoords[1];
+    const core::topology::BaseMeshTopology::Quad& quad = this->fromTopology->getQuads()[map.getValue()[i].in_index];
+    index[0] = quad[0]; weight[0] = ( 1-fx ) * ( 1-fy );
+    index[1] = quad[1]; weight[1] = ( fx ) * ( 1-fy );
+    index[2] = quad[3]; weight[2] = ( 1-fx ) * ( fy );
+    index[3] = quad[2]; weight[3] = ( fx ) * ( fy );
+    return 4;
+}
+
+template <class In, class Out>
+unsigned int BarycentricMapperTetrahedronSetTopology<In,Out>::getMaxPointWeights()
+{
+    this->fromTopology->getTetrahedra();
+    return 4;
+}
+
+template <class In, class Out>
+unsigned int BarycentricMapperTetrahedronSetTopology<In,Out>::getPointWeights( unsigned int i, unsigned int* index, Real* weight ) const
+{
+    const Real fx = map.getValue()[i].baryCoords[0];
+    const Real fy = map.getValue()[i].baryCoords[1];
+    const Real fz = map.getValue()[i].baryCoords[2];
+    const core::topology::BaseMeshTopology::Tetrahedron& tetra = this->fromTopology->getTetrahedra()[map.getValue()[i].in_index];
+    index[0] = tetra[0]; weight[0] = 1-fx-fy-fz;
+    index[1] = tetra[1]; weight[1] = fx;
+    index[2] = tetra[2]; weight[2] = fy;
+    index[3] = tetra[3]; weight[3] = fz;
+    return 4;
+}
+
+template <class In, class Out>
+unsigned int BarycentricMapperHexahedronSetTopology<In,Out>::getMaxPointWeights()
+{
+    this->fromTopology->getHexahedra();
+    return 8;
+}
+
+template <class In, class Out>
+unsigned int BarycentricMapperHexahedronSetTopology<In,Out>::getPointWeights( unsigned int i, unsigned int* index, Real* weight ) const
+{
+    const Real fx = map.getValue()[i].baryCoords[0];
+    const Real fy = map.getValue()[i].baryCoords[1];
+    const Real fz = map.getValue()[i].baryCoords[2];
+    const core::topology::BaseMeshTopology::Hexahedron& cube = this->fromTopology->getHexahedra()[map.getValue()[i].in_index];
+    this->getCubeWeights( cube[0], cube[1], cube[3], cube[2], cube[4], cube[5], cube[7], cube[6], fx, fy, fz, index, weight );
+    return 8;
+}
+
+
+/// Copy the weights of the mapped points [first,last) from the mapper, and count the points whose weights changed
+template <class In, class Out>
+class BarycentricWeightTable<In,Out>::UpdateFunctor
+{
+public:
+    UpdateFunctor(const Mapper& mapper, BarycentricWeightTable& table) : mapper(mapper), table(table) {}
+
+    std::size_t operator()(std::size_t first, std::size_t last) const
+    {
+        const unsigned int stride = table.stride;
+        helper::vector<unsigned int> index(stride);
+        helper::vector<Real> weight(stride);
+        std::size_t changed = 0;
+        for (std::size_t i=first; i<last; ++i)
+        {
+            const unsigned int n = mapper.getPointWeights((unsigned int)i, &index[0], &weight[0]);
+            for (unsigned int k=n; k<stride; ++k)
+            {
+                index[k] = 0;
+                weight[k] = (Real)0;
+            }
+            bool pointChanged = false;
+            if (table.nbWeights[i] != n)
+            {
+                table.nbWeights[i] = n;
+                pointChanged = true;
+            }
+            for (unsigned int k=0; k<stride; ++k)
+            {
+                const std::size_t e = i*stride+k;
+                if (table.index[e] != index[k] || table.weight[e] != weight[k])
+                {
+                    table.index[e] = index[k];
+                    table.weight[e] = weight[k];
+                    pointChanged = true;
+                }
+            }
+            if (pointChanged)
+                ++changed;
+        }
+        return changed;
+    }
+
+protected:
+    const Mapper& mapper;
+    BarycentricWeightTable& table;
+};
+
+template <class In, class Out>
+class BarycentricWeightTable<In,Out>::ApplyFunctor
+{
+public:
+    ApplyFunctor(const BarycentricWeightTable& table, typename Out::VecCoord& out, const typename In::VecCoord& in)
+        : table(table), out(out), in(in) {}
+
+    void operator()(std::size_t first, std::size_t last) const
+    {
+        const unsigned int stride = table.stride;
+        for (std::size_t i=first; i<last; ++i)
+        {
+            const unsigned int* index = &table.index[i*stride];
+            const Real* weight = &table.weight[i*stride];
+            typename In::Coord p = in[index[0]] * weight[0];
+            for (unsigned int k=1; k<stride; ++k)
+                p += in[index[k]] * weight[k];
+            Out::setCPos(out[i], p);
+        }
+    }
+
+protected:
+    const BarycentricWeightTable& table;
+    typename Out::VecCoord& out;
+    const typename In::VecCoord& in;
+};
+
+template <class In, class Out>
+class BarycentricWeightTable<In,Out>::ApplyJFunctor
+{
+public:
+    ApplyJFunctor(const BarycentricWeightTable& table, typename Out::VecDeriv& out, const typename In::VecDeriv& in, const ForceMask& maskTo)
+        : table(table), out(out), in(in), maskTo(maskTo) {}
+
+    void operator()(std::size_t first, std::size_t last) const
+    {
+        const unsigned int stride = table.stride;
+        for (std::size_t i=first; i<last; ++i)
+        {
+            if( maskTo.isActivated() && !maskTo.getEntry(i) ) continue;
+
+            const unsigned int* index = &table.index[i*stride];
+            const Real* weight = &table.weight[i*stride];
+            typename In::Deriv v = in[index[0]] * weight[0];
+            for (unsigned int k=1; k<stride; ++k)
+                v += in[index[k]] * weight[k];
+            Out::setDPos(out[i], v);
+        }
+    }
+
+protected:
+    const BarycentricWeightTable& table;
+    typename Out::VecDeriv& out;
+    const typename In::VecDeriv& in;
+    const ForceMask& maskTo;
+};
+
+/// Each parent point of [first,last) accumulates the forces of its children, in increasing order
+/// of the children as the serial loop of the mappers does
+template <class In, class Out>
+class BarycentricWeightTable<In,Out>::ApplyJTFunctor
+{
+public:
+    ApplyJTFunctor(BarycentricWeightTable& table, typename In::VecDeriv& out, const typename Out::VecDeriv& in, const ForceMask& maskTo)
+        : table(table), out(out), in(in), maskTo(maskTo) {}
+
+    void operator()(std::size_t first, std::size_t last) const
+    {
+        const std::size_t nbChildren = std::min(maskTo.size(), in.size());
+        for (std::size_t j=first; j<last; ++j)
+        {
+            unsigned char active = 0;
+            for (unsigned int c=table.childBegin[j]; c<table.childBegin[j+1]; ++c)
+            {
+                const unsigned int i = table.childIndex[c];
+                if( i >= nbChildren || !maskTo.getEntry(i) ) continue;
+
+                out[j] += Out::getDPos(in[i]) * (OutReal)table.childWeight[c];
+                active = 1;
+            }
+            table.activeParents[j] = active;
+        }
+    }
+
+protected:
+    BarycentricWeightTable& table;
+    typename In::VecDeriv& out;
+    const typename Out::VecDeriv& in;
+    const ForceMask& maskTo;
+};
+
+template <class In, class Out>
+bool BarycentricWeightTable<In,Out>::update( Mapper& mapper, std::size_t nbPoints, std::size_t nbParents )
+{
+    const unsigned int maxWeights = mapper.getMaxPointWeights();
+    if (!maxWeights)
+    {
+        stride = 0;
+        index.clear();
+        weight.clear();
+        nbWeights.clear();
+        return false;
+    }
+
+    bool resized = false;
+    if (maxWeights != stride || index.size() != nbPoints*maxWeights || nbParents != this->nbParents)
+    {
+        stride = maxWeights;
+        this->nbParents = nbParents;
+        index.assign(nbPoints*stride, 0u);
+        weight.assign(nbPoints*stride, (Real)0);
+        nbWeights.assign(nbPoints, 0u);
+        resized = true;
+    }
+    else if (!dirty)
+        return true;
+
+    const std::size_t changed = simulation::parallelReduce(0, nbPoints, (std::size_t)0, UpdateFunctor(mapper, *this), std::plus<std::size_t>(), POINTS_PER_TASK);
+    if (changed > 0 || resized)
+        transpose();
+    dirty = false;
+    return true;
+}
+
+/// Counting sort of the weights by parent point, the null ones included as the mappers also
+/// insert these parents in maskFrom
+template <class In, class Out>
+void BarycentricWeightTable<In,Out>::transpose()
+{
+    const std::size_t nbPoints = nbWeights.size();
+    childBegin.assign(nbParents+1, 0u);
+    for (std::size_t i=0; i<nbPoints; ++i)
+        for (unsigned int k=0; k<nbWeights[i]; ++k)
+            if (index[i*stride+k] < nbParents)
+                ++childBegin[index[i*stride+k]+1];
+    for (std::size_t j=0; j<nbParents; ++j)
+        childBegin[j+1] += childBegin[j];
+
+    childIndex.resize(childBegin[nbParents]);
+    childWeight.resize(childBegin[nbParents]);
+    helper::vector<unsigned int> cursor(childBegin.begin(), childBegin.end()-1);
+    for (std::size_t i=0; i<nbPoints; ++i)
+    {
+        for (unsigned int k=0; k<nbWeights[i]; ++k)
+        {
+            const std::size_t e = i*stride+k;
+            if (index[e] >= nbParents) continue;
+            const unsigned int c = cursor[index[e]]++;
+            childIndex[c] = (unsigned int)i;
+            childWeight[c] = weight[e];
+        }
+    }
+}
+
+template <class In, class Out>
+void BarycentricWeightTable<In,Out>::apply( typename Out::VecCoord& out, const typename In::VecCoord& in ) const
+{
+    out.resize(size());
+    simulation::parallelFor(0, size(), ApplyFunctor(*this, out, in), POINTS_PER_TASK);
+}
+
+template <class In, class Out>
+void BarycentricWeightTable<In,Out>::applyJ( typename Out::VecDeriv& out, const typename In::VecDeriv& in, const ForceMask& maskTo ) const
+{
+    out.resize(size());
+    simulation::parallelFor(0, std::min(size(), maskTo.size()), ApplyJFunctor(*this, out, in, maskTo), POINTS_PER_TASK);
+}
+
+template <class In, class Out>
+void BarycentricWeightTable<In,Out>::applyJT( typename In::VecDeriv& out, const typename Out::VecDeriv& in, const ForceMask& maskTo, ForceMask& maskFrom )
+{
+    activeParents.resize(nbParents);
+    simulation::parallelFor(0, nbParents, ApplyJTFunctor(*this, out, in, maskTo), POINTS_PER_TASK);
+
+    // the mask is a vector of bits, so it is filled afterwards from this thread only
+    for (std::size_t j=0; j<nbParents; ++j)
+        if (activeParents[j])
+            maskFrom.insertEntry(j);
+}
+
 template <class TIn, class TOut>
 void BarycentricMapping<TIn, TOut>::applyJ (const core::MechanicalParams * /*mparams*/, Data< typename Out::VecDeriv >& _out, const Data< typename In::VecDeriv >& in)
 {
@@ -1549,7 +2013,10 @@ void BarycentricMapping<TIn, TOut>::applyJ (const core::MechanicalParams * /*mpa
         typename Out::VecDeriv* out = _out.beginEdit();
         if (mapper != NULL)
         {
-            mapper->applyJ(*out, in.getValue());
+            if (d_parallel.getValue() && weightTable.isValid(this->toModel->getSize(), in.getValue().size()))
+                weightTable.applyJ(*out, in.getValue(), *this->maskTo);
+            else
+                mapper->applyJ(*out, in.getValue());
         }
         _out.endEdit();
 #ifdef SOFA_DEV
@@ -1872,7 +2339,11 @@ void BarycentricMapping<TIn, TOut>::applyJT (const core::MechanicalParams * /*mp
 #endif
         mapper != NULL)
     {
-        mapper->applyJT(*out.beginEdit(), in.getValue());
+        typename In::VecDeriv& f = *out.beginEdit();
+        if (d_parallel.getValue() && weightTable.isValid(this->toModel->getSize(), f.size()))
+            weightTable.applyJT(f, in.getValue(), *this->maskTo, *this->maskFrom);
+        else
+            mapper->applyJT(f, in.getValue());
         out.endEdit();
     }
 }
@@ -3739,10 +4210,11 @@ const helper::vector< defaulttype::BaseMatrix*>* BarycentricMapping<TIn, TOut>::
     typedef typename Mapper::MatrixType mat_type;
     const sofa::defaulttype::BaseMatrix* matJ = getJ();
 
-    const mat_type* mat = dynamic_cast<const mat_type*>(matJ);
+    mat_type* mat = const_cast<mat_type*>(dynamic_cast<const mat_type*>(matJ));
     assert( mat );
 
-    eigen.copyFrom( *mat );   // woot
+    mat->compress(); // the mappers fill their matrix without compressing it
+    eigen.updateFrom( *mat ); // only the values are copied while the mapper does not change the pattern
 
     js.resize( 1 );
     js[0] = &eigen;
@@ -0,0 +1,246 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2016 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU General Public License as published by the Free  *
+* Software Foundation; either version 2 of the License, or (at your option)   *
+* any later version.                                                          *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for    *
+* more details.                                                               *
+*                                                                             *
+* You should have received a copy of the GNU General Public License along     *
+* with this program; if not, write to the Free Software Foundation, Inc., 51  *
+* Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA.                   *
+*******************************************************************************
+*                            SOFA :: Applications                             *
+*                                                                             *
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <SofaBaseMechanics/BarycentricMapping.h>
+#include <SofaBaseMechanics/MechanicalObject.h>
+#include <SofaBaseTopology/MeshTopology.h>
+#include <SofaBaseTopology/RegularGridTopology.h>
+#include <SofaEigen2Solver/EigenSparseMatrix.h>
+#include <SofaSimulationGraph/DAGSimulation.h>
+#include <sofa/core/MechanicalParams.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+
+
+namespace sofa
+{
+
+namespace
+{
+
+using namespace sofa::defaulttype;
+using core::objectmodel::New;
+
+typedef component::container::MechanicalObject<Vec3dTypes> MechanicalObject3d;
+typedef component::mapping::BarycentricMapping<Vec3dTypes,Vec3dTypes> BarycentricMapping3d;
+
+double random01() { return rand() / (double)RAND_MAX; }
+
+/// Compare the serial and the parallel computations of the mapping, which must give the same values
+struct BarycentricMapping_test : public ::testing::Test
+{
+    simulation::Node::SPtr root;
+    MechanicalObject3d::SPtr from, to;
+    BarycentricMapping3d::SPtr mapping;
+
+    BarycentricMapping_test()
+    {
+        srand(0);
+        if (!simulation::getSimulation())
+            simulation::setSimulation(new simulation::graph::DAGSimulation());
+        root = simulation::getSimulation()->createNewGraph("root");
+    }
+
+    ~BarycentricMapping_test()
+    {
+        simulation::getSimulation()->unload(root);
+    }
+
+    void createMapping(unsigned int nbPoints)
+    {
+        from = New<MechanicalObject3d>();
+        root->addObject(from);
+
+        simulation::Node::SPtr child = root->createChild("mapped");
+        to = New<MechanicalObject3d>();
+        child->addObject(to);
+        to->resize(nbPoints);
+        {
+            helper::WriteAccessor< Data<Vec3dTypes::VecCoord> > x = *to->write(core::VecCoordId::position());
+            for (unsigned int i=0; i<nbPoints; ++i)
+                x[i] = Vec3d(random01(), random01(), random01());
+        }
+
+        mapping = New<BarycentricMapping3d>();
+        child->addObject(mapping);
+        mapping->setModels(from.get(), to.get());
+
+        simulation::getSimulation()->init(root.get());
+        to->forceMask.assign(to->getSize(), true);
+    }
+
+    /// With partialMask, only one child out of three is active in applyJT, so that the parents
+    /// inserted in the mask of the parent state are compared too
+    void compareSerialAndParallel(bool partialMask = false)
+    {
+        const core::MechanicalParams* mparams = core::MechanicalParams::defaultInstance();
+        const std::size_t nbParents = from->getSize();
+
+        Data<Vec3dTypes::VecCoord> x;
+        Data<Vec3dTypes::VecDeriv> dx, f;
+        {
+            helper::WriteAccessor< Data<Vec3dTypes::VecCoord> > wx = x;
+            helper::WriteAccessor< Data<Vec3dTypes::VecDeriv> > wdx = dx;
+            helper::WriteAccessor< Data<Vec3dTypes::VecDeriv> > wf = f;
+            for (std::size_t i=0; i<nbParents; ++i)
+            {
+                wx.push_back(Vec3d(random01(), random01(), random01()));
+                wdx.push_back(Vec3d(random01(), random01(), random01()));
+            }
+            for (std::size_t i=0; i<to->getSize(); ++i)
+                wf.push_back(Vec3d(random01(), random01(), random01()));
+        }
+
+        Data<Vec3dTypes::VecCoord> out[2];
+        Data<Vec3dTypes::VecDeriv> dout[2], fin[2];
+        helper::vector<bool> maskFrom[2];
+        for (int parallel=0; parallel<2; ++parallel)
+        {
+            mapping->d_parallel.setValue(parallel != 0);
+            mapping->apply(mparams, out[parallel], x);
+            mapping->applyJ(mparams, dout[parallel], dx);
+
+            if (partialMask)
+            {
+                to->forceMask.assign(to->getSize(), false);
+                to->forceMask.activate(true);
+                for (std::size_t i=0; i<to->getSize(); i+=3)
+                    to->forceMask.insertEntry(i);
+            }
+            from->forceMask.assign(nbParents, false);
+            fin[parallel].setValue(Vec3dTypes::VecDeriv(nbParents, Vec3d(1,2,3)));
+            mapping->applyJT(mparams, fin[parallel], f);
+            for (std::size_t j=0; j<nbParents; ++j)
+                maskFrom[parallel].push_back(from->forceMask.getEntry(j));
+            to->forceMask.assign(to->getSize(), true);
+        }
+
+        ASSERT_EQ(to->getSize(), out[1].getValue().size());
+        EXPECT_EQ(out[0].getValue(), out[1].getValue());
+        EXPECT_EQ(dout[0].getValue(), dout[1].getValue());
+        EXPECT_EQ(fin[0].getValue(), fin[1].getValue());
+        EXPECT_EQ(maskFrom[0], maskFrom[1]);
+    }
+};
+
+TEST_F(BarycentricMapping_test, parallelTetrahedra)
+{
+    component::topology::MeshTopology::SPtr topology = New<component::topology::MeshTopology>();
+    root->addObject(topology);
+    for (int i=0; i<60; ++i)
+        topology->addPoint(random01(), random01(), random01());
+    for (int i=0; i<200; ++i)
+        topology->addTetra(rand()%60, rand()%60, rand()%60, rand()%60);
+
+    createMapping(500);
+    compareSerialAndParallel();
+}
+
+TEST_F(BarycentricMapping_test, parallelRegularGrid)
+{
+    component::topology::RegularGridTopology::SPtr topology = New<component::topology::RegularGridTopology>(6, 5, 7);
+    topology->setPos(0, 1, 0, 1, 0, 1);
+    root->addObject(topology);
+
+    createMapping(500);
+    compareSerialAndParallel();
+}
+
+/// The points on the faces of the cells have null weights, whose parents are still inserted in the mask
+TEST_F(BarycentricMapping_test, parallelNullWeights)
+{
+    component::topology::RegularGridTopology::SPtr topology = New<component::topology::RegularGridTopology>(6, 5, 7);
+    topology->setPos(0, 1, 0, 1, 0, 1);
+    root->addObject(topology);
+
+    createMapping(500);
+    {
+        helper::WriteAccessor< Data<Vec3dTypes::VecCoord> > x = *to->write(core::VecCoordId::position());
+        for (unsigned int i=0; i<x.size(); ++i)
+            x[i][0] = (i%6) * 0.2;
+    }
+    mapping->reinit();
+    compareSerialAndParallel(true);
+}
+
+/// The weights are read again when the mapping is reinitialized
+TEST_F(BarycentricMapping_test, parallelReinit)
+{
+    component::topology::RegularGridTopology::SPtr topology = New<component::topology::RegularGridTopology>(6, 5, 7);
+    topology->setPos(0, 1, 0, 1, 0, 1);
+    root->addObject(topology);
+
+    createMapping(500);
+    compareSerialAndParallel();
+    {
+        helper::WriteAccessor< Data<Vec3dTypes::VecCoord> > x = *to->write(core::VecCoordId::position());
+        for (unsigned int i=0; i<x.size(); ++i)
+            x[i] = Vec3d(random01(), random01(), random01());
+    }
+    mapping->reinit();
+    compareSerialAndParallel();
+}
+
+/// The Jacobian given by getJs keeps its storage while the weights do not change,
+/// although the null entries of its blocks are not stored
+TEST_F(BarycentricMapping_test, jacobianUpdatedInPlace)
+{
+    typedef component::linearsolver::EigenSparseMatrix<Vec3dTypes,Vec3dTypes> EigenJ;
+    typedef component::linearsolver::CompressedRowSparseMatrix<Mat3x3d> CompressedJ;
+
+    component::topology::RegularGridTopology::SPtr topology = New<component::topology::RegularGridTopology>(6, 5, 7);
+    topology->setPos(0, 1, 0, 1, 0, 1);
+    root->addObject(topology);
+
+    createMapping(500);
+
+    EigenJ* J = dynamic_cast<EigenJ*>((*mapping->getJs())[0]);
+    ASSERT_TRUE(J != NULL);
+
+    // each block is a weight times the identity
+    const CompressedJ* crs = dynamic_cast<const CompressedJ*>(mapping->getJ());
+    ASSERT_TRUE(crs != NULL);
+    ASSERT_FALSE(crs->getColsValue().empty());
+    EXPECT_EQ(0.0, crs->getColsValue()[0][0][1]);
+    EXPECT_EQ(3*crs->getColsValue().size(), (std::size_t)J->compressedMatrix.nonZeros());
+
+    const EigenJ::CompressedMatrix reference = J->compressedMatrix;
+    const double* values = J->compressedMatrix.valuePtr();
+
+    EXPECT_TRUE(J->updateValuesFrom(*crs));
+    EXPECT_EQ(J, (*mapping->getJs())[0]);
+    EXPECT_EQ(values, J->compressedMatrix.valuePtr());
+    ASSERT_EQ(reference.nonZeros(), J->compressedMatrix.nonZeros());
+    for (int i=0; i<reference.nonZeros(); ++i)
+    {
+        EXPECT_EQ(reference.innerIndexPtr()[i], J->compressedMatrix.innerIndexPtr()[i]);
+        EXPECT_EQ(reference.valuePtr()[i], J->compressedMatrix.valuePtr()[i]);
+    }
+}
+
+} // namespace
+
+} // namespace sofa
@@ -0,0 +1,243 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2016 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This library is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This library is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this library; if not, write to the Free Software Foundation,     *
+* Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA.          *
+*******************************************************************************
+*                               SOFA :: Modules                               *
+*                                                                             *
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#ifndef SOFA_COMPONENT_TOPOLOGY_COMPRESSEDSHELLARRAY_H
+#define SOFA_COMPONENT_TOPOLOGY_COMPRESSEDSHELLARRAY_H
+#include "config.h"
+
+#include <sofa/helper/vector.h>
+#include <sofa/simulation/ParallelFor.h>
+
+#include <cstddef>
+
+
+namespace sofa
+{
+
+namespace component
+{
+
+namespace topology
+{
+
+/// Parallel construction of the shells of a topology (e.g. the tetrahedra around each vertex).
+///
+/// The topology containers keep their shells as one vector per entity: their accessors return
+/// references to these vectors, and the topology modifiers edit them in place. This class only
+/// replaces the serial loops creating them. build() is a counting sort of the elements spread over
+/// the TaskScheduler threads, giving the shells as compressed rows (the elements around the entity i
+/// are getIndex()[getBegin()[i]] ... getIndex()[getBegin()[i+1]-1]), and copyTo() then fills the
+/// per-entity vectors from them, each one allocated once to its final size. It is meant to be a
+/// temporary of the creation of these vectors, not a second storage of the shells.
+///
+/// Each shell lists its elements in increasing order, as the serial loops do, so that copyTo()
+/// gives the same vectors as these loops.
+class CompressedShellArray
+{
+public:
+    typedef unsigned int Index;
+
+    /// Number of entities
+    std::size_t size() const { return m_begin.empty() ? 0 : m_begin.size()-1; }
+    bool empty() const { return m_begin.empty(); }
+    void clear() { m_begin.clear(); m_index.clear(); }
+
+    std::size_t getShellSize(std::size_t i) const { return m_begin[i+1] - m_begin[i]; }
+    const Index* shellBegin(std::size_t i) const { return m_index.empty() ? NULL : &m_index[0] + m_begin[i]; }
+    const Index* shellEnd(std::size_t i) const { return m_index.empty() ? NULL : &m_index[0] + m_begin[i+1]; }
+
+    const helper::vector<Index>& getBegin() const { return m_begin; }
+    const helper::vector<Index>& getIndex() const { return m_index; }
+
+    /// Build the shells of nbEntities entities from the elements, a random-access container of fixed
+    /// size arrays of entity indices (e.g. the tetrahedra for the tetrahedra around each vertex, or
+    /// the edges in each tetrahedron for the tetrahedra around each edge). Indices out of range are ignored.
+    template<class VecElement>
+    void build(const VecElement& elements, std::size_t nbEntities);
+
+    /// Copy the shells to one vector per entity, each one allocated once to its final size
+    template<class Shell>
+    void copyTo(helper::vector<Shell>& shells) const;
+
+protected:
+    enum { ELEMENTS_PER_BLOCK = 4096, ENTITIES_PER_TASK = 1024 };
+
+    template<class VecElement> class CountFunctor;
+    class OffsetFunctor;
+    template<class VecElement> class FillFunctor;
+    template<class Shell> class CopyFunctor;
+
+    helper::vector<Index> m_begin;
+    helper::vector<Index> m_index;
+};
+
+/// Each block of consecutive elements counts its elements around each entity
+template<class VecElement>
+class CompressedShellArray::CountFunctor
+{
+public:
+    CountFunctor(const VecElement& elements, helper::vector< helper::vector<Index> >& blockOffsets)
+        : elements(elements), blockOffsets(blockOffsets) {}
+
+    void operator()(std::size_t firstBlock, std::size_t lastBlock) const
+    {
+        for (std::size_t b=firstBlock; b<lastBlock; ++b)
+        {
+            helper::vector<Index>& count = blockOffsets[b];
+            const std::size_t nbEntities = count.size();
+            const std::size_t first = (elements.size() * b) / blockOffsets.size();
+            const std::size_t last = (elements.size() * (b+1)) / blockOffsets.size();
+            for (std::size_t e=first; e<last; ++e)
+                for (std::size_t k=0; k<elements[e].size(); ++k)
+                    if ((std::size_t)elements[e][k] < nbEntities)
+                        ++count[elements[e][k]];
+        }
+    }
+
+protected:
+    const VecElement& elements;
+    helper::vector< helper::vector<Index> >& blockOffsets;
+};
+
+/// The elements of the block b around the entity i start after the ones of the previous blocks
+class CompressedShellArray::OffsetFunctor
+{
+public:
+    OffsetFunctor(const helper::vector<Index>& begin, helper::vector< helper::vector<Index> >& blockOffsets)
+        : begin(begin), blockOffsets(blockOffsets) {}
+
+    void operator()(std::size_t first, std::size_t last) const
+    {
+        for (std::size_t i=first; i<last; ++i)
+        {
+            Index offset = begin[i];
+            for (std::size_t b=0; b<blockOffsets.size(); ++b)
+            {
+                const Index count = blockOffsets[b][i];
+                blockOffsets[b][i] = offset;
+                offset += count;
+            }
+        }
+    }
+
+protected:
+    const helper::vector<Index>& begin;
+    helper::vector< helper::vector<Index> >& blockOffsets;
+};
+
+template<class VecElement>
+class CompressedShellArray::FillFunctor
+{
+public:
+    FillFunctor(const VecElement& elements, helper::vector< helper::vector<Index> >& blockOffsets, helper::vector<Index>& index)
+        : elements(elements), blockOffsets(blockOffsets), index(index) {}
+
+    void operator()(std::size_t firstBlock, std::size_t lastBlock) const
+    {
+        for (std::size_t b=firstBlock; b<lastBlock; ++b)
+        {
+            helper::vector<Index>& offset = blockOffsets[b];
+            const std::size_t nbEntities = offset.size();
+            const std::size_t first = (elements.size() * b) / blockOffsets.size();
+            const std::size_t last = (elements.size() * (b+1)) / blockOffsets.size();
+            for (std::size_t e=first; e<last; ++e)
+                for (std::size_t k=0; k<elements[e].size(); ++k)
+                    if ((std::size_t)elements[e][k] < nbEntities)
+                        index[offset[elements[e][k]]++] = (Index)e;
+        }
+    }
+
+protected:
+    const VecElement& elements;
+    helper::vector< helper::vector<Index> >& blockOffsets;
+    helper::vector<Index>& index;
+};
+
+template<class Shell>
+class CompressedShellArray::CopyFunctor
+{
+public:
+    CopyFunctor(const CompressedShellArray& array, helper::vector<Shell>& shells)
+        : array(array), shells(shells) {}
+
+    void operator()(std::size_t first, std::size_t last) const
+    {
+        for (std::size_t i=first; i<last; ++i)
+            shells[i].assign(array.shellBegin(i), array.shellEnd(i));
+    }
+
+protected:
+    const CompressedShellArray& array;
+    helper::vector<Shell>& shells;
+};
+
+template<class VecElement>
+void CompressedShellArray::build(const VecElement& elements, std::size_t nbEntities)
+{
+    // Each block counts its elements around every entity, so the blocks need nbBlocks*nbEntities
+    // counters. There is one block per thread at most, and no more blocks than the number of
+    // indices per entity, so that these counters never outgrow the shells themselves.
+    const std::size_t nbIndices = elements.empty() ? 0 : elements.size() * elements[0].size();
+    std::size_t nbBlocks = (elements.size() + ELEMENTS_PER_BLOCK - 1) / ELEMENTS_PER_BLOCK;
+    const std::size_t nbThreads = simulation::TaskScheduler::getInstance().getThreadCount();
+    if (nbBlocks > nbThreads) nbBlocks = nbThreads;
+    if (nbEntities > 0 && nbBlocks > nbIndices / nbEntities) nbBlocks = nbIndices / nbEntities;
+    if (nbBlocks < 1) nbBlocks = 1;
+
+    // for each block, its number of elements around each entity, then the position of the next one
+    helper::vector< helper::vector<Index> > blockOffsets(nbBlocks);
+    for (std::size_t b=0; b<nbBlocks; ++b)
+        blockOffsets[b].assign(nbEntities, 0);
+    simulation::parallelFor(0, nbBlocks, CountFunctor<VecElement>(elements, blockOffsets), 1);
+
+    m_begin.resize(nbEntities+1);
+    m_begin[0] = 0;
+    for (std::size_t i=0; i<nbEntities; ++i)
+    {
+        Index count = 0;
+        for (std::size_t b=0; b<nbBlocks; ++b)
+            count += blockOffsets[b][i];
+        m_begin[i+1] = m_begin[i] + count;
+    }
+    simulation::parallelFor(0, nbEntities, OffsetFunctor(m_begin, blockOffsets), ENTITIES_PER_TASK);
+
+    m_index.resize(m_begin[nbEntities]);
+    simulation::parallelFor(0, nbBlocks, FillFunctor<VecElement>(elements, blockOffsets, m_index), 1);
+}
+
+template<class Shell>
+void CompressedShellArray::copyTo(helper::vector<Shell>& shells) const
+{
+    shells.clear();
+    shells.resize(size());
+    simulation::parallelFor(0, size(), CopyFunctor<Shell>(*this, shells), ENTITIES_PER_TASK);
+}
+
+} // namespace topology
+
+} // namespace component
+
+} // namespace sofa
+
+#endif // SOFA_COMPONENT_TOPOLOGY_COMPRESSEDSHELLARRAY_H
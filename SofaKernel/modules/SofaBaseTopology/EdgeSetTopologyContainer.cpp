@@ -23,6 +23,7 @@
 * Contact information: contact@sofa-framework.org                             *
 ******************************************************************************/
 #include <SofaBaseTopology/EdgeSetTopologyContainer.h>
+#include <SofaBaseTopology/CompressedShellArray.h>
 #include <sofa/core/visual/VisualParams.h>
 
 #include <sofa/core/ObjectFactory.h>
@@ -110,12 +111,21 @@ void EdgeSetTopologyContainer::createEdgesAroundVertexArray()
     }
 
     helper::ReadAccessor< Data< sofa::helper::vector<Edge> > > m_edge = d_edge;
-    m_edgesAroundVertex.resize( getNbPoints() );
-    for (unsigned int edge=0; edge<m_edge.size(); ++edge)
+    if (d_compressedShells.getValue())
     {
-        // adding edge in the edge shell of both points
-        m_edgesAroundVertex[ m_edge[edge][0] ].push_back(edge);
-        m_edgesAroundVertex[ m_edge[edge][1] ].push_back(edge);
+        CompressedShellArray shells;
+        shells.build(m_edge.ref(), getNbPoints());
+        shells.copyTo(m_edgesAroundVertex);
+    }
+    else
+    {
+        m_edgesAroundVertex.resize( getNbPoints() );
+        for (unsigned int edge=0; edge<m_edge.size(); ++edge)
+        {
+            // adding edge in the edge shell of both points
+            m_edgesAroundVertex[ m_edge[edge][0] ].push_back(edge);
+            m_edgesAroundVertex[ m_edge[edge][1] ].push_back(edge);
+        }
     }
 
     if (m_checkConnexity.getValue())
@@ -24,6 +24,7 @@
 ******************************************************************************/
 
 #include <SofaBaseTopology/HexahedronSetTopologyContainer.h>
+#include <SofaBaseTopology/CompressedShellArray.h>
 #include <sofa/core/visual/VisualParams.h>
 #include <sofa/core/ObjectFactory.h>
 
@@ -387,8 +388,16 @@ void HexahedronSetTopologyContainer::createHexahedraAroundVertexArray()
     if(hasHexahedraAroundVertex())
         clearHexahedraAroundVertex();
 
-    m_hexahedraAroundVertex.resize( getNbPoints() );
     helper::ReadAccessor< Data< sofa::helper::vector<Hexahedron> > > m_hexahedron = d_hexahedron;
+    if (d_compressedShells.getValue())
+    {
+        CompressedShellArray shells;
+        shells.build(m_hexahedron.ref(), getNbPoints());
+        shells.copyTo(m_hexahedraAroundVertex);
+        return;
+    }
+
+    m_hexahedraAroundVertex.resize( getNbPoints() );
 
     for(unsigned int i=0; i<m_hexahedron.size(); ++i)
     {
@@ -406,6 +415,14 @@ void HexahedronSetTopologyContainer::createHexahedraAroundEdgeArray ()
     if(hasHexahedraAroundEdge())
         clearHexahedraAroundEdge();
 
+    if (d_compressedShells.getValue())
+    {
+        CompressedShellArray shells;
+        shells.build(m_edgesInHexahedron, getNumberOfEdges());
+        shells.copyTo(m_hexahedraAroundEdge);
+        return;
+    }
+
     m_hexahedraAroundEdge.resize(getNumberOfEdges());
 
     for(unsigned int i=0; i<getNumberOfHexahedra(); ++i)
@@ -426,6 +443,14 @@ void HexahedronSetTopologyContainer::createHexahedraAroundQuadArray()
     if(hasHexahedraAroundQuad())
         clearHexahedraAroundQuad();
 
+    if (d_compressedShells.getValue())
+    {
+        CompressedShellArray shells;
+        shells.build(m_quadsInHexahedron, getNumberOfQuads());
+        shells.copyTo(m_hexahedraAroundQuad);
+        return;
+    }
+
     m_hexahedraAroundQuad.resize( getNumberOfQuads());
 
     for(unsigned int i=0; i<getNumberOfHexahedra(); ++i)
@@ -24,6 +24,7 @@
 ******************************************************************************/
 #include <iostream>
 #include <SofaBaseTopology/MeshTopology.h>
+#include <SofaBaseTopology/CompressedShellArray.h>
 #include <sofa/core/visual/VisualParams.h>
 #include <sofa/core/ObjectFactory.h>
 #include <sofa/helper/fixed_array.h>
@@ -41,6 +42,20 @@ namespace topology
 
 using helper::vector;
 
+namespace
+{
+
+/// Create the shells of nbEntities entities from the elements, through a temporary compressed array
+template<class VecElement, class Shell>
+void createShells(const VecElement& elements, std::size_t nbEntities, vector<Shell>& shells)
+{
+    CompressedShellArray compressed;
+    compressed.build(elements, nbEntities);
+    compressed.copyTo(shells);
+}
+
+} // namespace
+
 
 MeshTopology::EdgeUpdate::EdgeUpdate(MeshTopology* t)
     :PrimitiveUpdate(t)
@@ -524,6 +539,7 @@ MeshTopology::MeshTopology()
     , isToPrint( initData(&isToPrint, false, "isToPrint", "suppress somes data before using save as function"))
     , seqHexahedra(initData(&seqHexahedra,"hexahedra","List of hexahedron indices"))
     , seqUVs(initData(&seqUVs,"uv","List of uv coordinates"))
+    , d_compressedShells(initData(&d_compressedShells, false, "compressedShells", "Build the elements around each vertex, edge, triangle and quad on several threads, with a counting sort, instead of the serial loops (except the oriented triangles around each edge)"))
     , nbPoints(0)
     , validTetrahedra(false), validHexahedra(false)
     , revision(0)
@@ -962,6 +978,11 @@ void MeshTopology::createTrianglesAroundVertexArray ()
 {
     const SeqTriangles& triangles = getTriangles(); // do not use seqTriangles directly as it might not be up-to-date
     m_trianglesAroundVertex.clear();
+    if (d_compressedShells.getValue())
+    {
+        createShells(triangles, nbPoints, m_trianglesAroundVertex);
+        return;
+    }
     m_trianglesAroundVertex.resize( nbPoints );
 
     for (unsigned int i = 0; i < triangles.size(); ++i)
@@ -1156,6 +1177,11 @@ void MeshTopology::createQuadsAroundVertexArray ()
 {
     const SeqQuads& quads = getQuads(); // do not use seqQuads directly as it might not be up-to-date
     m_quadsAroundVertex.clear();
+    if (d_compressedShells.getValue())
+    {
+        createShells(quads, nbPoints, m_quadsAroundVertex);
+        return;
+    }
     m_quadsAroundVertex.resize( nbPoints );
 
     for (unsigned int i = 0; i < quads.size(); ++i)
@@ -1310,6 +1336,11 @@ void MeshTopology::createQuadsAroundEdgeArray ()
     if (m_edgesInQuad.empty())
         createEdgesInQuadArray();
     m_quadsAroundEdge.clear();
+    if (d_compressedShells.getValue())
+    {
+        createShells(m_edgesInQuad, getNbEdges(), m_quadsAroundEdge);
+        return;
+    }
     m_quadsAroundEdge.resize( getNbEdges() );
     unsigned int j;
     for (unsigned int i = 0; i < quads.size(); ++i)
@@ -1360,6 +1391,11 @@ void MeshTopology::createQuadsInHexahedronArray ()
 
 void MeshTopology::createTetrahedraAroundVertexArray ()
 {
+    if (d_compressedShells.getValue())
+    {
+        createShells(seqTetrahedra.getValue(), nbPoints, m_tetrahedraAroundVertex);
+        return;
+    }
     m_tetrahedraAroundVertex.resize( nbPoints );
     unsigned int j;
 
@@ -1374,6 +1410,11 @@ void MeshTopology::createTetrahedraAroundEdgeArray ()
 {
     if (!m_edgesInTetrahedron.size())
         createEdgesInTetrahedronArray();
+    if (d_compressedShells.getValue())
+    {
+        createShells(m_edgesInTetrahedron, getNbEdges(), m_tetrahedraAroundEdge);
+        return;
+    }
     m_tetrahedraAroundEdge.resize( getNbEdges() );
     const vector< EdgesInTetrahedron > &tea = m_edgesInTetrahedron;
     unsigned int j;
@@ -1389,6 +1430,11 @@ void MeshTopology::createTetrahedraAroundTriangleArray ()
 {
     if (!m_trianglesInTetrahedron.size())
         createTrianglesInTetrahedronArray();
+    if (d_compressedShells.getValue())
+    {
+        createShells(m_trianglesInTetrahedron, getNbTriangles(), m_tetrahedraAroundTriangle);
+        return;
+    }
     m_tetrahedraAroundTriangle.resize( getNbTriangles());
     unsigned int j;
     const vector< TrianglesInTetrahedron > &tta=m_trianglesInTetrahedron;
@@ -1402,6 +1448,11 @@ void MeshTopology::createTetrahedraAroundTriangleArray ()
 
 void MeshTopology::createHexahedraAroundVertexArray ()
 {
+    if (d_compressedShells.getValue())
+    {
+        createShells(seqHexahedra.getValue(), nbPoints, m_hexahedraAroundVertex);
+        return;
+    }
     m_hexahedraAroundVertex.resize( nbPoints );
     unsigned int j;
 
@@ -1416,6 +1467,11 @@ void MeshTopology::createHexahedraAroundEdgeArray ()
 {
     if (!m_edgesInHexahedron.size())
         createEdgesInHexahedronArray();
+    if (d_compressedShells.getValue())
+    {
+        createShells(m_edgesInHexahedron, getNbEdges(), m_hexahedraAroundEdge);
+        return;
+    }
     m_hexahedraAroundEdge.resize(getNbEdges());
     unsigned int j;
     const vector< EdgesInHexahedron > &hea=m_edgesInHexahedron;
@@ -1431,6 +1487,11 @@ void MeshTopology::createHexahedraAroundQuadArray ()
 {
     if (!m_quadsInHexahedron.size())
         createQuadsInHexahedronArray();
+    if (d_compressedShells.getValue())
+    {
+        createShells(m_quadsInHexahedron, getNbQuads(), m_hexahedraAroundQuad);
+        return;
+    }
     m_hexahedraAroundQuad.resize( getNbQuads());
     unsigned int j;
     const vector< QuadsInHexahedron > &qha=m_quadsInHexahedron;
@@ -177,6 +177,7 @@ public:
     /// @}
 
 
+
     /// Get information about connexity of the mesh
     /// @{
     /** \brief Checks if the topology has only one connected component
@@ -281,6 +282,9 @@ public:
 #endif
     Data<SeqUV>	seqUVs;
 
+    /// Build the elements around each vertex, edge, triangle and quad with a counting sort on several threads (see CompressedShellArray)
+    Data<bool> d_compressedShells;
+
 protected:
     int  nbPoints;
 
@@ -46,6 +46,7 @@ int PointSetTopologyContainerClass = core::RegisterObject("Point set topology co
 PointSetTopologyContainer::PointSetTopologyContainer(int npoints)
     : nbPoints (initData(&nbPoints, (unsigned int )npoints, "nbPoints", "Number of points"))
     , d_initPoints (initData(&d_initPoints, "position", "Initial position of points"))
+    , d_compressedShells (initData(&d_compressedShells, false, "compressedShells", "Build the elements around each vertex, edge, triangle and quad on several threads, with a counting sort, instead of the serial loops"))
     , m_pointTopologyDirty(false)
 {
     addAlias(&d_initPoints,"points");
@@ -179,6 +179,9 @@ public:
     Data<unsigned int> nbPoints;
 
     Data<InitTypes::VecCoord> d_initPoints;
+
+    /// Build the elements around each vertex, edge, triangle and quad with a counting sort on several threads (see CompressedShellArray)
+    Data<bool> d_compressedShells;
 protected:
     /// Boolean used to know if the topology Data of this container is dirty
     bool m_pointTopologyDirty;
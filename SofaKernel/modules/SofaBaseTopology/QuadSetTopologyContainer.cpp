@@ -24,6 +24,7 @@
 ******************************************************************************/
 
 #include <SofaBaseTopology/QuadSetTopologyContainer.h>
+#include <SofaBaseTopology/CompressedShellArray.h>
 #include <sofa/core/visual/VisualParams.h>
 
 #include <sofa/core/ObjectFactory.h>
@@ -90,8 +91,16 @@ void QuadSetTopologyContainer::createQuadsAroundVertexArray()
         clearQuadsAroundVertex();
     }
 
-    m_quadsAroundVertex.resize( getNbPoints() );
     helper::ReadAccessor< Data< sofa::helper::vector<Quad> > > m_quad = d_quad;
+    if (d_compressedShells.getValue())
+    {
+        CompressedShellArray shells;
+        shells.build(m_quad.ref(), getNbPoints());
+        shells.copyTo(m_quadsAroundVertex);
+        return;
+    }
+
+    m_quadsAroundVertex.resize( getNbPoints() );
 
     for (size_t i=0; i<m_quad.size(); ++i)
     {
@@ -132,6 +141,14 @@ void QuadSetTopologyContainer::createQuadsAroundEdgeArray()
         clearQuadsAroundEdge();
     }
 
+    if (d_compressedShells.getValue())
+    {
+        CompressedShellArray shells;
+        shells.build(m_edgesInQuad, numEdges);
+        shells.copyTo(m_quadsAroundEdge);
+        return;
+    }
+
     m_quadsAroundEdge.resize(numEdges);
 
     for (size_t i=0; i<numQuads; ++i)
@@ -0,0 +1,148 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2016 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU General Public License as published by the Free  *
+* Software Foundation; either version 2 of the License, or (at your option)   *
+* any later version.                                                          *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for    *
+* more details.                                                               *
+*                                                                             *
+* You should have received a copy of the GNU General Public License along     *
+* with this program; if not, write to the Free Software Foundation, Inc., 51  *
+* Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA.                   *
+*******************************************************************************
+*                            SOFA :: Applications                             *
+*                                                                             *
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <SofaTest/Sofa_test.h>
+
+#include <SofaBaseTopology/CompressedShellArray.h>
+#include <SofaBaseTopology/MeshTopology.h>
+#include <sofa/simulation/TaskScheduler.h>
+
+#include <gtest/gtest.h>
+
+namespace sofa {
+
+using component::topology::CompressedShellArray;
+using component::topology::MeshTopology;
+using simulation::TaskScheduler;
+
+/** The shells built by CompressedShellArray on several threads are the ones
+  built by the serial loops of the topology containers, in the same order.
+  */
+struct CompressedShellArray_test : public Sofa_test<double>
+{
+    typedef core::topology::BaseMeshTopology::Tetrahedron Tetrahedron;
+    typedef helper::vector<unsigned int> Shell;
+
+    enum { NbPoints = 3000, NbTetrahedra = 20000 };
+
+    helper::vector<Tetrahedron> tetrahedra;
+
+    CompressedShellArray_test()
+    {
+        TaskScheduler::getInstance().start(4);
+
+        // pseudo random tetrahedra, with a few vertices shared by many of them
+        tetrahedra.resize(NbTetrahedra);
+        for (unsigned int i=0; i<NbTetrahedra; ++i)
+            tetrahedra[i] = Tetrahedron((i*7)%NbPoints, (i*13+1)%NbPoints, (i%50)*3, (i*31+5)%NbPoints);
+    }
+
+    ~CompressedShellArray_test()
+    {
+        TaskScheduler::getInstance().stop();
+    }
+
+    helper::vector<Shell> serialShells() const
+    {
+        helper::vector<Shell> shells(NbPoints);
+        for (unsigned int i=0; i<tetrahedra.size(); ++i)
+            for (unsigned int j=0; j<4; ++j)
+                shells[tetrahedra[i][j]].push_back(i);
+        return shells;
+    }
+};
+
+TEST_F(CompressedShellArray_test, build)
+{
+    CompressedShellArray compressed;
+    compressed.build(tetrahedra, NbPoints);
+    const helper::vector<Shell> shells = serialShells();
+
+    ASSERT_EQ((std::size_t)NbPoints, compressed.size());
+    EXPECT_EQ((unsigned int)(4*NbTetrahedra), compressed.getBegin()[NbPoints]);
+    for (unsigned int i=0; i<NbPoints; ++i)
+    {
+        ASSERT_EQ(shells[i].size(), compressed.getShellSize(i));
+        EXPECT_TRUE(std::equal(shells[i].begin(), shells[i].end(), compressed.shellBegin(i))) << "vertex " << i;
+    }
+
+    helper::vector<Shell> copied;
+    compressed.copyTo(copied);
+    EXPECT_TRUE(copied == shells);
+}
+
+TEST_F(CompressedShellArray_test, outOfRangeIndices)
+{
+    tetrahedra.resize(2);
+    tetrahedra[0] = Tetrahedron(0, 1, 2, 3);
+    tetrahedra[1] = Tetrahedron(2, 3, 4, 5);
+
+    CompressedShellArray compressed;
+    compressed.build(tetrahedra, 4);
+    ASSERT_EQ(4u, compressed.size());
+    EXPECT_EQ(1u, compressed.getShellSize(0));
+    EXPECT_EQ(2u, compressed.getShellSize(3));
+    EXPECT_EQ(1u, compressed.shellBegin(3)[1]);
+}
+
+TEST_F(CompressedShellArray_test, meshTopology)
+{
+    MeshTopology::SPtr serial = core::objectmodel::New<MeshTopology>();
+    MeshTopology::SPtr compressed = core::objectmodel::New<MeshTopology>();
+    compressed->d_compressedShells.setValue(true);
+    for (unsigned int i=0; i<tetrahedra.size(); ++i)
+    {
+        serial->addTetra(tetrahedra[i][0], tetrahedra[i][1], tetrahedra[i][2], tetrahedra[i][3]);
+        compressed->addTetra(tetrahedra[i][0], tetrahedra[i][1], tetrahedra[i][2], tetrahedra[i][3]);
+    }
+    serial->setNbPoints(NbPoints);
+    compressed->setNbPoints(NbPoints);
+
+    for (unsigned int i=0; i<NbPoints; ++i)
+        EXPECT_TRUE(compressed->getTetrahedraAroundVertex(i) == serial->getTetrahedraAroundVertex(i)) << "vertex " << i;
+}
+
+TEST_F(CompressedShellArray_test, meshTopologyElementShells)
+{
+    // a strip of tetrahedra, each one sharing a triangle with the next one
+    MeshTopology::SPtr serial = core::objectmodel::New<MeshTopology>();
+    MeshTopology::SPtr compressed = core::objectmodel::New<MeshTopology>();
+    compressed->d_compressedShells.setValue(true);
+    for (unsigned int i=0; i+3<NbPoints; ++i)
+    {
+        serial->addTetra(i, i+1, i+2, i+3);
+        compressed->addTetra(i, i+1, i+2, i+3);
+    }
+    serial->setNbPoints(NbPoints);
+    compressed->setNbPoints(NbPoints);
+
+    ASSERT_EQ(serial->getNbEdges(), compressed->getNbEdges());
+    for (int i=0; i<serial->getNbEdges(); ++i)
+        EXPECT_TRUE(compressed->getTetrahedraAroundEdge(i) == serial->getTetrahedraAroundEdge(i)) << "edge " << i;
+    ASSERT_EQ(serial->getNbTriangles(), compressed->getNbTriangles());
+    for (int i=0; i<serial->getNbTriangles(); ++i)
+        EXPECT_TRUE(compressed->getTetrahedraAroundTriangle(i) == serial->getTetrahedraAroundTriangle(i)) << "triangle " << i;
+}
+
+} // namespace sofa
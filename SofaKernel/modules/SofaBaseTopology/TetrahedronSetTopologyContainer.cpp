@@ -24,6 +24,7 @@
 ******************************************************************************/
 
 #include <SofaBaseTopology/TetrahedronSetTopologyContainer.h>
+#include <SofaBaseTopology/CompressedShellArray.h>
 #include <sofa/core/visual/VisualParams.h>
 #include <sofa/core/ObjectFactory.h>
 
@@ -355,8 +356,16 @@ void TetrahedronSetTopologyContainer::createTetrahedraAroundVertexArray ()
     if(hasTetrahedraAroundVertex())
         clearTetrahedraAroundVertex();
 
-    m_tetrahedraAroundVertex.resize( getNbPoints() );
     helper::ReadAccessor< Data< sofa::helper::vector<Tetrahedron> > > m_tetrahedron = d_tetrahedron;
+    if (d_compressedShells.getValue())
+    {
+        CompressedShellArray shells;
+        shells.build(m_tetrahedron.ref(), getNbPoints());
+        shells.copyTo(m_tetrahedraAroundVertex);
+        return;
+    }
+
+    m_tetrahedraAroundVertex.resize( getNbPoints() );
 
     for (unsigned int i = 0; i < getNumberOfTetrahedra(); ++i)
     {
@@ -376,6 +385,14 @@ void TetrahedronSetTopologyContainer::createTetrahedraAroundEdgeArray ()
     if(hasTetrahedraAroundEdge())
         clearTetrahedraAroundEdge();
 
+    if (d_compressedShells.getValue())
+    {
+        CompressedShellArray shells;
+        shells.build(m_edgesInTetrahedron, getNumberOfEdges());
+        shells.copyTo(m_tetrahedraAroundEdge);
+        return;
+    }
+
     m_tetrahedraAroundEdge.resize(getNumberOfEdges());
 
     for (unsigned int i=0; i< getNumberOfTetrahedra(); ++i)
@@ -396,6 +413,14 @@ void TetrahedronSetTopologyContainer::createTetrahedraAroundTriangleArray ()
     if(hasTetrahedraAroundTriangle())
         clearTetrahedraAroundTriangle();
 
+    if (d_compressedShells.getValue())
+    {
+        CompressedShellArray shells;
+        shells.build(m_trianglesInTetrahedron, getNumberOfTriangles());
+        shells.copyTo(m_tetrahedraAroundTriangle);
+        return;
+    }
+
     m_tetrahedraAroundTriangle.resize( getNumberOfTriangles());
 
     for (unsigned int i=0; i<getNumberOfTetrahedra(); ++i)
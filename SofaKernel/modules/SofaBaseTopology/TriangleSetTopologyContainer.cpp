@@ -23,6 +23,7 @@
 * Contact information: contact@sofa-framework.org                             *
 ******************************************************************************/
 #include <SofaBaseTopology/TriangleSetTopologyContainer.h>
+#include <SofaBaseTopology/CompressedShellArray.h>
 #include <sofa/core/visual/VisualParams.h>
 
 #include <sofa/core/ObjectFactory.h>
@@ -102,8 +103,16 @@ void TriangleSetTopologyContainer::createTrianglesAroundVertexArray ()
         clearTrianglesAroundVertex();
     }
 
-    m_trianglesAroundVertex.resize( getNbPoints() );
     helper::ReadAccessor< Data< sofa::helper::vector<Triangle> > > m_triangle = d_triangle;
+    if (d_compressedShells.getValue())
+    {
+        CompressedShellArray shells;
+        shells.build(m_triangle.ref(), getNbPoints());
+        shells.copyTo(m_trianglesAroundVertex);
+        return;
+    }
+
+    m_trianglesAroundVertex.resize( getNbPoints() );
 
     for (unsigned int i = 0; i < m_triangle.size(); ++i)
     {
@@ -142,6 +151,14 @@ void TriangleSetTopologyContainer::createTrianglesAroundEdgeArray ()
         clearTrianglesAroundEdge();
     }
 
+    if (d_compressedShells.getValue())
+    {
+        CompressedShellArray shells;
+        shells.build(m_edgesInTriangle, numEdges);
+        shells.copyTo(m_trianglesAroundEdge);
+        return;
+    }
+
     m_trianglesAroundEdge.resize( numEdges );
 
     for (unsigned int i = 0; i < numTriangles; ++i)
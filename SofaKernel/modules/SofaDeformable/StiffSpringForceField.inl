@@ -196,20 +196,13 @@ void StiffSpringForceField<DataTypes>::addKToMatrix(const core::MechanicalParams
         for (unsigned int e=0; e<n; e++)
         {
             const Spring& s = ss[e];
-            unsigned p1 = mat.offset+Deriv::total_size*s.m1;
-            unsigned p2 = mat.offset+Deriv::total_size*s.m2;
-            const Mat& m = this->dfdx[e];
-            for(int i=0; i<N; i++)
-            {
-                for (int j=0; j<N; j++)
-                {
-                    Real k = (Real)(m[i][j]*kFact);
-                    mat.matrix->add(p1+i,p1+j, -k);
-                    mat.matrix->add(p1+i,p2+j, k);
-                    mat.matrix->add(p2+i,p1+j, k);//or mat->add(p1+j,p2+i, k);
-                    mat.matrix->add(p2+i,p2+j, -k);
-                }
-            }
+            unsigned p1 = Deriv::total_size*s.m1;
+            unsigned p2 = Deriv::total_size*s.m2;
+            const Mat k = this->dfdx[e] * kFact;
+            mat.addBlock(p1, p1, -k);
+            mat.addBlock(p1, p2, k);
+            mat.addBlock(p2, p1, k);
+            mat.addBlock(p2, p2, -k);
         }
     }
     else
@@ -229,45 +222,13 @@ void StiffSpringForceField<DataTypes>::addKToMatrix(const core::MechanicalParams
             unsigned p2 = /*mat.offset+*/Deriv::total_size*s.m2;
             Mat m = this->dfdx[e]* (Real) kFact;
             if (mat11)
-            {
-                for(int i=0; i<N; i++)
-                {
-                    for (int j=0; j<N; j++)
-                    {
-                        mat11.matrix->add(mat11.offset+p1+i,mat11.offset+p1+j, -(Real)m[i][j]);
-                    }
-                }
-            }
+                mat11.addBlock(p1, p1, -m);
             if (mat12)
-            {
-                for(int i=0; i<N; i++)
-                {
-                    for (int j=0; j<N; j++)
-                    {
-                        mat12.matrix->add(mat12.offRow+p1+i,mat12.offCol+p2+j,  (Real)m[i][j]);
-                    }
-                }
-            }
+                mat12.addBlock(p1, p2, m);
             if (mat21)
-            {
-                for(int i=0; i<N; i++)
-                {
-                    for (int j=0; j<N; j++)
-                    {
-                        mat21.matrix->add(mat21.offRow+p2+i,mat21.offCol+p1+j,  (Real)m[i][j]);
-                    }
-                }
-            }
+                mat21.addBlock(p2, p1, m);
             if (mat22)
-            {
-                for(int i=0; i<N; i++)
-                {
-                    for (int j=0; j<N; j++)
-                    {
-                        mat22.matrix->add(mat22.offset+p2+i,mat22.offset+p2+j, -(Real)m[i][j]);
-                    }
-                }
-            }
+                mat22.addBlock(p2, p2, -m);
         }
     }
 
@@ -324,6 +324,63 @@ public:
 
     }
 
+    /** Overwrite the values with the ones of a CompressedRowSparseMatrix having the same non-zero pattern,
+      as set by a previous copyFrom, without any reallocation. As in copyFrom, the null values of the blocks
+      are not part of the pattern. @pre crs must be compressed
+      @return false if the pattern is different, the matrix then needs to be set with copyFrom
+      */
+    template<class AnyReal>
+    bool updateValuesFrom( const CompressedRowSparseMatrix< defaulttype::Mat<Nout,Nin, AnyReal> >& crs )
+    {
+        typedef typename CompressedMatrix::Index MatrixIndex;
+        CompressedMatrix& m = this->compressedMatrix;
+
+        if( m.rows() != (MatrixIndex)crs.rowSize() || m.cols() != (MatrixIndex)crs.colSize() || !m.isCompressed() )
+            return false;
+
+        const MatrixIndex* outer = m.outerIndexPtr();
+        const MatrixIndex* inner = m.innerIndexPtr();
+        Real* values = m.valuePtr();
+        MatrixIndex nnz = 0;
+
+        for (unsigned int xi = 0; xi < crs.rowIndex.size(); ++xi)  // for each non-null block row
+        {
+            int blRow = crs.rowIndex[xi];      // block row
+
+            typename CompressedRowSparseMatrix<Block>::Range rowRange(crs.rowBegin[xi], crs.rowBegin[xi+1]);
+
+            for( unsigned r=0; r<Nout; r++ )   // process one scalar row after another
+            {
+                const MatrixIndex row = r + blRow*Nout;
+                if( row >= m.rows() ) break;
+
+                MatrixIndex k = outer[row];
+                for (int xj = rowRange.begin(); xj < rowRange.end(); ++xj)  // for each non-null block
+                {
+                    int blCol = crs.colsIndex[xj];     // block column
+                    const Block& b = crs.colsValue[xj]; // block value
+                    for( unsigned c=0; c<Nin; c++ ) if( c+ blCol*Nin < (unsigned)this->colSize() && (double)b[r][c] != 0.0 )
+                        {
+                        if( k == outer[row+1] || inner[k] != (MatrixIndex)(c + blCol*Nin) ) return false;
+                        values[k++] = (Real)b[r][c];
+                        }
+                }
+                if( k != outer[row+1] ) return false;
+                nnz += outer[row+1] - outer[row];
+            }
+        }
+
+        return nnz == m.nonZeros(); // no entry in the rows which are empty in crs
+    }
+
+    /// Set from a CompressedRowSparseMatrix, only updating the values if its non-zero pattern did not change. @pre crs must be compressed
+    template<class AnyReal>
+    void updateFrom( const CompressedRowSparseMatrix< defaulttype::Mat<Nout,Nin, AnyReal> >& crs )
+    {
+        if( !updateValuesFrom(crs) )
+            copyFrom(crs);
+    }
+
 #ifdef _OPENMP
 #define EIGENSPARSEMATRIX_PARALLEL
 #endif
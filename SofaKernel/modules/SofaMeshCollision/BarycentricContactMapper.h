@@ -94,6 +94,7 @@ public:
         if (mapping!=NULL)
         {
             mapper->clear();
+            mapping->invalidateWeights();
             mapping->getMechTo()[0]->resize(size);
         }
     }
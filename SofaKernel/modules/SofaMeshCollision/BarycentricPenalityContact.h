@@ -101,6 +101,8 @@ public:
 
     void removeResponse();
 
+    void deactivate();
+
     void draw(const core::visual::VisualParams* vparams);
 
 };
@@ -252,6 +252,21 @@ void BarycentricPenalityContact<TCollisionModel1,TCollisionModel2,ResponseDataTy
     }
 }
 
+template < class TCollisionModel1, class TCollisionModel2, class ResponseDataTypes >
+void BarycentricPenalityContact<TCollisionModel1,TCollisionModel2,ResponseDataTypes>::deactivate()
+{
+    removeResponse();
+    if (ff!=NULL)
+    {
+        // clear twice so that the contacts kept from the previous step are released too
+        ff->clear();
+        ff->clear();
+    }
+    mapper1.resize(0);
+    mapper2.resize(0);
+    contactIndex.clear();
+}
+
 template < class TCollisionModel1, class TCollisionModel2, class ResponseDataTypes >
 void BarycentricPenalityContact<TCollisionModel1,TCollisionModel2,ResponseDataTypes>::draw(const core::visual::VisualParams* )
 {
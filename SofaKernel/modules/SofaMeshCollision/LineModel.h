@@ -33,6 +33,7 @@
 #include <sofa/core/topology/BaseMeshTopology.h>
 #include <sofa/defaulttype/Vec3Types.h>
 #include <SofaMeshCollision/PointModel.h>
+#include <SofaMeshCollision/PackedElementCoords.h>
 
 namespace sofa
 {
@@ -48,6 +49,8 @@ class TLineModel;
 
 class LineLocalMinDistanceFilter;
 
+class NewProximityIntersection;
+
 template<class TDataTypes>
 class TLine : public core::TCollisionElementIterator<TLineModel<TDataTypes> >
 {
@@ -167,6 +170,10 @@ public:
     
     int getLineFlags(int i);
 
+    /// Positions of the line vertices copied when computing the bounding tree, for batched proximity tests.
+    /// Returns NULL if the positions changed since then, or if NewProximityIntersection::vectorized is off.
+    const PackedElementCoords<2>* getPackedCoords() const;
+
     //template< class TFilter >
     //TFilter *getFilter() const
     //{
@@ -216,6 +223,16 @@ protected:
 
     LineActiver *myActiver;
 
+    PackedElementCoords<2> packedCoords;
+
+    /// Copy the positions of the line vertices in packedCoords
+    void updatePackedCoords();
+
+    /// Intersection reading packedCoords, NULL if there is none in the scene
+    NewProximityIntersection* m_proximityIntersection;
+
+    /// Whether packedCoords are read, i.e. the vectorized option of the intersection is on
+    bool usePackedCoords() const;
 
 };
 
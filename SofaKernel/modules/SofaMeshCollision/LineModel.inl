@@ -30,6 +30,7 @@
 #include <sofa/core/visual/VisualParams.h>
 #include <SofaMeshCollision/LineLocalMinDistanceFilter.h>
 #include <SofaBaseCollision/CubeModel.h>
+#include <SofaBaseCollision/NewProximityIntersection.h>
 #include <SofaMeshCollision/Line.h>
 #include <sofa/core/CollisionElement.h>
 #include <vector>
@@ -53,6 +54,7 @@ template<class DataTypes>
 TLineModel<DataTypes>::TLineModel()
     : bothSide(initData(&bothSide, false, "bothSide", "activate collision on both side of the line model (when surface normals are defined on these lines)") )
     , mstate(NULL), topology(NULL), meshRevision(-1), m_lmdFilter(NULL)
+    , m_proximityIntersection(NULL)
     , LineActiverPath(initData(&LineActiverPath,"LineActiverPath", "path of a component LineActiver that activates or deactivates collision line during execution") )
     , m_displayFreePosition(initData(&m_displayFreePosition, false, "displayFreePosition", "Display Collision Model Points free position(in green)") )
 {
@@ -96,6 +98,8 @@ void TLineModel<DataTypes>::init()
         m_lmdFilter = node->getNodeObject< LineLocalMinDistanceFilter >();
     }
 
+    this->getContext()->get(m_proximityIntersection, core::objectmodel::BaseContext::SearchRoot);
+
     core::topology::BaseMeshTopology *bmt = getContext()->getMeshTopology();
     if (!bmt)
     {
@@ -575,6 +579,8 @@ void TLineModel<DataTypes>::computeBoundingTree(int maxDepth)
     defaulttype::Vector3 minElem, maxElem;
 
     cubeModel->resize(size);
+    if (usePackedCoords())
+        updatePackedCoords();
     if (!empty())
     {
         const SReal distance = (SReal)this->proximity.getValue();
@@ -618,16 +624,20 @@ void TLineModel<DataTypes>::computeContinuousBoundingTree(double dt, int maxDept
     defaulttype::Vector3 minElem, maxElem;
 
     cubeModel->resize(size);
+    if (usePackedCoords())
+        updatePackedCoords();
     if (!empty())
     {
         const SReal distance = (SReal)this->proximity.getValue();
+        // swept from the current positions to the free positions after the free motion, else along the velocities
+        const bool freeMotion = mstate->read(core::ConstVecCoordId::freePosition())->isSet();
         for (int i=0; i<size; i++)
         {
             TLine<DataTypes> t(this,i);
             const defaulttype::Vector3& pt1 = t.p1();
             const defaulttype::Vector3& pt2 = t.p2();
-            const defaulttype::Vector3 pt1v = pt1 + t.v1()*dt;
-            const defaulttype::Vector3 pt2v = pt2 + t.v2()*dt;
+            const defaulttype::Vector3 pt1v = freeMotion ? defaulttype::Vector3(t.p1Free()) : pt1 + t.v1()*dt;
+            const defaulttype::Vector3 pt2v = freeMotion ? defaulttype::Vector3(t.p2Free()) : pt2 + t.v2()*dt;
 
             for (int c = 0; c < 3; c++)
             {
@@ -649,6 +659,33 @@ void TLineModel<DataTypes>::computeContinuousBoundingTree(double dt, int maxDept
     }
 }
 
+template<class DataTypes>
+bool TLineModel<DataTypes>::usePackedCoords() const
+{
+    return m_proximityIntersection != NULL && m_proximityIntersection->d_vectorized.getValue();
+}
+
+template<class DataTypes>
+void TLineModel<DataTypes>::updatePackedCoords()
+{
+    const VecCoord& x = mstate->read(core::ConstVecCoordId::position())->getValue();
+    packedCoords.resize(size);
+    for (int i=0; i<size; i++)
+    {
+        packedCoords.set(i, 0, x[elems[i].p[0]]);
+        packedCoords.set(i, 1, x[elems[i].p[1]]);
+    }
+    packedCoords.setCounter(mstate->read(core::ConstVecCoordId::position())->getCounter());
+}
+
+template<class DataTypes>
+const PackedElementCoords<2>* TLineModel<DataTypes>::getPackedCoords() const
+{
+    if (!packedCoords.isUpToDate(size, mstate->read(core::ConstVecCoordId::position())->getCounter()))
+        return NULL;
+    return &packedCoords;
+}
+
 template<class DataTypes>
 int TLineModel<DataTypes>::getLineFlags(int i)
 {
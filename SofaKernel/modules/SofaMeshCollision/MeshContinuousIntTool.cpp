@@ -0,0 +1,253 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2016 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This library is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This library is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this library; if not, write to the Free Software Foundation,     *
+* Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA.          *
+*******************************************************************************
+*                               SOFA :: Modules                               *
+*                                                                             *
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <SofaMeshCollision/MeshContinuousIntTool.h>
+#include <SofaBaseCollision/IntrUtility3.h>
+#include <sofa/helper/rmath.h>
+#include <algorithm>
+#include <cmath>
+
+namespace sofa
+{
+
+namespace component
+{
+
+namespace collision
+{
+
+namespace
+{
+
+inline SReal cubic(const SReal (&coefs)[4], SReal t)
+{
+    return ((coefs[0]*t + coefs[1])*t + coefs[2])*t + coefs[3];
+}
+
+inline SReal det3(const defaulttype::Vector3& u, const defaulttype::Vector3& v, const defaulttype::Vector3& w)
+{
+    return u * v.cross(w);
+}
+
+/// Positions of the 4 vertices at the time t of the step
+inline void interpolate(const defaulttype::Vector3 (&x0)[4], const defaulttype::Vector3 (&x1)[4], SReal t, defaulttype::Vector3 (&x)[4])
+{
+    for (int k=0; k<4; k++)
+        x[k] = x0[k] + (x1[k]-x0[k])*t;
+}
+
+} // anonymous namespace
+
+int MeshContinuousIntTool::cubicRootsInUnitInterval(SReal a, SReal b, SReal c, SReal d, SReal roots[3])
+{
+    const SReal scale = std::max(std::max(helper::rabs(a), helper::rabs(b)), std::max(helper::rabs(c), helper::rabs(d)));
+    if (scale == 0)
+        return 0; // identically null, no isolated root
+    const SReal coefs[4] = { a/scale, b/scale, c/scale, d/scale };
+    const SReal epsilon = (SReal)1e-12;
+
+    // the polynomial is monotonous between the roots of its derivative 3a t^2 + 2b t + c
+    SReal bounds[4];
+    int nbBounds = 0;
+    bounds[nbBounds++] = 0;
+    if (helper::rabs(coefs[0]) > epsilon)
+    {
+        const SReal disc = coefs[1]*coefs[1] - 3*coefs[0]*coefs[2];
+        if (disc > 0)
+        {
+            const SReal s = helper::rsqrt(disc);
+            SReal t1 = (-coefs[1] - s) / (3*coefs[0]);
+            SReal t2 = (-coefs[1] + s) / (3*coefs[0]);
+            if (t1 > t2) std::swap(t1, t2);
+            if (t1 > 0 && t1 < 1) bounds[nbBounds++] = t1;
+            if (t2 > 0 && t2 < 1) bounds[nbBounds++] = t2;
+        }
+    }
+    else if (helper::rabs(coefs[1]) > epsilon)
+    {
+        const SReal t = -coefs[2] / (2*coefs[1]);
+        if (t > 0 && t < 1) bounds[nbBounds++] = t;
+    }
+    bounds[nbBounds++] = 1;
+
+    int n = 0;
+    for (int i=0; i<nbBounds && n<3; i++)
+    {
+        SReal root = -1;
+        const SReal f = cubic(coefs, bounds[i]);
+        if (helper::rabs(f) <= epsilon)
+        {
+            // root at a bound, or extremum grazing 0: kept as a candidate
+            root = bounds[i];
+        }
+        else if (i+1 < nbBounds)
+        {
+            SReal lo = bounds[i];
+            SReal hi = bounds[i+1];
+            SReal flo = f;
+            const SReal fhi = cubic(coefs, hi);
+            if (helper::rabs(fhi) <= epsilon || (flo < 0) == (fhi < 0))
+                continue;
+            // bisection, the function being monotonous in [lo,hi]
+            for (int it=0; it<64 && hi-lo > epsilon; it++)
+            {
+                const SReal mid = (lo+hi)*(SReal)0.5;
+                const SReal fmid = cubic(coefs, mid);
+                if ((fmid < 0) == (flo < 0))
+                {
+                    lo = mid;
+                    flo = fmid;
+                }
+                else
+                    hi = mid;
+            }
+            root = (lo+hi)*(SReal)0.5;
+        }
+        else
+            continue;
+        if (n == 0 || root > roots[n-1])
+            roots[n++] = root;
+    }
+    return n;
+}
+
+void MeshContinuousIntTool::coplanarityPolynomial(const Vector3 (&x0)[4], const Vector3 (&x1)[4], SReal coefs[4])
+{
+    const Vector3 u = x0[1]-x0[0];
+    const Vector3 v = x0[2]-x0[0];
+    const Vector3 w = x0[3]-x0[0];
+    const Vector3 du = (x1[1]-x1[0]) - u;
+    const Vector3 dv = (x1[2]-x1[0]) - v;
+    const Vector3 dw = (x1[3]-x1[0]) - w;
+    coefs[0] = det3(du, dv, dw);
+    coefs[1] = det3(u, dv, dw) + det3(du, v, dw) + det3(du, dv, w);
+    coefs[2] = det3(du, v, w) + det3(u, dv, w) + det3(u, v, dw);
+    coefs[3] = det3(u, v, w);
+}
+
+MeshContinuousIntTool::Vector3 MeshContinuousIntTool::nearestPointOnTriangle(const Vector3& p1, const Vector3& p2, const Vector3& p3, const Vector3& q, SReal& alpha, SReal& beta)
+{
+    const Vector3 AB = p2-p1;
+    const Vector3 AC = p3-p1;
+    const Vector3 AQ = q-p1;
+    const SReal d1 = AB*AQ;
+    const SReal d2 = AC*AQ;
+    if (d1 <= 0 && d2 <= 0)
+    {
+        // vertex p1
+        alpha = 0; beta = 0;
+        return p1;
+    }
+    const Vector3 BQ = q-p2;
+    const SReal d3 = AB*BQ;
+    const SReal d4 = AC*BQ;
+    if (d3 >= 0 && d4 <= d3)
+    {
+        // vertex p2
+        alpha = 1; beta = 0;
+        return p2;
+    }
+    const SReal vc = d1*d4 - d3*d2;
+    if (vc <= 0 && d1 >= 0 && d3 <= 0)
+    {
+        // edge p1 p2
+        alpha = d1 / (d1-d3); beta = 0;
+        return p1 + AB*alpha;
+    }
+    const Vector3 CQ = q-p3;
+    const SReal d5 = AB*CQ;
+    const SReal d6 = AC*CQ;
+    if (d6 >= 0 && d5 <= d6)
+    {
+        // vertex p3
+        alpha = 0; beta = 1;
+        return p3;
+    }
+    const SReal vb = d5*d2 - d1*d6;
+    if (vb <= 0 && d2 >= 0 && d6 <= 0)
+    {
+        // edge p1 p3
+        alpha = 0; beta = d2 / (d2-d6);
+        return p1 + AC*beta;
+    }
+    const SReal va = d3*d6 - d5*d4;
+    if (va <= 0 && (d4-d3) >= 0 && (d5-d6) >= 0)
+    {
+        // edge p2 p3
+        beta = (d4-d3) / ((d4-d3) + (d5-d6)); alpha = 1-beta;
+        return p2 + (p3-p2)*beta;
+    }
+    // inside the triangle
+    const SReal denom = 1 / (va+vb+vc);
+    alpha = vb*denom;
+    beta = vc*denom;
+    return p1 + AB*alpha + AC*beta;
+}
+
+bool MeshContinuousIntTool::vertexFaceTimeOfImpact(const Vector3 (&x0)[4], const Vector3 (&x1)[4], SReal distance, SReal& t, SReal& alpha, SReal& beta)
+{
+    SReal coefs[4];
+    coplanarityPolynomial(x0, x1, coefs);
+    SReal roots[3];
+    const int n = cubicRootsInUnitInterval(coefs[0], coefs[1], coefs[2], coefs[3], roots);
+    for (int i=0; i<n; i++)
+    {
+        Vector3 x[4];
+        interpolate(x0, x1, roots[i], x);
+        const Vector3 p = nearestPointOnTriangle(x[0], x[1], x[2], x[3], alpha, beta);
+        if ((x[3]-p).norm2() <= distance*distance)
+        {
+            t = roots[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+bool MeshContinuousIntTool::edgeEdgeTimeOfImpact(const Vector3 (&x0)[4], const Vector3 (&x1)[4], SReal distance, SReal& t, SReal& alpha, SReal& beta)
+{
+    SReal coefs[4];
+    coplanarityPolynomial(x0, x1, coefs);
+    SReal roots[3];
+    const int n = cubicRootsInUnitInterval(coefs[0], coefs[1], coefs[2], coefs[3], roots);
+    for (int i=0; i<n; i++)
+    {
+        Vector3 x[4];
+        interpolate(x0, x1, roots[i], x);
+        Vector3 p, q;
+        IntrUtil<SReal>::segNearestPoints(x[0], x[1], x[2], x[3], p, q, alpha, beta);
+        if ((q-p).norm2() <= distance*distance)
+        {
+            t = roots[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace collision
+
+} // namespace component
+
+} // namespace sofa
@@ -0,0 +1,77 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2016 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This library is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This library is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this library; if not, write to the Free Software Foundation,     *
+* Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA.          *
+*******************************************************************************
+*                               SOFA :: Modules                               *
+*                                                                             *
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#ifndef SOFA_COMPONENT_COLLISION_MESHCONTINUOUSINTTOOL_H
+#define SOFA_COMPONENT_COLLISION_MESHCONTINUOUSINTTOOL_H
+#include "config.h"
+
+#include <sofa/defaulttype/Vec.h>
+
+namespace sofa
+{
+
+namespace component
+{
+
+namespace collision
+{
+
+/**
+ *  \brief Time of impact of mesh features moving linearly during a time step.
+ *
+ *  The vertices move from their positions x0 at the beginning of the step to their positions x1 at its end.
+ *  Four points are coplanar when the determinant of their edge vectors, a cubic polynomial of the time, vanishes:
+ *  its roots in [0,1] are the candidate times of impact of a vertex and a triangle, or of two edges, which are then
+ *  checked with the distance between the features at this time.
+ */
+class SOFA_MESH_COLLISION_API MeshContinuousIntTool
+{
+public:
+    typedef defaulttype::Vector3 Vector3;
+
+    /// Roots in [0,1] of a t^3 + b t^2 + c t + d, in increasing order. Returns their number.
+    static int cubicRootsInUnitInterval(SReal a, SReal b, SReal c, SReal d, SReal roots[3]);
+
+    /// Coefficients (t^3 first) of det(x1-x0, x2-x0, x3-x0)(t), for the 4 points x moving from x0 to x1.
+    static void coplanarityPolynomial(const Vector3 (&x0)[4], const Vector3 (&x1)[4], SReal coefs[4]);
+
+    /// Nearest point of the triangle (p1,p2,p3) to q, p1 + alpha (p2-p1) + beta (p3-p1).
+    static Vector3 nearestPointOnTriangle(const Vector3& p1, const Vector3& p2, const Vector3& p3, const Vector3& q, SReal& alpha, SReal& beta);
+
+    /// First time t in [0,1] at which the vertex x[3] comes within the given distance of the triangle (x[0],x[1],x[2]),
+    /// while crossing its plane. alpha and beta are the barycentric coordinates of the nearest point of the triangle at t.
+    static bool vertexFaceTimeOfImpact(const Vector3 (&x0)[4], const Vector3 (&x1)[4], SReal distance, SReal& t, SReal& alpha, SReal& beta);
+
+    /// First time t in [0,1] at which the edges (x[0],x[1]) and (x[2],x[3]) come within the given distance of each
+    /// other, while crossing. alpha and beta are the coordinates of their nearest points along each edge at t.
+    static bool edgeEdgeTimeOfImpact(const Vector3 (&x0)[4], const Vector3 (&x1)[4], SReal distance, SReal& t, SReal& alpha, SReal& beta);
+};
+
+} // namespace collision
+
+} // namespace component
+
+} // namespace sofa
+
+#endif
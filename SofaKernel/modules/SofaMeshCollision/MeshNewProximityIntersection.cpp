@@ -23,6 +23,7 @@
 * Contact information: contact@sofa-framework.org                             *
 ******************************************************************************/
 #include <SofaMeshCollision/MeshNewProximityIntersection.inl>
+#include <SofaMeshCollision/MeshProximityKernel.h>
 #include <sofa/helper/system/config.h>
 #include <sofa/helper/FnDispatcher.inl>
 #include <sofa/core/collision/Intersection.inl>
@@ -116,6 +117,8 @@ int MeshNewProximityIntersection::computeIntersection(Line& e1, Line& e2, Output
     const SReal dist2 = alarmDist*alarmDist;
     const int id = (e1.getCollisionModel()->getSize() > e2.getCollisionModel()->getSize()) ? e1.getIndex() : e2.getIndex();
     int n = doIntersectionLineLine(dist2, e1.p1(),e1.p2(), e2.p1(),e2.p2(), contacts, id);
+    if (n==0 && intersection->useContinuous())
+        n = computeContinuousIntersection(e1, e2, contacts);
     if (n>0)
     {
         const SReal contactDist = intersection->getContactDistance() + e1.getProximity() + e2.getProximity();
@@ -133,6 +136,8 @@ int MeshNewProximityIntersection::computeIntersection(Triangle& e1, Point& e2, O
     const SReal alarmDist = intersection->getAlarmDistance() + e1.getProximity() + e2.getProximity();
     const SReal dist2 = alarmDist*alarmDist;
     int n = doIntersectionTrianglePoint(dist2, e1.flags(),e1.p1(),e1.p2(),e1.p3(),e1.n(), e2.p(), contacts, e2.getIndex());
+    if (n==0 && intersection->useContinuous())
+        n = computeContinuousIntersection(e1, e2, contacts);
     if (n>0)
     {
         const SReal contactDist = intersection->getContactDistance() + e1.getProximity() + e2.getProximity();
@@ -187,6 +192,9 @@ int MeshNewProximityIntersection::computeIntersection(Triangle& e1, Line& e2, Ou
             n += doIntersectionLineLine(dist2, p3, p1, q1, q2, contacts, e2.getIndex());
     }
 
+    if (n==0 && intersection->useContinuous())
+        n = computeContinuousIntersection(e1, e2, contacts);
+
     if (n>0)
     {
         const SReal contactDist = intersection->getContactDistance() + e1.getProximity() + e2.getProximity();
@@ -283,6 +291,9 @@ int MeshNewProximityIntersection::computeIntersection(Triangle& e1, Triangle& e2
         }
     }
 
+    if (n==0 && intersection->useContinuous())
+        n = computeContinuousIntersection(e1, e2, contacts);
+
     if (n>0)
     {
         const SReal contactDist = intersection->getContactDistance() + e1.getProximity() + e2.getProximity();
@@ -296,6 +307,279 @@ int MeshNewProximityIntersection::computeIntersection(Triangle& e1, Triangle& e2
     return n;
 }
 
+namespace
+{
+
+/// Positions of the vertices at the end of the step for the continuous tests, as for the swept bounding volumes of the
+/// models: free positions after the free motion, else current positions extrapolated with the velocities.
+
+inline Vector3 endPosition(const Point& e, SReal dt)
+{
+    return e.hasFreePosition() ? e.pFree() : e.p() + e.v()*dt;
+}
+
+inline Vector3 endPosition(const Line& e, int i, SReal dt)
+{
+    if (e.hasFreePosition())
+        return i == 0 ? e.p1Free() : e.p2Free();
+    return e.p(i) + (i == 0 ? e.v1() : e.v2())*dt;
+}
+
+inline Vector3 endPosition(const Triangle& e, int i, SReal dt)
+{
+    if (e.hasFreePosition())
+        return i == 0 ? e.p1Free() : (i == 1 ? e.p2Free() : e.p3Free());
+    return e.p(i) + e.v(i)*dt;
+}
+
+} // anonymous namespace
+
+int MeshNewProximityIntersection::computeContinuousIntersection(Line& e1, Line& e2, OutputVector* contacts)
+{
+    const SReal alarmDist = intersection->getAlarmDistance() + e1.getProximity() + e2.getProximity();
+    const SReal dt = e1.getCollisionModel()->getContext()->getDt();
+    const int id = (e1.getCollisionModel()->getSize() > e2.getCollisionModel()->getSize()) ? e1.getIndex() : e2.getIndex();
+    const Vector3 x0[4] = { e1.p1(), e1.p2(), e2.p1(), e2.p2() };
+    const Vector3 x1[4] = { endPosition(e1, 0, dt), endPosition(e1, 1, dt), endPosition(e2, 0, dt), endPosition(e2, 1, dt) };
+    return doContinuousLineLine(alarmDist, x0, x1, dt, contacts, id);
+}
+
+int MeshNewProximityIntersection::computeContinuousIntersection(Triangle& e1, Point& e2, OutputVector* contacts)
+{
+    const SReal alarmDist = intersection->getAlarmDistance() + e1.getProximity() + e2.getProximity();
+    const SReal dt = e1.getCollisionModel()->getContext()->getDt();
+    const Vector3 x0[4] = { e1.p1(), e1.p2(), e1.p3(), e2.p() };
+    const Vector3 x1[4] = { endPosition(e1, 0, dt), endPosition(e1, 1, dt), endPosition(e1, 2, dt), endPosition(e2, dt) };
+    return doContinuousTrianglePoint(alarmDist, e1.flags(), x0, x1, dt, contacts, e2.getIndex());
+}
+
+int MeshNewProximityIntersection::computeContinuousIntersection(Triangle& e1, Line& e2, OutputVector* contacts)
+{
+    const SReal alarmDist = intersection->getAlarmDistance() + e1.getProximity() + e2.getProximity();
+    const SReal dt = e1.getCollisionModel()->getContext()->getDt();
+    const Vector3 p0[3] = { e1.p1(), e1.p2(), e1.p3() };
+    const Vector3 p1[3] = { endPosition(e1, 0, dt), endPosition(e1, 1, dt), endPosition(e1, 2, dt) };
+    const Vector3 q0[2] = { e2.p1(), e2.p2() };
+    const Vector3 q1[2] = { endPosition(e2, 0, dt), endPosition(e2, 1, dt) };
+    const int f1 = e1.flags();
+
+    int n = 0;
+    for (int j=0; j<2; j++)
+    {
+        const Vector3 x0[4] = { p0[0], p0[1], p0[2], q0[j] };
+        const Vector3 x1[4] = { p1[0], p1[1], p1[2], q1[j] };
+        n += doContinuousTrianglePoint(alarmDist, f1, x0, x1, dt, contacts, e2.getIndex());
+    }
+
+    if (intersection->useLineLine.getValue())
+    {
+        const int edgeFlags[3] = { TriangleModel::FLAG_E12, TriangleModel::FLAG_E23, TriangleModel::FLAG_E31 };
+        for (int i=0; i<3; i++)
+        {
+            if (!(f1&edgeFlags[i])) continue;
+            const Vector3 x0[4] = { p0[i], p0[(i+1)%3], q0[0], q0[1] };
+            const Vector3 x1[4] = { p1[i], p1[(i+1)%3], q1[0], q1[1] };
+            n += doContinuousLineLine(alarmDist, x0, x1, dt, contacts, e2.getIndex());
+        }
+    }
+    return n;
+}
+
+int MeshNewProximityIntersection::computeContinuousIntersection(Triangle& e1, Triangle& e2, OutputVector* contacts)
+{
+    const SReal alarmDist = intersection->getAlarmDistance() + e1.getProximity() + e2.getProximity();
+    const SReal dt = e1.getCollisionModel()->getContext()->getDt();
+    const Vector3 p0[3] = { e1.p1(), e1.p2(), e1.p3() };
+    const Vector3 p1[3] = { endPosition(e1, 0, dt), endPosition(e1, 1, dt), endPosition(e1, 2, dt) };
+    const Vector3 q0[3] = { e2.p1(), e2.p2(), e2.p3() };
+    const Vector3 q1[3] = { endPosition(e2, 0, dt), endPosition(e2, 1, dt), endPosition(e2, 2, dt) };
+    const int f1 = e1.flags();
+    const int f2 = e2.flags();
+    const int pointFlags[3] = { TriangleModel::FLAG_P1, TriangleModel::FLAG_P2, TriangleModel::FLAG_P3 };
+    const int edgeFlags[3] = { TriangleModel::FLAG_E12, TriangleModel::FLAG_E23, TriangleModel::FLAG_E31 };
+
+    // same contact ids as the discrete test
+    const int id1 = e1.getIndex()*3;
+    const int id2 = e1.getCollisionModel()->getSize()*3 + e2.getIndex()*12;
+
+    int n = 0;
+    for (int i=0; i<3; i++)
+    {
+        if (!(f1&pointFlags[i])) continue;
+        const Vector3 x0[4] = { q0[0], q0[1], q0[2], p0[i] };
+        const Vector3 x1[4] = { q1[0], q1[1], q1[2], p1[i] };
+        n += doContinuousTrianglePoint(alarmDist, f2, x0, x1, dt, contacts, id1+i, true);
+    }
+    for (int i=0; i<3; i++)
+    {
+        if (!(f2&pointFlags[i])) continue;
+        const Vector3 x0[4] = { p0[0], p0[1], p0[2], q0[i] };
+        const Vector3 x1[4] = { p1[0], p1[1], p1[2], q1[i] };
+        n += doContinuousTrianglePoint(alarmDist, f1, x0, x1, dt, contacts, id2+i, false);
+    }
+
+    if (intersection->useLineLine.getValue())
+    {
+        for (int i=0; i<3; i++)
+        {
+            if (!(f1&edgeFlags[i])) continue;
+            for (int j=0; j<3; j++)
+            {
+                if (!(f2&edgeFlags[j])) continue;
+                const Vector3 x0[4] = { p0[i], p0[(i+1)%3], q0[j], q0[(j+1)%3] };
+                const Vector3 x1[4] = { p1[i], p1[(i+1)%3], q1[j], q1[(j+1)%3] };
+                n += doContinuousLineLine(alarmDist, x0, x1, dt, contacts, id2+3+i*3+j);
+            }
+        }
+    }
+    return n;
+}
+
+namespace
+{
+
+/// Lower bounds of the distances of the tests of each pair of element types, for the batches
+
+struct PointPointDistance2
+{
+    template<class Real, int N>
+    void operator()(const Real (&p)[1][3][N], const Real (&q)[1][3][N], Real (&d2)[N]) const
+    {
+        pointPointDistance2(p[0], q[0], d2);
+    }
+};
+
+struct LinePointDistance2
+{
+    template<class Real, int N>
+    void operator()(const Real (&s)[2][3][N], const Real (&q)[1][3][N], Real (&d2)[N]) const
+    {
+        pointSegmentDistance2(s[0], s[1], q[0], d2);
+    }
+};
+
+struct LineLineDistance2
+{
+    template<class Real, int N>
+    void operator()(const Real (&s)[2][3][N], const Real (&r)[2][3][N], Real (&d2)[N]) const
+    {
+        segmentSegmentDistance2(s[0], s[1], r[0], r[1], IntrUtil<Real>::ZERO_TOLERANCE(), d2);
+    }
+};
+
+struct TrianglePointDistance2
+{
+    template<class Real, int N>
+    void operator()(const Real (&t)[3][3][N], const Real (&q)[1][3][N], Real (&d2)[N]) const
+    {
+        pointTriangleDistance2(t[0], t[1], t[2], q[0], d2);
+    }
+};
+
+struct TriangleLineDistance2
+{
+    TriangleLineDistance2(bool lineLine) : lineLine(lineLine) {}
+    template<class Real, int N>
+    void operator()(const Real (&t)[3][3][N], const Real (&s)[2][3][N], Real (&d2)[N]) const
+    {
+        triangleSegmentDistance2(t, s, lineLine, IntrUtil<Real>::ZERO_TOLERANCE(), d2);
+    }
+    bool lineLine;
+};
+
+struct TriangleTriangleDistance2
+{
+    TriangleTriangleDistance2(bool lineLine) : lineLine(lineLine) {}
+    template<class Real, int N>
+    void operator()(const Real (&t)[3][3][N], const Real (&u)[3][3][N], Real (&d2)[N]) const
+    {
+        triangleTriangleDistance2(t, u, lineLine, IntrUtil<Real>::ZERO_TOLERANCE(), d2);
+    }
+    bool lineLine;
+};
+
+} // anonymous namespace
+
+template<class Elem1, int NV1, class Model2, int NV2, class Distance2>
+int MeshNewProximityIntersection::computeBatchIntersections(Elem1& e1, const PackedElementCoords<NV1>* coords1, Model2* model2, const PackedElementCoords<NV2>* coords2,
+                                                            const helper::vector<int>& indices2, OutputVector* contacts, const Distance2& distance2)
+{
+    typedef typename Model2::Element Elem2;
+    enum { N = ProximityBatchSize };
+
+    // the batches reject the pairs on their current distances, which would discard the continuous tests
+    bool vectorized = intersection->d_vectorized.getValue() && !intersection->useContinuous() && coords1 != NULL && coords2 != NULL
+            && e1.getIndex() < e1.getCollisionModel()->getSize();
+    for (unsigned int i=0; i<indices2.size() && vectorized; i++)
+        vectorized = indices2[i] < model2->getSize();
+
+    int n = 0;
+    if (!vectorized)
+    {
+        for (unsigned int i=0; i<indices2.size(); i++)
+        {
+            Elem2 e2(model2, indices2[i]);
+            n += computeIntersection(e1, e2, contacts);
+        }
+        return n;
+    }
+
+    const SReal alarmDist = intersection->getAlarmDistance() + e1.getProximity() + model2->getProximity();
+    const SReal maxDist2 = proximityRejectDistance2(alarmDist*alarmDist);
+
+    SReal x1[NV1][3][N];
+    SReal x2[NV2][3][N];
+    SReal d2[N];
+    coords1->broadcast(e1.getIndex(), x1);
+    for (unsigned int b=0; b<indices2.size(); b+=N)
+    {
+        const int nb = std::min((int)N, (int)(indices2.size()-b));
+        coords2->gather(&indices2[b], nb, x2);
+        distance2(x1, x2, d2);
+        for (int l=0; l<nb; ++l)
+        {
+            if (d2[l] < maxDist2)
+            {
+                Elem2 e2(model2, indices2[b+l]);
+                n += computeIntersection(e1, e2, contacts);
+            }
+        }
+    }
+    return n;
+}
+
+int MeshNewProximityIntersection::computeIntersections(Point& e1, PointModel* model2, const helper::vector<int>& indices2, OutputVector* contacts)
+{
+    return computeBatchIntersections(e1, e1.getCollisionModel()->getPackedCoords(), model2, model2->getPackedCoords(), indices2, contacts, PointPointDistance2());
+}
+
+int MeshNewProximityIntersection::computeIntersections(Line& e1, PointModel* model2, const helper::vector<int>& indices2, OutputVector* contacts)
+{
+    return computeBatchIntersections(e1, e1.getCollisionModel()->getPackedCoords(), model2, model2->getPackedCoords(), indices2, contacts, LinePointDistance2());
+}
+
+int MeshNewProximityIntersection::computeIntersections(Line& e1, LineModel* model2, const helper::vector<int>& indices2, OutputVector* contacts)
+{
+    return computeBatchIntersections(e1, e1.getCollisionModel()->getPackedCoords(), model2, model2->getPackedCoords(), indices2, contacts, LineLineDistance2());
+}
+
+int MeshNewProximityIntersection::computeIntersections(Triangle& e1, PointModel* model2, const helper::vector<int>& indices2, OutputVector* contacts)
+{
+    return computeBatchIntersections(e1, e1.getCollisionModel()->getPackedCoords(), model2, model2->getPackedCoords(), indices2, contacts, TrianglePointDistance2());
+}
+
+int MeshNewProximityIntersection::computeIntersections(Triangle& e1, LineModel* model2, const helper::vector<int>& indices2, OutputVector* contacts)
+{
+    return computeBatchIntersections(e1, e1.getCollisionModel()->getPackedCoords(), model2, model2->getPackedCoords(), indices2, contacts,
+                                     TriangleLineDistance2(intersection->useLineLine.getValue()));
+}
+
+int MeshNewProximityIntersection::computeIntersections(Triangle& e1, TriangleModel* model2, const helper::vector<int>& indices2, OutputVector* contacts)
+{
+    return computeBatchIntersections(e1, e1.getCollisionModel()->getPackedCoords(), model2, model2->getPackedCoords(), indices2, contacts,
+                                     TriangleTriangleDistance2(intersection->useLineLine.getValue()));
+}
+
 
 
 } // namespace collision
@@ -73,6 +73,24 @@ public:
 
     int computeIntersection(Triangle&, Triangle&, OutputVector*);
 
+    /// Continuous tests (NewProximityIntersection::continuous) of the pairs without contact at the current positions.
+    /// The vertices move linearly to their positions at the end of the step, and a contact is created at the first time
+    /// of impact of each vertex-face pair, and of each edge-edge pair between lines or with useLineLine.
+    int computeContinuousIntersection(Line&, Line&, OutputVector*);
+    int computeContinuousIntersection(Triangle&, Point&, OutputVector*);
+    int computeContinuousIntersection(Triangle&, Line&, OutputVector*);
+    int computeContinuousIntersection(Triangle&, Triangle&, OutputVector*);
+
+    /// Tests between an element and the given elements of a model, in this order.
+    /// With NewProximityIntersection::vectorized, the pairs which are too far apart are first rejected
+    /// by batches, with the kernels of MeshProximityKernel.h on the packed coordinates of the models.
+    int computeIntersections(Point&, PointModel*, const helper::vector<int>&, OutputVector*);
+    int computeIntersections(Line&, PointModel*, const helper::vector<int>&, OutputVector*);
+    int computeIntersections(Line&, LineModel*, const helper::vector<int>&, OutputVector*);
+    int computeIntersections(Triangle&, PointModel*, const helper::vector<int>&, OutputVector*);
+    int computeIntersections(Triangle&, LineModel*, const helper::vector<int>&, OutputVector*);
+    int computeIntersections(Triangle&, TriangleModel*, const helper::vector<int>&, OutputVector*);
+
     template <class T1,class T2>
     int computeIntersection(T1 & e1,T2 & e2,OutputVector* contacts){
         return MeshIntTool::computeIntersection(e1,e2,e1.getProximity() + e2.getProximity() + intersection->getAlarmDistance(),e1.getProximity() + e2.getProximity() + intersection->getContactDistance(),contacts);
@@ -84,10 +102,21 @@ public:
 
     static inline int doIntersectionTrianglePoint(SReal dist2, int flags, const defaulttype::Vector3& p1, const defaulttype::Vector3& p2, const defaulttype::Vector3& p3, const defaulttype::Vector3& n, const defaulttype::Vector3& q, OutputVector* contacts, int id, bool swapElems = false);
 
+    /// Contact at the time of impact of the vertex x[3] with the triangle (x[0],x[1],x[2]) moving from x0 to x1 during dt.
+    /// The contact points and the distance along the normal are given at the current positions x0.
+    static inline int doContinuousTrianglePoint(SReal dist, int flags, const defaulttype::Vector3 (&x0)[4], const defaulttype::Vector3 (&x1)[4], SReal dt, OutputVector* contacts, int id, bool swapElems = false);
+
+    /// Contact at the time of impact of the edges (x[0],x[1]) and (x[2],x[3]) moving from x0 to x1 during dt.
+    static inline int doContinuousLineLine(SReal dist, const defaulttype::Vector3 (&x0)[4], const defaulttype::Vector3 (&x1)[4], SReal dt, OutputVector* contacts, int id);
+
     static inline int doIntersectionTrianglePoint2(SReal dist2, int flags, const defaulttype::Vector3& p1, const defaulttype::Vector3& p2, const defaulttype::Vector3& p3, const defaulttype::Vector3& n, const defaulttype::Vector3& q, OutputVector* contacts, int id, bool swapElems = false);
 
 protected:
 
+    template<class Elem1, int NV1, class Model2, int NV2, class Distance2>
+    int computeBatchIntersections(Elem1& e1, const PackedElementCoords<NV1>* coords1, Model2* model2, const PackedElementCoords<NV2>* coords2,
+                                  const helper::vector<int>& indices2, OutputVector* contacts, const Distance2& distance2);
+
     NewProximityIntersection* intersection;
 };
 
@@ -27,6 +27,7 @@
 
 #include <sofa/helper/system/config.h>
 #include <SofaMeshCollision/MeshNewProximityIntersection.h>
+#include <SofaMeshCollision/MeshContinuousIntTool.h>
 #include <SofaBaseCollision/NewProximityIntersection.inl>
 #include <sofa/core/visual/VisualParams.h>
 #include <sofa/helper/proximity.h>
@@ -341,6 +342,90 @@ inline int MeshNewProximityIntersection::doIntersectionTrianglePoint(SReal dist2
     return 1;
 }
 
+inline int MeshNewProximityIntersection::doContinuousTrianglePoint(SReal dist, int flags, const defaulttype::Vector3 (&x0)[4], const defaulttype::Vector3 (&x1)[4], SReal dt, OutputVector* contacts, int id, bool swapElems)
+{
+    SReal t, alpha, beta;
+    if (!MeshContinuousIntTool::vertexFaceTimeOfImpact(x0, x1, dist, t, alpha, beta))
+        return 0;
+
+    // same filtering of the corners and edges shared with other triangles as the discrete test
+    const SReal eps = 0.000001;
+    int feature = 0;
+    if (alpha + beta < eps) feature = TriangleModel::FLAG_P1;
+    else if (alpha > 1-eps) feature = TriangleModel::FLAG_P2;
+    else if (beta > 1-eps) feature = TriangleModel::FLAG_P3;
+    else if (beta < eps) feature = TriangleModel::FLAG_E12;
+    else if (alpha < eps) feature = TriangleModel::FLAG_E31;
+    else if (alpha + beta > 1-eps) feature = TriangleModel::FLAG_E23;
+    if (feature && !(flags&feature))
+        return 0;
+
+    // normal of the triangle at the time of impact, oriented toward the side of the vertex before the impact
+    const defaulttype::Vector3 p1t = x0[0] + (x1[0]-x0[0])*t;
+    defaulttype::Vector3 n = (x0[1] + (x1[1]-x0[1])*t - p1t).cross(x0[2] + (x1[2]-x0[2])*t - p1t);
+    const SReal norm = n.norm();
+    if (norm < IntrUtil<SReal>::ZERO_TOLERANCE()*IntrUtil<SReal>::ZERO_TOLERANCE())
+        return 0;
+    const defaulttype::Vector3 p = x0[0] + (x0[1]-x0[0])*alpha + (x0[2]-x0[0])*beta;
+    const defaulttype::Vector3 pFree = x1[0] + (x1[1]-x1[0])*alpha + (x1[2]-x1[0])*beta;
+    SReal side = n * (x0[3]-p);
+    if (side == 0)
+        side = -(n * (x1[3]-pFree));
+    n *= (side < 0 ? -1 : 1) / norm;
+
+    contacts->resize(contacts->size()+1);
+    core::collision::DetectionOutput *detection = &*(contacts->end()-1);
+    detection->id = id;
+    detection->value = n * (x0[3]-p);
+    detection->deltaT = t*dt;
+    if (swapElems)
+    {
+        detection->point[0]=x0[3];
+        detection->point[1]=p;
+        detection->normal = -n;
+    }
+    else
+    {
+        detection->point[0]=p;
+        detection->point[1]=x0[3];
+        detection->normal = n;
+    }
+    return 1;
+}
+
+inline int MeshNewProximityIntersection::doContinuousLineLine(SReal dist, const defaulttype::Vector3 (&x0)[4], const defaulttype::Vector3 (&x1)[4], SReal dt, OutputVector* contacts, int id)
+{
+    SReal t, alpha, beta;
+    if (!MeshContinuousIntTool::edgeEdgeTimeOfImpact(x0, x1, dist, t, alpha, beta))
+        return 0;
+
+    // normal of the edges at the time of impact, oriented from the first edge toward the second one before the impact
+    const defaulttype::Vector3 dp = (x0[1] + (x1[1]-x0[1])*t) - (x0[0] + (x1[0]-x0[0])*t);
+    const defaulttype::Vector3 dq = (x0[3] + (x1[3]-x0[3])*t) - (x0[2] + (x1[2]-x0[2])*t);
+    defaulttype::Vector3 n = dp.cross(dq);
+    const SReal norm2 = n.norm2();
+    if (norm2 <= IntrUtil<SReal>::SQ_ZERO_TOLERANCE()*dp.norm2()*dq.norm2())
+        return 0; // parallel edges, left to the vertex-face tests
+    const defaulttype::Vector3 p = x0[0] + (x0[1]-x0[0])*alpha;
+    const defaulttype::Vector3 q = x0[2] + (x0[3]-x0[2])*beta;
+    const defaulttype::Vector3 pFree = x1[0] + (x1[1]-x1[0])*alpha;
+    const defaulttype::Vector3 qFree = x1[2] + (x1[3]-x1[2])*beta;
+    SReal side = n * (q-p);
+    if (side == 0)
+        side = -(n * (qFree-pFree));
+    n *= (side < 0 ? -1 : 1) / helper::rsqrt(norm2);
+
+    contacts->resize(contacts->size()+1);
+    core::collision::DetectionOutput *detection = &*(contacts->end()-1);
+    detection->id = id;
+    detection->point[0]=p;
+    detection->point[1]=q;
+    detection->normal = n;
+    detection->value = n * (q-p);
+    detection->deltaT = t*dt;
+    return 1;
+}
+
 template<class T>
 int MeshNewProximityIntersection::computeIntersection(TSphere<T>& e1, Point& e2, OutputVector* contacts)
 {
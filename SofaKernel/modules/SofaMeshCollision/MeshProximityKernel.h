@@ -0,0 +1,228 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2016 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This library is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This library is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this library; if not, write to the Free Software Foundation,     *
+* Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA.          *
+*******************************************************************************
+*                               SOFA :: Modules                               *
+*                                                                             *
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#ifndef SOFA_COMPONENT_COLLISION_MESHPROXIMITYKERNEL_H
+#define SOFA_COMPONENT_COLLISION_MESHPROXIMITYKERNEL_H
+#include "config.h"
+
+#include <sofa/helper/rmath.h>
+
+namespace sofa
+{
+
+namespace component
+{
+
+namespace collision
+{
+
+/// Number of elements tested together by the batched proximity kernels. The elements
+/// of a batch are taken from those tested against one element by the detection, which
+/// are often few, so that a larger batch would mostly be padding.
+enum { ProximityBatchSize = 8 };
+
+/// The batched kernels compute lower bounds of the distances found by the tests
+/// of MeshNewProximityIntersection, for one element against a batch of elements,
+/// with one lane per pair. They are only used to reject the pairs which are too
+/// far apart: the remaining ones go through the exact tests, so the contacts are
+/// unchanged. The squared distances are negative for the pairs on which these
+/// tests do not compute points on the elements (degenerate triangles and
+/// segments, nearly parallel segments), so that they are never rejected.
+///
+/// Each kernel is a loop over the lanes, without branches nor intrinsics; whether
+/// it is vectorized is left to the compiler.
+
+/// Squared alarm distance beyond which the pairs can be rejected, with a margin
+/// covering the rounding differences between the batched and the exact tests
+template<class Real>
+inline Real proximityRejectDistance2(Real dist2)
+{
+    return dist2 * (Real)1.001;
+}
+
+/// Squared distance between a point q and a segment [p0,p1]
+template<class Real>
+inline Real pointSegmentDistance2(Real p0x, Real p0y, Real p0z, Real p1x, Real p1y, Real p1z, Real qx, Real qy, Real qz)
+{
+    const Real abx = p1x-p0x, aby = p1y-p0y, abz = p1z-p0z;
+    const Real aqx = qx-p0x, aqy = qy-p0y, aqz = qz-p0z;
+    const Real A = abx*abx + aby*aby + abz*abz;
+    const Real b = aqx*abx + aqy*aby + aqz*abz;
+    Real t = b / (A > 0 ? A : (Real)1);
+    t = t < 0 ? (Real)0 : (t > 1 ? (Real)1 : t);
+    const Real dx = aqx - t*abx, dy = aqy - t*aby, dz = aqz - t*abz;
+    const Real d2 = dx*dx + dy*dy + dz*dz;
+    return A > 0 ? d2 : (Real)-1;
+}
+
+/// Squared distances between the points p and q
+template<class Real, int N>
+inline void pointPointDistance2(const Real (&p)[3][N], const Real (&q)[3][N], Real (&d2)[N])
+{
+    for (int l=0; l<N; ++l)
+    {
+        const Real dx = q[0][l]-p[0][l], dy = q[1][l]-p[1][l], dz = q[2][l]-p[2][l];
+        d2[l] = dx*dx + dy*dy + dz*dz;
+    }
+}
+
+/// Squared distances between the points q and the segments [p0,p1]
+template<class Real, int N>
+inline void pointSegmentDistance2(const Real (&p0)[3][N], const Real (&p1)[3][N], const Real (&q)[3][N], Real (&d2)[N])
+{
+    for (int l=0; l<N; ++l)
+        d2[l] = pointSegmentDistance2(p0[0][l], p0[1][l], p0[2][l], p1[0][l], p1[1][l], p1[2][l], q[0][l], q[1][l], q[2][l]);
+}
+
+/// Squared distances between the points q and the triangles (a,b,c)
+template<class Real, int N>
+inline void pointTriangleDistance2(const Real (&a)[3][N], const Real (&b)[3][N], const Real (&c)[3][N], const Real (&q)[3][N], Real (&d2)[N])
+{
+    for (int l=0; l<N; ++l)
+    {
+        const Real abx = b[0][l]-a[0][l], aby = b[1][l]-a[1][l], abz = b[2][l]-a[2][l];
+        const Real acx = c[0][l]-a[0][l], acy = c[1][l]-a[1][l], acz = c[2][l]-a[2][l];
+        const Real aqx = q[0][l]-a[0][l], aqy = q[1][l]-a[1][l], aqz = q[2][l]-a[2][l];
+        const Real A00 = abx*abx + aby*aby + abz*abz;
+        const Real A11 = acx*acx + acy*acy + acz*acz;
+        const Real A01 = abx*acx + aby*acy + abz*acz;
+        const Real b0 = aqx*abx + aqy*aby + aqz*abz;
+        const Real b1 = aqx*acx + aqy*acy + aqz*acz;
+        const Real det = A00*A11 - A01*A01;
+        const bool degenerate = !(det > (Real)1e-8*A00*A11);
+
+        // projection inside the triangle: distance to the plane
+        const Real alpha = b0*A11 - b1*A01;
+        const Real beta  = b1*A00 - b0*A01;
+        const bool inside = alpha >= 0 && beta >= 0 && alpha + beta <= det;
+        const Real nx = aby*acz - abz*acy, ny = abz*acx - abx*acz, nz = abx*acy - aby*acx;
+        const Real n2 = nx*nx + ny*ny + nz*nz;
+        const Real h = aqx*nx + aqy*ny + aqz*nz;
+        const Real dPlane = h*h / (n2 > 0 ? n2 : (Real)1);
+
+        // otherwise: distance to the nearest edge
+        const Real dAB = pointSegmentDistance2(a[0][l], a[1][l], a[2][l], b[0][l], b[1][l], b[2][l], q[0][l], q[1][l], q[2][l]);
+        const Real dAC = pointSegmentDistance2(a[0][l], a[1][l], a[2][l], c[0][l], c[1][l], c[2][l], q[0][l], q[1][l], q[2][l]);
+        const Real dBC = pointSegmentDistance2(b[0][l], b[1][l], b[2][l], c[0][l], c[1][l], c[2][l], q[0][l], q[1][l], q[2][l]);
+        const Real dEdges = helper::rmin(dAB, helper::rmin(dAC, dBC));
+
+        d2[l] = degenerate ? (Real)-1 : (inside ? dPlane : dEdges);
+    }
+}
+
+/// Squared distances between the segments [p0,p1] and [q0,q1].
+/// The segments for which the determinant of the system giving the nearest points
+/// is below parallelTolerance are considered as parallel.
+template<class Real, int N>
+inline void segmentSegmentDistance2(const Real (&p0)[3][N], const Real (&p1)[3][N], const Real (&q0)[3][N], const Real (&q1)[3][N], Real parallelTolerance, Real (&d2)[N])
+{
+    for (int l=0; l<N; ++l)
+    {
+        const Real abx = p1[0][l]-p0[0][l], aby = p1[1][l]-p0[1][l], abz = p1[2][l]-p0[2][l];
+        const Real cdx = q1[0][l]-q0[0][l], cdy = q1[1][l]-q0[1][l], cdz = q1[2][l]-q0[2][l];
+        const Real acx = q0[0][l]-p0[0][l], acy = q0[1][l]-p0[1][l], acz = q0[2][l]-p0[2][l];
+        const Real A00 = abx*abx + aby*aby + abz*abz;
+        const Real A11 = cdx*cdx + cdy*cdy + cdz*cdz;
+        const Real A01 = -(abx*cdx + aby*cdy + abz*cdz);
+        const Real b0 = abx*acx + aby*acy + abz*acz;
+        const Real b1 = -(cdx*acx + cdy*acy + cdz*acz);
+        const Real det = A00*A11 - A01*A01;
+        const bool parallel = !(helper::rabs(det) > parallelTolerance*(Real)1.001 + (Real)1e-12*A00*A11);
+
+        // nearest points inside both segments
+        const Real invDet = (Real)1 / (parallel ? (Real)1 : det);
+        const Real s = (b0*A11 - b1*A01) * invDet;
+        const Real t = (b1*A00 - b0*A01) * invDet;
+        const bool interior = s >= 0 && s <= 1 && t >= 0 && t <= 1;
+        const Real dx = acx + t*cdx - s*abx, dy = acy + t*cdy - s*aby, dz = acz + t*cdz - s*abz;
+        const Real dInterior = dx*dx + dy*dy + dz*dz;
+
+        // otherwise: nearest endpoint
+        const Real d0 = pointSegmentDistance2(q0[0][l], q0[1][l], q0[2][l], q1[0][l], q1[1][l], q1[2][l], p0[0][l], p0[1][l], p0[2][l]);
+        const Real d1 = pointSegmentDistance2(q0[0][l], q0[1][l], q0[2][l], q1[0][l], q1[1][l], q1[2][l], p1[0][l], p1[1][l], p1[2][l]);
+        const Real d2q0 = pointSegmentDistance2(p0[0][l], p0[1][l], p0[2][l], p1[0][l], p1[1][l], p1[2][l], q0[0][l], q0[1][l], q0[2][l]);
+        const Real d2q1 = pointSegmentDistance2(p0[0][l], p0[1][l], p0[2][l], p1[0][l], p1[1][l], p1[2][l], q1[0][l], q1[1][l], q1[2][l]);
+        const Real dEnds = helper::rmin(helper::rmin(d0, d1), helper::rmin(d2q0, d2q1));
+
+        d2[l] = parallel ? (Real)-1 : (interior ? helper::rmin(dInterior, dEnds) : dEnds);
+    }
+}
+
+/// Lane-wise minimum, keeping the negative values of the pairs never rejected
+template<class Real, int N>
+inline void minDistance2(Real (&d2)[N], const Real (&other)[N])
+{
+    for (int l=0; l<N; ++l)
+        d2[l] = helper::rmin(d2[l], other[l]);
+}
+
+/// Lower bound of the distances of the tests between the triangles t and the segments s
+template<class Real, int N>
+inline void triangleSegmentDistance2(const Real (&t)[3][3][N], const Real (&s)[2][3][N], bool lineLine, Real parallelTolerance, Real (&d2)[N])
+{
+    Real d[N];
+    pointSegmentDistance2(s[0], s[1], t[0], d2);
+    pointSegmentDistance2(s[0], s[1], t[1], d); minDistance2(d2, d);
+    pointSegmentDistance2(s[0], s[1], t[2], d); minDistance2(d2, d);
+    pointTriangleDistance2(t[0], t[1], t[2], s[0], d); minDistance2(d2, d);
+    pointTriangleDistance2(t[0], t[1], t[2], s[1], d); minDistance2(d2, d);
+    if (lineLine)
+    {
+        for (int e=0; e<3; ++e)
+        {
+            segmentSegmentDistance2(t[e], t[(e+1)%3], s[0], s[1], parallelTolerance, d);
+            minDistance2(d2, d);
+        }
+    }
+}
+
+/// Lower bound of the distances of the tests between the triangles t and u
+template<class Real, int N>
+inline void triangleTriangleDistance2(const Real (&t)[3][3][N], const Real (&u)[3][3][N], bool lineLine, Real parallelTolerance, Real (&d2)[N])
+{
+    Real d[N];
+    pointTriangleDistance2(u[0], u[1], u[2], t[0], d2);
+    pointTriangleDistance2(u[0], u[1], u[2], t[1], d); minDistance2(d2, d);
+    pointTriangleDistance2(u[0], u[1], u[2], t[2], d); minDistance2(d2, d);
+    pointTriangleDistance2(t[0], t[1], t[2], u[0], d); minDistance2(d2, d);
+    pointTriangleDistance2(t[0], t[1], t[2], u[1], d); minDistance2(d2, d);
+    pointTriangleDistance2(t[0], t[1], t[2], u[2], d); minDistance2(d2, d);
+    if (lineLine)
+    {
+        for (int e=0; e<3; ++e)
+            for (int f=0; f<3; ++f)
+            {
+                segmentSegmentDistance2(t[e], t[(e+1)%3], u[f], u[(f+1)%3], parallelTolerance, d);
+                minDistance2(d2, d);
+            }
+    }
+}
+
+} // namespace collision
+
+} // namespace component
+
+} // namespace sofa
+
+#endif
@@ -0,0 +1,120 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2016 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This library is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This library is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this library; if not, write to the Free Software Foundation,     *
+* Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA.          *
+*******************************************************************************
+*                               SOFA :: Modules                               *
+*                                                                             *
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#ifndef SOFA_COMPONENT_COLLISION_PACKEDELEMENTCOORDS_H
+#define SOFA_COMPONENT_COLLISION_PACKEDELEMENTCOORDS_H
+#include "config.h"
+
+#include <sofa/helper/vector.h>
+
+namespace sofa
+{
+
+namespace component
+{
+
+namespace collision
+{
+
+/// Positions of the vertices of the elements of a collision model, copied per
+/// element in structure-of-arrays layout: coordinate c of vertex v of element i
+/// is stored in the array 3*v+c, at index i.
+///
+/// The collision models fill it when they compute their bounding tree, so that
+/// the batched proximity tests read contiguous coordinates instead of going
+/// through the element and vertex indices.
+template<int NV>
+class PackedElementCoords
+{
+public:
+    enum { NbVertices = NV };
+
+    PackedElementCoords() : counter(-1) {}
+
+    std::size_t size() const { return coords[0].size(); }
+
+    void resize(std::size_t n)
+    {
+        for (int k=0; k<3*NV; ++k)
+            coords[k].resize(n);
+    }
+
+    /// Set the position of the vertex v of the element i
+    template<class Coord>
+    void set(std::size_t i, int v, const Coord& p)
+    {
+        coords[3*v  ][i] = (SReal)p[0];
+        coords[3*v+1][i] = (SReal)p[1];
+        coords[3*v+2][i] = (SReal)p[2];
+    }
+
+    /// Copy the vertices of element i in all the lanes of a batch
+    template<class Real, int N>
+    void broadcast(int i, Real (&out)[NV][3][N]) const
+    {
+        for (int v=0; v<NV; ++v)
+            for (int c=0; c<3; ++c)
+            {
+                const Real x = (Real)coords[3*v+c][i];
+                for (int l=0; l<N; ++l)
+                    out[v][c][l] = x;
+            }
+    }
+
+    /// Copy the vertices of the nb given elements in the lanes of a batch.
+    /// The remaining lanes are filled with the last element.
+    template<class Real, int N>
+    void gather(const int* indices, int nb, Real (&out)[NV][3][N]) const
+    {
+        for (int v=0; v<NV; ++v)
+            for (int c=0; c<3; ++c)
+            {
+                const SReal* x = &coords[3*v+c][0];
+                for (int l=0; l<N; ++l)
+                    out[v][c][l] = (Real)x[indices[l < nb ? l : nb-1]];
+            }
+    }
+
+    /// Counter of the positions data when the coordinates were copied
+    int getCounter() const { return counter; }
+    void setCounter(int c) { counter = c; }
+
+    /// Check that the coordinates were copied from the current version of the positions of n elements
+    bool isUpToDate(std::size_t n, int positionCounter) const
+    {
+        return size() == n && counter == positionCounter;
+    }
+
+protected:
+    helper::vector<SReal> coords[3*NV];
+    int counter;
+};
+
+} // namespace collision
+
+} // namespace component
+
+} // namespace sofa
+
+#endif
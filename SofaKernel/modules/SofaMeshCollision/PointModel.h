@@ -28,6 +28,7 @@
 
 #include <sofa/core/CollisionModel.h>
 #include <SofaMeshCollision/LocalMinDistanceFilter.h>
+#include <SofaMeshCollision/PackedElementCoords.h>
 #include <SofaBaseMechanics/MechanicalObject.h>
 #include <sofa/core/topology/BaseMeshTopology.h>
 #include <sofa/defaulttype/Vec3Types.h>
@@ -47,6 +48,8 @@ class TPointModel;
 
 class PointLocalMinDistanceFilter;
 
+class NewProximityIntersection;
+
 template<class TDataTypes>
 class TPoint : public core::TCollisionElementIterator<TPointModel<TDataTypes> >
 {
@@ -138,6 +141,10 @@ public:
 
     const Deriv& velocity(int index) const;
 
+    /// Positions of the points copied when computing the bounding tree, for batched proximity tests.
+    /// Returns NULL if the positions changed since then, or if NewProximityIntersection::vectorized is off.
+    const PackedElementCoords<1>* getPackedCoords() const;
+
     Data<bool> bothSide; // to activate collision on both side of the point model (when surface normals are defined on these points)
 
     /// Pre-construction check method called by ObjectFactory.
@@ -180,6 +187,17 @@ protected:
     void updateNormals();
 
     PointActiver *myActiver;
+
+    PackedElementCoords<1> packedCoords;
+
+    /// Copy the positions of the points in packedCoords
+    void updatePackedCoords();
+
+    /// Intersection reading packedCoords, NULL if there is none in the scene
+    NewProximityIntersection* m_proximityIntersection;
+
+    /// Whether packedCoords are read, i.e. the vectorized option of the intersection is on
+    bool usePackedCoords() const;
 };
 
 template<class DataTypes>
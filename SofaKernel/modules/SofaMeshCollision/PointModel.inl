@@ -40,6 +40,7 @@
 #include <sofa/core/visual/VisualParams.h>
 #include <SofaMeshCollision/PointLocalMinDistanceFilter.h>
 #include <SofaBaseCollision/CubeModel.h>
+#include <SofaBaseCollision/NewProximityIntersection.h>
 #include <sofa/core/ObjectFactory.h>
 #include <vector>
 #include <sofa/helper/system/gl.h>
@@ -65,6 +66,7 @@ TPointModel<DataTypes>::TPointModel()
     , computeNormals( initData(&computeNormals, false, "computeNormals", "activate computation of normal vectors (required for some collision detection algorithms)") )
     , PointActiverPath(initData(&PointActiverPath,"PointActiverPath", "path of a component PointActiver that activate or deactivate collision point during execution") )
     , m_lmdFilter( NULL )
+    , m_proximityIntersection(NULL)
     , m_displayFreePosition(initData(&m_displayFreePosition, false, "displayFreePosition", "Display Collision Model Points free position(in green)") )
 {
     enum_type = POINT_TYPE;
@@ -94,6 +96,8 @@ void TPointModel<DataTypes>::init()
         m_lmdFilter = node->getNodeObject< PointLocalMinDistanceFilter >();
     }
 
+    this->getContext()->get(m_proximityIntersection, core::objectmodel::BaseContext::SearchRoot);
+
     const int npoints = mstate->getSize();
     resize(npoints);
     if (computeNormals.getValue()) updateNormals();
@@ -264,6 +268,8 @@ void TPointModel<DataTypes>::computeBoundingTree(int maxDepth)
     if (computeNormals.getValue()) updateNormals();
 
     cubeModel->resize(size);
+    if (usePackedCoords())
+        updatePackedCoords();
     if (!empty())
     {
         //VecCoord& x =mstate->read(core::ConstVecCoordId::position())->getValue();
@@ -301,16 +307,20 @@ void TPointModel<DataTypes>::computeContinuousBoundingTree(double dt, int maxDep
     defaulttype::Vector3 minElem, maxElem;
 
     cubeModel->resize(size);
+    if (usePackedCoords())
+        updatePackedCoords();
     if (!empty())
     {
         //VecCoord& x =mstate->read(core::ConstVecCoordId::position())->getValue();
         //VecDeriv& v = mstate->read(core::ConstVecDerivId::velocity())->getValue();
         const SReal distance = (SReal)this->proximity.getValue();
+        // swept from the current positions to the free positions after the free motion, else along the velocities
+        const bool freeMotion = mstate->read(core::ConstVecCoordId::freePosition())->isSet();
         for (int i=0; i<size; i++)
         {
             TPoint<DataTypes> p(this,i);
             const defaulttype::Vector3& pt = p.p();
-            const defaulttype::Vector3 ptv = pt + p.v()*dt;
+            const defaulttype::Vector3 ptv = freeMotion ? defaulttype::Vector3(p.pFree()) : pt + p.v()*dt;
 
             for (int c = 0; c < 3; c++)
             {
@@ -327,6 +337,30 @@ void TPointModel<DataTypes>::computeContinuousBoundingTree(double dt, int maxDep
     }
 }
 
+template<class DataTypes>
+bool TPointModel<DataTypes>::usePackedCoords() const
+{
+    return m_proximityIntersection != NULL && m_proximityIntersection->d_vectorized.getValue();
+}
+
+template<class DataTypes>
+void TPointModel<DataTypes>::updatePackedCoords()
+{
+    const VecCoord& x = mstate->read(core::ConstVecCoordId::position())->getValue();
+    packedCoords.resize(size);
+    for (int i=0; i<size; i++)
+        packedCoords.set(i, 0, x[i]);
+    packedCoords.setCounter(mstate->read(core::ConstVecCoordId::position())->getCounter());
+}
+
+template<class DataTypes>
+const PackedElementCoords<1>* TPointModel<DataTypes>::getPackedCoords() const
+{
+    if (!packedCoords.isUpToDate(size, mstate->read(core::ConstVecCoordId::position())->getCounter()))
+        return NULL;
+    return &packedCoords;
+}
+
 template<class DataTypes>
 void TPointModel<DataTypes>::updateNormals()
 {
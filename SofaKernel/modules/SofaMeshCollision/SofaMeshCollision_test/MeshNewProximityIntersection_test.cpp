@@ -2,6 +2,10 @@
 #include <gtest/gtest.h>
 #include <SofaTest/Sofa_test.h>
 #include <SofaMeshCollision/MeshNewProximityIntersection.inl>
+#include <SofaMeshCollision/MeshProximityKernel.h>
+#include <SofaMeshCollision/MeshContinuousIntTool.h>
+#include <SofaBaseTopology/MeshTopology.h>
+#include <SofaSimulationTree/GNode.h>
 
 #include <iostream>
 #include <sstream>
@@ -134,9 +138,380 @@ namespace sofa{
             return true;
         }
 
+
+        /// The batched point-triangle and segment-segment distances are lower bounds of the distances found by the exact tests
+        bool proximityKernels()
+        {
+            using namespace sofa::component::collision;
+            enum { N = ProximityBatchSize };
+            const SReal tol = IntrUtil<SReal>::ZERO_TOLERANCE();
+            for (unsigned i=0; i<100; i++)
+            {
+                SReal t[3][3][N], s[2][3][N], q[3][N], d2[N], e2[N];
+                for (int l=0; l<N; l++)
+                    for (int c=0; c<3; c++)
+                    {
+                        for (int v=0; v<3; v++)
+                            t[v][c][l] = helper::drand(1.0);
+                        for (int v=0; v<2; v++)
+                            s[v][c][l] = helper::drand(1.0);
+                        q[c][l] = helper::drand(1.0);
+                    }
+                pointTriangleDistance2(t[0], t[1], t[2], q, d2);
+                segmentSegmentDistance2(t[0], t[1], s[0], s[1], tol, e2);
+                for (int l=0; l<N; l++)
+                {
+                    const Vec3 p1(t[0][0][l], t[0][1][l], t[0][2][l]);
+                    const Vec3 p2(t[1][0][l], t[1][1][l], t[1][2][l]);
+                    const Vec3 p3(t[2][0][l], t[2][1][l], t[2][2][l]);
+                    const Vec3 q1(s[0][0][l], s[0][1][l], s[0][2][l]);
+                    const Vec3 q2(s[1][0][l], s[1][1][l], s[1][2][l]);
+                    const Vec3 pq(q[0][l], q[1][l], q[2][l]);
+                    sofa::helper::vector<sofa::core::collision::DetectionOutput> outputVector;
+                    ProximityIntersection::doIntersectionTrianglePoint(10, 0xffff, p1, p2, p3, Vec3(), pq, &outputVector, 0);
+                    ProximityIntersection::doIntersectionLineLine(10, p1, p2, q1, q2, &outputVector, 0);
+                    if (outputVector.size() != 2)
+                    {
+                        ADD_FAILURE() << "missing contact";
+                        return false;
+                    }
+                    if (outputVector[0].value*outputVector[0].value < d2[l]*(1-1e-9))
+                    {
+                        ADD_FAILURE() << "point-triangle distance " << outputVector[0].value << " below the batched one " << helper::rsqrt(d2[l]);
+                        return false;
+                    }
+                    if (outputVector[1].value*outputVector[1].value < e2[l]*(1-1e-9))
+                    {
+                        ADD_FAILURE() << "segment-segment distance " << outputVector[1].value << " below the batched one " << helper::rsqrt(e2[l]);
+                        return false;
+                    }
+                }
+            }
+
+            // point above the triangle
+            SReal t[3][3][1] = { {{0},{0},{0}}, {{1},{0},{0}}, {{0},{1},{0}} };
+            SReal q[3][1] = { {0.25}, {0.25}, {0.5} };
+            SReal d2[1];
+            pointTriangleDistance2(t[0], t[1], t[2], q, d2);
+            if (fabs(d2[0]-0.25) > 1e-12)
+            {
+                ADD_FAILURE() << "wrong point-triangle distance " << d2[0];
+                return false;
+            }
+            // degenerate triangle: never rejected
+            t[2][0][0] = 0.5;
+            t[2][1][0] = 0;
+            pointTriangleDistance2(t[0], t[1], t[2], q, d2);
+            if (d2[0] >= 0)
+            {
+                ADD_FAILURE() << "degenerate triangle not kept";
+                return false;
+            }
+            return true;
+        }
+
+        static bool sameValue(SReal a, SReal b)
+        {
+            return a == b || (a != a && b != b);
+        }
+
+        static bool sameOutput(const sofa::core::collision::DetectionOutput& a, const sofa::core::collision::DetectionOutput& b)
+        {
+            bool same = a.elem == b.elem && a.id == b.id && sameValue(a.value, b.value);
+            for (int c=0; c<3; c++)
+                same = same && sameValue(a.point[0][c], b.point[0][c]) && sameValue(a.point[1][c], b.point[1][c]) && sameValue(a.normal[c], b.normal[c]);
+            return same;
+        }
+
+        /// The vectorized batches give the same contacts as the tests of each pair, for all the types of mesh elements
+        bool vectorizedBatches()
+        {
+            using namespace sofa::component::collision;
+            typedef sofa::component::container::MechanicalObject<sofa::defaulttype::Vec3Types> MechanicalObject3;
+
+            sofa::simulation::Node::SPtr node = sofa::core::objectmodel::New<sofa::simulation::tree::GNode>();
+            MechanicalObject3::SPtr dofs = sofa::core::objectmodel::New<MechanicalObject3>();
+            const unsigned nbPoints = 60;
+            dofs->resize(nbPoints);
+            {
+                helper::WriteAccessor< Data<MechanicalObject3::VecCoord> > x = *dofs->write(sofa::core::VecId::position());
+                for (unsigned i=0; i<nbPoints-1; i++)
+                    x[i] = Vec3(helper::drand(1.0), helper::drand(1.0), helper::drand(1.0));
+                x[nbPoints-1] = (x[0]+x[1])*0.5;
+            }
+            node->addObject(dofs);
+
+            sofa::component::topology::MeshTopology::SPtr topology = sofa::core::objectmodel::New<sofa::component::topology::MeshTopology>();
+            for (unsigned i=0; i+2<nbPoints-1; i+=3)
+                topology->addTriangle(i, i+1, i+2);
+            topology->addTriangle(0, 1, nbPoints-1); // degenerate triangle, the edges are computed from the triangles
+            node->addObject(topology);
+            topology->init();
+
+            NewProximityIntersection::SPtr intersection = sofa::core::objectmodel::New<NewProximityIntersection>();
+            node->addObject(intersection);
+            intersection->setAlarmDistance(0.2);
+            intersection->setContactDistance(0.1);
+            intersection->useLineLine.setValue(true);
+            intersection->init();
+
+            TriangleModel::SPtr triangles = sofa::core::objectmodel::New<TriangleModel>();
+            LineModel::SPtr lines = sofa::core::objectmodel::New<LineModel>();
+            PointModel::SPtr points = sofa::core::objectmodel::New<PointModel>();
+            node->addObject(triangles);
+            node->addObject(lines);
+            node->addObject(points);
+            sofa::core::CollisionModel* models[3] = { triangles.get(), lines.get(), points.get() };
+            for (int m=0; m<3; m++)
+                models[m]->init();
+
+            // the positions are only packed when the intersection reads them
+            for (int m=0; m<3; m++)
+                models[m]->computeBoundingTree(0);
+            if (triangles->getPackedCoords() != NULL || lines->getPackedCoords() != NULL || points->getPackedCoords() != NULL)
+            {
+                ADD_FAILURE() << "positions packed while vectorized is off";
+                return false;
+            }
+
+            intersection->d_vectorized.setValue(true);
+            for (int m=0; m<3; m++)
+                models[m]->computeBoundingTree(0);
+            intersection->d_vectorized.setValue(false);
+            if (triangles->getPackedCoords() == NULL || lines->getPackedCoords() == NULL || points->getPackedCoords() == NULL)
+            {
+                ADD_FAILURE() << "positions not packed while vectorized is on";
+                return false;
+            }
+
+            for (int m1=0; m1<3; m1++)
+                for (int m2=m1; m2<3; m2++)
+                {
+                    sofa::core::CollisionModel* cm1 = models[m1];
+                    sofa::core::CollisionModel* cm2 = models[m2];
+                    bool swapModels = false;
+                    sofa::core::collision::ElementIntersector* intersector = intersection->findIntersector(cm1, cm2, swapModels);
+                    if (intersector == NULL)
+                    {
+                        ADD_FAILURE() << "no intersector for " << cm1->getClassName() << " - " << cm2->getClassName();
+                        return false;
+                    }
+                    if (swapModels)
+                        std::swap(cm1, cm2);
+
+                    helper::vector<int> indices2;
+                    for (int i=0; i<cm2->getSize(); i++)
+                        indices2.push_back(i);
+
+                    sofa::core::collision::DetectionOutputVector* pairOutputs = NULL;
+                    sofa::core::collision::DetectionOutputVector* batchOutputs = NULL;
+                    intersector->beginIntersect(cm1, cm2, pairOutputs);
+                    intersector->beginIntersect(cm1, cm2, batchOutputs);
+                    intersection->d_vectorized.setValue(true);
+                    for (int i=0; i<cm1->getSize(); i++)
+                    {
+                        for (unsigned j=0; j<indices2.size(); j++)
+                            intersector->intersect(sofa::core::CollisionElementIterator(cm1, i), sofa::core::CollisionElementIterator(cm2, indices2[j]), pairOutputs);
+                        intersector->intersectBatch(sofa::core::CollisionElementIterator(cm1, i), cm2, indices2, batchOutputs);
+                    }
+                    intersection->d_vectorized.setValue(false);
+
+                    typedef sofa::helper::vector<sofa::core::collision::DetectionOutput> OutputVector;
+                    const OutputVector& expected = *dynamic_cast<OutputVector*>(pairOutputs);
+                    const OutputVector& outputs = *dynamic_cast<OutputVector*>(batchOutputs);
+                    bool same = outputs.size() == expected.size();
+                    for (unsigned i=0; i<outputs.size() && same; i++)
+                        same = sameOutput(outputs[i], expected[i]);
+                    pairOutputs->release();
+                    batchOutputs->release();
+                    if (!same)
+                    {
+                        ADD_FAILURE() << cm1->getClassName() << " - " << cm2->getClassName() << ": " << outputs.size() << " contacts instead of " << expected.size();
+                        return false;
+                    }
+                    if (expected.empty())
+                    {
+                        ADD_FAILURE() << cm1->getClassName() << " - " << cm2->getClassName() << ": no contact to compare";
+                        return false;
+                    }
+                }
+            return true;
+        }
+
+        /// Times of impact of a vertex crossing a translating triangle, and of two crossing edges, at a known time
+        bool timeOfImpact()
+        {
+            using namespace sofa::component::collision;
+            SReal roots[3];
+            // (t-0.2)(t-0.5)(t-0.9)
+            if (MeshContinuousIntTool::cubicRootsInUnitInterval(1, -1.6, 0.73, -0.09, roots) != 3
+                    || fabs(roots[0]-0.2) > 1e-9 || fabs(roots[1]-0.5) > 1e-9 || fabs(roots[2]-0.9) > 1e-9)
+            {
+                ADD_FAILURE() << "wrong roots of the cubic";
+                return false;
+            }
+
+            for (unsigned i=0; i<100; i++)
+            {
+                const SReal impact = 0.1 + 0.8*helper::drand();
+                const Vec3 translation(helper::drand(1.0), helper::drand(1.0), helper::drand(1.0));
+                const Vec3 velocity(helper::drand(10.0), helper::drand(10.0), helper::drand(10.0));
+
+                // vertex going through a point of the translating triangle at the time of impact
+                Vec3 x0[4], x1[4];
+                for (int k=0; k<3; k++)
+                {
+                    x0[k] = Vec3(helper::drand(1.0), helper::drand(1.0), helper::drand(1.0));
+                    x1[k] = x0[k] + translation;
+                }
+                const SReal alpha = 0.1 + 0.4*helper::drand();
+                const SReal beta = 0.1 + 0.4*helper::drand();
+                const Vec3 pc = x0[0] + (x0[1]-x0[0])*alpha + (x0[2]-x0[0])*beta + translation*impact;
+                x0[3] = pc - velocity*impact;
+                x1[3] = pc + velocity*(1-impact);
+
+                sofa::helper::vector<sofa::core::collision::DetectionOutput> outputVector;
+                if (!ProximityIntersection::doContinuousTrianglePoint(1e-6, 0xffff, x0, x1, 0.01, &outputVector, 0))
+                {
+                    ADD_FAILURE() << "missed vertex-face impact at " << impact;
+                    return false;
+                }
+                const sofa::core::collision::DetectionOutput& o = outputVector[0];
+                const Vec3 p = x0[0] + (x0[1]-x0[0])*alpha + (x0[2]-x0[0])*beta;
+                if (fabs(o.deltaT - impact*0.01) > 1e-9 || Sofa_test::vectorMaxDiff<3,SReal>(o.point[0], p) > 1e-6
+                        || Sofa_test::vectorMaxDiff<3,SReal>(o.point[1], x0[3]) > 1e-12 || o.normal*(x0[3]-p) <= 0
+                        || fabs(o.value - o.normal*(x0[3]-p)) > 1e-9)
+                {
+                    ADD_FAILURE() << "wrong vertex-face contact: time " << o.deltaT << " instead of " << impact*0.01 << ", point " << o.point[0] << " instead of " << p;
+                    return false;
+                }
+
+                // edges crossing at the time of impact, the second one translating
+                const Vec3 dq(helper::drand(1.0), helper::drand(1.0), helper::drand(1.0));
+                const Vec3 crossing = x0[0] + (x0[1]-x0[0])*alpha;
+                Vec3 e0[4] = { x0[0], x0[1], crossing - dq*beta - velocity*impact, crossing + dq*(1-beta) - velocity*impact };
+                Vec3 e1[4] = { x0[0], x0[1], e0[2] + velocity, e0[3] + velocity };
+                outputVector.clear();
+                if (!ProximityIntersection::doContinuousLineLine(1e-6, e0, e1, 0.01, &outputVector, 0))
+                {
+                    ADD_FAILURE() << "missed edge-edge impact at " << impact;
+                    return false;
+                }
+                const sofa::core::collision::DetectionOutput& e = outputVector[0];
+                const Vec3 q = e0[2] + (e0[3]-e0[2])*beta;
+                if (fabs(e.deltaT - impact*0.01) > 1e-9 || Sofa_test::vectorMaxDiff<3,SReal>(e.point[0], crossing) > 1e-6
+                        || Sofa_test::vectorMaxDiff<3,SReal>(e.point[1], q) > 1e-6 || e.normal*(q-crossing) < 0)
+                {
+                    ADD_FAILURE() << "wrong edge-edge contact: time " << e.deltaT << " instead of " << impact*0.01;
+                    return false;
+                }
+
+                // vertex passing beside the triangle
+                x0[3] += (x0[1]-x0[0])*2;
+                x1[3] += (x0[1]-x0[0])*2;
+                outputVector.clear();
+                if (ProximityIntersection::doContinuousTrianglePoint(1e-6, 0xffff, x0, x1, 0.01, &outputVector, 0))
+                {
+                    ADD_FAILURE() << "vertex-face impact found for a vertex passing beside the triangle";
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /// A point going through a triangle during the step only gives a contact with NewProximityIntersection::continuous
+        bool continuousTunnelling()
+        {
+            using namespace sofa::component::collision;
+            typedef sofa::component::container::MechanicalObject<sofa::defaulttype::Vec3Types> MechanicalObject3;
+
+            sofa::simulation::Node::SPtr node = sofa::core::objectmodel::New<sofa::simulation::tree::GNode>();
+            node->setDt(0.01);
+            MechanicalObject3::SPtr dofs = sofa::core::objectmodel::New<MechanicalObject3>();
+            dofs->resize(4);
+            {
+                helper::WriteAccessor< Data<MechanicalObject3::VecCoord> > x = *dofs->write(sofa::core::VecId::position());
+                x[0] = Vec3(0,0,0);
+                x[1] = Vec3(1,0,0);
+                x[2] = Vec3(0,1,0);
+                x[3] = Vec3(0.25,0.25,1);
+                helper::WriteAccessor< Data<MechanicalObject3::VecCoord> > xfree = *dofs->write(sofa::core::VecId::freePosition());
+                xfree.resize(4);
+                for (int i=0; i<3; i++)
+                    xfree[i] = x[i];
+                xfree[3] = Vec3(0.25,0.25,-1);
+            }
+            node->addObject(dofs);
+
+            sofa::component::topology::MeshTopology::SPtr topology = sofa::core::objectmodel::New<sofa::component::topology::MeshTopology>();
+            topology->addTriangle(0, 1, 2);
+            node->addObject(topology);
+            topology->init();
+
+            TriangleModel::SPtr triangles = sofa::core::objectmodel::New<TriangleModel>();
+            PointModel::SPtr points = sofa::core::objectmodel::New<PointModel>();
+            node->addObject(triangles);
+            node->addObject(points);
+            triangles->init();
+            points->init();
+            triangles->computeContinuousBoundingTree(0.01, 0);
+            points->computeContinuousBoundingTree(0.01, 0);
+
+            // the bounding box of the point encloses its motion
+            CubeModel* cubes = dynamic_cast<CubeModel*>(points->getPrevious());
+            if (cubes == NULL || Cube(cubes, 3).minVect()[2] > -1 || Cube(cubes, 3).maxVect()[2] < 1)
+            {
+                ADD_FAILURE() << "bounding box not swept to the free position";
+                return false;
+            }
+
+            NewProximityIntersection::SPtr intersection = sofa::core::objectmodel::New<NewProximityIntersection>();
+            node->addObject(intersection);
+            intersection->setAlarmDistance(0.2);
+            intersection->setContactDistance(0.1);
+            intersection->init();
+
+            bool swapModels = false;
+            sofa::core::collision::ElementIntersector* intersector = intersection->findIntersector(triangles.get(), points.get(), swapModels);
+            if (intersector == NULL || swapModels)
+            {
+                ADD_FAILURE() << "no intersector for triangles - points";
+                return false;
+            }
+
+            typedef sofa::helper::vector<sofa::core::collision::DetectionOutput> OutputVector;
+            sofa::core::collision::DetectionOutputVector* outputs = NULL;
+            intersector->beginIntersect(triangles.get(), points.get(), outputs);
+            intersector->intersect(sofa::core::CollisionElementIterator(triangles.get(), 0), sofa::core::CollisionElementIterator(points.get(), 3), outputs);
+            const unsigned discrete = outputs->size();
+            intersection->d_continuous.setValue(true);
+            intersector->intersect(sofa::core::CollisionElementIterator(triangles.get(), 0), sofa::core::CollisionElementIterator(points.get(), 3), outputs);
+            const OutputVector contacts = *dynamic_cast<OutputVector*>(outputs);
+            outputs->release();
+
+            if (discrete != 0 || contacts.size() != 1)
+            {
+                ADD_FAILURE() << discrete << " discrete and " << contacts.size() << " continuous contacts instead of 0 and 1";
+                return false;
+            }
+            const sofa::core::collision::DetectionOutput& o = contacts[0];
+            if (fabs(o.deltaT - 0.005) > 1e-9 || Sofa_test::vectorMaxDiff<3,SReal>(o.point[0], Vec3(0.25,0.25,0)) > 1e-9
+                    || Sofa_test::vectorMaxDiff<3,SReal>(o.normal, Vec3(0,0,1)) > 1e-9 || fabs(o.value - 0.9) > 1e-9
+                    || o.elem.second.getIndex() != 3)
+            {
+                ADD_FAILURE() << "wrong contact: time " << o.deltaT << ", point " << o.point[0] << ", normal " << o.normal << ", value " << o.value;
+                return false;
+            }
+            return true;
+        }
+
     };
 
 
 TEST_F(MeshNewProximityIntersectionTest, pointTriangle ) { ASSERT_TRUE( pointTriangle()); }
+TEST_F(MeshNewProximityIntersectionTest, proximityKernels ) { ASSERT_TRUE( proximityKernels()); }
+TEST_F(MeshNewProximityIntersectionTest, vectorizedBatches ) { ASSERT_TRUE( vectorizedBatches()); }
+TEST_F(MeshNewProximityIntersectionTest, timeOfImpact ) { ASSERT_TRUE( timeOfImpact()); }
+TEST_F(MeshNewProximityIntersectionTest, continuousTunnelling ) { ASSERT_TRUE( continuousTunnelling()); }
 
 }
@@ -33,6 +33,7 @@
 #include <sofa/core/topology/BaseMeshTopology.h>
 #include <sofa/defaulttype/VecTypes.h>
 #include <SofaMeshCollision/PointModel.h>
+#include <SofaMeshCollision/PackedElementCoords.h>
 #include <map>
 
 namespace sofa
@@ -49,6 +50,8 @@ class TTriangleModel;
 
 class TriangleLocalMinDistanceFilter;
 
+class NewProximityIntersection;
+
 template<class TDataTypes>
 class TTriangle : public core::TCollisionElementIterator< TTriangleModel<TDataTypes> >
 {
@@ -182,6 +185,17 @@ protected:
 
     TriangleLocalMinDistanceFilter *m_lmdFilter;
 
+    PackedElementCoords<3> packedCoords;
+
+    /// Copy the positions of the triangle vertices in packedCoords
+    void updatePackedCoords();
+
+    /// Intersection reading packedCoords, NULL if there is none in the scene
+    NewProximityIntersection* m_proximityIntersection;
+
+    /// Whether packedCoords are read, i.e. the vectorized option of the intersection is on
+    bool usePackedCoords() const;
+
 protected:
 
     TTriangleModel();
@@ -211,6 +225,10 @@ public:
     const sofa::core::topology::BaseMeshTopology::SeqTriangles& getTriangles() const { return *triangles; }
     const VecDeriv& getNormals() const { return normals; }
 
+    /// Positions of the triangle vertices copied when computing the bounding tree, for batched proximity tests.
+    /// Returns NULL if the positions changed since then, or if NewProximityIntersection::vectorized is off.
+    const PackedElementCoords<3>* getPackedCoords() const;
+
     TriangleLocalMinDistanceFilter *getFilter() const;
 
     //template< class TFilter >
@@ -281,11 +299,11 @@ inline const typename DataTypes::Coord& TTriangle<DataTypes>::operator[](int i)
 }
 
 template<class DataTypes>
-inline const typename DataTypes::Coord& TTriangle<DataTypes>::p1Free() const { return (*this->model->mstate->read(sofa::core::ConstVecCoordId::freePosition())->getValue())[(*(this->model->triangles))[this->index][0]]; }
+inline const typename DataTypes::Coord& TTriangle<DataTypes>::p1Free() const { return this->model->mstate->read(sofa::core::ConstVecCoordId::freePosition())->getValue()[(*(this->model->triangles))[this->index][0]]; }
 template<class DataTypes>
-inline const typename DataTypes::Coord& TTriangle<DataTypes>::p2Free() const { return (*this->model->mstate->read(sofa::core::ConstVecCoordId::freePosition())->getValue())[(*(this->model->triangles))[this->index][1]]; }
+inline const typename DataTypes::Coord& TTriangle<DataTypes>::p2Free() const { return this->model->mstate->read(sofa::core::ConstVecCoordId::freePosition())->getValue()[(*(this->model->triangles))[this->index][1]]; }
 template<class DataTypes>
-inline const typename DataTypes::Coord& TTriangle<DataTypes>::p3Free() const { return (*this->model->mstate->read(sofa::core::ConstVecCoordId::freePosition())->getValue())[(*(this->model->triangles))[this->index][2]]; }
+inline const typename DataTypes::Coord& TTriangle<DataTypes>::p3Free() const { return this->model->mstate->read(sofa::core::ConstVecCoordId::freePosition())->getValue()[(*(this->model->triangles))[this->index][2]]; }
 
 template<class DataTypes>
 inline int TTriangle<DataTypes>::p1Index() const { return (*(this->model->triangles))[this->index][0]; }
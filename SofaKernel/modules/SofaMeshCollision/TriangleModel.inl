@@ -29,6 +29,7 @@
 #include <sofa/core/visual/VisualParams.h>
 #include <SofaMeshCollision/TriangleLocalMinDistanceFilter.h>
 #include <SofaBaseCollision/CubeModel.h>
+#include <SofaBaseCollision/NewProximityIntersection.h>
 #include <SofaMeshCollision/Triangle.h>
 #include <SofaBaseTopology/TopologyData.inl>
 #include <sofa/simulation/Node.h>
@@ -58,6 +59,7 @@ TTriangleModel<DataTypes>::TTriangleModel()
     , computeNormals(initData(&computeNormals, true, "computeNormals", "set to false to disable computation of triangles normal"))
     , meshRevision(-1)
     , m_lmdFilter(NULL)
+    , m_proximityIntersection(NULL)
 {
     triangles = &mytriangles;
     enum_type = TRIANGLE_TYPE;
@@ -101,6 +103,8 @@ void TTriangleModel<DataTypes>::init()
         m_lmdFilter = node->getNodeObject< TriangleLocalMinDistanceFilter >();
     }
 
+    this->getContext()->get(m_proximityIntersection, core::objectmodel::BaseContext::SearchRoot);
+
     //sout << "INFO_print : Col - init TRIANGLE " << sendl;
     sout << "TriangleModel: initially "<<_topology->getNbTriangles()<<" triangles." << sendl;
     triangles = &_topology->getTriangles();
@@ -744,6 +748,8 @@ void TTriangleModel<DataTypes>::computeBoundingTree(int maxDepth)
 //    {
 
         cubeModel->resize(size);  // size = number of triangles
+        if (usePackedCoords())
+            updatePackedCoords();
         if (!empty())
         {
             const SReal distance = (SReal)this->proximity.getValue();
@@ -795,18 +801,22 @@ void TTriangleModel<DataTypes>::computeContinuousBoundingTree(double dt, int max
     defaulttype::Vector3 minElem, maxElem;
 
     cubeModel->resize(size);
+    if (usePackedCoords())
+        updatePackedCoords();
     if (!empty())
     {
         const SReal distance = (SReal)this->proximity.getValue();
+        // swept from the current positions to the free positions after the free motion, else along the velocities
+        const bool freeMotion = mstate->read(core::ConstVecCoordId::freePosition())->isSet();
         for (int i=0; i<size; i++)
         {
             Element t(this,i);
             const defaulttype::Vector3& pt1 = t.p1();
             const defaulttype::Vector3& pt2 = t.p2();
             const defaulttype::Vector3& pt3 = t.p3();
-            const defaulttype::Vector3 pt1v = pt1 + t.v1()*dt;
-            const defaulttype::Vector3 pt2v = pt2 + t.v2()*dt;
-            const defaulttype::Vector3 pt3v = pt3 + t.v3()*dt;
+            const defaulttype::Vector3 pt1v = freeMotion ? defaulttype::Vector3(t.p1Free()) : pt1 + t.v1()*dt;
+            const defaulttype::Vector3 pt2v = freeMotion ? defaulttype::Vector3(t.p2Free()) : pt2 + t.v2()*dt;
+            const defaulttype::Vector3 pt3v = freeMotion ? defaulttype::Vector3(t.p3Free()) : pt3 + t.v3()*dt;
 
             for (int c = 0; c < 3; c++)
             {
@@ -838,6 +848,35 @@ void TTriangleModel<DataTypes>::computeContinuousBoundingTree(double dt, int max
     }
 }
 
+template<class DataTypes>
+bool TTriangleModel<DataTypes>::usePackedCoords() const
+{
+    return m_proximityIntersection != NULL && m_proximityIntersection->d_vectorized.getValue();
+}
+
+template<class DataTypes>
+void TTriangleModel<DataTypes>::updatePackedCoords()
+{
+    const VecCoord& x = mstate->read(core::ConstVecCoordId::position())->getValue();
+    packedCoords.resize(size);
+    for (int i=0; i<size; i++)
+    {
+        const sofa::core::topology::BaseMeshTopology::Triangle& t = (*triangles)[i];
+        packedCoords.set(i, 0, x[t[0]]);
+        packedCoords.set(i, 1, x[t[1]]);
+        packedCoords.set(i, 2, x[t[2]]);
+    }
+    packedCoords.setCounter(mstate->read(core::ConstVecCoordId::position())->getCounter());
+}
+
+template<class DataTypes>
+const PackedElementCoords<3>* TTriangleModel<DataTypes>::getPackedCoords() const
+{
+    if (!packedCoords.isUpToDate(size, mstate->read(core::ConstVecCoordId::position())->getCounter()))
+        return NULL;
+    return &packedCoords;
+}
+
 template<class DataTypes>
 TriangleLocalMinDistanceFilter *TTriangleModel<DataTypes>::getFilter() const
 {
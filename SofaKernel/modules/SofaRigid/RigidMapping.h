@@ -108,6 +108,8 @@ public:
 
     Data<int> geometricStiffness;
 
+    Data<bool> d_parallel;
+
 protected:
     RigidMapping();
     virtual ~RigidMapping() {}
@@ -160,6 +162,34 @@ protected:
     const VecCoord& getPoints();
     void setJMatrixBlock(unsigned outIdx, unsigned inIdx);
 
+    /// Parent frame of each mapped point, fetched once before a loop is spread over the threads
+    struct RigidIndices
+    {
+        const unsigned int* perPoint;   ///< rigidIndexPerPoint, or NULL if all the points use the same frame
+        unsigned int index;
+        unsigned int operator[](std::size_t i) const { return perPoint ? perPoint[i] : index; }
+    };
+    RigidIndices getRigidIndices() const;
+
+    /// Forces of a range of consecutive frames, accumulated by a chunk of mapped points in the parallel applyJT
+    struct FrameForces
+    {
+        unsigned int first;
+        InVecDeriv forces;
+        helper::vector<unsigned char> active;   ///< frames reached by the chunk, inserted afterwards in maskFrom
+        void merge(const FrameForces& other);
+    };
+
+    enum { POINTS_PER_TASK = 1024, ROWS_PER_TASK = 32 };
+
+    class ApplyFunctor;
+    class ApplyJFunctor;
+    class ApplyJTFunctor;
+    class ApplyJTMatrixFunctor;
+    class MergeFrameForces;
+
+    helper::vector<Mat> frameRotations;   ///< rotation matrices of the frames, used by the parallel apply
+
     std::unique_ptr<MatrixType> matrixJ;
     bool updateJ;
 
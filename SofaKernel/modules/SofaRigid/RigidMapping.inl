@@ -41,12 +41,15 @@
 #include <sofa/helper/decompose.h>
 
 #include <sofa/simulation/Simulation.h>
+#include <sofa/simulation/ParallelFor.h>
 
 #include <string.h>
 #include <iostream>
 #include <cassert>
 #include <numeric>
 #include <istream>
+#include <algorithm>
+#include <limits>
 
 namespace sofa
 {
@@ -139,6 +142,7 @@ RigidMapping<TIn, TOut>::RigidMapping()
     , rigidIndexPerPoint(initData(&rigidIndexPerPoint, "rigidIndexPerPoint", "For each mapped point, the index of the Rigid it is mapped from"))
     , globalToLocalCoords(initData(&globalToLocalCoords, "globalToLocalCoords", "are the output DOFs initially expressed in global coordinates"))
     , geometricStiffness(initData(&geometricStiffness, 0, "geometricStiffness", "assemble (and use) geometric stiffness (0=no GS, 1=non symmetric, 2=symmetrized)"))
+    , d_parallel(initData(&d_parallel, false, "parallel", "Compute apply, applyJ and applyJT on several threads, the forces being summed per frame by a tree reduction"))
     , matrixJ()
     , updateJ(false)
 {
@@ -327,6 +331,211 @@ const typename RigidMapping<TIn, TOut>::VecCoord & RigidMapping<TIn, TOut>::getP
     return points.getValue();
 }
 
+template <class TIn, class TOut>
+typename RigidMapping<TIn, TOut>::RigidIndices RigidMapping<TIn, TOut>::getRigidIndices() const
+{
+    RigidIndices rigid;
+    const helper::vector<unsigned int>& perPoint = rigidIndexPerPoint.getValue();
+    if( points.getValue().size() == perPoint.size() && !perPoint.empty() )
+    {
+        rigid.perPoint = &perPoint[0];
+        rigid.index = 0;
+    }
+    else
+    {
+        rigid.perPoint = NULL;
+        rigid.index = !indexFromEnd.getValue() ? index.getValue() : this->fromModel->getSize()-1-index.getValue();
+    }
+    return rigid;
+}
+
+/// Each mapped point of [first,last) is rotated by the matrix of its frame
+template <class TIn, class TOut>
+class RigidMapping<TIn, TOut>::ApplyFunctor
+{
+public:
+    ApplyFunctor(const RigidIndices& rigid, const helper::vector<Mat>& rotations, const VecCoord& pts, const InVecCoord& in, VecCoord& rotatedPoints, VecCoord& out)
+        : rigid(rigid), rotations(rotations), pts(pts), in(in), rotatedPoints(rotatedPoints), out(out) {}
+
+    void operator()(std::size_t first, std::size_t last) const
+    {
+        for (std::size_t i=first; i<last; ++i)
+        {
+            const unsigned int rigidIndex = rigid[i];
+            rotatedPoints[i] = rotations[rigidIndex] * pts[i];
+            out[i] = in[rigidIndex].translate( rotatedPoints[i] );
+        }
+    }
+
+protected:
+    const RigidIndices& rigid;
+    const helper::vector<Mat>& rotations;
+    const VecCoord& pts;
+    const InVecCoord& in;
+    VecCoord& rotatedPoints;
+    VecCoord& out;
+};
+
+template <class TIn, class TOut>
+class RigidMapping<TIn, TOut>::ApplyJFunctor
+{
+public:
+    ApplyJFunctor(const RigidIndices& rigid, const VecCoord& rotatedPoints, const InVecDeriv& in, VecDeriv& out, const ForceMask& maskTo)
+        : rigid(rigid), rotatedPoints(rotatedPoints), in(in), out(out), maskTo(maskTo) {}
+
+    void operator()(std::size_t first, std::size_t last) const
+    {
+        for (std::size_t i=first; i<last; ++i)
+        {
+            if( maskTo.isActivated() && !maskTo.getEntry(i) ) continue;
+
+            out[i] = velocityAtRotatedPoint( in[rigid[i]], rotatedPoints[i] );
+        }
+    }
+
+protected:
+    const RigidIndices& rigid;
+    const VecCoord& rotatedPoints;
+    const InVecDeriv& in;
+    VecDeriv& out;
+    const ForceMask& maskTo;
+};
+
+/// Sum the forces of the mapped points of [first,last) on the range of frames they are attached to
+template <class TIn, class TOut>
+class RigidMapping<TIn, TOut>::ApplyJTFunctor
+{
+public:
+    ApplyJTFunctor(const RigidIndices& rigid, const VecCoord& rotatedPoints, const VecDeriv& in, const ForceMask& maskTo)
+        : rigid(rigid), rotatedPoints(rotatedPoints), in(in), maskTo(maskTo) {}
+
+    FrameForces operator()(std::size_t first, std::size_t last) const
+    {
+        FrameForces f;
+        f.first = 0;
+
+        unsigned int minIndex = std::numeric_limits<unsigned int>::max(), maxIndex = 0;
+        for (std::size_t i=first; i<last; ++i)
+        {
+            if( !maskTo.getEntry(i) ) continue;
+            minIndex = std::min(minIndex, rigid[i]);
+            maxIndex = std::max(maxIndex, rigid[i]);
+        }
+        if( minIndex > maxIndex ) return f;
+
+        f.first = minIndex;
+        f.forces.resize(maxIndex-minIndex+1);
+        f.active.assign(maxIndex-minIndex+1, 0);
+        for (std::size_t i=first; i<last; ++i)
+        {
+            if( !maskTo.getEntry(i) ) continue;
+
+            const unsigned int k = rigid[i] - minIndex;
+            getVCenter(f.forces[k]) += in[i];
+            getVOrientation(f.forces[k]) += (typename InDeriv::Rot)cross(rotatedPoints[i], in[i]);
+            f.active[k] = 1;
+        }
+        return f;
+    }
+
+protected:
+    const RigidIndices& rigid;
+    const VecCoord& rotatedPoints;
+    const VecDeriv& in;
+    const ForceMask& maskTo;
+};
+
+template <class TIn, class TOut>
+class RigidMapping<TIn, TOut>::MergeFrameForces
+{
+public:
+    void operator()(FrameForces& f, const FrameForces& other) const { f.merge(other); }
+};
+
+template <class TIn, class TOut>
+void RigidMapping<TIn, TOut>::FrameForces::merge(const FrameForces& other)
+{
+    if( other.forces.empty() ) return;
+    if( forces.empty() )
+    {
+        *this = other;
+        return;
+    }
+
+    if( other.first < first )
+    {
+        forces.insert(forces.begin(), first-other.first, InDeriv());
+        active.insert(active.begin(), first-other.first, 0);
+        first = other.first;
+    }
+    if( other.first+other.forces.size() > first+forces.size() )
+    {
+        forces.resize(other.first+other.forces.size()-first);
+        active.resize(forces.size(), 0);
+    }
+
+    const unsigned int offset = other.first - first;
+    for (std::size_t k=0; k<other.forces.size(); ++k)
+    {
+        forces[offset+k] += other.forces[k];
+        active[offset+k] |= other.active[k];
+    }
+}
+
+/// Compute the constraint rows [first,last) on the frames, each row summing its entries per frame
+template <class TIn, class TOut>
+class RigidMapping<TIn, TOut>::ApplyJTMatrixFunctor
+{
+public:
+    typedef typename OutMatrixDeriv::RowConstIterator RowConstIterator;
+    typedef helper::vector< std::pair<unsigned int, InDeriv> > FrameRow;
+
+    ApplyJTMatrixFunctor(const RigidIndices& rigid, std::size_t nbPoints, const VecCoord& rotatedPoints, const helper::vector<RowConstIterator>& rows, helper::vector<FrameRow>& frameRows)
+        : rigid(rigid), nbPoints(nbPoints), rotatedPoints(rotatedPoints), rows(rows), frameRows(frameRows) {}
+
+    static bool lessFrame(const std::pair<unsigned int, InDeriv>& a, const std::pair<unsigned int, InDeriv>& b) { return a.first < b.first; }
+
+    void operator()(std::size_t first, std::size_t last) const
+    {
+        for (std::size_t r=first; r<last; ++r)
+        {
+            FrameRow& row = frameRows[r];
+            row.clear();
+
+            RowConstIterator rowIt = rows[r];
+            typename OutMatrixDeriv::ColConstIterator colItEnd = rowIt.end();
+            for (typename OutMatrixDeriv::ColConstIterator colIt = rowIt.begin(); colIt != colItEnd; ++colIt)
+            {
+                const unsigned int cpt = colIt.index();
+                if( cpt >= nbPoints ) continue;
+
+                // consecutive entries usually belong to the same frame
+                const unsigned int rigidIndex = rigid[cpt];
+                std::size_t k = row.size();
+                while( k > 0 && row[k-1].first != rigidIndex ) --k;
+                if( k == 0 )
+                {
+                    row.push_back(std::make_pair(rigidIndex, InDeriv()));
+                    k = row.size();
+                }
+
+                const Deriv f = colIt.val();
+                getVCenter(row[k-1].second) += f;
+                getVOrientation(row[k-1].second) += (typename InDeriv::Rot) cross(rotatedPoints[cpt], f);
+            }
+
+            std::sort(row.begin(), row.end(), &lessFrame);
+        }
+    }
+
+protected:
+    const RigidIndices& rigid;
+    const std::size_t nbPoints;
+    const VecCoord& rotatedPoints;
+    const helper::vector<RowConstIterator>& rows;
+    helper::vector<FrameRow>& frameRows;
+};
+
 template <class TIn, class TOut>
 void RigidMapping<TIn, TOut>::apply(const core::MechanicalParams * /*mparams*/, Data<VecCoord>& dOut, const Data<InVecCoord>& dIn)
 {
@@ -335,11 +544,21 @@ void RigidMapping<TIn, TOut>::apply(const core::MechanicalParams * /*mparams*/,
     const VecCoord& pts = this->getPoints();
 
     updateJ = true;
-    eigenJacobian.resizeBlocks(out.size(),in.size());
 
     rotatedPoints.resize(pts.size());
     out.resize(pts.size());
 
+    if (d_parallel.getValue())
+    {
+        frameRotations.resize(in.size());
+        for (std::size_t j = 0; j < in.size(); j++)
+            in[j].writeRotationMatrix(frameRotations[j]);
+
+        const RigidIndices rigid = getRigidIndices();
+        simulation::parallelFor(0, pts.size(), ApplyFunctor(rigid, frameRotations, pts, in.ref(), rotatedPoints, out.wref()), POINTS_PER_TASK);
+        return;
+    }
+
     for (unsigned int i = 0; i < pts.size(); i++)
     {
         unsigned int rigidIndex = getRigidIndex(i);
@@ -363,6 +582,13 @@ void RigidMapping<TIn, TOut>::applyJ(const core::MechanicalParams * /*mparams*/,
     const VecCoord& pts = this->getPoints();
     out.resize(pts.size());
 
+    if (d_parallel.getValue())
+    {
+        const RigidIndices rigid = getRigidIndices();
+        simulation::parallelFor(0, this->maskTo->size(), ApplyJFunctor(rigid, rotatedPoints, in.ref(), out.wref(), *this->maskTo), POINTS_PER_TASK);
+        return;
+    }
+
     for( size_t i=0 ; i<this->maskTo->size() ; ++i)
     {
         if( this->maskTo->isActivated() && !this->maskTo->getEntry(i) ) continue;
@@ -380,6 +606,22 @@ void RigidMapping<TIn, TOut>::applyJT(const core::MechanicalParams * /*mparams*/
 
     ForceMask &mask = *this->maskFrom;
 
+    if (d_parallel.getValue())
+    {
+        const RigidIndices rigid = getRigidIndices();
+        FrameForces init;
+        init.first = 0;
+        const FrameForces sum = simulation::parallelTreeReduce(0, this->maskTo->size(), init, ApplyJTFunctor(rigid, rotatedPoints, in.ref(), *this->maskTo), MergeFrameForces(), POINTS_PER_TASK);
+
+        for (std::size_t k = 0; k < sum.forces.size(); k++)
+        {
+            if( !sum.active[k] ) continue;
+            out[sum.first+k] += sum.forces[k];
+            mask.insertEntry(sum.first+k);
+        }
+        return;
+    }
+
     for( size_t i=0 ; i<this->maskTo->size() ; ++i)
     {
         if( !this->maskTo->getEntry(i) ) continue;
@@ -501,50 +743,33 @@ void RigidMapping<TIn, TOut>::applyJT(const core::ConstraintParams * /*cparams*/
 
     const unsigned int numDofs = this->getFromModel()->getSize();
 
-
-    // TODO the implementation on the new data structure could maybe be optimized
-
+    // the rows are computed independently, then written from this thread only
+    typedef typename ApplyJTMatrixFunctor::RowConstIterator RowConstIterator;
+    typedef typename ApplyJTMatrixFunctor::FrameRow FrameRow;
+    helper::vector<RowConstIterator> rows;
     typename Out::MatrixDeriv::RowConstIterator rowItEnd = in.end();
-
     for (typename Out::MatrixDeriv::RowConstIterator rowIt = in.begin(); rowIt != rowItEnd; ++rowIt)
-    {
-        typename Out::MatrixDeriv::ColConstIterator colIt = rowIt.begin();
-        typename Out::MatrixDeriv::ColConstIterator colItEnd = rowIt.end();
-
-        for (unsigned int ito = 0; ito < numDofs; ito++)
-        {
-            DPos v;
-            DRot omega = DRot();
-            bool needToInsert = false;
-
-            for (unsigned int cpt = 0; cpt < points.getValue().size() && colIt != colItEnd; cpt++)
-            {
-                unsigned int rigidIndex = getRigidIndex( cpt );
-                if( rigidIndex != ito )
-                    continue;
-                if (colIt.index() != cpt)
-                    continue;
-
-                needToInsert = true;
-                const Deriv f = colIt.val();
-                v += f;
-                omega += (DRot) cross(rotatedPoints[cpt], f);
+        rows.push_back(rowIt);
 
-                ++colIt;
-            }
+    helper::vector<FrameRow> frameRows(rows.size());
+    const RigidIndices rigid = getRigidIndices();
+    ApplyJTMatrixFunctor functor(rigid, points.getValue().size(), rotatedPoints, rows, frameRows);
+    if (d_parallel.getValue())
+        simulation::parallelFor(0, rows.size(), functor, ROWS_PER_TASK);
+    else
+        functor(0, rows.size());
 
-            if (needToInsert)
-            {
-                const InDeriv result(v, omega);
+    for (std::size_t r = 0; r < rows.size(); r++)
+    {
+        const FrameRow& row = frameRows[r];
+        if (row.empty() || row[0].first >= numDofs)
+            continue;
 
-                typename InMatrixDeriv::RowIterator o = out.writeLine(rowIt.index());
-                o.addCol(ito, result);
-            }
-        }
+        typename InMatrixDeriv::RowIterator o = out.writeLine(rows[r].index());
+        for (std::size_t k = 0; k < row.size() && row[k].first < numDofs; k++)
+            o.addCol(row[k].first, row[k].second);
     }
 
-
-
     if (this->f_printLog.getValue())
     {
         sout << "new J on input  DOFs = " << out << sendl;
@@ -597,9 +822,6 @@ const helper::vector<sofa::defaulttype::BaseMatrix*>* RigidMapping<TIn, TOut>::g
 
         updateJ = false;
 
-		J.resize(out.size() * NOut, in.size() * NIn);
-		J.setZero();
-
 		// matrix chunk
 		typedef typename TOut::Real real;
 		typedef Eigen::Matrix<real, NOut, NIn> block_type;
@@ -608,7 +830,46 @@ const helper::vector<sofa::defaulttype::BaseMatrix*>* RigidMapping<TIn, TOut>::g
 		// translation part
 		block.template leftCols<NOut>().setIdentity();
 
+        // entries which are not null for a generic point: the pattern of J then only depends
+        // on the rigid indices and on the mask, and not on the positions
+        block_type pattern = block;
+        Coord generic;
+        generic.fill(1);
+        impl::fill_block(pattern, generic);
+
+        // when the pattern did not change since the previous step, only the values are updated
+        typedef typename SparseMatrixEigen::CompressedMatrix::Index MatrixIndex;
+        bool samePattern = J.rows() == (MatrixIndex)(out.size() * NOut) && J.cols() == (MatrixIndex)(in.size() * NIn)
+                && J.isCompressed() && this->maskTo->size() <= out.size();
+        for( size_t outIdx=0 ; samePattern && outIdx<this->maskTo->size() ; ++outIdx)
+        {
+            const bool active = this->maskTo->getEntry(outIdx);
+            unsigned int inIdx = 0;
+            if( active )
+            {
+                inIdx = getRigidIndex(outIdx);
+                impl::fill_block(block, rotatedPoints[outIdx]);
+            }
 
+            for(unsigned i = 0; samePattern && i < NOut; ++i)
+            {
+                const unsigned row = outIdx * NOut + i;
+                MatrixIndex k = J.outerIndexPtr()[row];
+                const MatrixIndex end = J.outerIndexPtr()[row+1];
+                for(unsigned j = 0; active && j < NIn; ++j)
+                {
+                    if( pattern(i, j) == 0 ) continue;
+                    if( k == end || J.innerIndexPtr()[k] != (MatrixIndex)(inIdx * NIn + j) ) { samePattern = false; break; }
+                    J.valuePtr()[k++] = block(i, j);
+                }
+                if( k != end ) samePattern = false;
+            }
+        }
+        if( samePattern && J.outerIndexPtr()[this->maskTo->size() * NOut] == J.nonZeros() )
+            return &eigenJacobians;
+
+		J.resize(out.size() * NOut, in.size() * NIn);
+		J.setZero();
 
         for( size_t outIdx=0 ; outIdx<this->maskTo->size() ; ++outIdx)
         {
@@ -641,7 +902,7 @@ const helper::vector<sofa::defaulttype::BaseMatrix*>* RigidMapping<TIn, TOut>::g
                 for(unsigned j = 0; j < NIn; ++j) {
                     unsigned col = inIdx * NIn + j;
 
-                    if( block(i, j) != 0 ) {
+                    if( pattern(i, j) != 0 ) {
 
                         J.insertBack(row, col) = block(i, j);
 
@@ -684,6 +945,7 @@ void RigidMapping<TIn, TOut>::updateK( const core::MechanicalParams* mparams, co
     for(unsigned i = 0, n = rotatedPoints.size(); i < n; ++i)
         in_out[ getRigidIndex(i) ].push_back(i);
 
+    unsigned nextRow = 0;
     for( in_out_type::const_iterator it = in_out.begin(), end = in_out.end() ; it != end; ++it )
     {
         const unsigned rigidIdx = it->first;
@@ -709,7 +971,9 @@ void RigidMapping<TIn, TOut>::updateK( const core::MechanicalParams* mparams, co
 
             const unsigned row = TIn::deriv_total_size * rigidIdx + TIn::spatial_dimensions + j;
 
-            dJ.startVec( row );
+            // do not forget to add the empty rows in between (mandatory for Eigen)
+            for( ; nextRow <= row ; ++nextRow )
+                dJ.startVec( nextRow );
 
             for(unsigned k = 0; k < rotation_dimension; ++k) {
                 const unsigned col = TIn::deriv_total_size * rigidIdx + TIn::spatial_dimensions + k;
@@ -750,6 +1014,19 @@ const sofa::defaulttype::BaseMatrix* RigidMapping<TIn, TOut>::getJ()
         }
         else
         {
+            // same sizes: the existing blocks are overwritten in place, unless the rigid indices changed
+            bool sameBlocks = matrixJ->colsIndex.size() == pts.size();
+            for (unsigned int outIdx = 0; sameBlocks && outIdx < pts.size() ; outIdx++)
+            {
+                MBloc* block = matrixJ->wbloc(outIdx, getRigidIndex(outIdx), false);
+                if (block)
+                    RigidMappingMatrixHelper<N, Real>::setMatrix(*block, rotatedPoints[outIdx]);
+                else
+                    sameBlocks = false;
+            }
+            if (sameBlocks)
+                return matrixJ.get();
+
             matrixJ->clear();
         }
 
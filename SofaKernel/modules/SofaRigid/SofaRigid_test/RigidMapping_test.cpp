@@ -187,7 +187,146 @@ struct RigidMappingTest : public Mapping_test<_RigidMapping>
         return this->runTest(xin_init,xout,xin,expectedChildCoords);
     }
 
-    /// @todo test with several frames
+    /** Several frames, with many particles given in local coordinates and attached to the frames in turn.
+     * The particles span several chunks of the parallel computation, whose forces are merged per frame.
+    */
+    bool test_severalRigids_manyParticles_parallel()
+    {
+        const int Nin=3, Nout=2100;
+        this->inDofs->resize(Nin);
+        this->outDofs->resize(Nout);
+
+        rigidMapping->globalToLocalCoords.setValue(false);
+        rigidMapping->geometricStiffness.setValue(1);
+        rigidMapping->d_parallel.setValue(true);
+
+        helper::vector<unsigned> rigidIndexPerPoint(Nout);
+        OutVecCoord xout(Nout);
+        for(int i=0; i<Nout; i++ )
+        {
+            rigidIndexPerPoint[i] = i % Nin;
+            OutDataTypes::set( xout[i], (i%7)*0.25, (i%11)*-0.1, (i%5)*0.3 );
+        }
+        rigidMapping->rigidIndexPerPoint.setValue(rigidIndexPerPoint);
+
+        InVecCoord xin(Nin);
+        RotationMatrix m[Nin];
+        for(int j=0; j<Nin; j++ )
+        {
+            InDataTypes::set( xin[j], 1.+j, -2.*j, 3. );
+            InDataTypes::setCRot( xin[j], InDataTypes::rotationEuler(-1.+j, 2., -3.*j) );
+            xin[j].writeRotationMatrix(m[j]);
+        }
+
+        OutVecCoord expectedChildCoords(Nout);
+        for(int i=0; i<Nout; i++ )
+            expectedChildCoords[i] = xin[i%Nin].getCenter() + m[i%Nin] * xout[i];
+
+        return this->runTest(xin,xout,xin,expectedChildCoords);
+    }
+
+
+    /** Several frames, with constraint rows whose particles are not sorted by frame.
+     * applyJT on matrices must sum the entries of each row per frame. The reference is computed
+     * as the previous implementation did, scanning every particle for each frame, which gave the
+     * right result only when the particles of a row were sorted by frame.
+    */
+    bool test_severalRigids_constraintRows()
+    {
+        typedef typename InDataTypes::MatrixDeriv InMatrixDeriv;
+        typedef typename OutDataTypes::MatrixDeriv OutMatrixDeriv;
+        const int Nin=3, Nout=9, Nrows=3;
+
+        rigidMapping->globalToLocalCoords.setValue(false);
+        const unsigned frames[Nout] = { 2, 0, 1, 0, 2, 1, 1, 0, 2 };
+        helper::vector<unsigned> rigidIndices(Nout);
+        for(int i=0; i<Nout; i++ )
+            rigidIndices[i] = frames[i];
+        rigidMapping->rigidIndexPerPoint.setValue(rigidIndices);
+
+        this->inDofs->resize(Nin);
+        InVecCoord xin(Nin);
+        RotationMatrix m[Nin];
+        {
+            WriteInVecCoord x = this->inDofs->writePositions();
+            for(int j=0; j<Nin; j++ )
+            {
+                InDataTypes::set( xin[j], 1.+j, -2.*j, 3. );
+                InDataTypes::setCRot( xin[j], InDataTypes::rotationEuler(-1.+j, 2., -3.*j) );
+                xin[j].writeRotationMatrix(m[j]);
+                x[j] = xin[j];
+            }
+        }
+        this->outDofs->resize(Nout);
+        OutVecCoord xout(Nout);
+        {
+            WriteOutVecCoord x = this->outDofs->writePositions();
+            for(int i=0; i<Nout; i++ )
+            {
+                OutDataTypes::set( xout[i], (i%3)*0.5, (i%4)*-0.25, (i%2)*0.75 );
+                x[i] = xout[i];
+            }
+        }
+        sofa::simulation::getSimulation()->init(this->root.get());
+
+        // rows over all the particles, a subset of them, and two particles of different frames
+        const unsigned rowPoints[Nrows][Nout] = { {0,1,2,3,4,5,6,7,8}, {1,4,6,8}, {0,5} };
+        const unsigned rowSizes[Nrows] = { 9, 4, 2 };
+        Data<OutMatrixDeriv> dOut;
+        OutMatrixDeriv& constraints = *dOut.beginEdit();
+        helper::vector< helper::vector<OutDeriv> > values(Nrows, helper::vector<OutDeriv>(Nout));
+        for(int r=0; r<Nrows; r++ )
+        {
+            typename OutMatrixDeriv::RowIterator row = constraints.writeLine(r);
+            for(unsigned k=0; k<rowSizes[r]; k++ )
+            {
+                const unsigned i = rowPoints[r][k];
+                values[r][i] = OutDataTypes::randomDeriv( 0.1, 1.0 );
+                row.addCol(i, values[r][i]);
+            }
+        }
+        dOut.endEdit();
+
+        Data<InMatrixDeriv> dIn;
+        core::ConstraintParams cparams;
+        rigidMapping->applyJT(&cparams, dIn, dOut);
+        const InMatrixDeriv& cin = dIn.getValue();
+
+        bool succeed = true;
+        for(int r=0; r<Nrows; r++ )
+        {
+            helper::vector<InDeriv> expected(Nin);
+            helper::vector<bool> expectedFrames(Nin, false);
+            for(int j=0; j<Nin; j++ )
+                for(unsigned k=0; k<rowSizes[r]; k++ )
+                {
+                    const unsigned i = rowPoints[r][k];
+                    if( frames[i] != (unsigned)j ) continue;
+                    getVCenter(expected[j]) += values[r][i];
+                    getVOrientation(expected[j]) += (typename InDeriv::Rot) cross(m[j] * xout[i], values[r][i]);
+                    expectedFrames[j] = true;
+                }
+
+            typename InMatrixDeriv::RowConstIterator row = cin.readLine(r);
+            helper::vector<bool> rowFrames(Nin, false);
+            if( row != cin.end() )
+                for( typename InMatrixDeriv::ColConstIterator col = row.begin(); col != row.end(); ++col )
+                {
+                    rowFrames[col.index()] = true;
+                    if( !this->isSmall( (col.val() - expected[col.index()]).norm(), this->errorMax ) )
+                    {
+                        ADD_FAILURE() << "row " << r << ", frame " << col.index() << ": " << col.val() << ", expected " << expected[col.index()];
+                        succeed = false;
+                    }
+                }
+            if( rowFrames != expectedFrames )
+            {
+                ADD_FAILURE() << "row " << r << " does not have the expected frames";
+                succeed = false;
+            }
+        }
+        return succeed;
+    }
 
 
     ///@}
@@ -217,6 +356,23 @@ TYPED_TEST( RigidMappingTest , oneRigid_fourParticles_worldCoords )
     this->errorMax = 100.; // a larger error occurs, probably due to the world to local mapping at init:
     ASSERT_TRUE(this->test_oneRigid_fourParticles_worldCoords());
 }
+TYPED_TEST( RigidMappingTest , oneRigid_fourParticles_updatedJacobians )
+{
+    // the Jacobians of the second test are updated in place from the ones of the first test
+    ASSERT_TRUE(this->test_oneRigid_fourParticles_localCoords());
+    this->rigidMapping->points.setValue(typename TestFixture::OutVecCoord()); // recomputed from the world coordinates
+    this->errorMax = 100.;
+    ASSERT_TRUE(this->test_oneRigid_fourParticles_worldCoords());
+}
+TYPED_TEST( RigidMappingTest , severalRigids_constraintRows )
+{
+    ASSERT_TRUE(this->test_severalRigids_constraintRows());
+}
+TYPED_TEST( RigidMappingTest , severalRigids_manyParticles_parallel )
+{
+    this->errorMax = 1000.; // the forces of hundreds of particles are summed on each frame
+    ASSERT_TRUE(this->test_severalRigids_manyParticles_parallel());
+}
 
 }//anonymous namespace
 } // namespace sofa
@@ -0,0 +1,206 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2016 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This library is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This library is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this library; if not, write to the Free Software Foundation,     *
+* Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA.          *
+*******************************************************************************
+*                               SOFA :: Modules                               *
+*                                                                             *
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#ifndef SOFA_COMPONENT_FORCEFIELD_COROTATIONALTETRAHEDRONKERNEL_H
+#define SOFA_COMPONENT_FORCEFIELD_COROTATIONALTETRAHEDRONKERNEL_H
+#include "config.h"
+
+#include <sofa/helper/rmath.h>
+
+#include <limits>
+
+namespace sofa
+{
+
+namespace component
+{
+
+namespace forcefield
+{
+
+/// Number of tetrahedra computed together by the batched corotational kernel.
+/// The kernel has no SIMD intrinsics: each operation is a plain loop over the
+/// tetrahedra of a batch. With 8 of them, the rest and current states of a batch
+/// (about 5.5 KB in double precision) stay in the L1 cache between operations.
+enum { CorotationalTetrahedronBatchSize = 8 };
+
+/// Rest state of a batch of tetrahedra for the "large" corotational method, in
+/// structure-of-arrays layout: the last index is the tetrahedron in the batch.
+template<class Real, int N = CorotationalTetrahedronBatchSize>
+struct CorotationalTetrahedronBatch
+{
+    /// Rest positions in the element frame. Only 6 of them are not zero:
+    /// x1, x2, y2, x3, y3, z3
+    Real initial[6][N];
+
+    /// Non-zero entries of the strain-displacement matrix J, for each vertex v:
+    /// J[3v][0], J[3v][3], J[3v][5], J[3v+1][1], J[3v+1][3], J[3v+1][4], J[3v+2][2], J[3v+2][4], J[3v+2][5]
+    Real J[4][9][N];
+
+    /// Non-zero entries of the material stiffness matrix K:
+    /// the 3x3 upper-left block by rows, then K[3][3], K[4][4], K[5][5]
+    Real K[12][N];
+};
+
+/// Per-step input and output of the batched corotational kernel
+template<class Real, int N = CorotationalTetrahedronBatchSize>
+struct CorotationalTetrahedronBatchState
+{
+    /// current positions of the 4 vertices
+    Real x[4][3][N];
+    /// rotation from the world frame to the element frame (rows are the element axes)
+    Real R[3][3][N];
+    /// forces on the 4 vertices, in the world frame
+    Real f[4][3][N];
+};
+
+/// Normalize the vectors (x,y,z) of a batch, leaving the ones with a too small norm unchanged
+template<class Real, int N>
+inline void normalizeBatch(Real (&x)[N], Real (&y)[N], Real (&z)[N])
+{
+    for (int l=0; l<N; ++l)
+    {
+        const Real norm = helper::rsqrt(x[l]*x[l] + y[l]*y[l] + z[l]*z[l]);
+        const bool valid = norm > std::numeric_limits<Real>::epsilon();
+        const Real d = valid ? norm : (Real)1;
+        x[l] /= d;
+        y[l] /= d;
+        z[l] /= d;
+    }
+}
+
+/// Elastic forces of a batch of tetrahedra with the "large" corotational method.
+///
+/// This is the computation of TetrahedronFEMForceField::accumulateForceLarge,
+/// with the same operations in the same order, written as loops over the
+/// tetrahedra of the batch. These are plain C++ loops without branches over
+/// contiguous arrays, which the compiler may auto-vectorize depending on the
+/// target and the optimization flags; no intrinsics are used. The zero entries of the displacement in the element frame are skipped.
+/// It assumes that the strain-displacement matrices are not updated, and that
+/// there is no plasticity.
+template<class Real, int N>
+void computeCorotationalTetrahedronForces(const CorotationalTetrahedronBatch<Real,N>& rest, CorotationalTetrahedronBatchState<Real,N>& s)
+{
+    // element frame: first axis on the first edge, second one in the plane of the two first edges
+    Real ex[3][N], ey[3][N], ez[3][N];
+    for (int k=0; k<3; ++k)
+        for (int l=0; l<N; ++l)
+        {
+            ex[k][l] = s.x[1][k][l] - s.x[0][k][l];
+            ey[k][l] = s.x[2][k][l] - s.x[0][k][l];
+        }
+    normalizeBatch(ex[0], ex[1], ex[2]);
+    normalizeBatch(ey[0], ey[1], ey[2]);
+
+    for (int l=0; l<N; ++l)
+    {
+        ez[0][l] = ex[1][l]*ey[2][l] - ex[2][l]*ey[1][l];
+        ez[1][l] = ex[2][l]*ey[0][l] - ex[0][l]*ey[2][l];
+        ez[2][l] = ex[0][l]*ey[1][l] - ex[1][l]*ey[0][l];
+    }
+    normalizeBatch(ez[0], ez[1], ez[2]);
+
+    for (int l=0; l<N; ++l)
+    {
+        ey[0][l] = ez[1][l]*ex[2][l] - ez[2][l]*ex[1][l];
+        ey[1][l] = ez[2][l]*ex[0][l] - ez[0][l]*ex[2][l];
+        ey[2][l] = ez[0][l]*ex[1][l] - ez[1][l]*ex[0][l];
+    }
+    normalizeBatch(ey[0], ey[1], ey[2]);
+
+    for (int k=0; k<3; ++k)
+        for (int l=0; l<N; ++l)
+        {
+            s.R[0][k][l] = ex[k][l];
+            s.R[1][k][l] = ey[k][l];
+            s.R[2][k][l] = ez[k][l];
+        }
+
+    // positions in the element frame
+    Real deforme[4][3][N];
+    for (int v=0; v<4; ++v)
+        for (int i=0; i<3; ++i)
+            for (int l=0; l<N; ++l)
+                deforme[v][i][l] = s.R[i][0][l]*s.x[v][0][l] + s.R[i][1][l]*s.x[v][1][l] + s.R[i][2][l]*s.x[v][2][l];
+
+    // displacement, the other entries are zero
+    Real D3[N], D6[N], D7[N], D9[N], D10[N], D11[N];
+    for (int l=0; l<N; ++l)
+    {
+        D3[l]  = rest.initial[0][l] - (deforme[1][0][l] - deforme[0][0][l]);
+        D6[l]  = rest.initial[1][l] - (deforme[2][0][l] - deforme[0][0][l]);
+        D7[l]  = rest.initial[2][l] - (deforme[2][1][l] - deforme[0][1][l]);
+        D9[l]  = rest.initial[3][l] - (deforme[3][0][l] - deforme[0][0][l]);
+        D10[l] = rest.initial[4][l] - (deforme[3][1][l] - deforme[0][1][l]);
+        D11[l] = rest.initial[5][l] - (deforme[3][2][l] - deforme[0][2][l]);
+    }
+
+    // strain J^T D
+    Real JtD[6][N];
+    for (int l=0; l<N; ++l)
+    {
+        JtD[0][l] = rest.J[1][0][l]*D3[l] + rest.J[2][0][l]*D6[l] + rest.J[3][0][l]*D9[l];
+        JtD[1][l] = rest.J[2][3][l]*D7[l] + rest.J[3][3][l]*D10[l];
+        JtD[2][l] = rest.J[3][6][l]*D11[l];
+        JtD[3][l] = rest.J[1][1][l]*D3[l] + rest.J[2][1][l]*D6[l] + rest.J[2][4][l]*D7[l] + rest.J[3][1][l]*D9[l] + rest.J[3][4][l]*D10[l];
+        JtD[4][l] = rest.J[2][5][l]*D7[l] + rest.J[3][5][l]*D10[l] + rest.J[3][7][l]*D11[l];
+        JtD[5][l] = rest.J[1][2][l]*D3[l] + rest.J[2][2][l]*D6[l] + rest.J[3][2][l]*D9[l] + rest.J[3][8][l]*D11[l];
+    }
+
+    // stress K J^T D
+    Real KJtD[6][N];
+    for (int l=0; l<N; ++l)
+    {
+        KJtD[0][l] = rest.K[0][l]*JtD[0][l] + rest.K[1][l]*JtD[1][l] + rest.K[2][l]*JtD[2][l];
+        KJtD[1][l] = rest.K[3][l]*JtD[0][l] + rest.K[4][l]*JtD[1][l] + rest.K[5][l]*JtD[2][l];
+        KJtD[2][l] = rest.K[6][l]*JtD[0][l] + rest.K[7][l]*JtD[1][l] + rest.K[8][l]*JtD[2][l];
+        KJtD[3][l] = rest.K[9][l]*JtD[3][l];
+        KJtD[4][l] = rest.K[10][l]*JtD[4][l];
+        KJtD[5][l] = rest.K[11][l]*JtD[5][l];
+    }
+
+    // forces J K J^T D in the element frame, rotated back to the world frame
+    for (int v=0; v<4; ++v)
+    {
+        const Real (&Jv)[9][N] = rest.J[v];
+        Real F[3][N];
+        for (int l=0; l<N; ++l)
+        {
+            F[0][l] = Jv[0][l]*KJtD[0][l] + Jv[1][l]*KJtD[3][l] + Jv[2][l]*KJtD[5][l];
+            F[1][l] = Jv[3][l]*KJtD[1][l] + Jv[4][l]*KJtD[3][l] + Jv[5][l]*KJtD[4][l];
+            F[2][l] = Jv[6][l]*KJtD[2][l] + Jv[7][l]*KJtD[4][l] + Jv[8][l]*KJtD[5][l];
+        }
+        for (int k=0; k<3; ++k)
+            for (int l=0; l<N; ++l)
+                s.f[v][k][l] = s.R[0][k][l]*F[0][l] + s.R[1][k][l]*F[1][l] + s.R[2][k][l]*F[2][l];
+    }
+}
+
+} // namespace forcefield
+
+} // namespace component
+
+} // namespace sofa
+
+#endif // SOFA_COMPONENT_FORCEFIELD_COROTATIONALTETRAHEDRONKERNEL_H
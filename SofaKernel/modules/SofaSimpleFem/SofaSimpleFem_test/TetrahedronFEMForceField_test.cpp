@@ -39,6 +39,9 @@ using sofa::simulation::Node ;
 using sofa::simulation::SceneLoaderXML ;
 using sofa::core::ExecParams ;
 
+#include <sofa/simulation/TaskScheduler.h>
+using sofa::simulation::TaskScheduler ;
+
 namespace sofa {
 
 using namespace modeling;
@@ -174,4 +177,146 @@ TYPED_TEST(TetrahedronFEMForceField_test, checkGracefullHandlingWhenTopologyIsMi
     this->checkGracefullHandlingWhenTopologyIsMissing();
 }
 
+/// Compare the multithreaded element loops with the sequential ones
+struct TetrahedronFEMForceField_parallel_test : public Sofa_test<double>
+{
+    typedef component::forcefield::TetrahedronFEMForceField<defaulttype::Vec3dTypes> FEM;
+    typedef FEM::VecCoord VecCoord;
+    typedef FEM::VecDeriv VecDeriv;
+
+    Node::SPtr root;
+    FEM* fem;
+    core::objectmodel::Data<VecCoord> x;
+    core::objectmodel::Data<VecDeriv> v, dx;
+
+    TetrahedronFEMForceField_parallel_test() : fem(NULL)
+    {
+        sofa::simulation::setSimulation(new sofa::simulation::graph::DAGSimulation());
+        std::string scene =
+                "<?xml version='1.0'?>"
+                "<Node name='Root'> "
+                "  <RegularGridTopology n='5 4 6' min='0 0 0' max='1 1 2'/> "
+                "  <MechanicalObject/> "
+                "  <TetrahedronFEMForceField name='fem' youngModulus='1000' poissonRatio='0.3'/> "
+                "</Node> ";
+        root = SceneLoaderXML::loadFromMemory("testscene", scene.c_str(), scene.size());
+        root->init(ExecParams::defaultInstance());
+        root->get(fem);
+
+        // deformed positions and some displacement, always the same
+        const VecCoord& x0 = fem->getMState()->read(core::ConstVecCoordId::position())->getValue();
+        VecCoord& xs = *x.beginEdit();
+        VecDeriv& dxs = *dx.beginEdit();
+        xs = x0;
+        dxs.resize(x0.size());
+        for (unsigned int i=0; i<xs.size(); ++i)
+        {
+            xs[i] += FEM::Coord(0.1*std::sin(3.0*i), 0.05*std::cos(7.0*i), 0.1*std::sin(0.5*i));
+            dxs[i] = FEM::Deriv(std::cos(1.0*i), std::sin(2.0*i), 0.3);
+        }
+        x.endEdit();
+        dx.endEdit();
+        v.setValue(VecDeriv(xs.size()));
+    }
+
+    ~TetrahedronFEMForceField_parallel_test()
+    {
+        TaskScheduler::getInstance().stop();
+    }
+
+    /// Forces and df with the given settings, on nbThreads threads (0 for sequential loops)
+    void compute(unsigned int nbThreads, const std::string& scatter, bool deterministic, VecDeriv& f, VecDeriv& df)
+    {
+        if (nbThreads)
+            TaskScheduler::getInstance().start(nbThreads);
+        fem->d_parallel.setValue(nbThreads != 0);
+        fem->d_parallelScatter.beginEdit()->setSelectedItem(scatter);
+        fem->d_parallelScatter.endEdit();
+        fem->d_deterministic.setValue(deterministic);
+
+        core::MechanicalParams mparams;
+        mparams.setKFactor(1.0);
+        core::objectmodel::Data<VecDeriv> fData, dfData;
+        fData.setValue(VecDeriv(x.getValue().size()));
+        dfData.setValue(VecDeriv(x.getValue().size()));
+        fem->addForce(&mparams, fData, x, v);
+        fem->addDForce(&mparams, dfData, dx);
+        f = fData.getValue();
+        df = dfData.getValue();
+    }
+
+    void run(const std::string& method)
+    {
+        fem->f_method.setValue(method);
+        fem->reinit();
+
+        VecDeriv f0, df0;
+        compute(0, "coloring", false, f0, df0);
+
+        const char* scatters[] = { "coloring", "threadBuffers" };
+        for (unsigned int s=0; s<2; ++s)
+        {
+            VecDeriv f2, df2;
+            compute(2, scatters[s], true, f2, df2);
+            EXPECT_LT(this->vectorMaxDiff(f0, f2), 1e-10) << method << " " << scatters[s];
+            EXPECT_LT(this->vectorMaxDiff(df0, df2), 1e-10) << method << " " << scatters[s];
+
+            const unsigned int threads[] = { 3, 4 };
+            for (unsigned int t=0; t<2; ++t)
+            {
+                VecDeriv f, df;
+                compute(threads[t], scatters[s], true, f, df);
+                for (unsigned int i=0; i<f.size(); ++i)
+                {
+                    // bit-for-bit identical, whatever the number of threads
+                    EXPECT_EQ(f2[i], f[i]) << method << " " << scatters[s] << " " << threads[t] << " threads";
+                    EXPECT_EQ(df2[i], df[i]) << method << " " << scatters[s] << " " << threads[t] << " threads";
+                }
+
+                compute(threads[t], scatters[s], false, f, df);
+                EXPECT_LT(this->vectorMaxDiff(f0, f), 1e-10) << method << " " << scatters[s];
+                EXPECT_LT(this->vectorMaxDiff(df0, df), 1e-10) << method << " " << scatters[s];
+            }
+        }
+    }
+};
+
+TEST_F(TetrahedronFEMForceField_parallel_test, small) { run("small"); }
+TEST_F(TetrahedronFEMForceField_parallel_test, large) { run("large"); }
+TEST_F(TetrahedronFEMForceField_parallel_test, polar) { run("polar"); }
+TEST_F(TetrahedronFEMForceField_parallel_test, svd) { run("svd"); }
+
+/// The batched kernel of the large method gives the same forces and rotations as the scalar code
+TEST_F(TetrahedronFEMForceField_parallel_test, vectorized)
+{
+    fem->f_method.setValue("large");
+    fem->reinit();
+
+    VecDeriv f0, df0;
+    compute(0, "coloring", false, f0, df0);
+    const unsigned int nbElements = fem->getContext()->getMeshTopology()->getNbTetrahedra();
+    helper::vector<defaulttype::Mat3x3d> rotations0(nbElements);
+    for (unsigned int i=0; i<nbElements; ++i)
+        rotations0[i] = fem->getActualTetraRotation(i);
+
+    fem->d_vectorized.setValue(true);
+    const char* scatters[] = { "coloring", "threadBuffers" };
+    const unsigned int threads[] = { 0, 1, 4 };
+    for (unsigned int t=0; t<3; ++t)
+        for (unsigned int s=0; s<2; ++s)
+        {
+            VecDeriv f, df;
+            compute(threads[t], scatters[s], false, f, df);
+            EXPECT_LT(this->vectorMaxDiff(f0, f), 1e-10) << threads[t] << " threads " << scatters[s];
+            EXPECT_LT(this->vectorMaxDiff(df0, df), 1e-10) << threads[t] << " threads " << scatters[s];
+
+            for (unsigned int i=0; i<nbElements; ++i)
+            {
+                const defaulttype::Mat3x3d R = fem->getActualTetraRotation(i);
+                for (int j=0; j<3; ++j)
+                    EXPECT_LT((rotations0[i][j] - R[j]).norm(), 1e-12);
+            }
+        }
+}
+
 } // namespace sofa
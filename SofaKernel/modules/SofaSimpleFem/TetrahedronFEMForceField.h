@@ -34,6 +34,7 @@
 #include <sofa/core/behavior/BaseRotationFinder.h>
 #include <sofa/core/behavior/RotationMatrix.h>
 #include <sofa/helper/OptionsGroup.h>
+#include "CorotationalTetrahedronKernel.h"
 
 // FIX: temporarily disabled as SofaSimpleFem is not supposed to depend on SofaOpenGLVisual
 #define SIMPLEFEM_COLORMAP
@@ -303,6 +304,15 @@ public:
     Data < bool > isToPrint;
     Data<bool>  _updateStiffness;
 
+    /// @name Multithreaded element loops of addForce and addDForce
+    /// @{
+    Data<bool> d_parallel; ///< use the TaskScheduler threads
+    Data<sofa::helper::OptionsGroup> d_parallelScatter; ///< how the element forces are added to the nodes: "coloring" or "threadBuffers"
+    Data<bool> d_deterministic; ///< make the results independent of the number of threads
+    /// @}
+
+    Data<bool> d_vectorized; ///< compute the "large" method forces by batches of tetrahedra
+
     helper::vector<defaulttype::Vec<6,Real> > elemDisplacements;
 
     bool updateVonMisesStress;
@@ -338,7 +348,14 @@ protected:
 #endif
         , isToPrint( initData(&isToPrint, false, "isToPrint", "suppress somes data before using save as function"))
         , _updateStiffness(initData(&_updateStiffness,false,"updateStiffness","udpate structures (precomputed in init) using stiffness parameters in each iteration (set listening=1)"))
+        , d_parallel(initData(&d_parallel,false,"parallel","compute the element forces of addForce and addDForce on several threads (not available with computeGlobalMatrix)"))
+        , d_parallelScatter(initData(&d_parallelScatter,"parallelScatter","how the element forces computed in parallel are added to the nodes: \"coloring\" (elements sharing no node are processed together) or \"threadBuffers\" (one force vector per thread, summed at the end)"))
+        , d_deterministic(initData(&d_deterministic,false,"deterministic","with threadBuffers, split the elements into blocks of a fixed size, each with its own buffer, instead of one buffer per thread, so that the results do not depend on the number of threads (coloring is always deterministic)"))
+        , d_vectorized(initData(&d_vectorized,false,"vectorized","compute the forces of the \"large\" method by batches of tetrahedra stored as structures of arrays, in plain loops over the batch without SIMD intrinsics (not available with updateStiffnessMatrix, updateStiffness, computeGlobalMatrix or plasticity)"))
     {
+        helper::OptionsGroup scatterOptions(2,"coloring","threadBuffers");
+        d_parallelScatter.setValue(scatterOptions);
+
 		_poissonRatio.setRequired(true);
 		_youngModulus.setRequired(true);
 		_youngModulus.beginEdit()->push_back((Real)5000.);
@@ -477,6 +494,70 @@ protected:
 
     void applyStiffnessCorotational( Vector& f, const Vector& x, int i=0, Index a=0,Index b=1,Index c=2,Index d=3, SReal fact=1.0  );
 
+    ////////////// multithreaded element loops
+
+    /// Elements grouped such that the elements of a group share no node, computed when needed by the coloring scatter
+    helper::vector< helper::vector<unsigned int> > elementColors;
+    /// Force vectors of the threadBuffers scatter
+    helper::vector<VecDeriv> scatterBuffers;
+
+    /// Whether addForce and addDForce can use the parallel element loops
+    bool useParallelElementLoops();
+
+    /// Call functor(f, elementIndex) for each element, on several threads.
+    /// elements lists the nodes of each element, and colors is computed from it if needed.
+    template<class VecElementNodes, class ElementFunctor>
+    void parallelElementLoop( VecDeriv& f, const VecElementNodes& elements, helper::vector< helper::vector<unsigned int> >& colors, const ElementFunctor& functor );
+
+    /// Add the force of one element, using the current method
+    void accumulateForce( Vector& f, const Vector& p, Index elementIndex );
+    /// Add the stiffness of one element times x, using the current method
+    void applyStiffness( Vector& f, const Vector& x, Index elementIndex, SReal fact );
+
+    struct AccumulateForceFunctor
+    {
+        TetrahedronFEMForceField* ff;
+        const Vector* p;
+        void operator()(Vector& f, unsigned int elementIndex) const { ff->accumulateForce(f, *p, elementIndex); }
+    };
+
+    struct ApplyStiffnessFunctor
+    {
+        TetrahedronFEMForceField* ff;
+        const Vector* x;
+        SReal fact;
+        void operator()(Vector& f, unsigned int elementIndex) const { ff->applyStiffness(f, *x, elementIndex, fact); }
+    };
+
+    ////////////// batched kernel of the large method
+
+    typedef CorotationalTetrahedronBatch<Real> RestBatch;
+    typedef CorotationalTetrahedronBatchState<Real> BatchState;
+    enum { BatchSize = CorotationalTetrahedronBatchSize };
+
+    /// Rest data of the batches, packed when needed by the batched kernel
+    helper::vector<RestBatch> restBatches;
+    /// Elements of each batch, the last batch can be incomplete
+    helper::vector< helper::vector<unsigned int> > batchElements;
+    /// Nodes of each batch, used by the coloring scatter
+    helper::vector< helper::vector<Index> > batchNodes;
+    /// Batches grouped such that the batches of a group share no node
+    helper::vector< helper::vector<unsigned int> > batchColors;
+
+    /// Whether addForce can use the batched kernel
+    bool useBatchedKernel();
+    /// Pack the rest data of the elements into batches
+    void initBatches();
+    /// Add the forces of the elements of a batch, and update their rotations
+    void accumulateForceBatch( Vector& f, const Vector& p, unsigned int batchIndex );
+
+    struct AccumulateForceBatchFunctor
+    {
+        TetrahedronFEMForceField* ff;
+        const Vector* p;
+        void operator()(Vector& f, unsigned int batchIndex) const { ff->accumulateForceBatch(f, *p, batchIndex); }
+    };
+
 
     void handleTopologyChange()
     {
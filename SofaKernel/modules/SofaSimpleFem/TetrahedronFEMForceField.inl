@@ -37,6 +37,7 @@
 #include <SofaBaseLinearSolver/CompressedRowSparseMatrix.h>
 #include <sofa/simulation/AnimateBeginEvent.h>
 #include <sofa/simulation/AnimateEndEvent.h>
+#include <sofa/simulation/ParallelScatter.h>
 
 
 namespace sofa
@@ -1390,6 +1391,162 @@ inline void TetrahedronFEMForceField<DataTypes>::applyStiffnessCorotational( Vec
 }
 
 
+//////////////////////////////////////////////////////////////////////
+////////////////////  multithreaded element loops  ///////////////////
+//////////////////////////////////////////////////////////////////////
+
+template<class DataTypes>
+bool TetrahedronFEMForceField<DataTypes>::useParallelElementLoops()
+{
+    // the assembled stiffness is shared by all the elements
+    if (!d_parallel.getValue() || _assembling.getValue())
+        return false;
+
+    if (!simulation::parallel::getParallelWorker())
+        return false;
+
+    // make sure the Data read by the element computations are up-to-date before they are read concurrently
+    _initialPoints.getValue();
+    _updateStiffnessMatrix.getValue();
+    _plasticMaxThreshold.getValue();
+    _plasticYieldThreshold.getValue();
+    _plasticCreep.getValue();
+
+    return true;
+}
+
+template<class DataTypes>
+template<class VecElementNodes, class ElementFunctor>
+void TetrahedronFEMForceField<DataTypes>::parallelElementLoop( VecDeriv& f, const VecElementNodes& elements, helper::vector< helper::vector<unsigned int> >& colors, const ElementFunctor& functor )
+{
+    if (d_parallelScatter.getValue().getSelectedId() == 0)
+    {
+        if (colors.empty())
+            simulation::computeElementColors(elements, colors);
+        simulation::parallelScatterColored(f, colors, functor);
+    }
+    else
+    {
+        simulation::parallelScatterBuffered(f, elements.size(), scatterBuffers, d_deterministic.getValue(), functor);
+    }
+}
+
+template<class DataTypes>
+inline void TetrahedronFEMForceField<DataTypes>::accumulateForce( Vector& f, const Vector& p, Index elementIndex )
+{
+    typename VecElement::const_iterator it = _indexedElements->begin() + elementIndex;
+    switch(method)
+    {
+    case SMALL : accumulateForceSmall( f, p, it, elementIndex ); break;
+    case LARGE : accumulateForceLarge( f, p, it, elementIndex ); break;
+    case POLAR : accumulateForcePolar( f, p, it, elementIndex ); break;
+    case SVD :   accumulateForceSVD( f, p, it, elementIndex ); break;
+    }
+}
+
+template<class DataTypes>
+inline void TetrahedronFEMForceField<DataTypes>::applyStiffness( Vector& f, const Vector& x, Index elementIndex, SReal fact )
+{
+    const Element& e = (*_indexedElements)[elementIndex];
+    if( method == SMALL )
+        applyStiffnessSmall( f, x, elementIndex, e[0], e[1], e[2], e[3], fact );
+    else
+        applyStiffnessCorotational( f, x, elementIndex, e[0], e[1], e[2], e[3], fact );
+}
+
+
+//////////////////////////////////////////////////////////////////////
+///////////////////  batched kernel of large method  /////////////////
+//////////////////////////////////////////////////////////////////////
+
+template<class DataTypes>
+bool TetrahedronFEMForceField<DataTypes>::useBatchedKernel()
+{
+    // the kernel uses the strain-displacement and material stiffness matrices computed in reinit
+    return d_vectorized.getValue() && method == LARGE
+            && !_updateStiffnessMatrix.getValue() && !_updateStiffness.getValue()
+            && !_assembling.getValue() && _plasticMaxThreshold.getValue() <= 0;
+}
+
+template<class DataTypes>
+void TetrahedronFEMForceField<DataTypes>::initBatches()
+{
+    static const int Jrow[9] = { 0, 0, 0, 1, 1, 1, 2, 2, 2 };
+    static const int Jcol[9] = { 0, 3, 5, 1, 3, 4, 2, 4, 5 };
+    static const int Krow[12] = { 0, 0, 0, 1, 1, 1, 2, 2, 2, 3, 4, 5 };
+    static const int Kcol[12] = { 0, 1, 2, 0, 1, 2, 0, 1, 2, 3, 4, 5 };
+
+    const unsigned int nbElements = (unsigned int)_indexedElements->size();
+    const unsigned int nbBatches = (nbElements + BatchSize - 1) / BatchSize;
+    restBatches.resize(nbBatches);
+    batchElements.resize(nbBatches);
+    batchNodes.resize(nbBatches);
+    batchColors.clear();
+
+    for (unsigned int b=0; b<nbBatches; ++b)
+    {
+        helper::vector<unsigned int>& elements = batchElements[b];
+        elements.clear();
+        batchNodes[b].clear();
+        for (unsigned int e = b*BatchSize; e < nbElements && e < (b+1)*BatchSize; ++e)
+        {
+            elements.push_back(e);
+            for (int v=0; v<4; ++v)
+                batchNodes[b].push_back((*_indexedElements)[e][v]);
+        }
+
+        // the unused lanes of the last batch repeat its first element
+        RestBatch& rest = restBatches[b];
+        for (int l=0; l<BatchSize; ++l)
+        {
+            const unsigned int e = elements[(unsigned int)l < elements.size() ? l : 0];
+            const helper::fixed_array<Coord,4>& initial = _rotatedInitialElements[e];
+            rest.initial[0][l] = initial[1][0];
+            rest.initial[1][l] = initial[2][0];
+            rest.initial[2][l] = initial[2][1];
+            rest.initial[3][l] = initial[3][0];
+            rest.initial[4][l] = initial[3][1];
+            rest.initial[5][l] = initial[3][2];
+            for (int v=0; v<4; ++v)
+                for (int j=0; j<9; ++j)
+                    rest.J[v][j][l] = strainDisplacements[e][3*v+Jrow[j]][Jcol[j]];
+            for (int k=0; k<12; ++k)
+                rest.K[k][l] = materialsStiffnesses[e][Krow[k]][Kcol[k]];
+        }
+    }
+}
+
+template<class DataTypes>
+inline void TetrahedronFEMForceField<DataTypes>::accumulateForceBatch( Vector& f, const Vector& p, unsigned int batchIndex )
+{
+    const helper::vector<unsigned int>& elements = batchElements[batchIndex];
+    const unsigned int nbElements = (unsigned int)elements.size();
+
+    BatchState state;
+    for (int l=0; l<BatchSize; ++l)
+    {
+        const Element& index = (*_indexedElements)[elements[(unsigned int)l < nbElements ? l : 0]];
+        for (int v=0; v<4; ++v)
+            for (int k=0; k<3; ++k)
+                state.x[v][k][l] = p[index[v]][k];
+    }
+
+    computeCorotationalTetrahedronForces(restBatches[batchIndex], state);
+
+    for (unsigned int l=0; l<nbElements; ++l)
+    {
+        const unsigned int elementIndex = elements[l];
+        const Element& index = (*_indexedElements)[elementIndex];
+        Transformation& R = rotations[elementIndex];
+        for (int i=0; i<3; ++i)
+            for (int j=0; j<3; ++j)
+                R[i][j] = state.R[j][i][l];
+        for (int v=0; v<4; ++v)
+            f[index[v]] += Deriv( state.f[v][0][l], state.f[v][1][l], state.f[v][2][l] );
+    }
+}
+
+
 //////////////////////////////////////////////////////////////////////
 ////////////////  generic main computations methods  /////////////////
 //////////////////////////////////////////////////////////////////////
@@ -1411,6 +1568,9 @@ void TetrahedronFEMForceField<DataTypes>::init()
     if (_updateStiffness.getValue())
         this->f_listening.setValue(true);
 
+    if (d_parallel.getValue())
+        simulation::TaskScheduler::getInstance().start();
+
     // ParallelDataThrd is used to build the matrix asynchronusly (when listening = true)
     // This feature is activated when callin handleEvent with ParallelizeBuildEvent
     // At init parallelDataSimu == parallelDataThrd (and it's the case since handleEvent is called)
@@ -1592,6 +1752,9 @@ inline void TetrahedronFEMForceField<DataTypes>::reinit()
     strainDisplacements.resize( _indexedElements->size() );
     materialsStiffnesses.resize(_indexedElements->size() );
     _plasticStrains.resize(     _indexedElements->size() );
+    elementColors.clear();
+    restBatches.clear();
+    batchColors.clear();
     if(_assembling.getValue())
     {
         _stiffnesses.resize( _initialPoints.getValue().size()*3 );
@@ -1732,6 +1895,39 @@ inline void TetrahedronFEMForceField<DataTypes>::addForce (const core::Mechanica
         needUpdateTopology = false;
     }
 
+    if (useBatchedKernel())
+    {
+        if (restBatches.empty())
+            initBatches();
+
+        AccumulateForceBatchFunctor functor;
+        functor.ff = this;
+        functor.p = &p;
+        if (useParallelElementLoops())
+            parallelElementLoop(f, batchNodes, batchColors, functor);
+        else
+        {
+            for (unsigned int b=0; b<restBatches.size(); ++b)
+                functor(f, b);
+        }
+
+        d_f.endEdit();
+        updateVonMisesStress = true;
+        return;
+    }
+
+    if (useParallelElementLoops())
+    {
+        AccumulateForceFunctor functor;
+        functor.ff = this;
+        functor.p = &p;
+        parallelElementLoop(f, *_indexedElements, elementColors, functor);
+
+        d_f.endEdit();
+        updateVonMisesStress = true;
+        return;
+    }
+
     unsigned int i;
     typename VecElement::const_iterator it;
     switch(method)
@@ -1783,6 +1979,19 @@ inline void TetrahedronFEMForceField<DataTypes>::addDForce(const core::Mechanica
     Real kFactor = (Real)mparams->kFactorIncludingRayleighDamping(this->rayleighStiffness.getValue());
 
     df.resize(dx.size());
+
+    if (useParallelElementLoops())
+    {
+        ApplyStiffnessFunctor functor;
+        functor.ff = this;
+        functor.x = &dx;
+        functor.fact = kFactor;
+        parallelElementLoop(df, *_indexedElements, elementColors, functor);
+
+        d_df.endEdit();
+        return;
+    }
+
     unsigned int i;
     typename VecElement::const_iterator it;
 
@@ -2120,146 +2329,36 @@ template<class DataTypes>
 void TetrahedronFEMForceField<DataTypes>::addKToMatrix(sofa::defaulttype::BaseMatrix *mat, SReal k, unsigned int &offset)
 {
     // Build Matrix Block for this ForceField
-    int i,j,n1, n2, row, column, ROW, COLUMN , IT;
+    int i,j,n1, n2, IT;
 
     Transformation Rot;
     StiffnessMatrix JKJt,tmp;
 
     typename VecElement::const_iterator it;
 
-    Index noeud1, noeud2;
-    int offd3 = offset/3;
-
     Rot[0][0]=Rot[1][1]=Rot[2][2]=1;
     Rot[0][1]=Rot[0][2]=0;
     Rot[1][0]=Rot[1][2]=0;
     Rot[2][0]=Rot[2][1]=0;
 
-    if (sofa::component::linearsolver::CompressedRowSparseMatrix<defaulttype::Mat<3,3,double> > * crsmat = dynamic_cast<sofa::component::linearsolver::CompressedRowSparseMatrix<defaulttype::Mat<3,3,double> > * >(mat))
-    {
-        for(it = _indexedElements->begin(), IT=0 ; it != _indexedElements->end() ; ++it,++IT)
-        {
-            if (method == SMALL) computeStiffnessMatrix(JKJt,tmp,materialsStiffnesses[IT], strainDisplacements[IT],Rot);
-            else computeStiffnessMatrix(JKJt,tmp,materialsStiffnesses[IT], strainDisplacements[IT],rotations[IT]);
-
-            defaulttype::Mat<3,3,double> tmpBlock[4][4];
-            // find index of node 1
-            for (n1=0; n1<4; n1++)
-            {
-                for(i=0; i<3; i++)
-                {
-                    for (n2=0; n2<4; n2++)
-                    {
-                        for (j=0; j<3; j++)
-                        {
-                            tmpBlock[n1][n2][i][j] = - tmp[n1*3+i][n2*3+j]*k;
-                        }
-                    }
-                }
-            }
-            *crsmat->wbloc(offd3 + (*it)[0], offd3 + (*it)[0],true) += tmpBlock[0][0];
-            *crsmat->wbloc(offd3 + (*it)[0], offd3 + (*it)[1],true) += tmpBlock[0][1];
-            *crsmat->wbloc(offd3 + (*it)[0], offd3 + (*it)[2],true) += tmpBlock[0][2];
-            *crsmat->wbloc(offd3 + (*it)[0], offd3 + (*it)[3],true) += tmpBlock[0][3];
-
-            *crsmat->wbloc(offd3 + (*it)[1], offd3 + (*it)[0],true) += tmpBlock[1][0];
-            *crsmat->wbloc(offd3 + (*it)[1], offd3 + (*it)[1],true) += tmpBlock[1][1];
-            *crsmat->wbloc(offd3 + (*it)[1], offd3 + (*it)[2],true) += tmpBlock[1][2];
-            *crsmat->wbloc(offd3 + (*it)[1], offd3 + (*it)[3],true) += tmpBlock[1][3];
-
-            *crsmat->wbloc(offd3 + (*it)[2], offd3 + (*it)[0],true) += tmpBlock[2][0];
-            *crsmat->wbloc(offd3 + (*it)[2], offd3 + (*it)[1],true) += tmpBlock[2][1];
-            *crsmat->wbloc(offd3 + (*it)[2], offd3 + (*it)[2],true) += tmpBlock[2][2];
-            *crsmat->wbloc(offd3 + (*it)[2], offd3 + (*it)[3],true) += tmpBlock[2][3];
-
-            *crsmat->wbloc(offd3 + (*it)[3], offd3 + (*it)[0],true) += tmpBlock[3][0];
-            *crsmat->wbloc(offd3 + (*it)[3], offd3 + (*it)[1],true) += tmpBlock[3][1];
-            *crsmat->wbloc(offd3 + (*it)[3], offd3 + (*it)[2],true) += tmpBlock[3][2];
-            *crsmat->wbloc(offd3 + (*it)[3], offd3 + (*it)[3],true) += tmpBlock[3][3];
-        }
-    }
-    else if (sofa::component::linearsolver::CompressedRowSparseMatrix<defaulttype::Mat<3,3,float> > * crsmat = dynamic_cast<sofa::component::linearsolver::CompressedRowSparseMatrix<defaulttype::Mat<3,3,float> > * >(mat))
+    defaulttype::Mat<3,3,double> tmpBlock;
+    for(it = _indexedElements->begin(), IT=0 ; it != _indexedElements->end() ; ++it,++IT)
     {
-        for(it = _indexedElements->begin(), IT=0 ; it != _indexedElements->end() ; ++it,++IT)
-        {
-            if (method == SMALL) computeStiffnessMatrix(JKJt,tmp,materialsStiffnesses[IT], strainDisplacements[IT],Rot);
-            else computeStiffnessMatrix(JKJt,tmp,materialsStiffnesses[IT], strainDisplacements[IT],rotations[IT]);
+        if (method == SMALL) computeStiffnessMatrix(JKJt,tmp,materialsStiffnesses[IT], strainDisplacements[IT],Rot);
+        else computeStiffnessMatrix(JKJt,tmp,materialsStiffnesses[IT], strainDisplacements[IT],rotations[IT]);
 
-            defaulttype::Mat<3,3,double> tmpBlock[4][4];
-            // find index of node 1
-            for (n1=0; n1<4; n1++)
-            {
-                for(i=0; i<3; i++)
-                {
-                    for (n2=0; n2<4; n2++)
-                    {
-                        for (j=0; j<3; j++)
-                        {
-                            tmpBlock[n1][n2][i][j] = - tmp[n1*3+i][n2*3+j]*k;
-                        }
-                    }
-                }
-            }
-
-            *crsmat->wbloc(offd3 + (*it)[0], offd3 + (*it)[0],true) += tmpBlock[0][0];
-            *crsmat->wbloc(offd3 + (*it)[0], offd3 + (*it)[1],true) += tmpBlock[0][1];
-            *crsmat->wbloc(offd3 + (*it)[0], offd3 + (*it)[2],true) += tmpBlock[0][2];
-            *crsmat->wbloc(offd3 + (*it)[0], offd3 + (*it)[3],true) += tmpBlock[0][3];
-
-            *crsmat->wbloc(offd3 + (*it)[1], offd3 + (*it)[0],true) += tmpBlock[1][0];
-            *crsmat->wbloc(offd3 + (*it)[1], offd3 + (*it)[1],true) += tmpBlock[1][1];
-            *crsmat->wbloc(offd3 + (*it)[1], offd3 + (*it)[2],true) += tmpBlock[1][2];
-            *crsmat->wbloc(offd3 + (*it)[1], offd3 + (*it)[3],true) += tmpBlock[1][3];
-
-            *crsmat->wbloc(offd3 + (*it)[2], offd3 + (*it)[0],true) += tmpBlock[2][0];
-            *crsmat->wbloc(offd3 + (*it)[2], offd3 + (*it)[1],true) += tmpBlock[2][1];
-            *crsmat->wbloc(offd3 + (*it)[2], offd3 + (*it)[2],true) += tmpBlock[2][2];
-            *crsmat->wbloc(offd3 + (*it)[2], offd3 + (*it)[3],true) += tmpBlock[2][3];
-
-            *crsmat->wbloc(offd3 + (*it)[3], offd3 + (*it)[0],true) += tmpBlock[3][0];
-            *crsmat->wbloc(offd3 + (*it)[3], offd3 + (*it)[1],true) += tmpBlock[3][1];
-            *crsmat->wbloc(offd3 + (*it)[3], offd3 + (*it)[2],true) += tmpBlock[3][2];
-            *crsmat->wbloc(offd3 + (*it)[3], offd3 + (*it)[3],true) += tmpBlock[3][3];
-        }
-    }
-    else
-    {
-        for(it = _indexedElements->begin(), IT=0 ; it != _indexedElements->end() ; ++it,++IT)
+        // one 3x3 block per pair of nodes, added at once in the matrices storing blocks
+        for (n1=0; n1<4; n1++)
         {
-            if (method == SMALL)
-                computeStiffnessMatrix(JKJt,tmp,materialsStiffnesses[IT], strainDisplacements[IT],Rot);
-            else
-                computeStiffnessMatrix(JKJt,tmp,materialsStiffnesses[IT], strainDisplacements[IT],rotations[IT]);
-
-            // find index of node 1
-            for (n1=0; n1<4; n1++)
+            for (n2=0; n2<4; n2++)
             {
-                noeud1 = (*it)[n1];
-
                 for(i=0; i<3; i++)
-                {
-                    ROW = offset+3*noeud1+i;
-                    row = 3*n1+i;
-                    // find index of node 2
-                    for (n2=0; n2<4; n2++)
-                    {
-                        noeud2 = (*it)[n2];
-
-                        for (j=0; j<3; j++)
-                        {
-                            COLUMN = offset+3*noeud2+j;
-                            column = 3*n2+j;
-                            mat->add(ROW, COLUMN, - tmp[row][column]*k);
-//                                                        cerr<<"TetrahedronFEMForceField<DataTypes>::addKToMatrix, k= " << k << ", value = " << - tmp[row][column]*k <<", ROW = "<< ROW << ", COLUMN = "<< COLUMN << endl << *mat << endl;
-//                                                        cerr<<"TetrahedronFEMForceField<DataTypes>::addKToMatrix, k= " << k << ", value = " << - tmp[row][column]*k <<", ROW = "<< ROW << ", COLUMN = "<< COLUMN << endl ;
-                        }
-                    }
-                }
+                    for (j=0; j<3; j++)
+                        tmpBlock[i][j] = - tmp[n1*3+i][n2*3+j]*k;
+                mat->addBlock33(offset + 3*(*it)[n1], offset + 3*(*it)[n2], tmpBlock);
             }
         }
-
     }
-    //std::cout << this->getName() << " M = " << *mat << std::endl;
 }
 
 template<class DataTypes>
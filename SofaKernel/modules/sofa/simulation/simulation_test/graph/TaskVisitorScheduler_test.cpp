@@ -0,0 +1,189 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2016 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU General Public License as published by the Free  *
+* Software Foundation; either version 2 of the License, or (at your option)   *
+* any later version.                                                          *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for    *
+* more details.                                                               *
+*                                                                             *
+* You should have received a copy of the GNU General Public License along     *
+* with this program; if not, write to the Free Software Foundation, Inc., 51  *
+* Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA.                   *
+*******************************************************************************
+*                            SOFA :: Applications                             *
+*                                                                             *
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <SofaTest/Sofa_test.h>
+#include <SofaSimulationGraph/DAGSimulation.h>
+#include <SofaSimulationCommon/SceneLoaderXML.h>
+#include <SofaBaseMechanics/MechanicalObject.h>
+#include <SofaBaseMechanics/IdentityMapping.h>
+
+#include <sofa/simulation/Node.h>
+#include <sofa/simulation/TaskScheduler.h>
+#include <sofa/simulation/TaskVisitorScheduler.h>
+
+namespace sofa {
+
+using simulation::Node;
+using simulation::TaskVisitorScheduler;
+typedef component::container::MechanicalObject<defaulttype::Vec3dTypes> MechanicalObject3;
+typedef component::mapping::IdentityMapping<defaulttype::Vec3dTypes, defaulttype::Vec3dTypes> IdentityMapping3;
+
+/// Gives access to the groups cached by the scheduler
+struct CachingTaskVisitorScheduler : public TaskVisitorScheduler
+{
+    using TaskVisitorScheduler::ChildGroups;
+    using TaskVisitorScheduler::getChildGroups;
+};
+
+/** Test the parallel traversal of independent subtrees by TaskVisitorScheduler.
+
+  The root node contains a solver animating four children:
+  A and B are independent objects, each with a mapped child,
+  D is mapped from the state of C, so C and D must be visited together.
+*/
+struct TaskVisitorScheduler_test : public Sofa_test<SReal>
+{
+    TaskVisitorScheduler_test()
+    {
+        sofa::simulation::setSimulation(new simulation::graph::DAGSimulation());
+    }
+
+    ~TaskVisitorScheduler_test()
+    {
+        simulation::TaskScheduler::getInstance().stop();
+    }
+
+    static std::string object(const std::string& name)
+    {
+        return
+            "   <Node name='" + name + "'> "
+            "       <MechanicalObject name='dofs' position='0 0 0  1 0 0  0 1 0' velocity='0 1 0  1 0 0  0 0 -1'/> "
+            "       <UniformMass totalMass='1'/> "
+            "       <RestShapeSpringsForceField stiffness='100'/> "
+            "       <Node name='" + name + "1'> "
+            "           <MechanicalObject/> "
+            "           <UniformMass totalMass='0.5'/> "
+            "           <IdentityMapping/> "
+            "       </Node> "
+            "   </Node> ";
+    }
+
+    static Node::SPtr createScene(bool parallel)
+    {
+        std::string scene =
+            "<?xml version='1.0'?>"
+            "<Node name='root' gravity='0 -9.81 0' dt='0.01'> "
+            + std::string(parallel ? "<TaskVisitorScheduler nbThreads='4'/> " : "") +
+            "   <EulerImplicitSolver rayleighStiffness='0.1' rayleighMass='0.1'/> "
+            "   <CGLinearSolver iterations='50' tolerance='1e-12' threshold='1e-12'/> "
+            + object("A") + object("B") + object("C") +
+            "   <Node name='D'> "
+            "       <MechanicalObject/> "
+            "       <UniformMass totalMass='0.5'/> "
+            "       <IdentityMapping input='@../C/dofs' output='@./'/> "
+            "   </Node> "
+            "</Node> ";
+
+        Node::SPtr root = simulation::SceneLoaderXML::loadFromMemory("TaskVisitorScheduler", scene.c_str(), scene.size());
+        simulation::getSimulation()->init(root.get());
+        return root;
+    }
+
+    static const MechanicalObject3::VecCoord& positions(Node* root, const std::string& path)
+    {
+        MechanicalObject3* dofs = NULL;
+        root->getChild(path)->get(dofs);
+        return dofs->x.getValue();
+    }
+};
+
+TEST_F( TaskVisitorScheduler_test, groupIndependentChildren)
+{
+    Node::SPtr root = createScene(true);
+
+    helper::vector<Node*> children;
+    for (unsigned int i=0; i<root->child.size(); ++i)
+        children.push_back(root->child[i].get());
+
+    helper::vector< helper::vector<unsigned int> > groups;
+    ASSERT_TRUE(TaskVisitorScheduler::groupIndependentChildren(children, groups));
+    ASSERT_EQ(3u, groups.size());
+    EXPECT_EQ(1u, groups[0].size());
+    EXPECT_EQ(0u, groups[0][0]);
+    EXPECT_EQ(1u, groups[1].size());
+    EXPECT_EQ(1u, groups[1][0]);
+    ASSERT_EQ(2u, groups[2].size());
+    EXPECT_EQ(2u, groups[2][0]);
+    EXPECT_EQ(3u, groups[2][1]);
+}
+
+TEST_F( TaskVisitorScheduler_test, cachedGroupsFollowGraphChanges)
+{
+    Node::SPtr root = createScene(true);
+    helper::vector<Node*> children;
+    for (unsigned int i=0; i<root->child.size(); ++i)
+        children.push_back(root->child[i].get());
+
+    CachingTaskVisitorScheduler scheduler;
+    const CachingTaskVisitorScheduler::ChildGroups& groups = scheduler.getChildGroups(root.get(), false, children);
+    ASSERT_TRUE(groups.independent);
+    EXPECT_EQ(3u, groups.groups.size());
+    EXPECT_EQ(&groups, &scheduler.getChildGroups(root.get(), false, children));
+
+    // B gets a child mapped from the state of A, the children of the root are the same but A and B are now dependent
+    const unsigned int revision = Node::getGraphRevision();
+    MechanicalObject3* dofsA = NULL;
+    root->getChild("A")->get(dofsA);
+    Node::SPtr mapped = root->getChild("B")->createChild("BA");
+    MechanicalObject3::SPtr dofs = core::objectmodel::New<MechanicalObject3>();
+    mapped->addObject(dofs);
+    IdentityMapping3::SPtr mapping = core::objectmodel::New<IdentityMapping3>();
+    mapping->setModels(dofsA, dofs.get());
+    mapped->addObject(mapping);
+    EXPECT_NE(revision, Node::getGraphRevision());
+
+    const CachingTaskVisitorScheduler::ChildGroups& updated = scheduler.getChildGroups(root.get(), false, children);
+    ASSERT_TRUE(updated.independent);
+    ASSERT_EQ(2u, updated.groups.size());
+    ASSERT_EQ(2u, updated.groups[0].size());
+    EXPECT_EQ(0u, updated.groups[0][0]);
+    EXPECT_EQ(1u, updated.groups[0][1]);
+}
+
+TEST_F( TaskVisitorScheduler_test, sameResultAsSequentialTraversal)
+{
+    Node::SPtr sequentialRoot = createScene(false);
+    Node::SPtr parallelRoot = createScene(true);
+    ASSERT_TRUE(parallelRoot->visitorScheduler.get() != NULL);
+
+    for (int step=0; step<20; ++step)
+    {
+        simulation::getSimulation()->animate(sequentialRoot.get(), 0.01);
+        simulation::getSimulation()->animate(parallelRoot.get(), 0.01);
+    }
+
+    const char* nodes[] = { "A", "B", "C", "D" };
+    for (unsigned int i=0; i<4; ++i)
+    {
+        const MechanicalObject3::VecCoord& expected = positions(sequentialRoot.get(), nodes[i]);
+        const MechanicalObject3::VecCoord& actual = positions(parallelRoot.get(), nodes[i]);
+        ASSERT_EQ(expected.size(), actual.size());
+        for (unsigned int j=0; j<expected.size(); ++j)
+            EXPECT_EQ(expected[j], actual[j]) << nodes[i] << "[" << j << "]";
+    }
+    // the objects actually moved
+    EXPECT_NE(MechanicalObject3::Coord(0,0,0), positions(parallelRoot.get(), "A")[0]);
+}
+
+}// namespace sofa
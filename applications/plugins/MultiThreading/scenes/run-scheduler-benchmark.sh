@@ -0,0 +1,34 @@
+#!/bin/bash
+# Time the AnimationLoopParallelScheduler scenes for several thread counts.
+#
+# usage: run-scheduler-benchmark.sh runSofa [runSofa-reference] [iterations]
+#
+# Give the runSofa of a build made before the scheduler moved to
+# SofaSimulationCore as second argument to compare both schedulers
+# (boost scheduler, capped at 16 threads, vs work-stealing scheduler).
+
+NEW=$1
+OLD=$2
+ITERATIONS=${3:-500}
+SCENEDIR=$(cd "$(dirname "$0")" && pwd)
+TMPDIR=$(mktemp -d)
+
+if [ -z "$NEW" ]; then
+    echo "usage: $0 runSofa [runSofa-reference] [iterations]"
+    exit 1
+fi
+
+for scene in livers TriangularForceFieldComparison;
+do
+for threads in 1 2 4 8 16 32 64;
+do
+    sed "s/threadNumber=\"[0-9]*\"/threadNumber=\"$threads\"/" $SCENEDIR/$scene.scn > $TMPDIR/$scene-$threads.scn
+    for bin in $OLD $NEW;
+    do
+        echo "$scene - $threads threads - $bin"
+        $bin -g batch -n $ITERATIONS -l MultiThreading $TMPDIR/$scene-$threads.scn 2>&1 | grep "iterations done"
+    done
+done
+done
+
+rm -rf $TMPDIR
@@ -1,6 +1,6 @@
 #include "AnimationLoopParallelScheduler.h"
 
-#include "TaskSchedulerBoost.h"
+#include <sofa/simulation/TaskScheduler.h>
 #include "AnimationLoopTasks.h"
 #include "DataExchange.h"
 
@@ -184,11 +184,10 @@ namespace simulation
 
 		boost::pool<> task_pool(sizeof(InitPerThreadDataTask));
 
-		//volatile long atomicCounter = TaskScheduler::getInstance().size();// mNbThread;
-		helper::system::atomic<int> atomicCounter( TaskScheduler::getInstance().size() );
+		std::atomic<int> atomicCounter( TaskScheduler::getInstance().size() );
 
 
-		boost::mutex  InitPerThreadMutex;
+		std::mutex  InitPerThreadMutex;
 
 		Task::Status status;
 
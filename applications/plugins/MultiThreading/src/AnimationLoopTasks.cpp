@@ -6,7 +6,8 @@
 #include <sofa/core/MechanicalParams.h>
 #include <sofa/core/visual/VisualParams.h>
 #include <sofa/helper/AdvancedTimer.h>
-//#include <sofa/helper/system/atomic.h>
+
+#include <thread>
 
 namespace sofa
 {
@@ -37,8 +38,7 @@ namespace simulation
 
 
 	
-		//InitPerThreadDataTask::InitPerThreadDataTask(volatile long* atomicCounter, boost::mutex* mutex, TaskStatus* pStatus ) 
-		InitPerThreadDataTask::InitPerThreadDataTask(helper::system::atomic<int>* atomicCounter, boost::mutex* mutex, Task::Status* pStatus ) 
+		InitPerThreadDataTask::InitPerThreadDataTask(std::atomic<int>* atomicCounter, std::mutex* mutex, Task::Status* pStatus ) 
 			: Task(pStatus), IdFactorygetIDMutex(mutex), mAtomicCounter(atomicCounter) 
 		{}
 
@@ -62,7 +62,7 @@ namespace simulation
 			//std::stack<AdvancedTimer::IdTimer>& getCurTimer();
 			{	
 				// to solve IdFactory<Base>::getID() problem in AdvancedTimer functions
-				boost::lock_guard<boost::mutex> lock(*IdFactorygetIDMutex);
+				std::lock_guard<std::mutex> lock(*IdFactorygetIDMutex);
 
 				//spinMutexLock lock( IdFactorygetIDMutex );
 
@@ -79,10 +79,10 @@ namespace simulation
 			--(*mAtomicCounter);
 
 
-			while(mAtomicCounter->operator int() > 0)  
+			while(mAtomicCounter->load() > 0)  
 			{  
 				// yield while waiting  
-				boost::this_thread::yield();
+				std::this_thread::yield();
 			}  
 			return false;
 		}  
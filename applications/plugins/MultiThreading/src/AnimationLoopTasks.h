@@ -25,9 +25,10 @@
 #ifndef AnimationLoopTasks_h__
 #define AnimationLoopTasks_h__
 
-#include "TaskSchedulerBoost.h"
+#include <sofa/simulation/TaskScheduler.h>
 
-#include <sofa/helper/system/atomic.h>
+#include <atomic>
+#include <mutex>
 
 namespace sofa
 {
@@ -74,8 +75,7 @@ namespace simulation
 
 	public:
 
-		//InitPerThreadDataTask(volatile long* atomicCounter, boost::mutex* mutex, TaskStatus* pStatus );
-		InitPerThreadDataTask(helper::system::atomic<int>* atomicCounter, boost::mutex* mutex, Task::Status* pStatus );
+		InitPerThreadDataTask(std::atomic<int>* atomicCounter, std::mutex* mutex, Task::Status* pStatus );
 		
 		virtual ~InitPerThreadDataTask();
 
@@ -84,10 +84,9 @@ namespace simulation
 
 	private:
 
-		boost::mutex*	 IdFactorygetIDMutex;
+		std::mutex*	 IdFactorygetIDMutex;
 
-		//volatile long* mAtomicCounter;
-		helper::system::atomic<int>* mAtomicCounter;
+		std::atomic<int>* mAtomicCounter;
 
 	};
 
@@ -29,7 +29,7 @@
 #include <SofaMiscMapping/BeamLinearMapping.h>
 
 
-#include "TaskSchedulerBoost.h"
+#include <sofa/simulation/TaskScheduler.h>
 
 
 
@@ -29,6 +29,8 @@
 
 #include "BeamLinearMapping_tasks.inl"
 
+#include <boost/pool/pool.hpp>
+
 
 namespace sofa
 {
@@ -500,6 +500,7 @@ void PersistentFrictionContact<TCollisionModel1,TCollisionModel2>::activateConst
         }
 
         this->m_constraint = new constraintset::PersistentUnilateralInteractionConstraint<Vec3Types>(mmodel1, mmodel2);
+        this->m_constraint->setGlobalContactIds(true);
 
         if (this->f_printLog.getValue())
         {
@@ -667,7 +668,7 @@ void PersistentFrictionContact<TCollisionModel1,TCollisionModel2>::createRespons
                 typedef constraintset::PersistentUnilateralInteractionConstraint<Vec3Types> PersistentConstraint;
                 PersistentConstraint *persistent_constraint = static_cast< PersistentConstraint * >(this->m_constraint.get());
 
-                persistent_constraint->addContact(mu_, o->normal, distance, index1, index2, index, o->id);
+                persistent_constraint->addContact(mu_, o->normal, distance, index1, index2, index, constraintset::ConstraintWarmStart::contactKey(*o));
 
                 persistent_constraint->setInitForce(index, initForce);
 
@@ -0,0 +1,381 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2016 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU General Public License as published by the Free  *
+* Software Foundation; either version 2 of the License, or (at your option)   *
+* any later version.                                                          *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for    *
+* more details.                                                               *
+*                                                                             *
+* You should have received a copy of the GNU General Public License along     *
+* with this program; if not, write to the Free Software Foundation, Inc., 51  *
+* Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA.                   *
+*******************************************************************************
+*                            SOFA :: Applications                             *
+*                                                                             *
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <SofaSimulationGraph/DAGSimulation.h>
+#include <SofaSimulationGraph/DAGNode.h>
+#include <SofaBaseMechanics/MechanicalObject.h>
+#include <SofaBaseCollision/SphereModel.h>
+#include <SofaBaseTopology/MeshTopology.h>
+#include <SofaMeshCollision/TriangleModel.h>
+#include <SofaMeshCollision/LineModel.h>
+#include <SofaMeshCollision/PointModel.h>
+#include <SofaBaseCollision/NewProximityIntersection.h>
+#include <SofaBaseCollision/BruteForceDetection.h>
+#include <SofaBaseCollision/SpatialHashDetection.h>
+#include <SofaGeneralMeshCollision/DirectSAP.h>
+#include <SofaGeneralMeshCollision/IncrSAP.h>
+#include <SofaGeneralMeshCollision/BVHDetection.h>
+#include <sofa/simulation/TaskScheduler.h>
+#include <sofa/helper/system/thread/CTime.h>
+#include <sofa/helper/ArgumentParser.h>
+#include <sofa/helper/RandomGenerator.h>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <cmath>
+
+using sofa::helper::system::thread::CTime;
+using sofa::helper::system::thread::ctime_t;
+using namespace sofa::component::collision;
+
+// Micro-benchmark of the collision detection components, on clouds of spheres
+// of which a part moves at each step, as DefaultPipeline would run them.
+// With --cloth, it measures instead the self-collision of a folded sheet of
+// triangles, with and without the vectorized proximity tests.
+
+typedef sofa::defaulttype::Vec3Types DataTypes;
+typedef sofa::component::container::MechanicalObject<DataTypes> MechanicalObject;
+typedef DataTypes::VecCoord VecCoord;
+typedef DataTypes::Coord Coord;
+
+/// Depth of the bounding trees used by DefaultPipeline
+const int PIPELINE_DEPTH = 6;
+
+struct Cloud
+{
+    MechanicalObject::SPtr dofs;
+    SphereModel::SPtr spheres;
+};
+
+/// Collision models and their moving degrees of freedom
+struct Scene
+{
+    sofa::helper::vector<MechanicalObject*> dofs;
+    sofa::helper::vector<sofa::core::CollisionModel*> models;
+};
+
+Cloud createCloud(sofa::simulation::Node* root, const char* name, unsigned int size, double extent, sofa::helper::RandomGenerator& random)
+{
+    sofa::simulation::Node::SPtr node = root->createChild(name);
+    Cloud cloud;
+    cloud.dofs = sofa::core::objectmodel::New<MechanicalObject>();
+    cloud.dofs->resize(size);
+    {
+        VecCoord& x = *cloud.dofs->write(sofa::core::VecCoordId::position())->beginEdit();
+        for (unsigned int i=0; i<size; ++i)
+            x[i] = Coord((SReal)random.random(0.0, extent), (SReal)random.random(0.0, extent), (SReal)random.random(0.0, extent));
+        cloud.dofs->write(sofa::core::VecCoordId::position())->endEdit();
+    }
+    node->addObject(cloud.dofs);
+
+    cloud.spheres = sofa::core::objectmodel::New<SphereModel>();
+    cloud.spheres->defaultRadius.setValue(1.0);
+    cloud.spheres->setSelfCollision(true);
+    node->addObject(cloud.spheres);
+    return cloud;
+}
+
+/// Sheet of size x size squares, each one split in 2 triangles, folded in accordion so that
+/// its layers are closer than the alarm distance
+Scene createCloth(sofa::simulation::Node* root, unsigned int size, double alarmDist)
+{
+    sofa::simulation::Node::SPtr node = root->createChild("cloth");
+    MechanicalObject::SPtr dofs = sofa::core::objectmodel::New<MechanicalObject>();
+    const unsigned int nbFolds = 8;
+    const double width = (double)size / nbFolds;
+    dofs->resize((size+1)*(size+1));
+    {
+        VecCoord& x = *dofs->write(sofa::core::VecCoordId::position())->beginEdit();
+        for (unsigned int j=0; j<=size; ++j)
+        {
+            const unsigned int layer = std::min(j*nbFolds/size, nbFolds-1);
+            const double t = (double)j - layer*width;
+            const double y = (layer%2 == 0) ? t : width-t;
+            for (unsigned int i=0; i<=size; ++i)
+                x[j*(size+1)+i] = Coord((SReal)i, (SReal)y, (SReal)(layer*0.8*alarmDist));
+        }
+        dofs->write(sofa::core::VecCoordId::position())->endEdit();
+    }
+    node->addObject(dofs);
+
+    sofa::component::topology::MeshTopology::SPtr topology = sofa::core::objectmodel::New<sofa::component::topology::MeshTopology>();
+    for (unsigned int j=0; j<size; ++j)
+        for (unsigned int i=0; i<size; ++i)
+        {
+            const int p = j*(size+1)+i;
+            topology->addTriangle(p, p+1, p+size+2);
+            topology->addTriangle(p, p+size+2, p+size+1);
+        }
+    for (unsigned int j=0; j<=size; ++j)
+        for (unsigned int i=0; i<=size; ++i)
+        {
+            const int p = j*(size+1)+i;
+            if (i < size) topology->addEdge(p, p+1);
+            if (j < size) topology->addEdge(p, p+size+1);
+            if (i < size && j < size) topology->addEdge(p, p+size+2);
+        }
+    node->addObject(topology);
+
+    TriangleModel::SPtr triangles = sofa::core::objectmodel::New<TriangleModel>();
+    LineModel::SPtr lines = sofa::core::objectmodel::New<LineModel>();
+    PointModel::SPtr points = sofa::core::objectmodel::New<PointModel>();
+    node->addObject(triangles);
+    node->addObject(lines);
+    node->addObject(points);
+
+    Scene scene;
+    scene.dofs.push_back(dofs.get());
+    scene.models.push_back(triangles.get());
+    scene.models.push_back(lines.get());
+    scene.models.push_back(points.get());
+    for (unsigned int m=0; m<scene.models.size(); ++m)
+        scene.models[m]->setSelfCollision(true);
+    return scene;
+}
+
+/// Move randomly the given fraction of the points, by at most step
+void moveDofs(MechanicalObject* dofs, double fraction, double step, sofa::helper::RandomGenerator& random)
+{
+    VecCoord& x = *dofs->write(sofa::core::VecCoordId::position())->beginEdit();
+    for (unsigned int i=0; i<x.size(); ++i)
+    {
+        if (random.random(0.0, 1.0) < fraction)
+            x[i] += Coord((SReal)random.random(-step, step), (SReal)random.random(-step, step), (SReal)random.random(-step, step));
+    }
+    dofs->write(sofa::core::VecCoordId::position())->endEdit();
+}
+
+/// Run the given number of collision detections with moving points, and return the average time in milliseconds.
+/// The number of contacts found during the last step is stored in nbContacts.
+template<class Detection>
+double timeDetection(const char* name, Detection* detection, NewProximityIntersection* intersection,
+                     Scene& scene, unsigned int iterations, double fraction, double step, unsigned int& nbContacts)
+{
+    detection->setName(name);
+    detection->setIntersectionMethod(intersection);
+    detection->init();
+
+    // same motion for all the detections
+    sofa::helper::RandomGenerator random(0);
+    const int depth = detection->needsDeepBoundingTree() ? PIPELINE_DEPTH : 0;
+
+    ctime_t total = 0;
+    for (unsigned int it=0; it<iterations; ++it)
+    {
+        for (unsigned int d=0; d<scene.dofs.size(); ++d)
+            moveDofs(scene.dofs[d], fraction, step, random);
+
+        const ctime_t start = CTime::getRefTime();
+        for (unsigned int m=0; m<scene.models.size(); ++m)
+            scene.models[m]->computeBoundingTree(depth);
+
+        detection->beginBroadPhase();
+        for (unsigned int m=0; m<scene.models.size(); ++m)
+            detection->addCollisionModel(scene.models[m]->getFirst());
+        detection->endBroadPhase();
+
+        detection->beginNarrowPhase();
+        detection->addCollisionPairs(detection->getCollisionModelPairs());
+        detection->endNarrowPhase();
+        total += CTime::getRefTime() - start;
+    }
+
+    nbContacts = 0;
+    const sofa::core::collision::NarrowPhaseDetection::DetectionOutputMap& outputs = detection->getDetectionOutputs();
+    for (sofa::core::collision::NarrowPhaseDetection::DetectionOutputMap::const_iterator it = outputs.begin(); it != outputs.end(); ++it)
+        if (it->second)
+            nbContacts += it->second->size();
+
+    return 1000.0 * (double)total / (double)CTime::getRefTicksPerSec() / (double)iterations;
+}
+
+/// Reset the positions of the points before each detection
+void resetScene(Scene& scene, const sofa::helper::vector<VecCoord>& initialPositions)
+{
+    for (unsigned int d=0; d<scene.dofs.size(); ++d)
+        scene.dofs[d]->write(sofa::core::VecCoordId::position())->setValue(initialPositions[d]);
+}
+
+struct Result
+{
+    std::string name;
+    double time;
+    unsigned int nbContacts;
+};
+
+/// Time the given detection, from the initial positions of the points
+template<class Detection>
+Result runDetection(const std::string& name, Detection* detection, NewProximityIntersection* intersection, Scene& scene,
+                    const sofa::helper::vector<VecCoord>& initialPositions, unsigned int iterations, double fraction, double step)
+{
+    resetScene(scene, initialPositions);
+    Result result;
+    result.name = name;
+    result.time = timeDetection(name.c_str(), detection, intersection, scene, iterations, fraction, step, result.nbContacts);
+    return result;
+}
+
+/// Self-collision of a folded cloth, with the scalar and the vectorized proximity tests
+void runCloth(sofa::simulation::Node* root, unsigned int size, unsigned int iterations, double fraction, double step, unsigned int threads)
+{
+    NewProximityIntersection::SPtr intersection = sofa::core::objectmodel::New<NewProximityIntersection>();
+    intersection->setAlarmDistance(0.1);
+    intersection->setContactDistance(0.05);
+    root->addObject(intersection);
+
+    Scene scene = createCloth(root, size, intersection->getAlarmDistance());
+    sofa::simulation::getSimulation()->init(root);
+
+    sofa::helper::vector<VecCoord> initialPositions;
+    initialPositions.push_back(scene.dofs[0]->read(sofa::core::ConstVecCoordId::position())->getValue());
+
+    std::cout << "cloth of " << scene.models[0]->getSize() << " triangles, " << fraction*100 << "% of the points moving, "
+              << iterations << " collision detections" << std::endl;
+
+    sofa::helper::vector<Result> results;
+    intersection->d_vectorized.setValue(false);
+    results.push_back(runDetection("BVHDetection", sofa::core::objectmodel::New<BVHDetection>().get(), intersection.get(), scene, initialPositions, iterations, fraction, step));
+    intersection->d_vectorized.setValue(true);
+    results.push_back(runDetection("BVHDetection, vectorized", sofa::core::objectmodel::New<BVHDetection>().get(), intersection.get(), scene, initialPositions, iterations, fraction, step));
+    results.push_back(runDetection("SpatialHashDetection, vectorized", sofa::core::objectmodel::New<SpatialHashDetection>().get(), intersection.get(), scene, initialPositions, iterations, fraction, step));
+
+    if (threads > 1)
+    {
+        sofa::simulation::TaskScheduler::getInstance().start(threads);
+        BVHDetection::SPtr bvhParallel = sofa::core::objectmodel::New<BVHDetection>();
+        bvhParallel->d_parallel.setValue(true);
+        std::ostringstream name;
+        name << "BVHDetection, vectorized, " << threads << " threads";
+        results.push_back(runDetection(name.str(), bvhParallel.get(), intersection.get(), scene, initialPositions, iterations, fraction, step));
+        SpatialHashDetection::SPtr hashParallel = sofa::core::objectmodel::New<SpatialHashDetection>();
+        hashParallel->d_parallel.setValue(true);
+        name.str("");
+        name << "SpatialHashDetection, vectorized, " << threads << " threads";
+        results.push_back(runDetection(name.str(), hashParallel.get(), intersection.get(), scene, initialPositions, iterations, fraction, step));
+        sofa::simulation::TaskScheduler::getInstance().stop();
+    }
+
+    for (unsigned int i=0; i<results.size(); ++i)
+        std::cout << results[i].name << ": " << results[i].time << " ms (x" << results[0].time/results[i].time << "), "
+                  << results[i].nbContacts << " contacts" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    unsigned int size = 2000;
+    unsigned int nbClouds = 2;
+    unsigned int iterations = 20;
+    double fraction = 0.2;
+    double step = -1;
+    unsigned int threads = 0;
+    unsigned int cloth = 0;
+
+    sofa::helper::parse(
+        "Micro-benchmark of the collision detection components (BruteForceDetection, "
+        "DirectSAP, IncrSAP, BVHDetection, SpatialHashDetection) on clouds of moving spheres, or on a folded cloth.")
+    .option(&size,       's', "size",       "number of spheres per cloud (default: 2000)")
+    .option(&nbClouds,   'c', "clouds",     "number of clouds, i.e. of collision models (default: 2)")
+    .option(&iterations, 'n', "iterations", "number of collision detections (default: 20)")
+    .option(&fraction,   'f', "fraction",   "fraction of the spheres moving at each step (default: 0.2)")
+    .option(&step,       'd', "step",       "maximum displacement of a moving sphere along each axis (default: 0.5, 0.005 with --cloth)")
+    .option(&threads,    't', "threads",    "also measure the multithreaded BVH and grid traversals with this number of threads (default: 0 -> no)")
+    .option(&cloth,      'm', "cloth",      "measure instead the self-collision of a folded cloth of this resolution (default: 0 -> no)")
+    (argc, argv);
+
+    sofa::simulation::setSimulation(new sofa::simulation::graph::DAGSimulation());
+    sofa::simulation::Node::SPtr root = sofa::simulation::getSimulation()->createNewGraph("root");
+
+    if (cloth > 0)
+    {
+        runCloth(root.get(), cloth, iterations, fraction, step < 0 ? 0.005 : step, threads);
+        sofa::simulation::getSimulation()->unload(root);
+        return 0;
+    }
+    if (step < 0)
+        step = 0.5;
+
+    // about 10% of the volume filled with spheres of radius 1
+    sofa::helper::RandomGenerator random(0);
+    const double extent = std::pow(4.19 * size * nbClouds / 0.1, 1.0/3.0);
+    Scene clouds;
+    for (unsigned int c=0; c<nbClouds; ++c)
+    {
+        std::ostringstream name;
+        name << "cloud" << c;
+        Cloud cloud = createCloud(root.get(), name.str().c_str(), size, extent, random);
+        clouds.dofs.push_back(cloud.dofs.get());
+        clouds.models.push_back(cloud.spheres.get());
+    }
+
+    NewProximityIntersection::SPtr intersection = sofa::core::objectmodel::New<NewProximityIntersection>();
+    intersection->setAlarmDistance(0.1);
+    intersection->setContactDistance(0.05);
+    root->addObject(intersection);
+
+    sofa::simulation::getSimulation()->init(root.get());
+
+    sofa::helper::vector<VecCoord> initialPositions;
+    for (unsigned int c=0; c<clouds.dofs.size(); ++c)
+        initialPositions.push_back(clouds.dofs[c]->read(sofa::core::ConstVecCoordId::position())->getValue());
+
+    std::cout << nbClouds << " clouds of " << size << " spheres, " << fraction*100 << "% moving, "
+              << iterations << " collision detections" << std::endl;
+
+    // BruteForceDetection is run last: the deep bounding trees it needs sort the leaf cubes of the models,
+    // which DirectSAP and IncrSAP do not expect
+    sofa::helper::vector<Result> results;
+    results.push_back(runDetection("DirectSAP", sofa::core::objectmodel::New<DirectSAP>().get(), intersection.get(), clouds, initialPositions, iterations, fraction, step));
+    results.push_back(runDetection("IncrSAP", sofa::core::objectmodel::New<IncrSAP>().get(), intersection.get(), clouds, initialPositions, iterations, fraction, step));
+
+    BVHDetection::SPtr bvh = sofa::core::objectmodel::New<BVHDetection>();
+    results.push_back(runDetection("BVHDetection", bvh.get(), intersection.get(), clouds, initialPositions, iterations, fraction, step));
+    const int nbRebuilds = bvh->d_nbRebuilds.getValue();
+    results.push_back(runDetection("SpatialHashDetection", sofa::core::objectmodel::New<SpatialHashDetection>().get(), intersection.get(), clouds, initialPositions, iterations, fraction, step));
+
+    if (threads > 1)
+    {
+        sofa::simulation::TaskScheduler::getInstance().start(threads);
+        BVHDetection::SPtr bvhParallel = sofa::core::objectmodel::New<BVHDetection>();
+        bvhParallel->d_parallel.setValue(true);
+        std::ostringstream name;
+        name << "BVHDetection, " << threads << " threads";
+        results.push_back(runDetection(name.str(), bvhParallel.get(), intersection.get(), clouds, initialPositions, iterations, fraction, step));
+        SpatialHashDetection::SPtr hashParallel = sofa::core::objectmodel::New<SpatialHashDetection>();
+        hashParallel->d_parallel.setValue(true);
+        name.str("");
+        name << "SpatialHashDetection, " << threads << " threads";
+        results.push_back(runDetection(name.str(), hashParallel.get(), intersection.get(), clouds, initialPositions, iterations, fraction, step));
+        sofa::simulation::TaskScheduler::getInstance().stop();
+    }
+
+    const Result bruteForce = runDetection("BruteForceDetection", sofa::core::objectmodel::New<BruteForceDetection>().get(), intersection.get(), clouds, initialPositions, iterations, fraction, step);
+    std::cout << bruteForce.name << ": " << bruteForce.time << " ms, " << bruteForce.nbContacts << " contacts" << std::endl;
+    for (unsigned int i=0; i<results.size(); ++i)
+        std::cout << results[i].name << ": " << results[i].time << " ms (x" << bruteForce.time/results[i].time << "), "
+                  << results[i].nbContacts << " contacts" << std::endl;
+    std::cout << "BVHDetection rebuilt " << nbRebuilds << " trees instead of refitting them during the last step" << std::endl;
+
+    sofa::simulation::getSimulation()->unload(root);
+    return 0;
+}
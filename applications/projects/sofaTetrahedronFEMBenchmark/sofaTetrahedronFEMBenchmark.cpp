@@ -0,0 +1,164 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2016 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU General Public License as published by the Free  *
+* Software Foundation; either version 2 of the License, or (at your option)   *
+* any later version.                                                          *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for    *
+* more details.                                                               *
+*                                                                             *
+* You should have received a copy of the GNU General Public License along     *
+* with this program; if not, write to the Free Software Foundation, Inc., 51  *
+* Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA.                   *
+*******************************************************************************
+*                            SOFA :: Applications                             *
+*                                                                             *
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <SofaSimulationGraph/DAGSimulation.h>
+#include <SofaSimulationGraph/DAGNode.h>
+#include <SofaBaseTopology/RegularGridTopology.h>
+#include <SofaBaseMechanics/MechanicalObject.h>
+#include <SofaSimpleFem/TetrahedronFEMForceField.h>
+#include <sofa/core/MechanicalParams.h>
+#include <sofa/simulation/TaskScheduler.h>
+#include <sofa/helper/system/thread/CTime.h>
+#include <sofa/helper/ArgumentParser.h>
+#include <iostream>
+#include <cmath>
+
+using sofa::helper::system::thread::CTime;
+using sofa::helper::system::thread::ctime_t;
+
+// Micro-benchmark of TetrahedronFEMForceField::addForce with the "large" method,
+// comparing the scalar element loop with the batched (vectorized) kernel, on the
+// bar of examples/Benchmark/Performance/Bar16-fem-implicit-Vec3f.pscn.
+
+#ifndef SOFA_DOUBLE
+typedef sofa::defaulttype::Vec3fTypes DataTypes;
+#else
+typedef sofa::defaulttype::Vec3dTypes DataTypes;
+#endif
+typedef sofa::component::container::MechanicalObject<DataTypes> MechanicalObject;
+typedef sofa::component::forcefield::TetrahedronFEMForceField<DataTypes> TetrahedronFEMForceField;
+typedef DataTypes::VecCoord VecCoord;
+typedef DataTypes::VecDeriv VecDeriv;
+
+/// Average time of addForce in milliseconds, and the computed forces
+double timeAddForce(TetrahedronFEMForceField* fem, const sofa::core::objectmodel::Data<VecCoord>& x, unsigned int iterations, VecDeriv& f)
+{
+    const sofa::core::MechanicalParams* mparams = sofa::core::MechanicalParams::defaultInstance();
+    sofa::core::objectmodel::Data<VecDeriv> v, fData;
+    v.setValue(VecDeriv(x.getValue().size()));
+
+    // first call to allocate and initialize what is needed
+    fData.setValue(VecDeriv(x.getValue().size()));
+    fem->addForce(mparams, fData, x, v);
+
+    ctime_t total = 0;
+    for (unsigned int i=0; i<iterations; ++i)
+    {
+        fData.setValue(VecDeriv(x.getValue().size()));
+        const ctime_t start = CTime::getRefTime();
+        fem->addForce(mparams, fData, x, v);
+        total += CTime::getRefTime() - start;
+    }
+    f = fData.getValue();
+    return 1000.0 * (double)total / (double)CTime::getRefTicksPerSec() / (double)iterations;
+}
+
+double maxDifference(const VecDeriv& a, const VecDeriv& b)
+{
+    double d = 0;
+    for (unsigned int i=0; i<a.size(); ++i)
+        d = std::max(d, (double)(a[i]-b[i]).norm());
+    return d;
+}
+
+int main(int argc, char** argv)
+{
+    unsigned int size = 10;
+    unsigned int iterations = 100;
+    unsigned int threads = 0;
+
+    sofa::helper::parse(
+        "Micro-benchmark of the TetrahedronFEMForceField element loop, "
+        "on the 16x16 bar of the Bar16-fem-implicit benchmark.")
+    .option(&size,       's', "size",       "length of the bar, as the s parameter of Bar16-fem-implicit (default: 10)")
+    .option(&iterations, 'n', "iterations", "number of calls to addForce (default: 100)")
+    .option(&threads,    't', "threads",    "also measure the multithreaded loops with this number of threads (default: 0 -> no)")
+    (argc, argv);
+
+    sofa::simulation::setSimulation(new sofa::simulation::graph::DAGSimulation());
+    sofa::simulation::Node::SPtr root = sofa::simulation::getSimulation()->createNewGraph("root");
+
+    sofa::component::topology::RegularGridTopology::SPtr grid = sofa::core::objectmodel::New<sofa::component::topology::RegularGridTopology>();
+    grid->setNumVertices(16, 16, 5*size+1);
+    grid->setPos(0, 3, 0, 3, 0, size);
+    root->addObject(grid);
+
+    MechanicalObject::SPtr dofs = sofa::core::objectmodel::New<MechanicalObject>();
+    root->addObject(dofs);
+
+    TetrahedronFEMForceField::SPtr fem = sofa::core::objectmodel::New<TetrahedronFEMForceField>();
+    fem->f_method.setValue("large");
+    fem->setYoungModulus(24000);
+    fem->setPoissonRatio((TetrahedronFEMForceField::Real)0.3);
+    root->addObject(fem);
+
+    sofa::simulation::getSimulation()->init(root.get());
+
+    // bent and twisted bar
+    sofa::core::objectmodel::Data<VecCoord> x;
+    x.setValue(dofs->read(sofa::core::ConstVecCoordId::position())->getValue());
+    {
+        VecCoord& p = *x.beginEdit();
+        for (unsigned int i=0; i<p.size(); ++i)
+        {
+            const double a = 0.05 * p[i][2];
+            const double px = p[i][0] - 1.5, py = p[i][1] - 1.5;
+            p[i][0] = (DataTypes::Real)(1.5 + std::cos(a)*px - std::sin(a)*py + 0.02*p[i][2]*p[i][2]);
+            p[i][1] = (DataTypes::Real)(1.5 + std::sin(a)*px + std::cos(a)*py);
+        }
+        x.endEdit();
+    }
+
+    std::cout << dofs->getSize() << " nodes, "
+              << grid->getNbTetrahedra() + 6*grid->getNbHexahedra() << " tetrahedra, "
+              << iterations << " calls to addForce" << std::endl;
+
+    VecDeriv fScalar, f;
+    fem->d_vectorized.setValue(false);
+    const double tScalar = timeAddForce(fem.get(), x, iterations, fScalar);
+    std::cout << "scalar:      " << tScalar << " ms" << std::endl;
+
+    fem->d_vectorized.setValue(true);
+    const double tVectorized = timeAddForce(fem.get(), x, iterations, f);
+    std::cout << "vectorized:  " << tVectorized << " ms (x" << tScalar/tVectorized << "), max difference " << maxDifference(fScalar, f) << std::endl;
+
+    if (threads > 1)
+    {
+        sofa::simulation::TaskScheduler::getInstance().start(threads);
+        fem->d_parallel.setValue(true);
+
+        fem->d_vectorized.setValue(false);
+        const double tParallel = timeAddForce(fem.get(), x, iterations, f);
+        std::cout << "scalar, " << threads << " threads:     " << tParallel << " ms (x" << tScalar/tParallel << "), max difference " << maxDifference(fScalar, f) << std::endl;
+
+        fem->d_vectorized.setValue(true);
+        const double tBoth = timeAddForce(fem.get(), x, iterations, f);
+        std::cout << "vectorized, " << threads << " threads: " << tBoth << " ms (x" << tScalar/tBoth << "), max difference " << maxDifference(fScalar, f) << std::endl;
+
+        sofa::simulation::TaskScheduler::getInstance().stop();
+    }
+
+    sofa::simulation::getSimulation()->unload(root);
+    return 0;
+}
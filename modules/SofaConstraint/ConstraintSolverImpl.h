@@ -84,6 +84,65 @@ public:
 
 
 
+class MechanicalGetConstraintInfoVisitor : public simulation::BaseMechanicalVisitor
+{
+public:
+    typedef core::behavior::BaseConstraint::VecConstraintBlockInfo VecConstraintBlockInfo;
+    typedef core::behavior::BaseConstraint::VecPersistentID VecPersistentID;
+    typedef core::behavior::BaseConstraint::VecConstCoord VecConstCoord;
+    typedef core::behavior::BaseConstraint::VecConstDeriv VecConstDeriv;
+    typedef core::behavior::BaseConstraint::VecConstArea VecConstArea;
+
+    MechanicalGetConstraintInfoVisitor(const core::ConstraintParams* params, VecConstraintBlockInfo& blocks, VecPersistentID& ids, VecConstCoord& positions, VecConstDeriv& directions, VecConstArea& areas)
+        : simulation::BaseMechanicalVisitor(params)
+        , _blocks(blocks)
+        , _ids(ids)
+        , _positions(positions)
+        , _directions(directions)
+        , _areas(areas)
+        , _cparams(params)
+    {
+#ifdef SOFA_DUMP_VISITOR_INFO
+        setReadWriteVectors();
+#endif
+    }
+
+    virtual Result fwdConstraintSet(simulation::Node* node, core::behavior::BaseConstraintSet* cSet)
+    {
+        if (core::behavior::BaseConstraint *c=cSet->toBaseConstraint())
+        {
+            ctime_t t0 = begin(node, c);
+            c->getConstraintInfo(_cparams, _blocks, _ids, _positions, _directions, _areas);
+            end(node, c, t0);
+        }
+        return RESULT_CONTINUE;
+    }
+
+
+    // This visitor must go through all mechanical mappings, even if isMechanical flag is disabled
+    virtual bool stopAtMechanicalMapping(simulation::Node* /*node*/, core::BaseMapping* /*map*/)
+    {
+        return false; // !map->isMechanical();
+    }
+
+    /// Return a class name for this visitor
+    /// Only used for debugging / profiling purposes
+    virtual const char* getClassName() const { return "MechanicalGetConstraintInfoVisitor";}
+
+#ifdef SOFA_DUMP_VISITOR_INFO
+    void setReadWriteVectors()
+    {
+    }
+#endif
+private:
+    VecConstraintBlockInfo& _blocks;
+    VecPersistentID& _ids;
+    VecConstCoord& _positions;
+    VecConstDeriv& _directions;
+    VecConstArea& _areas;
+    const core::ConstraintParams* _cparams;
+};
+
 /// Gets the vector of constraint violation values
 class MechanicalGetConstraintViolationVisitor : public simulation::BaseMechanicalVisitor
 {
@@ -0,0 +1,135 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2016 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This library is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This library is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this library; if not, write to the Free Software Foundation,     *
+* Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA.          *
+*******************************************************************************
+*                               SOFA :: Modules                               *
+*                                                                             *
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <SofaConstraint/ConstraintWarmStart.h>
+
+namespace sofa
+{
+
+namespace component
+{
+
+namespace constraintset
+{
+
+namespace
+{
+
+/// Mix the bits of the key with the ones of v (splitmix64 finalizer)
+inline unsigned long long mixKey(unsigned long long key, unsigned long long v)
+{
+    unsigned long long z = key ^ (v + 0x9e3779b97f4a7c15ULL + (key << 6) + (key >> 2));
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+} // anonymous namespace
+
+ConstraintWarmStart::ConstraintWarmStart()
+    : step(0), maxAge(1), nbLookups(0), nbHits(0)
+{
+}
+
+ConstraintWarmStart::PersistentID ConstraintWarmStart::contactKey(const core::collision::DetectionOutput& o)
+{
+    unsigned long long key = 0;
+    key = mixKey(key, (unsigned long long)(std::size_t)o.elem.first.getCollisionModel());
+    key = mixKey(key, (unsigned long long)o.elem.first.getIndex());
+    key = mixKey(key, (unsigned long long)(std::size_t)o.elem.second.getCollisionModel());
+    key = mixKey(key, (unsigned long long)o.elem.second.getIndex());
+    key = mixKey(key, (unsigned long long)o.id);
+    key &= 0x7fffffffffffffffULL;
+    return key ? (PersistentID)key : 1;
+}
+
+unsigned int ConstraintWarmStart::apply(const VecConstraintBlockInfo& blocks, const VecPersistentID& ids, double* force, int dimension)
+{
+    nbLookups = 0;
+    nbHits = 0;
+    for (std::size_t b=0; b<blocks.size(); ++b)
+    {
+        const ConstraintBlockInfo& info = blocks[b];
+        if (!info.hasId || !info.parent) continue;
+        for (int c=0; c<info.nbGroups; ++c)
+        {
+            const int line = info.const0 + c*info.nbLines;
+            if (line + info.nbLines > dimension) break;
+            ++nbLookups;
+
+            std::map<Key, Entry>::const_iterator it = entries.find(Key(info, ids[info.offsetId + c]));
+            if (it == entries.end()) continue;
+            ++nbHits;
+
+            const Entry& e = it->second;
+            const int nbl = (info.nbLines < e.nbLines) ? info.nbLines : e.nbLines;
+            for (int l=0; l<nbl; ++l)
+                force[line + l] = e.force[l];
+        }
+    }
+    return nbHits;
+}
+
+void ConstraintWarmStart::store(const VecConstraintBlockInfo& blocks, const VecPersistentID& ids, const double* force, int dimension)
+{
+    ++step;
+    for (std::size_t b=0; b<blocks.size(); ++b)
+    {
+        const ConstraintBlockInfo& info = blocks[b];
+        if (!info.hasId || !info.parent || info.nbLines > MaxLines) continue;
+        for (int c=0; c<info.nbGroups; ++c)
+        {
+            const int line = info.const0 + c*info.nbLines;
+            if (line + info.nbLines > dimension) break;
+
+            Entry& e = entries[Key(info, ids[info.offsetId + c])];
+            e.nbLines = info.nbLines;
+            e.step = step;
+            for (int l=0; l<info.nbLines; ++l)
+                e.force[l] = force[line + l];
+        }
+    }
+
+    // forget the constraints which disappeared maxAge stores ago
+    for (std::map<Key, Entry>::iterator it = entries.begin(); it != entries.end(); )
+    {
+        if (step - it->second.step >= maxAge)
+            entries.erase(it++);
+        else
+            ++it;
+    }
+}
+
+void ConstraintWarmStart::clear()
+{
+    entries.clear();
+    nbLookups = 0;
+    nbHits = 0;
+}
+
+} // namespace constraintset
+
+} // namespace component
+
+} // namespace sofa
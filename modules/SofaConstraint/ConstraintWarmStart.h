@@ -0,0 +1,128 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2016 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This library is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This library is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this library; if not, write to the Free Software Foundation,     *
+* Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA.          *
+*******************************************************************************
+*                               SOFA :: Modules                               *
+*                                                                             *
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#ifndef SOFA_COMPONENT_CONSTRAINTSET_CONSTRAINTWARMSTART_H
+#define SOFA_COMPONENT_CONSTRAINTSET_CONSTRAINTWARMSTART_H
+#include "config.h"
+
+#include <sofa/core/behavior/BaseConstraint.h>
+#include <sofa/core/collision/DetectionOutput.h>
+
+#include <map>
+
+namespace sofa
+{
+
+namespace component
+{
+
+namespace constraintset
+{
+
+/// Forces of the constraints at the previous time steps, found back from the
+/// persistent ids given by BaseConstraint::getConstraintInfo, and used by the
+/// constraint solvers as initial guess of their Gauss-Seidel iterations.
+///
+/// The ids of a constraint are only compared with the ones of the same constraint
+/// object, unless they are global ids (ConstraintBlockInfo::hasGlobalId), such as
+/// the contact keys computed by contactKey from the colliding elements: they then
+/// survive the re-creation of the contact response. The ids are compared with
+/// their sign, which constraints such as UnilateralInteractionConstraint use to
+/// mark the step where they are created.
+class SOFA_CONSTRAINT_API ConstraintWarmStart
+{
+public:
+    typedef core::behavior::BaseConstraint::PersistentID PersistentID;
+    typedef core::behavior::BaseConstraint::VecPersistentID VecPersistentID;
+    typedef core::behavior::BaseConstraint::ConstraintBlockInfo ConstraintBlockInfo;
+    typedef core::behavior::BaseConstraint::VecConstraintBlockInfo VecConstraintBlockInfo;
+
+    ConstraintWarmStart();
+
+    /// Global key of a contact, computed from the pair of colliding elements and
+    /// the id of the contact between them. It is always positive, so that the
+    /// constraints can still give it negated while they are not integrated yet.
+    static PersistentID contactKey(const core::collision::DetectionOutput& o);
+
+    /// Number of stores during which the force of a constraint is kept after the constraint disappeared (1 by default)
+    void setMaxAge(unsigned int age) { maxAge = (age ? age : 1); }
+    unsigned int getMaxAge() const { return maxAge; }
+
+    /// Copy in force the stored forces of the constraint groups described by blocks and ids,
+    /// and return the number of groups found
+    unsigned int apply(const VecConstraintBlockInfo& blocks, const VecPersistentID& ids, double* force, int dimension);
+
+    /// Store the forces of the constraint groups described by blocks and ids
+    void store(const VecConstraintBlockInfo& blocks, const VecPersistentID& ids, const double* force, int dimension);
+
+    void clear();
+
+    /// Number of constraint groups with a persistent id during the last apply
+    unsigned int getNbLookups() const { return nbLookups; }
+    /// Number of constraint groups found during the last apply
+    unsigned int getNbHits() const { return nbHits; }
+    /// Ratio of the constraint groups found during the last apply
+    double getHitRate() const { return nbLookups ? (double)nbHits / (double)nbLookups : 0.0; }
+
+    /// Number of stored constraint groups
+    std::size_t size() const { return entries.size(); }
+
+protected:
+    enum { MaxLines = 6 };
+
+    struct Key
+    {
+        const core::behavior::BaseConstraint* parent; ///< NULL for global ids
+        PersistentID id;
+
+        Key(const ConstraintBlockInfo& info, PersistentID id)
+            : parent(info.hasGlobalId ? NULL : info.parent), id(id) {}
+
+        bool operator<(const Key& k) const
+        {
+            return (id < k.id) || (id == k.id && parent < k.parent);
+        }
+    };
+
+    struct Entry
+    {
+        double force[MaxLines];
+        int nbLines;
+        unsigned int step; ///< last store this group was seen at
+    };
+
+    std::map<Key, Entry> entries;
+    unsigned int step;
+    unsigned int maxAge;
+    unsigned int nbLookups;
+    unsigned int nbHits;
+};
+
+} // namespace constraintset
+
+} // namespace component
+
+} // namespace sofa
+
+#endif // SOFA_COMPONENT_CONSTRAINTSET_CONSTRAINTWARMSTART_H
@@ -125,6 +125,8 @@ public:
     void createResponse(core::objectmodel::BaseContext* group);
 
     void removeResponse();
+
+    void deactivate();
 };
 
 inline long cantorPolynomia(sofa::core::collision::DetectionOutput::ContactId x, sofa::core::collision::DetectionOutput::ContactId y)
@@ -26,6 +26,7 @@
 #define SOFA_COMPONENT_COLLISION_FRICTIONCONTACT_INL
 
 #include <SofaConstraint/FrictionContact.h>
+#include <SofaConstraint/ConstraintWarmStart.h>
 #include <sofa/core/visual/VisualParams.h>
 #include <SofaBaseCollision/DefaultContactManager.h>
 #include <SofaMeshCollision/BarycentricContactMapper.h>
@@ -145,6 +146,7 @@ void FrictionContact<TCollisionModel1,TCollisionModel2,ResponseDataTypes>::activ
         // Get the mechanical model from mapper2 to fill the constraints vector
         MechanicalState2* mmodel2 = selfCollision ? mmodel1 : mapper2.createMapping(GenerateStirngID::generate().c_str());
         m_constraint = sofa::core::objectmodel::New<constraintset::UnilateralInteractionConstraint<defaulttype::Vec3Types> >(mmodel1, mmodel2);
+        m_constraint->setGlobalContactIds(true);
         m_constraint->setName( getName() );
         setInteractionTags(mmodel1, mmodel2);
         m_constraint->setCustomTolerance( tol.getValue() );
@@ -244,7 +246,7 @@ void FrictionContact<TCollisionModel1,TCollisionModel2,ResponseDataTypes>::creat
             long index = cantorPolynomia(o->id /*cantorPolynomia(index1, index2)*/,id);
 
             // Add contact in unilateral constraint
-            m_constraint->addContact(mu_, o->normal, distance, index1, index2, index, o->id);
+            m_constraint->addContact(mu_, o->normal, distance, index1, index2, index, constraintset::ConstraintWarmStart::contactKey(*o));
         }
 
         if (parent!=NULL)
@@ -280,6 +282,17 @@ void FrictionContact<TCollisionModel1,TCollisionModel2,ResponseDataTypes>::remov
     }
 }
 
+template < class TCollisionModel1, class TCollisionModel2, class ResponseDataTypes  >
+void FrictionContact<TCollisionModel1,TCollisionModel2,ResponseDataTypes>::deactivate()
+{
+    removeResponse();
+    // the detection outputs are owned by the narrow phase and will not survive this step
+    contacts.clear();
+    mappedContacts.clear();
+    if (m_constraint)
+        m_constraint->clear();
+}
+
 template < class TCollisionModel1, class TCollisionModel2, class ResponseDataTypes  >
 void FrictionContact<TCollisionModel1,TCollisionModel2,ResponseDataTypes>::setInteractionTags(MechanicalState1* mstate1, MechanicalState2* mstate2)
 {
@@ -37,7 +37,9 @@
 #include <sofa/helper/gl/Cylinder.h>
 #include <sofa/helper/AdvancedTimer.h>
 #include <sofa/helper/system/thread/CTime.h>
+#include <sofa/simulation/ParallelFor.h>
 #include <math.h>
+#include <algorithm>
 
 #include <sofa/core/ObjectFactory.h>
 
@@ -69,6 +71,13 @@ GenericConstraintSolver::GenericConstraintSolver()
 , currentIterations(initData(&currentIterations, 0, "currentIterations", "OUTPUT: current number of constraint groups"))
 , currentError(initData(&currentError, 0.0, "currentError", "OUTPUT: current error"))
 , reverseAccumulateOrder(initData(&reverseAccumulateOrder, false, "reverseAccumulateOrder", "True to accumulate constraints from nodes in reversed order (can be necessary when using multi-mappings or interaction constraints not following the node hierarchy)"))
+, d_parallel(initData(&d_parallel, false, "parallel", "Solve the constraint groups on several threads (built version only): groups which are not coupled in the compliance get the same color and are solved concurrently, colors being solved one after the other"))
+, d_maxColors(initData(&d_maxColors, 0, "maxColors", "In parallel mode, maximum number of colors (0 for no limit). Coupled groups of a same color are solved with a Jacobi update"))
+, d_currentNumColors(initData(&d_currentNumColors, 0, "currentNumColors", "OUTPUT: current number of colors of constraint groups"))
+, d_warmStart(initData(&d_warmStart, false, "warmStart", "Use the forces of the previous steps as initial guess, the constraints being found back from their persistent ids (such as contact keys computed from the colliding elements)"))
+, d_warmStartMaxAge(initData(&d_warmStartMaxAge, 1, "warmStartMaxAge", "If warmStart is active: number of steps during which the last force of a constraint is kept after the constraint disappeared"))
+, d_warmStartHits(initData(&d_warmStartHits, 0, "warmStartHits", "OUTPUT: number of constraint groups initialized with their previous force"))
+, d_warmStartHitRate(initData(&d_warmStartHitRate, 0.0, "warmStartHitRate", "OUTPUT: ratio of constraint groups initialized with their previous force"))
 , current_cp(&cp1)
 , last_cp(NULL)
 {
@@ -94,6 +103,12 @@ GenericConstraintSolver::GenericConstraintSolver()
 	currentIterations.setGroup("Stats");
 	currentError.setReadOnly(true);
 	currentError.setGroup("Stats");
+	d_currentNumColors.setReadOnly(true);
+	d_currentNumColors.setGroup("Stats");
+	d_warmStartHits.setReadOnly(true);
+	d_warmStartHits.setGroup("Stats");
+	d_warmStartHitRate.setReadOnly(true);
+	d_warmStartHitRate.setGroup("Stats");
 
 	maxIt.setRequired(true);
 	tolerance.setRequired(true);
@@ -120,6 +135,9 @@ void GenericConstraintSolver::init()
     for (unsigned int i = 0; i < constraintCorrections.size(); i++)
         constraintCorrections[i]->addConstraintSolver(this);
 	context = (simulation::Node*) getContext();
+
+	if (d_parallel.getValue())
+		simulation::TaskScheduler::getInstance().start();
 }
 
 void GenericConstraintSolver::cleanup()
@@ -192,6 +210,22 @@ bool GenericConstraintSolver::buildSystem(const core::ConstraintParams *cParams,
 	MechanicalGetConstraintResolutionVisitor(cParams, current_cp->constraintsResolutions).execute(context);
     sofa::helper::AdvancedTimer::stepEnd("Get Constraint Resolutions");
 
+	constraintBlockInfo.clear();
+	constraintIds.clear();
+	constraintPositions.clear();
+	constraintDirections.clear();
+	constraintAreas.clear();
+	if (d_warmStart.getValue())
+	{
+		sofa::helper::AdvancedTimer::stepBegin("InitialGuess");
+		MechanicalGetConstraintInfoVisitor(cParams, constraintBlockInfo, constraintIds, constraintPositions, constraintDirections, constraintAreas).execute(context);
+		warmStart.setMaxAge((unsigned int)d_warmStartMaxAge.getValue());
+		warmStart.apply(constraintBlockInfo, constraintIds, current_cp->getF(), numConstraints);
+		sofa::helper::AdvancedTimer::stepEnd("InitialGuess");
+	}
+	d_warmStartHits.setValue((int)warmStart.getNbHits());
+	d_warmStartHitRate.setValue(warmStart.getHitRate());
+
     if (this->f_printLog.getValue()) sout<<"GenericConstraintSolver: "<<numConstraints<<" constraints"<<sendl;
 
 	// Test if the nodes containing the constraint correction are active (not sleeping)
@@ -323,6 +357,8 @@ bool GenericConstraintSolver::solveSystem(const core::ConstraintParams * /*cPara
 	current_cp->allVerified = allVerified.getValue();
 	current_cp->sor = sor.getValue();
 	current_cp->unbuilt = unbuilt.getValue();
+	current_cp->parallel = d_parallel.getValue();
+	current_cp->maxColors = d_maxColors.getValue();
 
 	if (unbuilt.getValue())
 	{
@@ -343,10 +379,14 @@ bool GenericConstraintSolver::solveSystem(const core::ConstraintParams * /*cPara
 		sofa::helper::AdvancedTimer::stepEnd("ConstraintsGaussSeidel");
 	}
 
+	if (d_warmStart.getValue())
+		warmStart.store(constraintBlockInfo, constraintIds, current_cp->getF(), current_cp->getDimension());
+
     this->currentError.setValue(current_cp->currentError);
     this->currentIterations.setValue(current_cp->currentIterations);
     this->currentNumConstraints.setValue(current_cp->getNumConstraints());
     this->currentNumConstraintGroups.setValue(current_cp->getNumConstraintGroups());
+    this->d_currentNumColors.setValue((current_cp->parallel && !current_cp->unbuilt && !current_cp->colorBegin.empty()) ? (int)current_cp->colorBegin.size()-1 : 0);
 
 	if ( displayTime.getValue() )
 	{
@@ -489,9 +529,12 @@ void GenericConstraintProblem::solveTimed(double tol, int maxIt, double timeout)
 {
 	double tempTol = tolerance;
 	int tempMaxIt = maxIterations;
+	bool tempParallel = parallel;
 
 	tolerance = tol;
 	maxIterations = maxIt;
+	// the haptic thread is not a thread of the TaskScheduler, and the colors would be computed again on each call
+	parallel = false;
 
 // TODO : for the unbuild version to work in the haptic thread, we have to duplicate the ConstraintCorrections first...
 /*	if(unbuilt)
@@ -501,6 +544,276 @@ void GenericConstraintProblem::solveTimed(double tol, int maxIt, double timeout)
 
 	tolerance = tempTol;
 	maxIterations = tempMaxIt;
+	parallel = tempParallel;
+}
+
+namespace
+{
+
+/// Solve the constraint group starting at line j: d is computed from the forces read in force,
+/// and the group writes its new forces in groupForce (which is force in the sequential version).
+/// Returns the error of the group, and sets verified to false if it is above the tolerance.
+double solveConstraintGroup(core::behavior::ConstraintResolution* resolution, int j, int dimension,
+                            double** w, double* dfree, double* d, const double* force, double* groupForce,
+                            double tol, bool& verified)
+{
+    double errF[6] = {0,0,0,0,0,0};
+
+    //1. nbLines provide the dimension of the constraint  (max=6)
+    const int nb = resolution->nbLines;
+
+    //2. for each line we compute the actual value of d
+    //   (a)d is set to dfree
+    for(int l=0; l<nb; l++)
+    {
+        errF[l] = groupForce[j+l];
+        d[j+l] = dfree[j+l];
+    }
+    //   (b) contribution of forces are added to d     => TODO => optimization (no computation when force= 0 !!)
+    for(int k=0; k<dimension; k++)
+        for(int l=0; l<nb; l++)
+            d[j+l] += w[j+l][k] * force[k];
+
+    //3. the specific resolution of the constraint(s) is called
+    resolution->resolution(j, w, d, groupForce, dfree);
+
+    //4. the error is measured (displacement due to the new resolution (i.e. due to the new force))
+    double contraintError = 0.0;
+    if(nb > 1)
+    {
+        for(int l=0; l<nb; l++)
+        {
+            double lineError = 0.0;
+            for (int m=0; m<nb; m++)
+            {
+                double dofError = w[j+l][j+m] * (groupForce[j+m] - errF[m]);
+                lineError += dofError * dofError;
+            }
+            lineError = sqrt(lineError);
+            if(lineError > tol)
+                verified = false;
+
+            contraintError += lineError;
+        }
+    }
+    else
+    {
+        contraintError = fabs(w[j][j] * (groupForce[j] - errF[0]));
+        if(contraintError > tol)
+            verified = false;
+    }
+
+    if(resolution->tolerance)
+    {
+        if(contraintError > resolution->tolerance)
+            verified = false;
+        contraintError *= tol / resolution->tolerance;
+    }
+
+    return contraintError;
+}
+
+/// Error of a range of constraint groups, and whether all of them are verified
+struct GroupError
+{
+    double error;
+    bool verified;
+
+    GroupError() : error(0.0), verified(true) {}
+};
+
+struct SumGroupError
+{
+    GroupError operator()(const GroupError& a, const GroupError& b) const
+    {
+        GroupError r;
+        r.error = a.error + b.error;
+        r.verified = a.verified && b.verified;
+        return r;
+    }
+};
+
+/// Solve the groups of a color, reading the forces of the previous colors in force
+/// and writing the new forces in groupForces
+class ColorGaussSeidelFunctor
+{
+public:
+    ColorGaussSeidelFunctor(const int* groups, const std::vector<core::behavior::ConstraintResolution*>& resolutions,
+                            int dimension, double** w, double* dfree, double* d, const double* force, double* groupForces,
+                            double tol, double* tabErrors)
+        : groups(groups), resolutions(resolutions), dimension(dimension), w(w), dfree(dfree), d(d)
+        , force(force), groupForces(groupForces), tol(tol), tabErrors(tabErrors)
+    {}
+
+    GroupError operator()(std::size_t first, std::size_t last) const
+    {
+        GroupError result;
+        for (std::size_t g=first; g<last; ++g)
+        {
+            const int j = groups[g];
+            core::behavior::ConstraintResolution* resolution = resolutions[j];
+            for (unsigned int l=0; l<resolution->nbLines; l++)
+                groupForces[j+l] = force[j+l];
+
+            const double contraintError = solveConstraintGroup(resolution, j, dimension, w, dfree, d, force, groupForces, tol, result.verified);
+            result.error += contraintError;
+            if (tabErrors)
+                tabErrors[j] = contraintError;
+        }
+        return result;
+    }
+
+protected:
+    const int* groups;
+    const std::vector<core::behavior::ConstraintResolution*>& resolutions;
+    int dimension;
+    double** w;
+    double* dfree;
+    double* d;
+    const double* force;
+    double* groupForces;
+    double tol;
+    double* tabErrors;
+};
+
+/// Number of constraint groups solved by each task of the parallel version,
+/// fixed so that the error is summed in the same order whatever the number of threads
+enum { GROUP_GRAIN_SIZE = 8 };
+
+/// Number of constraint groups whose lines of W are scanned by each task of computeGroupColors
+enum { COUPLING_GRAIN_SIZE = 16 };
+
+/// Find the groups coupled with each group in its lines of W, one pass over each line
+class GroupCouplingFunctor
+{
+public:
+    GroupCouplingFunctor(const std::vector<int>& groups, const std::vector<int>& lineGroup, const std::vector<core::behavior::ConstraintResolution*>& resolutions,
+                         double** w, int dimension, std::vector< std::vector<int> >& coupled)
+        : groups(groups), lineGroup(lineGroup), resolutions(resolutions), w(w), dimension(dimension), coupled(coupled)
+    {}
+
+    void operator()(std::size_t first, std::size_t last) const
+    {
+        for (std::size_t g=first; g<last; ++g)
+        {
+            std::vector<int>& c = coupled[g];
+            c.clear();
+            const int j = groups[g];
+            for (unsigned int l=0; l<resolutions[j]->nbLines; l++)
+            {
+                const double* line = w[j+l];
+                for (int k=0; k<dimension; k++)
+                {
+                    // the lines of a group are contiguous, so most repetitions are consecutive
+                    if (line[k] != 0.0 && lineGroup[k] != (int)g && (c.empty() || c.back() != lineGroup[k]))
+                        c.push_back(lineGroup[k]);
+                }
+            }
+        }
+    }
+
+protected:
+    const std::vector<int>& groups;
+    const std::vector<int>& lineGroup;
+    const std::vector<core::behavior::ConstraintResolution*>& resolutions;
+    double** w;
+    int dimension;
+    std::vector< std::vector<int> >& coupled;
+};
+
+} // anonymous namespace
+
+void GenericConstraintProblem::computeGroupColors()
+{
+    double **w = getW();
+
+    std::vector<int> groups;
+    std::vector<int> lineGroup(dimension);
+    for (int j=0; j<dimension; j += constraintsResolutions[j]->nbLines)
+    {
+        for (unsigned int l=0; l<constraintsResolutions[j]->nbLines; l++)
+            lineGroup[j+l] = (int)groups.size();
+        groups.push_back(j);
+    }
+    const int nbGroups = (int)groups.size();
+
+    // coupling graph of the groups, from the non-zero entries of W, which is scanned once on all the threads
+    couplingGraph.resize(nbGroups);
+    simulation::parallelFor(0, (std::size_t)nbGroups, GroupCouplingFunctor(groups, lineGroup, constraintsResolutions, w, dimension, couplingGraph), (std::size_t)COUPLING_GRAIN_SIZE);
+
+    // made symmetric, as an entry of W may be zero while the transposed one is not
+    couplingBegin.assign(nbGroups+1, 0);
+    for (int g=0; g<nbGroups; g++)
+        for (std::size_t k=0; k<couplingGraph[g].size(); k++)
+        {
+            ++couplingBegin[g+1];
+            ++couplingBegin[couplingGraph[g][k]+1];
+        }
+    for (int g=0; g<nbGroups; g++)
+        couplingBegin[g+1] += couplingBegin[g];
+    couplingGroups.resize(couplingBegin[nbGroups]);
+    std::vector<int> couplingEnd(couplingBegin.begin(), couplingBegin.end()-1);
+    for (int g=0; g<nbGroups; g++)
+        for (std::size_t k=0; k<couplingGraph[g].size(); k++)
+        {
+            const int h = couplingGraph[g][k];
+            couplingGroups[couplingEnd[g]++] = h;
+            couplingGroups[couplingEnd[h]++] = g;
+        }
+
+    std::vector<int> groupColor(nbGroups);
+    std::vector<int> colorSize;
+    std::vector<int> coupling; // number of groups of each color coupled with the current group
+    std::vector<int> lastCoupled(nbGroups, -1); // last group for which each group was counted in coupling
+    for (int g=0; g<nbGroups; g++)
+    {
+        coupling.assign(colorSize.size(), 0);
+        for (int k=couplingBegin[g]; k<couplingBegin[g+1]; k++)
+        {
+            const int h = couplingGroups[k];
+            if (h < g && lastCoupled[h] != g)
+            {
+                lastCoupled[h] = g;
+                ++coupling[groupColor[h]];
+            }
+        }
+
+        int color = -1;
+        for (int c=0; c<(int)coupling.size() && color<0; c++)
+            if (!coupling[c])
+                color = c;
+
+        if (color < 0)
+        {
+            if (maxColors <= 0 || (int)colorSize.size() < maxColors)
+            {
+                color = (int)colorSize.size();
+                colorSize.push_back(0);
+            }
+            else
+            {
+                // Jacobi update with the groups of the least coupled color
+                color = 0;
+                for (int c=1; c<(int)coupling.size(); c++)
+                    if (coupling[c] < coupling[color])
+                        color = c;
+            }
+        }
+
+        groupColor[g] = color;
+        ++colorSize[color];
+    }
+
+    const int nbColors = (int)colorSize.size();
+    colorBegin.resize(nbColors+1);
+    colorBegin[0] = 0;
+    for (int c=0; c<nbColors; c++)
+        colorBegin[c+1] = colorBegin[c] + colorSize[c];
+
+    colorGroups.resize(nbGroups);
+    std::vector<int> colorEnd(colorBegin.begin(), colorBegin.end()-1);
+    for (int g=0; g<nbGroups; g++)
+        colorGroups[colorEnd[groupColor[g]]++] = groups[g];
 }
 
 // Debug is only available when called directly by the solver (not in haptic thread)
@@ -510,6 +823,7 @@ void GenericConstraintProblem::gaussSeidel(double timeout, GenericConstraintSolv
     {
         currentError = 0.0;
         currentIterations = 0;
+        colorBegin.clear();
         return;
     }
 
@@ -523,9 +837,8 @@ void GenericConstraintProblem::gaussSeidel(double timeout, GenericConstraintSolv
 
 	double *d = _d.ptr();
 
-	int i, j, k, l, nb;
+	int i, j, l, nb;
 
-    double errF[6] = {0,0,0,0,0,0};
 	double error=0.0;
 
 	bool convergence = false;
@@ -576,6 +889,12 @@ void GenericConstraintProblem::gaussSeidel(double timeout, GenericConstraintSolv
 		tabErrors.resize(dimension);
 	}
 
+	if(parallel)
+	{
+		computeGroupColors();
+		groupForces.resize(dimension);
+	}
+
  /*   if(schemeCorrection)
     {
         std::cout<<"shemeCorrection => LCP before step 1"<<std::endl;
@@ -603,58 +922,33 @@ void GenericConstraintProblem::gaussSeidel(double timeout, GenericConstraintSolv
 		}
 
 		error=0.0;
-		for(j=0; j<dimension; ) // increment of j realized at the end of the loop
+		if(parallel)
 		{
-			//1. nbLines provide the dimension of the constraint  (max=6)
-			nb = constraintsResolutions[j]->nbLines;
-
-			//2. for each line we compute the actual value of d
-			//   (a)d is set to dfree
-			for(l=0; l<nb; l++)
+			// the groups of a color read the forces of the previous colors, then their new forces are copied back
+			for(int c=0; c+1<(int)colorBegin.size(); c++)
 			{
-				errF[l] = force[j+l];
-				d[j+l] = dfree[j+l];
-			}
-            //   (b) contribution of forces are added to d     => TODO => optimization (no computation when force= 0 !!)
-			for(k=0; k<dimension; k++)
-				for(l=0; l<nb; l++)
-					d[j+l] += w[j+l][k] * force[k];
+				GroupError colorError = simulation::parallelReduce((std::size_t)colorBegin[c], (std::size_t)colorBegin[c+1], GroupError(),
+					ColorGaussSeidelFunctor(&colorGroups[0], constraintsResolutions, dimension, w, dfree, d, force, &groupForces[0], tol, solver ? &tabErrors[0] : NULL),
+					SumGroupError(), (std::size_t)GROUP_GRAIN_SIZE);
 
-			//3. the specific resolution of the constraint(s) is called
-			constraintsResolutions[j]->resolution(j, w, d, force, dfree);
-
-			//4. the error is measured (displacement due to the new resolution (i.e. due to the new force))
-			double contraintError = 0.0;
-			if(nb > 1)
-			{
-				for(l=0; l<nb; l++)
+				for(int g=colorBegin[c]; g<colorBegin[c+1]; g++)
 				{
-					double lineError = 0.0;
-					for (int m=0; m<nb; m++)
-					{
-						double dofError = w[j+l][j+m] * (force[j+m] - errF[m]);
-						lineError += dofError * dofError;
-					}
-					lineError = sqrt(lineError);
-					if(lineError > tol)
-						constraintsAreVerified = false;
-
-					contraintError += lineError;
+					j = colorGroups[g];
+					nb = constraintsResolutions[j]->nbLines;
+					for(l=0; l<nb; l++)
+						force[j+l] = groupForces[j+l];
 				}
-			}
-			else
-			{
-				contraintError = fabs(w[j][j] * (force[j] - errF[0]));
-				if(contraintError > tol)
-					constraintsAreVerified = false;
-			}
 
-			if(constraintsResolutions[j]->tolerance)
-			{
-				if(contraintError > constraintsResolutions[j]->tolerance)
+				error += colorError.error;
+				if(!colorError.verified)
 					constraintsAreVerified = false;
-				contraintError *= tol / constraintsResolutions[j]->tolerance;
 			}
+		}
+		else for(j=0; j<dimension; ) // increment of j realized at the end of the loop
+		{
+			nb = constraintsResolutions[j]->nbLines;
+
+			double contraintError = solveConstraintGroup(constraintsResolutions[j], j, dimension, w, dfree, d, force, force, tol, constraintsAreVerified);
 
 			error += contraintError;
 			if(solver)
@@ -803,6 +1097,10 @@ void GenericConstraintProblem::unbuiltGaussSeidel(double timeout, GenericConstra
 
 	if(solver)
 	{
+		// the constraint corrections were reset with the current forces, zero or the warm start:
+		// the initial guesses written by the resolutions are discarded to stay consistent with them
+		sofa::helper::vector<double> resetForces;
+		resetForces.assign(force, force + dimension);
 		for(i=0; i<dimension; )
 		{
 			if(!constraintsResolutions[i])
@@ -814,7 +1112,7 @@ void GenericConstraintProblem::unbuiltGaussSeidel(double timeout, GenericConstra
 			constraintsResolutions[i]->init(i, w, force);
 			i += constraintsResolutions[i]->nbLines;
 		}
-		memset(force, 0, dimension * sizeof(double));	// Erase previous forces for the time being
+		std::copy(resetForces.begin(), resetForces.begin() + dimension, force);
 	}
 	
 	bool showGraphs = false;
@@ -27,6 +27,7 @@
 #include "config.h"
 
 #include <SofaConstraint/ConstraintSolverImpl.h>
+#include <SofaConstraint/ConstraintWarmStart.h>
 #include <sofa/core/behavior/BaseConstraint.h>
 #include <sofa/core/behavior/ConstraintSolver.h>
 #include <sofa/core/behavior/BaseConstraintCorrection.h>
@@ -66,6 +67,16 @@ public:
     std::list<unsigned int> constraints_sequence;
 	bool change_sequence;
 
+	// For parallel version :
+	bool parallel;
+	int maxColors;
+	std::vector<int> colorBegin; ///< start of each color in colorGroups
+	std::vector<int> colorGroups; ///< first line of each group, sorted by color
+	sofa::helper::vector<double> groupForces; ///< forces computed by the groups of the current color
+	std::vector< std::vector<int> > couplingGraph; ///< groups found coupled in the lines of W of each group
+	std::vector<int> couplingBegin; ///< start of the groups coupled with each group in couplingGroups
+	std::vector<int> couplingGroups; ///< groups coupled with each group, in either direction
+
 	typedef std::vector< core::behavior::BaseConstraintCorrection* > ConstraintCorrections;
 	typedef std::vector< core::behavior::BaseConstraintCorrection* >::iterator ConstraintCorrectionIterator;
 
@@ -74,7 +85,7 @@ public:
 
 	GenericConstraintProblem() : scaleTolerance(true), allVerified(false), sor(1.0)
         , sceneTime(0.0), currentError(0.0), currentIterations(0)
-		, change_sequence(false) {}
+		, change_sequence(false), parallel(false), maxColors(0) {}
 	~GenericConstraintProblem() { freeConstraintResolutions(); }
 
 	void clear(int nbConstraints);
@@ -84,6 +95,12 @@ public:
 	void gaussSeidel(double timeout=0, GenericConstraintSolver* solver = NULL);
 	void unbuiltGaussSeidel(double timeout=0, GenericConstraintSolver* solver = NULL);
 
+	/// Color the constraint groups so that the groups of a color are not coupled in W
+	/// (i.e. they do not act on the same DOFs). When maxColors is reached, a group is
+	/// added to the color it is the least coupled with, and solved with the Jacobi update.
+	/// The coupled groups are found in a single pass over W, split among the threads.
+	void computeGroupColors();
+
     int getNumConstraints();
     int getNumConstraintGroups();
 };
@@ -124,6 +141,13 @@ public:
 	Data<int> currentIterations;
 	Data<double> currentError;
     Data<bool> reverseAccumulateOrder;
+	Data<bool> d_parallel;
+	Data<int> d_maxColors;
+	Data<int> d_currentNumColors;
+	Data<bool> d_warmStart;
+	Data<int> d_warmStartMaxAge;
+	Data<int> d_warmStartHits;
+	Data<double> d_warmStartHitRate;
 
 	ConstraintProblem* getConstraintProblem();
 	void lockConstraintProblem(ConstraintProblem* p1, ConstraintProblem* p2=0);
@@ -138,6 +162,14 @@ protected:
 
 	simulation::Node *context;
 
+	/// forces of the previous steps, used as initial guess
+	ConstraintWarmStart warmStart;
+	core::behavior::BaseConstraint::VecConstraintBlockInfo constraintBlockInfo;
+	core::behavior::BaseConstraint::VecPersistentID constraintIds;
+	core::behavior::BaseConstraint::VecConstCoord constraintPositions;
+	core::behavior::BaseConstraint::VecConstDeriv constraintDirections;
+	core::behavior::BaseConstraint::VecConstArea constraintAreas;
+
     sofa::helper::system::thread::CTime timer;
     sofa::helper::system::thread::CTime timerTotal;
 
@@ -52,9 +52,40 @@ namespace component
 namespace constraintset
 {
 
+void LCPConstraintProblem::clear(int nbConstraints)
+{
+    if (!useSparseW)
+    {
+        ConstraintProblem::clear(nbConstraints);
+        sparseW.resize(0, 0);
+        return;
+    }
+
+    // the dense compliance is not allocated
+    ConstraintProblem::clear(0);
+    dimension = nbConstraints;
+    dFree.resize(nbConstraints);
+    f.resize(nbConstraints);
+
+    // new pattern, as the constraints changed
+    sparseW.resize(0, 0);
+    sparseW.resize(nbConstraints, nbConstraints);
+}
+
+helper::LCPBlockMatrix33 LCPConstraintProblem::getBlockW() const
+{
+    const sofa::component::linearsolver::CompressedRowSparseMatrix<defaulttype::Mat<3,3,double> >::VecIndex& rowIndex = sparseW.getRowIndex();
+    if (rowIndex.empty())
+        return helper::LCPBlockMatrix33();
+    return helper::LCPBlockMatrix33((int)rowIndex.size(), &rowIndex[0], &sparseW.getRowBegin()[0], &sparseW.getColsIndex()[0], sparseW.getColsValue()[0].ptr());
+}
+
 void LCPConstraintProblem::solveTimed(double tolerance, int maxIt, double timeout)
 {
-    helper::nlcp_gaussseidelTimed(dimension, getDfree(), getW(), getF(), mu, tolerance, maxIt, true, timeout);
+    if (useSparseW)
+        helper::nlcp_gaussseidelTimed(dimension, getDfree(), getBlockW(), getF(), mu, tolerance, maxIt, true, timeout);
+    else
+        helper::nlcp_gaussseidelTimed(dimension, getDfree(), getW(), getF(), mu, tolerance, maxIt, true, timeout);
 }
 
 bool LCPConstraintSolver::prepareStates(const core::ConstraintParams * /*cParams*/, MultiVecId /*res1*/, MultiVecId /*res2*/)
@@ -176,8 +207,12 @@ bool LCPConstraintSolver::solveSystem(const core::ConstraintParams * /*cParams*/
                 sofa::helper::vector<double>& graph_violations = graph["Violation"];
                 graph_violations.clear();
                 sofa::helper::AdvancedTimer::stepBegin("NLCP GaussSeidel");
-                helper::nlcp_gaussseidel(_numConstraints, _dFree->ptr(), _W->lptr(), _result->ptr(), _mu, _tol, _maxIt, initial_guess.getValue(),
-                        this->f_printLog.getValue(), _minW, _maxF, &graph_error, &graph_violations);
+                if (lcp->useSparseW)
+                    helper::nlcp_gaussseidel(_numConstraints, _dFree->ptr(), lcp->getBlockW(), _result->ptr(), _mu, _tol, _maxIt, initial_guess.getValue(),
+                            this->f_printLog.getValue(), _minW, _maxF, &graph_error, &graph_violations);
+                else
+                    helper::nlcp_gaussseidel(_numConstraints, _dFree->ptr(), _W->lptr(), _result->ptr(), _mu, _tol, _maxIt, initial_guess.getValue(),
+                            this->f_printLog.getValue(), _minW, _maxF, &graph_error, &graph_violations);
                 sofa::helper::AdvancedTimer::stepEnd("NLCP GaussSeidel");
 
                 //std::cout << "errors: " << graph_error << std::endl;
@@ -191,9 +226,16 @@ bool LCPConstraintSolver::solveSystem(const core::ConstraintParams * /*cParams*/
             sofa::helper::vector<double>& graph_error = graph["Error"];
             graph_error.clear();
             sofa::helper::AdvancedTimer::stepBegin("LCP GaussSeidel");
-            helper::gaussSeidelLCP1(_numConstraints, _dFree->ptr(), _W->lptr(), _result->ptr(), _tol, _maxIt, _minW, _maxF, &graph_error);
+            if (lcp->useSparseW)
+            {
+                if (!initial_guess.getValue())
+                    _result->clear();
+                helper::gaussSeidelLCP1(_numConstraints, _dFree->ptr(), lcp->getBlockW(), _result->ptr(), _tol, _maxIt, _minW, _maxF, &graph_error);
+            }
+            else
+                helper::gaussSeidelLCP1(_numConstraints, _dFree->ptr(), _W->lptr(), _result->ptr(), _tol, _maxIt, _minW, _maxF, &graph_error);
             sofa::helper::AdvancedTimer::stepEnd  ("LCP GaussSeidel");
-            if (this->f_printLog.getValue()) helper::afficheLCP(_dFree->ptr(), _W->lptr(), _result->ptr(),_numConstraints);
+            if (this->f_printLog.getValue() && !lcp->useSparseW) helper::afficheLCP(_dFree->ptr(), _W->lptr(), _result->ptr(),_numConstraints);
         }
     }
     else
@@ -288,6 +330,10 @@ LCPConstraintSolver::LCPConstraintSolver()
     , merge_method( initData(&merge_method, 0, "merge_method","if multi_grid is active: which method to use to merge constraints (0 = compliance-based, 1 = spatial coordinates)"))
     , merge_spatial_step( initData(&merge_spatial_step, 2, "merge_spatial_step", "if merge_method is 1: grid size reduction between multigrid levels"))
     , merge_local_levels( initData(&merge_local_levels, 2, "merge_local_levels", "if merge_method is 1: up to the specified level of the multigrid, constraints are grouped locally, i.e. separately within each contact pairs, while on upper levels they are grouped globally independently of contact pairs."))
+    , d_sparseW( initData(&d_sparseW, false, "sparseW", "Store the compliance W as a block-sparse matrix of 3x3 blocks, the Gauss-Seidel iterations only visiting its non-empty blocks (built LCP without multi_grid)"))
+    , d_warmStartMaxAge( initData(&d_warmStartMaxAge, 1, "warmStartMaxAge", "if initial_guess is active: number of steps during which the last force of a contact is kept as initial guess after the contact disappeared"))
+    , d_warmStartHits( initData(&d_warmStartHits, 0, "warmStartHits", "OUTPUT: number of constraint groups initialized with their previous force"))
+    , d_warmStartHitRate( initData(&d_warmStartHitRate, 0.0, "warmStartHitRate", "OUTPUT: ratio of constraint groups initialized with their previous force"))
     , constraintGroups( initData(&constraintGroups, "group", "list of ID of groups of constraints to be handled by this solver."))
     , f_graph( initData(&f_graph,"graph","Graph of residuals at each iteration"))
     , showLevels( initData(&showLevels,0,"showLevels","Number of constraint levels to display"))
@@ -308,6 +354,11 @@ LCPConstraintSolver::LCPConstraintSolver()
     constraintGroups.endEdit();
 
     f_graph.setWidget("graph");
+
+    d_warmStartHits.setReadOnly(true);
+    d_warmStartHits.setGroup("Stats");
+    d_warmStartHitRate.setReadOnly(true);
+    d_warmStartHitRate.setGroup("Stats");
     //f_graph.setReadOnly(true);
 
     //_numPreviousContact=0;
@@ -380,6 +431,7 @@ void LCPConstraintSolver::build_LCP()
     sofa::helper::AdvancedTimer::valSet("numConstraints", _numConstraints);
 
     lcp->mu = _mu;
+    lcp->useSparseW = d_sparseW.getValue() && build_lcp.getValue() && !multi_grid.getValue();
     lcp->clear(_numConstraints);
 
     sofa::helper::AdvancedTimer::stepBegin("Get Constraint Value");
@@ -396,11 +448,21 @@ void LCPConstraintSolver::build_LCP()
     for (unsigned int i=0; i<constraintCorrections.size(); i++)
     {
         core::behavior::BaseConstraintCorrection* cc = constraintCorrections[i];
-        cc->addComplianceInConstraintSpace(&cparams, _W);
+        if (lcp->useSparseW)
+            cc->addComplianceInConstraintSpace(&cparams, &lcp->sparseW);
+        else
+            cc->addComplianceInConstraintSpace(&cparams, _W);
     }
+    if (lcp->useSparseW)
+        lcp->sparseW.compress();
 
     if (this->f_printLog.getValue())
-        sout << "W=" << *_W << sendl;
+    {
+        if (lcp->useSparseW)
+            sout << "W=" << lcp->sparseW << sendl;
+        else
+            sout << "W=" << *_W << sendl;
+    }
 
     sofa::helper::AdvancedTimer::stepEnd  ("Get Compliance");
     if (this->f_printLog.getValue())
@@ -781,6 +843,7 @@ void LCPConstraintSolver::build_problem_info()
     sofa::helper::AdvancedTimer::valSet("numConstraints", _numConstraints);
 
     lcp->mu = _mu;
+    lcp->useSparseW = d_sparseW.getValue() && build_lcp.getValue() && !multi_grid.getValue();
     lcp->clear(_numConstraints);
 
     // as _Wdiag is a sparse matrix resize do not allocate memory
@@ -850,27 +913,10 @@ void LCPConstraintSolver::computeInitialGuess()
             (*_result)[c+numContact] =  0.0;
         }
     }
-    for (unsigned cb = 0; cb < constraintBlockInfo.size(); ++cb)
-    {
-        const ConstraintBlockInfo& info = constraintBlockInfo[cb];
-        if (!info.hasId) continue;
-        std::map<core::behavior::BaseConstraint*, ConstraintBlockBuf>::const_iterator previt = _previousConstraints.find(info.parent);
-        if (previt == _previousConstraints.end()) continue;
-        const ConstraintBlockBuf& buf = previt->second;
-        const int c0 = info.const0;
-        const int nbl = (info.nbLines < buf.nbLines) ? info.nbLines : buf.nbLines;
-        for (int c = 0; c < info.nbGroups; ++c)
-        {
-            std::map<PersistentID,int>::const_iterator it = buf.persistentToConstraintIdMap.find(constraintIds[info.offsetId + c]);
-            if (it == buf.persistentToConstraintIdMap.end()) continue;
-            int prevIndex = it->second;
-            if (prevIndex >= 0 && prevIndex+nbl <= (int) _previousForces.size())
-            {
-                for (int l=0; l<nbl; ++l)
-                    (*_result)[c0 + c*nbl + l] = _previousForces[prevIndex + l];
-            }
-        }
-    }
+    warmStart.setMaxAge((unsigned int)d_warmStartMaxAge.getValue());
+    warmStart.apply(constraintBlockInfo, constraintIds, _result->ptr(), _numConstraints);
+    d_warmStartHits.setValue((int)warmStart.getNbHits());
+    d_warmStartHitRate.setValue(warmStart.getHitRate());
 }
 
 void LCPConstraintSolver::keepContactForcesValue()
@@ -878,30 +924,7 @@ void LCPConstraintSolver::keepContactForcesValue()
     sofa::helper::AdvancedTimer::StepVar vtimer("KeepForces");
     const VecConstraintBlockInfo& constraintBlockInfo = hierarchy_constraintBlockInfo[0];
     const VecPersistentID& constraintIds = hierarchy_constraintIds[0];
-    // store current force
-    _previousForces.resize(_numConstraints);
-    for (unsigned int c=0; c<_numConstraints; ++c)
-        _previousForces[c] = (*_result)[c];
-    // clear previous history
-    for (std::map<core::behavior::BaseConstraint*, ConstraintBlockBuf>::iterator it = _previousConstraints.begin(), itend = _previousConstraints.end(); it != itend; ++it)
-    {
-        ConstraintBlockBuf& buf = it->second;
-        for (std::map<PersistentID,int>::iterator it2 = buf.persistentToConstraintIdMap.begin(), it2end = buf.persistentToConstraintIdMap.end(); it2 != it2end; ++it2)
-            it2->second = -1;
-    }
-    // fill info from current ids
-    for (unsigned cb = 0; cb < constraintBlockInfo.size(); ++cb)
-    {
-        const ConstraintBlockInfo& info = constraintBlockInfo[cb];
-        if (!info.parent) continue;
-        if (!info.hasId) continue;
-        ConstraintBlockBuf& buf = _previousConstraints[info.parent];
-        int c0 = info.const0;
-        int nbl = info.nbLines;
-        buf.nbLines = nbl;
-        for (int c = 0; c < info.nbGroups; ++c)
-            buf.persistentToConstraintIdMap[constraintIds[info.offsetId + c]] = c0 + c*nbl;
-    }
+    warmStart.store(constraintBlockInfo, constraintIds, _result->ptr(), _numConstraints);
 }
 
 
@@ -27,6 +27,7 @@
 #include "config.h"
 
 #include <SofaConstraint/ConstraintSolverImpl.h>
+#include <SofaConstraint/ConstraintWarmStart.h>
 #include <sofa/core/behavior/BaseConstraintCorrection.h>
 
 #include <sofa/simulation/Node.h>
@@ -34,6 +35,7 @@
 
 #include <SofaBaseLinearSolver/FullMatrix.h>
 #include <SofaBaseLinearSolver/SparseMatrix.h>
+#include <SofaBaseLinearSolver/CompressedRowSparseMatrix.h>
 
 #include <sofa/helper/set.h>
 #include <sofa/helper/map.h>
@@ -49,71 +51,25 @@ namespace constraintset
 {
 
 /// Christian : WARNING: this class is already defined in sofa::helper
-class LCPConstraintProblem : public ConstraintProblem
+class SOFA_CONSTRAINT_API LCPConstraintProblem : public ConstraintProblem
 {
 public:
     double mu;
 
-    void solveTimed(double tolerance, int maxIt, double timeout);
-};
+    /// if true, the compliance is stored in sparseW instead of the dense W
+    bool useSparseW;
+    sofa::component::linearsolver::CompressedRowSparseMatrix<defaulttype::Mat<3,3,double> > sparseW;
 
-class MechanicalGetConstraintInfoVisitor : public simulation::BaseMechanicalVisitor
-{
-public:
-    typedef core::behavior::BaseConstraint::VecConstraintBlockInfo VecConstraintBlockInfo;
-    typedef core::behavior::BaseConstraint::VecPersistentID VecPersistentID;
-    typedef core::behavior::BaseConstraint::VecConstCoord VecConstCoord;
-    typedef core::behavior::BaseConstraint::VecConstDeriv VecConstDeriv;
-    typedef core::behavior::BaseConstraint::VecConstArea VecConstArea;
+    LCPConstraintProblem() : mu(0.0), useSparseW(false) {}
 
-    MechanicalGetConstraintInfoVisitor(const core::ConstraintParams* params, VecConstraintBlockInfo& blocks, VecPersistentID& ids, VecConstCoord& positions, VecConstDeriv& directions, VecConstArea& areas)
-        : simulation::BaseMechanicalVisitor(params)
-        , _blocks(blocks)
-        , _ids(ids)
-        , _positions(positions)
-        , _directions(directions)
-        , _areas(areas)
-        , _cparams(params)
-    {
-#ifdef SOFA_DUMP_VISITOR_INFO
-        setReadWriteVectors();
-#endif
-    }
-
-    virtual Result fwdConstraintSet(simulation::Node* node, core::behavior::BaseConstraintSet* cSet)
-    {
-        if (core::behavior::BaseConstraint *c=cSet->toBaseConstraint())
-        {
-            ctime_t t0 = begin(node, c);
-            c->getConstraintInfo(_cparams, _blocks, _ids, _positions, _directions, _areas);
-            end(node, c, t0);
-        }
-        return RESULT_CONTINUE;
-    }
-
-
-    // This visitor must go through all mechanical mappings, even if isMechanical flag is disabled
-    virtual bool stopAtMechanicalMapping(simulation::Node* /*node*/, core::BaseMapping* /*map*/)
-    {
-        return false; // !map->isMechanical();
-    }
-
-    /// Return a class name for this visitor
-    /// Only used for debugging / profiling purposes
-    virtual const char* getClassName() const { return "MechanicalGetConstraintInfoVisitor";}
-
-#ifdef SOFA_DUMP_VISITOR_INFO
-    void setReadWriteVectors()
-    {
-    }
-#endif
-private:
-    VecConstraintBlockInfo& _blocks;
-    VecPersistentID& _ids;
-    VecConstCoord& _positions;
-    VecConstDeriv& _directions;
-    VecConstArea& _areas;
-    const core::ConstraintParams* _cparams;
+    virtual void clear(int nbConstraints);
+
+    /// View on the blocks of sparseW, used by the helper::LCP solvers.
+    /// sparseW is compressed once the compliance is built, so that the haptic thread
+    /// calling solveTimed only reads it.
+    helper::LCPBlockMatrix33 getBlockW() const;
+
+    void solveTimed(double tolerance, int maxIt, double timeout);
 };
 
 class SOFA_CONSTRAINT_API LCPConstraintSolver : public ConstraintSolverImpl
@@ -162,6 +118,10 @@ public:
     Data<int> merge_method;
     Data<int> merge_spatial_step;
     Data<int> merge_local_levels;
+    Data<bool> d_sparseW;
+    Data<int> d_warmStartMaxAge;
+    Data<int> d_warmStartHits;
+    Data<double> d_warmStartHitRate;
 
     Data < helper::set<int> > constraintGroups;
 
@@ -244,15 +204,8 @@ public:
     typedef core::behavior::BaseConstraint::VecConstDeriv VecConstDeriv;
     typedef core::behavior::BaseConstraint::VecConstArea VecConstArea;
 
-    class ConstraintBlockBuf
-    {
-    public:
-        std::map<PersistentID,int> persistentToConstraintIdMap;
-        int nbLines; ///< how many dofs (i.e. lines in the matrix) are used by each constraint
-    };
-
-    std::map<core::behavior::BaseConstraint*, ConstraintBlockBuf> _previousConstraints;
-    helper::vector< double > _previousForces;
+    /// forces of the previous steps, used as initial guess
+    ConstraintWarmStart warmStart;
 
     helper::vector< VecConstraintBlockInfo > hierarchy_constraintBlockInfo;
     helper::vector< VecPersistentID > hierarchy_constraintIds;
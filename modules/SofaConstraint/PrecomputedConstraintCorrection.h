@@ -30,6 +30,7 @@
 #include <sofa/core/objectmodel/DataFileName.h>
 
 #include <SofaBaseLinearSolver/FullMatrix.h>
+#include <SofaBaseLinearSolver/PrecomputedMatrixCache.h>
 
 #include <sofa/defaulttype/Mat.h>
 #include <sofa/defaulttype/Vec.h>
@@ -131,11 +132,15 @@ public:
     {
         Real* data;
         int nbref;
-        InverseStorage() : data(NULL), nbref(0) {}
+        /// file mapping data, if it was loaded from a cache file (data is then read-only), or NULL if data was allocated
+        linearsolver::PrecomputedMatrixCache* cache;
+        InverseStorage() : data(NULL), nbref(0), cache(NULL) {}
     };
 
     std::string invName;
     InverseStorage* invM;
+    /// Hash of the parameters of the precomputation, stored in and checked against the compliance files
+    linearsolver::PrecomputedMatrixCache::Key cacheKey;
     Real* appCompliance;
     unsigned int dimensionAppCompliance;
 
@@ -181,12 +186,15 @@ protected:
     /**
      * @brief Load compliance matrix from memory or external file according to fileName.
      *
+     * Compliance files are memory-mapped, and rejected if they were computed for other
+     * parameters than the ones given by cacheKey.
+     *
      * @return Loading success.
      */
     bool loadCompliance(std::string fileName);
 
     /**
-     * @brief Save compliance matrix into a file.
+     * @brief Save compliance matrix into a file, and use the file mapping instead of the allocated matrix.
      */
     void saveCompliance(const std::string& fileName);
 
@@ -195,6 +203,11 @@ protected:
      */
     std::string buildFileName();
 
+    /**
+     * @brief Computes cacheKey from the mesh, material and solver parameters of the context.
+     */
+    void computeCacheKey();
+
     /**
      * @brief Compute dx correction from motion space force vector.
      */
@@ -111,7 +111,8 @@ void PrecomputedConstraintCorrection<DataTypes>::releaseInverse(std::string name
     std::map< std::string, InverseStorage >& registry = getInverseMap();
     if (--inv->nbref == 0)
     {
-        if (inv->data) delete[] inv->data;
+        if (inv->cache) delete inv->cache;
+        else if (inv->data) delete[] inv->data;
         registry.erase(name);
     }
 }
@@ -127,7 +128,7 @@ std::string PrecomputedConstraintCorrection<DataTypes>::buildFileName()
     const std::string name = this->getContext()->getName();
 
     std::stringstream ss;
-    ss << name << "-" << nbRows << "-" << dt <<".comp";
+    ss << name << "-" << nbRows << "-" << dt << "-" << cacheKey.str() << ".comp";
 
     return ss.str();
 }
@@ -135,57 +136,66 @@ std::string PrecomputedConstraintCorrection<DataTypes>::buildFileName()
 
 
 template<class DataTypes>
-bool PrecomputedConstraintCorrection<DataTypes>::loadCompliance(std::string fileName)
+void PrecomputedConstraintCorrection<DataTypes>::computeCacheKey()
 {
-    // Try to load from memory
-    sout << "Try to load compliance from memory " << fileName << sendl;
-
-    invM = getInverse(fileName);
-    dimensionAppCompliance = nbRows;
-
-    if (invM->data == NULL)
-    {
-        // Try to load from file
-        sout << "Try to load compliance from : " << fileName << sendl;
-
-        std::string dir = fileDir.getValue();
-        if (!dir.empty())
-        {
-			std::ifstream compFileIn((dir + "/" + fileName).c_str(), std::ifstream::binary);
-            if (compFileIn.is_open())
-            {
-                invM->data = new Real[nbRows * nbCols];
+    cacheKey = linearsolver::PrecomputedMatrixCache::Key();
+    cacheKey.add(this->getTemplateName());
+    cacheKey.add((long long)nbRows);
+    cacheKey.add((double)this->getContext()->getDt());
+    cacheKey.addMechanicalContext(this->getContext(), this);
+}
 
-                sout << "File " << dir + "/" + fileName << " found. Loading..." << sendl;
 
-                compFileIn.read((char*)invM->data, nbCols * nbRows * sizeof(double));
-                compFileIn.close();
 
-                return true;
-            }
-            else
-                return false;
-        }
-        else if (recompute.getValue() == false)
-        {
-            if(sofa::helper::system::DataRepository.findFile(fileName))
-            {
-                invM->data = new Real[nbRows * nbCols];
+template<class DataTypes>
+bool PrecomputedConstraintCorrection<DataTypes>::loadCompliance(std::string fileName)
+{
+    // Try to load from memory
+    sout << "Try to load compliance from memory " << invName << sendl;
 
-                std::ifstream compFileIn(fileName.c_str(), std::ifstream::binary);
+    invM = getInverse(invName);
+    dimensionAppCompliance = nbRows;
 
-                sout << "File " << fileName << " found. Loading..." << sendl;
+    if (invM->data != NULL)
+        return true;
 
-                compFileIn.read((char*)invM->data, nbCols * nbRows * sizeof(double));
-                compFileIn.close();
+    // Try to load from file
+    sout << "Try to load compliance from : " << fileName << sendl;
 
-                return true;
-            }
-        }
+    std::string dir = fileDir.getValue();
+    std::string path;
+    if (!dir.empty())
+        path = dir + "/" + fileName;
+    else if (recompute.getValue() == false)
+    {
+        path = fileName;
+        if (!sofa::helper::system::DataRepository.findFile(path))
+            return false;
+    }
+    else
+        return false;
 
+    linearsolver::PrecomputedMatrixCache* cache = new linearsolver::PrecomputedMatrixCache;
+    switch (cache->open<Real>(path, cacheKey, nbRows, nbCols))
+    {
+    case linearsolver::PrecomputedMatrixCache::VALID:
+        sout << "File " << path << " found. Mapping..." << sendl;
+        break;
+    case linearsolver::PrecomputedMatrixCache::LEGACY:
+        serr << "File " << path << " has no header and can not be checked against the current parameters, remove it to recompute the compliance" << sendl;
+        break;
+    case linearsolver::PrecomputedMatrixCache::OUTDATED:
+        sout << "File " << path << " was computed for other parameters" << sendl;
+        delete cache;
+        return false;
+    default:
+        delete cache;
         return false;
     }
 
+    invM->cache = cache;
+    invM->data = const_cast<Real*>(cache->values<Real>());
+
     return true;
 }
 
@@ -203,9 +213,22 @@ void PrecomputedConstraintCorrection<DataTypes>::saveCompliance(const std::strin
     else
         filePathInSofaShare  = sofa::helper::system::DataRepository.getFirstPath() + "/" + fileName;
 
-    std::ofstream compFileOut(filePathInSofaShare.c_str(), std::fstream::out | std::fstream::binary);
-    compFileOut.write((char*)invM->data, nbCols * nbRows * sizeof(double));
-    compFileOut.close();
+    if (!linearsolver::PrecomputedMatrixCache::write<Real>(filePathInSofaShare, cacheKey, nbRows, nbCols, invM->data))
+    {
+        serr << "Unable to write " << filePathInSofaShare << sendl;
+        return;
+    }
+
+    // use the pages of the file, shared with the other simulations, instead of the allocated matrix
+    linearsolver::PrecomputedMatrixCache* cache = new linearsolver::PrecomputedMatrixCache;
+    if (cache->open<Real>(filePathInSofaShare, cacheKey, nbRows, nbCols) == linearsolver::PrecomputedMatrixCache::VALID)
+    {
+        delete[] invM->data;
+        invM->cache = cache;
+        invM->data = const_cast<Real*>(cache->values<Real>());
+    }
+    else
+        delete cache;
 }
 
 
@@ -232,9 +255,12 @@ void PrecomputedConstraintCorrection<DataTypes>::bwdInit()
 
     double dt = this->getContext()->getDt();
 
-    invName = f_fileCompliance.getFullPath().empty() ? buildFileName() : f_fileCompliance.getFullPath();
+    computeCacheKey();
+
+    const std::string fileName = f_fileCompliance.getFullPath().empty() ? buildFileName() : f_fileCompliance.getFullPath();
+    invName = fileName + "#" + cacheKey.str();
 
-    if (!loadCompliance(invName))
+    if (!loadCompliance(fileName))
     {
         sout << "Compliance being built" << sendl;
 
@@ -384,7 +410,7 @@ void PrecomputedConstraintCorrection<DataTypes>::bwdInit()
         if (linearSolver)
             linearSolver->freezeSystemMatrix();
 
-        saveCompliance(invName);
+        saveCompliance(fileName);
 
         // Restore gravity
         this->getContext()->setGravity(gravity);
@@ -0,0 +1,185 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2016 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU General Public License as published by the Free  *
+* Software Foundation; either version 2 of the License, or (at your option)   *
+* any later version.                                                          *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for    *
+* more details.                                                               *
+*                                                                             *
+* You should have received a copy of the GNU General Public License along     *
+* with this program; if not, write to the Free Software Foundation, Inc., 51  *
+* Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA.                   *
+*******************************************************************************
+*                            SOFA :: Applications                             *
+*                                                                             *
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+
+#include <SofaTest/Sofa_test.h>
+
+#include <SofaConstraint/ConstraintWarmStart.h>
+#include <SofaConstraint/UnilateralInteractionConstraint.h>
+
+#include <gtest/gtest.h>
+
+namespace sofa {
+
+using component::constraintset::ConstraintWarmStart;
+using core::behavior::BaseConstraint;
+
+/** Forces of the constraint groups are found back from their persistent ids,
+  whatever their order and the constraint object giving them.
+  */
+struct ConstraintWarmStart_test : public Sofa_test<double>
+{
+    ConstraintWarmStart warmStart;
+    BaseConstraint::VecConstraintBlockInfo blocks;
+    BaseConstraint::VecPersistentID ids;
+
+    // only used as keys
+    int parents[2];
+
+    /// One block of contacts with 3 lines each, starting at line 0
+    void setContacts(int parent, bool global, const BaseConstraint::PersistentID* contactIds, int nbContacts)
+    {
+        blocks.resize(1);
+        BaseConstraint::ConstraintBlockInfo& info = blocks[0];
+        info.parent = reinterpret_cast<BaseConstraint*>(&parents[parent]);
+        info.const0 = 0;
+        info.nbLines = 3;
+        info.nbGroups = nbContacts;
+        info.hasId = true;
+        info.hasGlobalId = global;
+        info.offsetId = 0;
+        ids.assign(contactIds, contactIds+nbContacts);
+    }
+};
+
+TEST_F(ConstraintWarmStart_test, reorderedContacts)
+{
+    const BaseConstraint::PersistentID ids0[3] = { 10, 20, 30 };
+    setContacts(0, false, ids0, 3);
+    const double f0[9] = { 1,2,3, 4,5,6, 7,8,9 };
+    warmStart.store(blocks, ids, f0, 9);
+
+    // 20 disappeared, 40 is new, 10 and 30 are swapped
+    const BaseConstraint::PersistentID ids1[3] = { 30, 40, 10 };
+    setContacts(0, false, ids1, 3);
+    double f1[9] = { 0,0,0, 0,0,0, 0,0,0 };
+    EXPECT_EQ(2u, warmStart.apply(blocks, ids, f1, 9));
+    EXPECT_EQ(3u, warmStart.getNbLookups());
+    EXPECT_NEAR(2.0/3.0, warmStart.getHitRate(), 1e-12);
+
+    const double expected[9] = { 7,8,9, 0,0,0, 1,2,3 };
+    for (int i=0; i<9; ++i)
+        EXPECT_EQ(expected[i], f1[i]);
+}
+
+TEST_F(ConstraintWarmStart_test, globalIds)
+{
+    const BaseConstraint::PersistentID contactIds[2] = { 10, 20 };
+    const double f0[6] = { 1,2,3, 4,5,6 };
+    double f1[6] = { 0,0,0, 0,0,0 };
+
+    // local ids are not found from another constraint
+    setContacts(0, false, contactIds, 2);
+    warmStart.store(blocks, ids, f0, 6);
+    setContacts(1, false, contactIds, 2);
+    EXPECT_EQ(0u, warmStart.apply(blocks, ids, f1, 6));
+
+    // global ids are
+    warmStart.clear();
+    setContacts(0, true, contactIds, 2);
+    warmStart.store(blocks, ids, f0, 6);
+    setContacts(1, true, contactIds, 2);
+    EXPECT_EQ(2u, warmStart.apply(blocks, ids, f1, 6));
+    EXPECT_EQ(4.0, f1[3]);
+}
+
+TEST_F(ConstraintWarmStart_test, maxAge)
+{
+    const BaseConstraint::PersistentID contactIds[1] = { 10 };
+    const double f0[3] = { 1,2,3 };
+    double f1[3] = { 0,0,0 };
+
+    warmStart.setMaxAge(2);
+    setContacts(0, true, contactIds, 1);
+    warmStart.store(blocks, ids, f0, 3);
+
+    // the contact disappears during one step
+    setContacts(0, true, contactIds, 0);
+    warmStart.store(blocks, ids, f0, 0);
+    EXPECT_EQ(1u, warmStart.size());
+
+    setContacts(0, true, contactIds, 1);
+    EXPECT_EQ(1u, warmStart.apply(blocks, ids, f1, 3));
+    EXPECT_EQ(1.0, f1[0]);
+
+    // and then during two steps
+    setContacts(0, true, contactIds, 0);
+    warmStart.store(blocks, ids, f0, 0);
+    warmStart.store(blocks, ids, f0, 0);
+    EXPECT_EQ(0u, warmStart.size());
+}
+
+TEST_F(ConstraintWarmStart_test, contactKey)
+{
+    core::collision::DetectionOutput o1, o2;
+    o1.elem.first = core::CollisionElementIterator(NULL, 3);
+    o1.elem.second = core::CollisionElementIterator(NULL, 5);
+    o1.id = 7;
+    o2 = o1;
+    EXPECT_EQ(ConstraintWarmStart::contactKey(o1), ConstraintWarmStart::contactKey(o2));
+    EXPECT_LT(0, ConstraintWarmStart::contactKey(o1));
+
+    o2.elem.second = core::CollisionElementIterator(NULL, 6);
+    EXPECT_NE(ConstraintWarmStart::contactKey(o1), ConstraintWarmStart::contactKey(o2));
+    o2 = o1;
+    o2.id = 8;
+    EXPECT_NE(ConstraintWarmStart::contactKey(o1), ConstraintWarmStart::contactKey(o2));
+}
+
+TEST_F(ConstraintWarmStart_test, unilateralConstraintIds)
+{
+    typedef component::constraintset::UnilateralInteractionConstraint<defaulttype::Vec3Types> Constraint;
+    typedef Constraint::Coord Coord;
+    typedef Constraint::Deriv Deriv;
+
+    BaseConstraint::VecConstCoord positions;
+    BaseConstraint::VecConstDeriv directions;
+    BaseConstraint::VecConstArea areas;
+
+    for (int global=0; global<2; ++global)
+    {
+        Constraint::SPtr constraint = core::objectmodel::New<Constraint>();
+        constraint->setGlobalContactIds(global != 0);
+        // 0 is a valid key
+        constraint->addContact(0.0, Deriv(0,0,1), Coord(), Coord(), 0.1, 0, 0, Coord(), Coord(), 5, 0);
+        constraint->addContact(0.0, Deriv(0,0,1), Coord(), Coord(), 0.1, 1, 1, Coord(), Coord(), 6, 42);
+
+        // the ids are negated until the constraint is integrated
+        for (int integrated=0; integrated<2; ++integrated)
+        {
+            blocks.clear();
+            ids.clear();
+            directions.clear();
+            constraint->getConstraintInfo(NULL, blocks, ids, positions, directions, areas);
+            ASSERT_EQ(1u, blocks.size());
+            EXPECT_EQ(global != 0, blocks[0].hasGlobalId);
+            ASSERT_EQ(2u, ids.size());
+            const BaseConstraint::PersistentID sign = integrated ? 1 : -1;
+            EXPECT_EQ(sign * (global ? 0 : 5), ids[0]);
+            EXPECT_EQ(sign * (global ? 42 : 6), ids[1]);
+        }
+    }
+}
+
+}// namespace sofa
@@ -0,0 +1,153 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2016 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU General Public License as published by the Free  *
+* Software Foundation; either version 2 of the License, or (at your option)   *
+* any later version.                                                          *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for    *
+* more details.                                                               *
+*                                                                             *
+* You should have received a copy of the GNU General Public License along     *
+* with this program; if not, write to the Free Software Foundation, Inc., 51  *
+* Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA.                   *
+*******************************************************************************
+*                            SOFA :: Applications                             *
+*                                                                             *
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+
+#include <SofaTest/Sofa_test.h>
+
+#include <SofaConstraint/GenericConstraintSolver.h>
+#include <SofaConstraint/UnilateralInteractionConstraint.h>
+#include <sofa/simulation/TaskScheduler.h>
+
+#include <gtest/gtest.h>
+
+namespace sofa {
+
+using component::constraintset::GenericConstraintProblem;
+using component::constraintset::UnilateralConstraintResolution;
+using simulation::TaskScheduler;
+
+/** The parallel Gauss-Seidel of GenericConstraintProblem, which solves the
+  constraint groups color by color, converges to the same forces as the
+  sequential one.
+  */
+struct GenericConstraintSolver_test : public Sofa_test<double>
+{
+    enum { NbBodies = 12, NbContactsPerBody = 4, N = NbBodies*NbContactsPerBody };
+
+    GenericConstraintProblem sequential, parallel;
+
+    GenericConstraintSolver_test()
+    {
+        TaskScheduler::getInstance().start(4);
+    }
+
+    ~GenericConstraintSolver_test()
+    {
+        TaskScheduler::getInstance().stop();
+    }
+
+    /// Contacts of the bodies are interleaved, the contacts of a same body being coupled if coupling is not 0
+    void fill(GenericConstraintProblem& p, double coupling)
+    {
+        p.clear(N);
+        p.tolerance = 1e-12;
+        p.maxIterations = 1000;
+        p.scaleTolerance = false;
+        for (int i=0; i<N; ++i)
+        {
+            p.constraintsResolutions[i] = new UnilateralConstraintResolution;
+            p.getDfree()[i] = (i%3==0) ? 0.5 : -1.0 - 0.1*i;
+            p.getF()[i] = 0.0;
+            for (int j=0; j<N; ++j)
+                p.getW()[i][j] = (i==j) ? 4.0 + 0.01*i : ((i%NbBodies == j%NbBodies) ? coupling : 0.0);
+        }
+    }
+
+    void solve(double coupling, int maxColors)
+    {
+        fill(sequential, coupling);
+        fill(parallel, coupling);
+        parallel.parallel = true;
+        parallel.maxColors = maxColors;
+
+        sequential.gaussSeidel();
+        parallel.gaussSeidel();
+    }
+};
+
+TEST_F(GenericConstraintSolver_test, uncoupledGroups)
+{
+    solve(0.0, 0);
+
+    // a single color gives exactly the sequential iterations
+    EXPECT_EQ(2u, parallel.colorBegin.size());
+    EXPECT_EQ(sequential.currentIterations, parallel.currentIterations);
+    EXPECT_EQ(sequential.currentError, parallel.currentError);
+    for (int i=0; i<N; ++i)
+        EXPECT_EQ(sequential.getF()[i], parallel.getF()[i]);
+}
+
+TEST_F(GenericConstraintSolver_test, coloredGroups)
+{
+    solve(0.5, 0);
+
+    EXPECT_EQ((std::size_t)NbContactsPerBody+1, parallel.colorBegin.size());
+    EXPECT_LT(parallel.currentIterations, parallel.maxIterations);
+    EXPECT_LT(parallel.currentError, parallel.tolerance);
+    for (int i=0; i<N; ++i)
+        EXPECT_NEAR(sequential.getF()[i], parallel.getF()[i], 1e-10);
+}
+
+TEST_F(GenericConstraintSolver_test, jacobiWithinColors)
+{
+    solve(0.5, 2);
+
+    EXPECT_EQ(3u, parallel.colorBegin.size());
+    EXPECT_LT(parallel.currentIterations, parallel.maxIterations);
+    EXPECT_LT(parallel.currentError, parallel.tolerance);
+    for (int i=0; i<N; ++i)
+        EXPECT_NEAR(sequential.getF()[i], parallel.getF()[i], 1e-10);
+}
+
+TEST_F(GenericConstraintSolver_test, oneSidedCoupling)
+{
+    // an entry of W whose transposed one is zero still couples the two groups
+    fill(parallel, 0.0);
+    parallel.getW()[0][N-1] = 0.5;
+    parallel.parallel = true;
+    parallel.gaussSeidel();
+
+    ASSERT_EQ(3u, parallel.colorBegin.size());
+    EXPECT_EQ(1, parallel.colorBegin[2] - parallel.colorBegin[1]);
+    EXPECT_EQ(N-1, parallel.colorGroups[parallel.colorBegin[1]]);
+}
+
+TEST_F(GenericConstraintSolver_test, solveTimedIsSequential)
+{
+    fill(sequential, 0.5);
+    fill(parallel, 0.5);
+    parallel.parallel = true;
+
+    sequential.gaussSeidel();
+    parallel.solveTimed(parallel.tolerance, parallel.maxIterations, 0.0);
+
+    // the haptic thread does not color the groups
+    EXPECT_TRUE(parallel.parallel);
+    EXPECT_TRUE(parallel.colorBegin.empty());
+    EXPECT_EQ(sequential.currentIterations, parallel.currentIterations);
+    for (int i=0; i<N; ++i)
+        EXPECT_EQ(sequential.getF()[i], parallel.getF()[i]);
+}
+
+}// namespace sofa
@@ -118,24 +118,43 @@ SOFA_CONSTRAINT_API void UncoupledConstraintCorrection< defaulttype::Rigid3Types
 
     const VecReal& usedComp = compliance.getValue();
 
+    // rows gathered by dof, as in the generic version
+    for (unsigned int dof = 0; dof < dofConstraints.size(); dof++)
+        dofConstraints[dof].clear();
+
     MatrixDerivRowConstIterator rowIt = constraints.begin();
     MatrixDerivRowConstIterator rowItEnd = constraints.end();
 
     while (rowIt != rowItEnd)
     {
-        const unsigned int indexCurRowConst = rowIt.index();
-
         MatrixDerivColConstIterator colIt = rowIt.begin();
         MatrixDerivColConstIterator colItEnd = rowIt.end();
 
         while (colIt != colItEnd)
         {
             unsigned int dof = colIt.index();
-            Deriv n = colIt.val();
 
 #ifdef DEBUG
-            std::cout << "    [ " << dof << "]=" << n << std::endl;
+            std::cout << "    [ " << dof << "]=" << colIt.val() << std::endl;
 #endif
+            if (dof >= dofConstraints.size())
+                dofConstraints.resize(dof + 1);
+            dofConstraints[dof].push_back(std::make_pair((int)rowIt.index(), colIt.val()));
+
+            ++colIt;
+        }
+
+        ++rowIt;
+    }
+
+    for (unsigned int dof = 0; dof < dofConstraints.size(); dof++)
+    {
+        const helper::vector< std::pair<int, Deriv> >& rows = dofConstraints[dof];
+
+        for (unsigned int i = 0; i < rows.size(); i++)
+        {
+            const unsigned int indexCurRowConst = rows[i].first;
+            const Deriv& n = rows[i].second;
 
             getVCenter(weightedNormal) = getVCenter(n);
             getVOrientation(weightedNormal) = getVOrientation(n);
@@ -150,40 +169,18 @@ SOFA_CONSTRAINT_API void UncoupledConstraintCorrection< defaulttype::Rigid3Types
             comp_wN[4] =  usedComp[2] * wn3 +  usedComp[4] * wn4 +  usedComp[5] * wn5;
             comp_wN[5] =  usedComp[3] * wn3 +  usedComp[5] * wn4 +  usedComp[6] * wn5;
 
-            MatrixDerivRowConstIterator rowIt2 = rowIt;
-
-            while (rowIt2 != rowItEnd)
+            for (unsigned int j = i; j < rows.size(); j++)
             {
-                const unsigned int indexCurColConst = rowIt2.index();
-
-                MatrixDerivColConstIterator colIt2 = rowIt2.begin();
-                MatrixDerivColConstIterator colIt2End = rowIt2.end();
+                const unsigned int indexCurColConst = rows[j].first;
 
-                while (colIt2 != colIt2End)
-                {
-                    unsigned int dof2 = colIt2.index();
-                    Deriv n2 = colIt2.val();
+                double w = rows[j].second * comp_wN;
 
-                    if (dof == dof2)
-                    {
-                        double w = n2 * comp_wN;
-
-                        W->add(indexCurRowConst, indexCurColConst, w);
-
-                        if (indexCurRowConst != indexCurColConst)
-                            W->add(indexCurColConst, indexCurRowConst, w);
-                    }
+                W->add(indexCurRowConst, indexCurColConst, w);
 
-                    ++colIt2;
-                }
-
-                ++rowIt2;
+                if (indexCurRowConst != indexCurColConst)
+                    W->add(indexCurColConst, indexCurRowConst, w);
             }
-
-            ++colIt;
         }
-
-        ++rowIt;
     }
 
 #ifdef DEBUG
@@ -132,6 +132,9 @@ private:
     VecDeriv constraint_disp, constraint_force;
     std::list<int> constraint_dofs;		// list of indices of each point which is involve with constraint
 
+    /// constraint rows (index and value) acting on each dof, gathered in addComplianceInConstraintSpace
+    helper::vector< helper::vector< std::pair<int, Deriv> > > dofConstraints;
+
     //std::vector< std::vector<int> >  dof_constraint_table;   // table of indices of each point involved with each constraint
 
 protected:
@@ -248,6 +248,12 @@ void UncoupledConstraintCorrection<DataTypes>::addComplianceInConstraintSpace(co
     const VecReal& comp = compliance.getValue();
     const Real comp0 = defaultCompliance.getValue();
 
+    // The compliance being diagonal, only the rows sharing a dof are coupled.
+    // The rows are first gathered by dof, instead of looking for each dof of
+    // a row in all the following rows.
+    for (unsigned int dof = 0; dof < dofConstraints.size(); dof++)
+        dofConstraints[dof].clear();
+
     for (MatrixDerivRowConstIterator rowIt = constraints.begin(), rowItEnd = constraints.end(); rowIt != rowItEnd; ++rowIt)
     {
         int indexCurRowConst = rowIt.index();
@@ -263,39 +269,38 @@ void UncoupledConstraintCorrection<DataTypes>::addComplianceInConstraintSpace(co
             if (f_verbose.getValue())
                 sout << " dof[" << dof << "]=" << n;
 
-            int indexCurColConst;
-
 #ifdef DEBUG
             std::cout << " [ " << dof << "]=" << n << std::endl;
 #endif
-            for (MatrixDerivRowConstIterator rowIt2 = rowIt; rowIt2 != rowItEnd; ++rowIt2)
-            {
-                indexCurColConst = rowIt2.index();
+            if (dof >= dofConstraints.size())
+                dofConstraints.resize(dof + 1);
+            dofConstraints[dof].push_back(std::make_pair(indexCurRowConst, n));
+        }
+        if (f_verbose.getValue())
+            sout << sendl;
+    }
 
-                for (MatrixDerivColConstIterator colIt2 = rowIt2.begin(), colIt2End = rowIt2.end(); colIt2 != colIt2End; ++colIt2)
-                {
-                    if (dof == colIt2.index())
-                    {
-                        double w = n * colIt2.val() * (dof < comp.size() ? comp[dof] : comp0);
-                        W->add(indexCurRowConst, indexCurColConst, w);
-                        if (indexCurRowConst != indexCurColConst)
-                        {
-                            W->add(indexCurColConst, indexCurRowConst, w);
-                        }
-                    }
-                }
-            }
+    for (unsigned int dof = 0; dof < dofConstraints.size(); dof++)
+    {
+        const helper::vector< std::pair<int, Deriv> >& rows = dofConstraints[dof];
+        const Real c = (dof < comp.size() ? comp[dof] : comp0);
+
+        for (unsigned int i = 0; i < rows.size(); i++)
+        {
+            const int indexCurRowConst = rows[i].first;
+            const Deriv& n = rows[i].second;
 
-            /*
-            for(unsigned int curColConst = curRowConst+1; curColConst < numConstraints; curColConst++)
+            for (unsigned int j = i; j < rows.size(); j++)
             {
-            	indexCurColConst = mstate->getConstraintId()[curColConst];
-            	W[indexCurColConst][indexCurRowConst] = W[indexCurRowConst][indexCurColConst];
+                const int indexCurColConst = rows[j].first;
+                double w = n * rows[j].second * c;
+                W->add(indexCurRowConst, indexCurColConst, w);
+                if (indexCurRowConst != indexCurColConst)
+                {
+                    W->add(indexCurColConst, indexCurRowConst, w);
+                }
             }
-            */
         }
-        if (f_verbose.getValue())
-            sout << sendl;
     }
 
     /*debug : verifie qu'il n'y a pas de 0 sur la diagonale de W
@@ -168,6 +168,7 @@ protected:
     sofa::helper::vector<Contact> contacts;
     Real epsilon;
     bool yetIntegrated;
+    bool globalContactIds;
     double customTolerance;
 
     PreviousForcesContainer prevForces;
@@ -192,6 +193,7 @@ protected:
         : Inherit(object1, object2)
         , epsilon(Real(0.001))
         , yetIntegrated(false)
+        , globalContactIds(false)
         , customTolerance(0.0)
         , contactsStatus(NULL)
     {
@@ -205,6 +207,11 @@ protected:
 public:
     void setCustomTolerance(double tol) { customTolerance = tol; }
 
+    /// The localid given to addContact are keys unique among all the constraints (see ConstraintWarmStart::contactKey),
+    /// used as the persistent ids of the contacts instead of their id
+    void setGlobalContactIds(bool global) { globalContactIds = global; }
+    bool hasGlobalContactIds() const { return globalContactIds; }
+
     void clear(int reserve = 0)
     {
         contacts.clear();
@@ -292,10 +292,14 @@ void UnilateralInteractionConstraint<DataTypes>::getConstraintInfo(const core::C
     info.offsetDirection = directions.size();
     info.nbGroups = contacts.size();
 
+    // contacts added with global keys (see ConstraintWarmStart::contactKey) are identified by them
+    info.hasGlobalId = globalContactIds;
+
     for (unsigned int i=0; i<contacts.size(); i++)
     {
         Contact& c = contacts[i];
-        ids.push_back( yetIntegrated ? c.contactId : -c.contactId);
+        const PersistentID id = globalContactIds ? c.localId : (PersistentID)c.contactId;
+        ids.push_back( yetIntegrated ? id : -id);
         directions.push_back( c.norm );
         if (friction)
         {
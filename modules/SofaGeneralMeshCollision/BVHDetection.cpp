@@ -0,0 +1,611 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2016 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This library is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This library is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this library; if not, write to the Free Software Foundation,     *
+* Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA.          *
+*******************************************************************************
+*                               SOFA :: Modules                               *
+*                                                                             *
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <SofaGeneralMeshCollision/BVHDetection.h>
+#include <sofa/core/ObjectFactory.h>
+#include <sofa/helper/AdvancedTimer.h>
+#include <sofa/simulation/ParallelFor.h>
+#include <algorithm>
+
+namespace sofa
+{
+
+namespace component
+{
+
+namespace collision
+{
+
+using defaulttype::Vector3;
+
+namespace
+{
+
+/// number of bins along each axis to evaluate the surface area heuristic
+const int SAH_BINS = 16;
+
+/// number of independent node pairs per thread before traversing the trees in parallel
+const std::size_t TASKS_PER_THREAD = 8;
+
+inline double boxArea(const Vector3& minBBox, const Vector3& maxBBox)
+{
+    const Vector3 d = maxBBox - minBBox;
+    return 2.0 * (d[0]*d[1] + d[1]*d[2] + d[2]*d[0]);
+}
+
+inline void growBox(Vector3& minBBox, Vector3& maxBBox, const Vector3& pmin, const Vector3& pmax)
+{
+    for (int c=0; c<3; c++)
+    {
+        if (pmin[c] < minBBox[c]) minBBox[c] = pmin[c];
+        if (pmax[c] > maxBBox[c]) maxBBox[c] = pmax[c];
+    }
+}
+
+inline bool boxOverlap(const Vector3& min0, const Vector3& max0, const Vector3& min1, const Vector3& max1, double alarmDist)
+{
+    for (int c=0; c<3; c++)
+    {
+        if (min0[c] > max1[c] + alarmDist || min1[c] > max0[c] + alarmDist)
+            return false;
+    }
+    return true;
+}
+
+/// Bin of a primitive along an axis, from its centroid
+struct SAHBin
+{
+    int axis;
+    double cmin, scale;
+
+    SAHBin(int axis, double cmin, double cmax) : axis(axis), cmin(cmin), scale(SAH_BINS / (cmax - cmin)) {}
+
+    int operator()(const Vector3& pmin, const Vector3& pmax) const
+    {
+        const int b = (int)(((pmin[axis] + pmax[axis]) * 0.5 - cmin) * scale);
+        return b < 0 ? 0 : (b >= SAH_BINS ? SAH_BINS-1 : b);
+    }
+};
+
+/// Primitives left of a split, for std::partition
+struct SAHLeftOf
+{
+    const SAHBin& bin;
+    const helper::vector<Vector3>& primMin;
+    const helper::vector<Vector3>& primMax;
+    int split;
+
+    SAHLeftOf(const SAHBin& bin, const helper::vector<Vector3>& primMin, const helper::vector<Vector3>& primMax, int split)
+        : bin(bin), primMin(primMin), primMax(primMax), split(split) {}
+
+    bool operator()(int p) const { return bin(primMin[p], primMax[p]) <= split; }
+};
+
+/// Traversal of a list of independent node pairs, each one writing its own output
+class BVHTraversalFunctor
+{
+public:
+    BVHTraversalFunctor(const BVHTree& tree1, const BVHTree& tree2, bool self, double alarmDist,
+                        const helper::vector<BVHTree::IndexPair>& tasks, helper::vector< helper::vector<BVHTree::IndexPair> >& results)
+        : tree1(tree1), tree2(tree2), self(self), alarmDist(alarmDist), tasks(tasks), results(results)
+    {
+    }
+
+    void operator()(std::size_t first, std::size_t last) const
+    {
+        for (std::size_t i=first; i<last; i++)
+            tree1.collideNodes(tree2, self, alarmDist, tasks[i].first, tasks[i].second, results[i]);
+    }
+
+protected:
+    const BVHTree& tree1;
+    const BVHTree& tree2;
+    const bool self;
+    const double alarmDist;
+    const helper::vector<BVHTree::IndexPair>& tasks;
+    helper::vector< helper::vector<BVHTree::IndexPair> >& results;
+};
+
+} // namespace
+
+
+BVHTree::BVHTree()
+    : maxLeafSize(4)
+    , buildCost(0)
+{
+}
+
+void BVHTree::build(const helper::vector<Vector3>& minBBox, const helper::vector<Vector3>& maxBBox)
+{
+    const int n = (int)minBBox.size();
+    primMin = minBBox;
+    primMax = maxBBox;
+    nodes.clear();
+    primitives.resize(n);
+    for (int i=0; i<n; i++)
+        primitives[i] = i;
+    buildCost = 0;
+    if (n == 0)
+        return;
+
+    Node root;
+    root.children = -1;
+    root.first = 0;
+    root.count = n;
+    nodes.reserve(2*(n/maxLeafSize)+1);
+    nodes.push_back(root);
+
+    helper::vector<int> stack;
+    stack.push_back(0);
+    while (!stack.empty())
+    {
+        const int node = stack.back();
+        stack.pop_back();
+        const int first = nodes[node].first;
+        const int count = nodes[node].count;
+        if (count <= maxLeafSize)
+            continue;
+
+        // bounds of the centroids (as min+max)
+        Vector3 cmin = primMin[primitives[first]] + primMax[primitives[first]];
+        Vector3 cmax = cmin;
+        for (int i=first+1; i<first+count; i++)
+        {
+            const Vector3 c = primMin[primitives[i]] + primMax[primitives[i]];
+            growBox(cmin, cmax, c, c);
+        }
+        cmin *= 0.5;
+        cmax *= 0.5;
+
+        // binned surface area heuristic: minimize the sum of area*count of both sides
+        int bestAxis = -1, bestSplit = -1;
+        double bestCost = 0;
+        for (int axis=0; axis<3; axis++)
+        {
+            if (!(cmax[axis] > cmin[axis]))
+                continue;
+            SAHBin bin(axis, cmin[axis], cmax[axis]);
+            int binCount[SAH_BINS];
+            Vector3 binMin[SAH_BINS], binMax[SAH_BINS];
+            for (int b=0; b<SAH_BINS; b++)
+            {
+                binCount[b] = 0;
+                binMin[b] = primMax[primitives[first]];
+                binMax[b] = primMin[primitives[first]];
+            }
+            for (int i=first; i<first+count; i++)
+            {
+                const int p = primitives[i];
+                const int b = bin(primMin[p], primMax[p]);
+                if (binCount[b]++ == 0)
+                {
+                    binMin[b] = primMin[p];
+                    binMax[b] = primMax[p];
+                }
+                else
+                    growBox(binMin[b], binMax[b], primMin[p], primMax[p]);
+            }
+
+            // areas and counts on the right of each split, then sweep from the left
+            double rightArea[SAH_BINS];
+            int rightCount[SAH_BINS];
+            Vector3 rmin, rmax;
+            int rcount = 0;
+            for (int b=SAH_BINS-1; b>0; b--)
+            {
+                if (binCount[b])
+                {
+                    if (rcount == 0) { rmin = binMin[b]; rmax = binMax[b]; }
+                    else growBox(rmin, rmax, binMin[b], binMax[b]);
+                    rcount += binCount[b];
+                }
+                rightCount[b-1] = rcount;
+                rightArea[b-1] = rcount ? boxArea(rmin, rmax) : 0.0;
+            }
+            Vector3 lmin, lmax;
+            int lcount = 0;
+            for (int b=0; b<SAH_BINS-1; b++)
+            {
+                if (binCount[b])
+                {
+                    if (lcount == 0) { lmin = binMin[b]; lmax = binMax[b]; }
+                    else growBox(lmin, lmax, binMin[b], binMax[b]);
+                    lcount += binCount[b];
+                }
+                if (lcount == 0 || rightCount[b] == 0)
+                    continue;
+                const double cost = boxArea(lmin, lmax) * lcount + rightArea[b] * rightCount[b];
+                if (bestAxis < 0 || cost < bestCost)
+                {
+                    bestAxis = axis;
+                    bestSplit = b;
+                    bestCost = cost;
+                }
+            }
+        }
+
+        int middle;
+        if (bestAxis >= 0)
+        {
+            SAHBin bin(bestAxis, cmin[bestAxis], cmax[bestAxis]);
+            middle = (int)(std::partition(primitives.begin()+first, primitives.begin()+first+count, SAHLeftOf(bin, primMin, primMax, bestSplit)) - primitives.begin());
+        }
+        else
+        {
+            // all the centroids are at the same place
+            middle = first + count/2;
+        }
+
+        const int children = (int)nodes.size();
+        Node left, right;
+        left.children = right.children = -1;
+        left.first = first;
+        left.count = middle - first;
+        right.first = middle;
+        right.count = first + count - middle;
+        nodes[node].children = children;
+        nodes.push_back(left);
+        nodes.push_back(right);
+        stack.push_back(children);
+        stack.push_back(children+1);
+    }
+
+    refit(minBBox, maxBBox);
+    buildCost = cost();
+}
+
+void BVHTree::refit(const helper::vector<Vector3>& minBBox, const helper::vector<Vector3>& maxBBox)
+{
+    primMin = minBBox;
+    primMax = maxBBox;
+
+    // children are stored after their parent
+    for (int i=(int)nodes.size()-1; i>=0; i--)
+    {
+        Node& node = nodes[i];
+        if (node.children < 0)
+        {
+            node.minBBox = primMin[primitives[node.first]];
+            node.maxBBox = primMax[primitives[node.first]];
+            for (int j=node.first+1; j<node.first+node.count; j++)
+                growBox(node.minBBox, node.maxBBox, primMin[primitives[j]], primMax[primitives[j]]);
+        }
+        else
+        {
+            node.minBBox = nodes[node.children].minBBox;
+            node.maxBBox = nodes[node.children].maxBBox;
+            growBox(node.minBBox, node.maxBBox, nodes[node.children+1].minBBox, nodes[node.children+1].maxBBox);
+        }
+    }
+}
+
+bool BVHTree::update(const helper::vector<Vector3>& minBBox, const helper::vector<Vector3>& maxBBox, double rebuildRatio)
+{
+    if (nodes.empty() || minBBox.size() != primMin.size())
+    {
+        build(minBBox, maxBBox);
+        return true;
+    }
+
+    refit(minBBox, maxBBox);
+    if (cost() > rebuildRatio * buildCost)
+    {
+        build(minBBox, maxBBox);
+        return true;
+    }
+    return false;
+}
+
+double BVHTree::cost() const
+{
+    if (nodes.empty())
+        return 0;
+
+    const double rootArea = boxArea(nodes[0].minBBox, nodes[0].maxBBox);
+    if (!(rootArea > 0))
+        return (double)nodes.size();
+
+    double area = 0;
+    for (unsigned int i=0; i<nodes.size(); i++)
+        area += boxArea(nodes[i].minBBox, nodes[i].maxBBox);
+    return area / rootArea;
+}
+
+bool BVHTree::needsTest(const BVHTree& other, bool self, double alarmDist, int a, int b) const
+{
+    if (self && a == b)
+        return true;
+    const Node& n1 = nodes[a];
+    const Node& n2 = other.nodes[b];
+    return boxOverlap(n1.minBBox, n1.maxBBox, n2.minBBox, n2.maxBBox, alarmDist);
+}
+
+bool BVHTree::split(const BVHTree& other, bool self, int a, int b, helper::vector<IndexPair>& children) const
+{
+    const Node& n1 = nodes[a];
+    const Node& n2 = other.nodes[b];
+
+    if (self && a == b)
+    {
+        if (n1.children < 0)
+            return false;
+        const int c = n1.children;
+        children.push_back(std::make_pair(c, c));
+        children.push_back(std::make_pair(c+1, c+1));
+        children.push_back(std::make_pair(c, c+1));
+        return true;
+    }
+
+    if (n1.children < 0 && n2.children < 0)
+        return false;
+
+    // descend into the largest node
+    if (n2.children < 0 || (n1.children >= 0 && boxArea(n1.minBBox, n1.maxBBox) >= boxArea(n2.minBBox, n2.maxBBox)))
+    {
+        children.push_back(std::make_pair(n1.children, b));
+        children.push_back(std::make_pair(n1.children+1, b));
+    }
+    else
+    {
+        children.push_back(std::make_pair(a, n2.children));
+        children.push_back(std::make_pair(a, n2.children+1));
+    }
+    return true;
+}
+
+void BVHTree::collideLeaves(const BVHTree& other, bool self, double alarmDist, int a, int b, helper::vector<IndexPair>& pairs) const
+{
+    const Node& n1 = nodes[a];
+    const Node& n2 = other.nodes[b];
+
+    if (self && a == b)
+    {
+        for (int i=n1.first; i<n1.first+n1.count; i++)
+        {
+            const int p = primitives[i];
+            for (int j=i+1; j<n1.first+n1.count; j++)
+            {
+                const int q = primitives[j];
+                if (boxOverlap(primMin[p], primMax[p], primMin[q], primMax[q], alarmDist))
+                    pairs.push_back(p < q ? std::make_pair(p, q) : std::make_pair(q, p));
+            }
+        }
+        return;
+    }
+
+    for (int i=n1.first; i<n1.first+n1.count; i++)
+    {
+        const int p = primitives[i];
+        for (int j=n2.first; j<n2.first+n2.count; j++)
+        {
+            const int q = other.primitives[j];
+            if (!boxOverlap(primMin[p], primMax[p], other.primMin[q], other.primMax[q], alarmDist))
+                continue;
+            if (self && q < p)
+                pairs.push_back(std::make_pair(q, p));
+            else
+                pairs.push_back(std::make_pair(p, q));
+        }
+    }
+}
+
+void BVHTree::collideNodes(const BVHTree& other, bool self, double alarmDist, int a, int b, helper::vector<IndexPair>& pairs) const
+{
+    helper::vector<IndexPair> stack;
+    stack.push_back(std::make_pair(a, b));
+    while (!stack.empty())
+    {
+        const IndexPair current = stack.back();
+        stack.pop_back();
+        if (!needsTest(other, self, alarmDist, current.first, current.second))
+            continue;
+        if (!split(other, self, current.first, current.second, stack))
+            collideLeaves(other, self, alarmDist, current.first, current.second, pairs);
+    }
+}
+
+void BVHTree::traverse(const BVHTree& other, bool self, double alarmDist, helper::vector<IndexPair>& pairs, bool parallel) const
+{
+    if (nodes.empty() || other.nodes.empty())
+        return;
+
+    const std::size_t nbThreads = parallel ? (std::size_t)simulation::TaskScheduler::getInstance().getThreadCount() : 1;
+    if (nbThreads < 2)
+    {
+        collideNodes(other, self, alarmDist, 0, 0, pairs);
+        return;
+    }
+
+    // expand the top of the traversal breadth-first, until there are enough independent node pairs
+    helper::vector<IndexPair> tasks, next;
+    tasks.push_back(std::make_pair(0, 0));
+    bool expanded = true;
+    while (expanded && tasks.size() < TASKS_PER_THREAD * nbThreads)
+    {
+        expanded = false;
+        next.clear();
+        for (unsigned int i=0; i<tasks.size(); i++)
+        {
+            if (!needsTest(other, self, alarmDist, tasks[i].first, tasks[i].second))
+                continue;
+            if (split(other, self, tasks[i].first, tasks[i].second, next))
+                expanded = true;
+            else
+                next.push_back(tasks[i]);
+        }
+        tasks.swap(next);
+    }
+
+    helper::vector< helper::vector<IndexPair> > results(tasks.size());
+    BVHTraversalFunctor functor(*this, other, self, alarmDist, tasks, results);
+    simulation::parallelFor(0, tasks.size(), functor, 1);
+
+    // gathered in the order of the tasks, whatever the thread which processed them
+    for (unsigned int i=0; i<results.size(); i++)
+        pairs.insert(pairs.end(), results[i].begin(), results[i].end());
+}
+
+void BVHTree::collide(const BVHTree& other, double alarmDist, helper::vector<IndexPair>& pairs, bool parallel) const
+{
+    traverse(other, false, alarmDist, pairs, parallel);
+}
+
+void BVHTree::selfCollide(double alarmDist, helper::vector<IndexPair>& pairs, bool parallel) const
+{
+    traverse(*this, true, alarmDist, pairs, parallel);
+}
+
+
+SOFA_DECL_CLASS(BVHDetection)
+
+int BVHDetectionClass = core::RegisterObject("Collision detection using a refitted bounding volume hierarchy per collision model")
+        .add< BVHDetection >()
+        ;
+
+BVHDetection::BVHDetection()
+    : d_rebuildRatio(initData(&d_rebuildRatio, 1.5, "rebuildRatio", "Rebuild a tree instead of refitting it when its cost (sum of the areas of its nodes relative to its root) exceeds this ratio of its cost after the last build"))
+    , d_maxLeafSize(initData(&d_maxLeafSize, 4, "maxLeafSize", "Maximum number of elements in a leaf of the trees"))
+    , d_parallel(initData(&d_parallel, false, "parallel", "Traverse the trees on several threads"))
+    , d_nbRebuilds(initData(&d_nbRebuilds, 0, "nbRebuilds", "OUTPUT: number of trees rebuilt instead of refitted during the last step"))
+    , step(0)
+{
+    d_nbRebuilds.setReadOnly(true);
+    d_nbRebuilds.setGroup("Stats");
+}
+
+BVHDetection::~BVHDetection()
+{
+}
+
+void BVHDetection::init()
+{
+    BruteForceDetection::init();
+
+    if (d_parallel.getValue())
+        simulation::TaskScheduler::getInstance().start();
+}
+
+void BVHDetection::beginNarrowPhase()
+{
+    BruteForceDetection::beginNarrowPhase();
+    ++step;
+    d_nbRebuilds.setValue(0);
+}
+
+BVHTree* BVHDetection::getTree(core::CollisionModel* finalcm)
+{
+    // a cube per element, as computed by the models for a bounding tree of depth 0
+    CubeModel* cubes = dynamic_cast<CubeModel*>(finalcm->getPrevious());
+    if (cubes == NULL || cubes->getPrevious() == NULL || cubes->getSize() != finalcm->getSize())
+        return NULL;
+
+    std::map<core::CollisionModel*, ModelTree>::iterator it = trees.find(finalcm);
+    if (it != trees.end() && it->second.step == step)
+        return &it->second.tree;
+
+    ModelTree& t = trees[finalcm];
+    t.step = step;
+    const int n = cubes->getSize();
+    minBBox.resize(n);
+    maxBBox.resize(n);
+    for (int i=0; i<n; i++)
+    {
+        const CubeModel::CubeData& c = cubes->getCubeData(i);
+        minBBox[i] = c.minBBox;
+        maxBBox[i] = c.maxBBox;
+    }
+    t.tree.setMaxLeafSize(d_maxLeafSize.getValue());
+    if (t.tree.update(minBBox, maxBBox, d_rebuildRatio.getValue()))
+        d_nbRebuilds.setValue(d_nbRebuilds.getValue() + 1);
+    return &t.tree;
+}
+
+void BVHDetection::beginParallelCollisionPairs(const sofa::helper::vector<ModelPair>& v)
+{
+    BruteForceDetection::beginParallelCollisionPairs(v);
+
+    for (sofa::helper::vector<ModelPair>::const_iterator it = v.begin(); it != v.end(); ++it)
+    {
+        getTree(it->first->getLast());
+        getTree(it->second->getLast());
+    }
+}
+
+void BVHDetection::addCollisionPair(const std::pair<core::CollisionModel*, core::CollisionModel*>& cmPair)
+{
+    sofa::helper::AdvancedTimer::StepVar bvhTimer("BVHDetection::addCollisionPair");
+
+    core::CollisionModel *cm1 = cmPair.first;
+    core::CollisionModel *cm2 = cmPair.second;
+
+    if (!cm1->isSimulated() && !cm2->isSimulated())
+        return;
+
+    if (cm1->empty() || cm2->empty())
+        return;
+
+    core::CollisionModel *finalcm1 = cm1->getLast();
+    core::CollisionModel *finalcm2 = cm2->getLast();
+
+    BVHTree* tree1 = getTree(finalcm1);
+    BVHTree* tree2 = getTree(finalcm2);
+    if (tree1 == NULL || tree2 == NULL)
+    {
+        // no cube per element to build the trees on
+        BruteForceDetection::addCollisionPair(cmPair);
+        return;
+    }
+
+    bool swapModels = false;
+    core::collision::ElementIntersector* finalintersector = intersectionMethod->findIntersector(finalcm1, finalcm2, swapModels);
+    if (finalintersector == NULL)
+        return;
+    if (swapModels)
+    {
+        std::swap(finalcm1, finalcm2);
+        std::swap(tree1, tree2);
+    }
+
+    sofa::core::collision::DetectionOutputVector*& outputs = this->getDetectionOutputs(finalcm1, finalcm2);
+
+    finalintersector->beginIntersect(finalcm1, finalcm2, outputs);//creates outputs if null
+
+    const double alarmDist = intersectionMethod->getAlarmDistance();
+    helper::vector<IndexPair> pairs;
+    {
+        sofa::helper::AdvancedTimer::StepVar traversalTimer("BVHDetection::traversal");
+        if (tree1 == tree2)
+            tree1->selfCollide(alarmDist, pairs, d_parallel.getValue());
+        else
+            tree1->collide(*tree2, alarmDist, pairs, d_parallel.getValue());
+    }
+
+    intersectCubePairs(finalintersector, finalcm1, finalcm2, pairs, outputs);
+}
+
+} // namespace collision
+
+} // namespace component
+
+} // namespace sofa
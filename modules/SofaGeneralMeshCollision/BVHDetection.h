@@ -0,0 +1,191 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2016 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This library is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This library is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this library; if not, write to the Free Software Foundation,     *
+* Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA.          *
+*******************************************************************************
+*                               SOFA :: Modules                               *
+*                                                                             *
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#ifndef SOFA_COMPONENT_COLLISION_BVHDETECTION_H
+#define SOFA_COMPONENT_COLLISION_BVHDETECTION_H
+#include "config.h"
+
+#include <SofaBaseCollision/BruteForceDetection.h>
+#include <sofa/defaulttype/Vec.h>
+#include <sofa/helper/vector.h>
+#include <map>
+
+
+namespace sofa
+{
+
+namespace component
+{
+
+namespace collision
+{
+
+/**
+  *Axis aligned bounding box tree over a set of primitives given by their boxes.
+  *
+  *The tree is built top-down with the surface area heuristic, evaluated on a
+  *fixed number of bins along each axis. The two children of a node are stored
+  *next to each other, after their parent, so that the tree can be refitted in
+  *place, from the last node to the root, when the primitives move.
+  *
+  *The quality of the tree is measured by the sum of the areas of its nodes,
+  *relative to the area of the root: this is the expected number of nodes
+  *visited by a random query. update() rebuilds the tree when this cost grows
+  *too much compared to the cost right after the last build.
+  */
+class SOFA_GENERAL_MESH_COLLISION_API BVHTree
+{
+public:
+    typedef defaulttype::Vector3 Vector3;
+    typedef std::pair<int,int> IndexPair;
+
+    struct Node
+    {
+        Vector3 minBBox, maxBBox;
+        int children; ///< index of the first of the two children, or -1 for a leaf
+        int first;    ///< for a leaf, first primitive in the primitives array
+        int count;    ///< for a leaf, number of primitives
+    };
+
+    BVHTree();
+
+    /// Build the tree from scratch
+    void build(const helper::vector<Vector3>& minBBox, const helper::vector<Vector3>& maxBBox);
+
+    /// Recompute the boxes of the nodes, keeping the structure of the tree
+    void refit(const helper::vector<Vector3>& minBBox, const helper::vector<Vector3>& maxBBox);
+
+    /// Refit the tree, or rebuild it if the number of primitives changed or if its cost
+    /// exceeds rebuildRatio times its cost after the last build. Return true if it was rebuilt.
+    bool update(const helper::vector<Vector3>& minBBox, const helper::vector<Vector3>& maxBBox, double rebuildRatio);
+
+    /// Sum of the areas of the nodes, divided by the area of the root
+    double cost() const;
+
+    double getBuildCost() const { return buildCost; }
+
+    /// Pairs (i,j) of primitives of this tree and of the other one whose boxes are closer than alarmDist along each axis.
+    /// If parallel is set, the traversal is split among the threads of the TaskScheduler; the pairs are in the same order either way.
+    void collide(const BVHTree& other, double alarmDist, helper::vector<IndexPair>& pairs, bool parallel = false) const;
+
+    /// Pairs (i,j), i<j, of primitives of this tree whose boxes are closer than alarmDist along each axis
+    void selfCollide(double alarmDist, helper::vector<IndexPair>& pairs, bool parallel = false) const;
+
+    int size() const { return (int)primMin.size(); }
+
+    const helper::vector<Node>& getNodes() const { return nodes; }
+
+    void setMaxLeafSize(int s) { maxLeafSize = (s > 0 ? s : 1); }
+
+    /// Append the pairs of primitives below the node a of this tree and the node b of the other tree.
+    /// In self mode (other is this tree), the node pair (a,a) stands for the pairs inside the subtree of a.
+    void collideNodes(const BVHTree& other, bool self, double alarmDist, int a, int b, helper::vector<IndexPair>& pairs) const;
+
+protected:
+    helper::vector<Node> nodes;
+    helper::vector<int> primitives;      ///< primitives sorted by leaf
+    helper::vector<Vector3> primMin, primMax;
+    int maxLeafSize;
+    double buildCost;
+
+    void traverse(const BVHTree& other, bool self, double alarmDist, helper::vector<IndexPair>& pairs, bool parallel) const;
+
+    /// Whether the node pair (a,b) has to be tested, i.e. is a self node or has overlapping boxes
+    bool needsTest(const BVHTree& other, bool self, double alarmDist, int a, int b) const;
+
+    /// Append the node pairs to test below (a,b), or return false if both nodes are leaves
+    bool split(const BVHTree& other, bool self, int a, int b, helper::vector<IndexPair>& children) const;
+
+    /// Append the pairs of overlapping primitives of the leaves a and b
+    void collideLeaves(const BVHTree& other, bool self, double alarmDist, int a, int b, helper::vector<IndexPair>& pairs) const;
+};
+
+/**
+  *Collision detection using a bounding volume hierarchy per collision model.
+  *
+  *The broad phase is the one of BruteForceDetection. Instead of the deep
+  *CubeModel hierarchy, rebuilt by the models at each step, the narrow phase
+  *keeps a BVHTree over the leaf cubes of each model. The trees are refitted at
+  *each step and only rebuilt when their quality degrades. Trees are then
+  *traversed against each other, the independent pairs of nodes being
+  *processed on the TaskScheduler threads. The candidate pairs of elements are
+  *finally tested in a fixed order, so that the contacts do not depend on the
+  *number of threads.
+  */
+class SOFA_GENERAL_MESH_COLLISION_API BVHDetection : public BruteForceDetection
+{
+public:
+    SOFA_CLASS(BVHDetection, BruteForceDetection);
+
+    typedef BVHTree::IndexPair IndexPair;
+
+    Data<double> d_rebuildRatio;
+    Data<int> d_maxLeafSize;
+    Data<bool> d_parallel;
+    Data<int> d_nbRebuilds;
+
+protected:
+    BVHDetection();
+
+    ~BVHDetection();
+
+    struct ModelTree
+    {
+        ModelTree() : step(-1) {}
+        BVHTree tree;
+        int step; ///< last step the tree was updated
+    };
+
+    std::map<core::CollisionModel*, ModelTree> trees;
+    int step;
+    helper::vector<BVHTree::Vector3> minBBox, maxBBox;
+
+    /// Tree over the leaf cubes of the given final model, updated once per step.
+    /// Only looked up if it is already updated, so it can be called from several threads after beginParallelCollisionPairs.
+    BVHTree* getTree(core::CollisionModel* finalcm);
+
+public:
+
+    void init();
+
+    virtual void beginNarrowPhase();
+
+    void addCollisionPair (const std::pair<core::CollisionModel*, core::CollisionModel*>& cmPair);
+
+    /// Update the trees of the models of the pairs, before they are processed in parallel
+    virtual void beginParallelCollisionPairs(const sofa::helper::vector<ModelPair>& v);
+
+    /// addCollisionPair only reads the trees updated by beginParallelCollisionPairs
+    virtual bool canAddCollisionPairsInParallel() const { return true; }
+
+    inline virtual bool needsDeepBoundingTree()const{return false;}
+};
+
+} // namespace collision
+
+} // namespace component
+
+} // namespace sofa
+
+#endif
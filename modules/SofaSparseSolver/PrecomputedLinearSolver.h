@@ -31,6 +31,7 @@
 #include <sofa/simulation/MechanicalVisitor.h>
 #include <SofaBaseLinearSolver/SparseMatrix.h>
 #include <SofaBaseLinearSolver/FullMatrix.h>
+#include <SofaBaseLinearSolver/PrecomputedMatrixCache.h>
 #include <sofa/helper/map.h>
 #include <math.h>
 #include <SofaBaseLinearSolver/CompressedRowSparseMatrix.h>
@@ -56,25 +57,36 @@ public :
     std::vector<int> idActiveDofs;
     std::vector<int> invActiveDofs;
 
-    bool readFile(const char * filename,unsigned systemSize)
-    {
-        std::ifstream compFileIn(filename, std::ifstream::binary);
+    /// Mapping of the file Minv was loaded from, if any (Minv is then read-only)
+    PrecomputedMatrixCache cache;
 
-        if(compFileIn.good())
+    /// Map Minv from a file, if it has been computed for the given key
+    bool readFile(const char * filename,unsigned systemSize,const PrecomputedMatrixCache::Key& key)
+    {
+        switch (cache.open<Real>(filename, key, systemSize, systemSize))
         {
-            std::cout << "file open : " << filename << " compliance being loaded" << std::endl;
-            compFileIn.read((char*) Minv[0], systemSize * systemSize * sizeof(Real));
-            compFileIn.close();
+        case PrecomputedMatrixCache::VALID:
+            std::cout << "file open : " << filename << " compliance being mapped" << std::endl;
+            Minv.setptr(const_cast<Real*>(cache.values<Real>()), systemSize, systemSize);
             return true;
+        case PrecomputedMatrixCache::OUTDATED:
+            std::cout << "file " << filename << " was computed for other parameters" << std::endl;
+            return false;
+        default:
+            return false;
         }
-        return false;
     }
 
-    void writeFile(const char * filename,unsigned systemSize)
+    /// Save Minv in a file, and use the file mapping instead of the allocated matrix
+    void writeFile(const char * filename,unsigned systemSize,const PrecomputedMatrixCache::Key& key)
     {
-        std::ofstream compFileOut(filename, std::fstream::out | std::fstream::binary);
-        compFileOut.write((char*) Minv[0], systemSize * systemSize*sizeof(Real));
-        compFileOut.close();
+        if (!PrecomputedMatrixCache::write<Real>(filename, key, systemSize, systemSize, Minv[0]))
+        {
+            std::cerr << "ERROR: unable to write " << filename << std::endl;
+            return;
+        }
+        if (cache.open<Real>(filename, key, systemSize, systemSize) == PrecomputedMatrixCache::VALID)
+            Minv.setptr(const_cast<Real*>(cache.values<Real>()), systemSize, systemSize);
     }
 };
 
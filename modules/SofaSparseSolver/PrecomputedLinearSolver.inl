@@ -94,7 +94,6 @@ template<class TMatrix,class TVector>
 void PrecomputedLinearSolver<TMatrix,TVector >::loadMatrix(TMatrix& M)
 {
     systemSize = this->currentGroup->systemMatrix->rowSize();
-    internalData.Minv.resize(systemSize,systemSize);
     dt = this->getContext()->getDt();
 
     odesolver::EulerImplicitSolver* EulerSolver;
@@ -102,17 +101,25 @@ void PrecomputedLinearSolver<TMatrix,TVector >::loadMatrix(TMatrix& M)
     factInt = 1.0; // christian : it is not a compliance... but an admittance that is computed !
     if (EulerSolver) factInt = EulerSolver->getPositionIntegrationFactor(); // here, we compute a compliance
 
+    PrecomputedMatrixCache::Key key;
+    key.add(this->getTemplateName());
+    key.add((long long)systemSize);
+    key.add(dt);
+    key.add(factInt);
+    key.addMechanicalContext(this->getContext(), this);
+
     std::stringstream ss;
-    ss << this->getContext()->getName() << "-" << systemSize << "-" << dt << ".comp";
-    if(! use_file.getValue() || ! internalData.readFile(ss.str().c_str(),systemSize) )
-    {
+    ss << this->getContext()->getName() << "-" << systemSize << "-" << dt << "-" << key.str() << ".comp";
+    if(use_file.getValue() && internalData.readFile(ss.str().c_str(),systemSize,key))
+        return;
+
+    internalData.Minv.resize(systemSize,systemSize);
 #ifdef SOFA_HAVE_CSPARSE
-        loadMatrixWithCSparse(M);
-        if (use_file.getValue()) internalData.writeFile(ss.str().c_str(),systemSize);
+    loadMatrixWithCSparse(M);
 #else
-        serr << "CSPARSE support is required to invert the matrix" << sendl;
+    serr << "CSPARSE support is required to invert the matrix" << sendl;
+    return;
 #endif
-    }
 
     for (unsigned int j=0; j<systemSize; j++)
     {
@@ -121,6 +128,9 @@ void PrecomputedLinearSolver<TMatrix,TVector >::loadMatrix(TMatrix& M)
             internalData.Minv.set(j,i,internalData.Minv.element(j,i)/factInt);
         }
     }
+
+    // the file stores the inverse itself, so that it can be used in place
+    if (use_file.getValue()) internalData.writeFile(ss.str().c_str(),systemSize,key);
 }
 
 #ifdef SOFA_HAVE_CSPARSE
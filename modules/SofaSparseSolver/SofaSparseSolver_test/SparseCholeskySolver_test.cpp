@@ -0,0 +1,142 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2016 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU General Public License as published by the Free  *
+* Software Foundation; either version 2 of the License, or (at your option)   *
+* any later version.                                                          *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for    *
+* more details.                                                               *
+*                                                                             *
+* You should have received a copy of the GNU General Public License along     *
+* with this program; if not, write to the Free Software Foundation, Inc., 51  *
+* Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA.                   *
+*******************************************************************************
+*                            SOFA :: Applications                             *
+*                                                                             *
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <SofaTest/Sofa_test.h>
+
+#include <SofaSparseSolver/SparseCholeskySolver.h>
+#include <SofaBaseLinearSolver/CompressedRowSparseMatrix.h>
+#include <SofaBaseLinearSolver/SparseMatrix.h>
+#include <SofaBaseLinearSolver/FullMatrix.h>
+#include <SofaBaseLinearSolver/FullVector.h>
+#include <sofa/simulation/TaskScheduler.h>
+
+#include <gtest/gtest.h>
+
+namespace sofa {
+
+using component::linearsolver::CompressedRowSparseMatrix;
+using component::linearsolver::SparseMatrix;
+using component::linearsolver::FullMatrix;
+using component::linearsolver::FullVector;
+using component::linearsolver::MatrixLinearSolver;
+using simulation::TaskScheduler;
+
+/** SparseCholeskySolver::addJMInvJtLocal, which solves all the rows of J as a
+  block with forward substitutions only, gives the same J A^-1 J^t as the
+  default implementation of MatrixLinearSolver, doing one solveSystem per row,
+  on one thread and on several.
+  */
+struct SparseCholeskySolver_test : public Sofa_test<double>
+{
+    typedef CompressedRowSparseMatrix<double> Matrix;
+    typedef FullVector<double> Vector;
+    typedef component::linearsolver::SparseCholeskySolver<Matrix,Vector> Solver;
+    typedef MatrixLinearSolver<Matrix,Vector> DefaultSolver;
+
+    enum { N = 40, NbRows = 6 };
+
+    ~SparseCholeskySolver_test()
+    {
+        TaskScheduler::getInstance().stop();
+    }
+
+    /// Band matrix with a dominant diagonal, so that it is symmetric positive definite
+    static void fill(Matrix& m)
+    {
+        m.resize(N,N);
+        for (int i=0; i<N; ++i)
+        {
+            m.add(i, i, 4.0 + 0.1*(i%5));
+            for (int k=1; k<=3 && i+k<N; ++k)
+            {
+                const double v = (k==1) ? -1.0 : 0.2*k - 0.7;
+                m.add(i, i+k, v);
+                m.add(i+k, i, v);
+            }
+        }
+        m.compress();
+    }
+
+    /// Rows of J with scattered and overlapping columns, one of them empty
+    static void fill(SparseMatrix<double>& J)
+    {
+        J.resize(NbRows, N);
+        J.set(0, 0, 1.0);
+        J.set(0, N-1, -2.0);
+        J.set(1, 5, 0.5);
+        J.set(1, 6, 1.5);
+        J.set(1, 20, -1.0);
+        J.set(2, 21, 3.0);
+        for (int i=0; i<N; i+=3)
+            J.set(3, i, 0.1*(i%7) - 0.3);
+        J.set(5, 6, -0.75);
+        J.set(5, 39, 1.25);
+        J.set(5, 12, 2.0);
+    }
+
+    void sameResultAsDefaultImplementation()
+    {
+        SparseMatrix<double> J;
+        fill(J);
+        const double fact = 0.5;
+
+        FullMatrix<double> expected(NbRows,NbRows), actual(NbRows,NbRows);
+        expected.clear();
+        actual.clear();
+
+        // each solver owns its system matrix
+        Solver::SPtr reference = core::objectmodel::New<Solver>();
+        Matrix* A = new Matrix;
+        fill(*A);
+        reference->setSystemMatrix(A);
+        ASSERT_TRUE(reference->DefaultSolver::addJMInvJtLocal(A, &expected, &J, fact));
+
+        Solver::SPtr solver = core::objectmodel::New<Solver>();
+        A = new Matrix;
+        fill(*A);
+        solver->setSystemMatrix(A);
+        ASSERT_TRUE(solver->addJMInvJtLocal(A, &actual, &J, fact));
+
+        for (int i=0; i<NbRows; ++i)
+            for (int j=0; j<NbRows; ++j)
+                EXPECT_NEAR(expected.element(i,j), actual.element(i,j), 1e-12) << "(" << i << "," << j << ")";
+
+        // the empty row of J gives an empty row and column
+        for (int i=0; i<NbRows; ++i)
+            EXPECT_EQ(0.0, actual.element(4,i));
+    }
+};
+
+TEST_F(SparseCholeskySolver_test, addJMInvJt)
+{
+    sameResultAsDefaultImplementation();
+}
+
+TEST_F(SparseCholeskySolver_test, addJMInvJtParallel)
+{
+    TaskScheduler::getInstance().start(4);
+    sameResultAsDefaultImplementation();
+}
+
+} // namespace sofa
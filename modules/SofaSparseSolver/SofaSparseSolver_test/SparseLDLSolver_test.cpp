@@ -0,0 +1,213 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2016 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU General Public License as published by the Free  *
+* Software Foundation; either version 2 of the License, or (at your option)   *
+* any later version.                                                          *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for    *
+* more details.                                                               *
+*                                                                             *
+* You should have received a copy of the GNU General Public License along     *
+* with this program; if not, write to the Free Software Foundation, Inc., 51  *
+* Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA.                   *
+*******************************************************************************
+*                            SOFA :: Applications                             *
+*                                                                             *
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <SofaTest/Sofa_test.h>
+
+#include <SofaSparseSolver/SparseLDLSolver.h>
+#include <SofaBaseLinearSolver/CompressedRowSparseMatrix.h>
+#include <SofaBaseLinearSolver/SparseMatrix.h>
+#include <SofaBaseLinearSolver/FullMatrix.h>
+#include <SofaBaseLinearSolver/FullVector.h>
+#include <sofa/simulation/TaskScheduler.h>
+
+#include <gtest/gtest.h>
+
+namespace sofa {
+
+using component::linearsolver::CompressedRowSparseMatrix;
+using component::linearsolver::SparseMatrix;
+using component::linearsolver::FullMatrix;
+using component::linearsolver::FullVector;
+using component::linearsolver::MatrixLinearSolver;
+using simulation::TaskScheduler;
+
+/** The supernodal factorization of SparseLDLSolver, used once the pattern of
+  the matrix is known, gives the same solutions as the scalar one, on one
+  thread and on several.
+  Its addJMInvJtLocal gives the same J A^-1 J^t as the default implementation
+  of MatrixLinearSolver, doing one solveSystem per row of J.
+  */
+struct SparseLDLSolver_test : public Sofa_test<double>
+{
+    typedef CompressedRowSparseMatrix<double> Matrix;
+    typedef FullVector<double> Vector;
+    typedef component::linearsolver::SparseLDLSolver<Matrix,Vector> Solver;
+    typedef MatrixLinearSolver<Matrix,Vector> DefaultSolver;
+
+    enum { GridSize = 8, BlockSize = 3, N = GridSize*GridSize*BlockSize, NbRows = 7 };
+
+    ~SparseLDLSolver_test()
+    {
+        TaskScheduler::getInstance().stop();
+    }
+
+    /// 3x3 blocks of the laplacian of a 2D grid, with a dominant diagonal.
+    /// The dofs of a node share the same pattern, so the columns of L form supernodes.
+    static void fill(Matrix& m, double coupling)
+    {
+        m.resize(N,N);
+        for (int y=0; y<GridSize; ++y)
+            for (int x=0; x<GridSize; ++x)
+            {
+                const int node = y*GridSize + x;
+                const int neighbors[4][2] = { {x-1,y}, {x+1,y}, {x,y-1}, {x,y+1} };
+                for (int a=0; a<BlockSize; ++a)
+                    for (int b=0; b<BlockSize; ++b)
+                        m.add(node*BlockSize+a, node*BlockSize+b, (a==b) ? 10.0 + 0.01*node : 0.5);
+                for (int k=0; k<4; ++k)
+                {
+                    if (neighbors[k][0] < 0 || neighbors[k][0] >= GridSize || neighbors[k][1] < 0 || neighbors[k][1] >= GridSize)
+                        continue;
+                    const int other = neighbors[k][1]*GridSize + neighbors[k][0];
+                    for (int a=0; a<BlockSize; ++a)
+                        for (int b=0; b<BlockSize; ++b)
+                            m.add(node*BlockSize+a, other*BlockSize+b, (a==b) ? -coupling : 0.05*coupling);
+                }
+            }
+        m.compress();
+    }
+
+    static void fill(Vector& b)
+    {
+        b.resize(N);
+        for (int i=0; i<N; ++i)
+            b[i] = 1.0 + (i%7) - 0.25*(i%3);
+    }
+
+    /// Rows of J with scattered and overlapping columns, one of them empty
+    static void fill(SparseMatrix<double>& J)
+    {
+        J.resize(NbRows, N);
+        J.set(0, 0, 1.0);
+        J.set(0, N-1, -2.0);
+        J.set(1, 25, 0.5);
+        J.set(1, 26, 1.5);
+        J.set(1, 100, -1.0);
+        J.set(2, 101, 3.0);
+        for (int i=0; i<N; i+=5)
+            J.set(3, i, 0.1*(i%7) - 0.3);
+        J.set(5, 26, -0.75);
+        J.set(5, 150, 1.25);
+        J.set(5, 12, 2.0);
+        J.set(6, 13, 1.0);
+        J.set(6, 14, 1.0);
+    }
+
+    /// Factorize the matrices one after the other and solve for the same right-hand side, returning the last solution
+    static Vector solve(Solver* solver, Matrix* matrices, unsigned int nbMatrices)
+    {
+        Vector x, b;
+        fill(b);
+        x.resize(N);
+        for (unsigned int i=0; i<nbMatrices; ++i)
+        {
+            solver->invert(matrices[i]);
+            solver->solve(matrices[i], x, b);
+        }
+        return x;
+    }
+
+    /// The scalar factorization of the first matrix builds the supernodes, the next matrices with the same pattern are factorized by supernodes
+    void sameSolutionAsScalarFactorization()
+    {
+        Matrix matrices[3];
+        fill(matrices[0], 1.0);
+        fill(matrices[1], 0.5);
+        fill(matrices[2], 2.0);
+
+        Solver::SPtr scalar = core::objectmodel::New<Solver>();
+        Solver::SPtr supernodal = core::objectmodel::New<Solver>();
+        supernodal->d_supernodal.setValue(true);
+
+        Vector expected = solve(scalar.get(), matrices, 3);
+        Vector actual = solve(supernodal.get(), matrices, 3);
+        for (int i=0; i<N; ++i)
+            EXPECT_NEAR(expected[i], actual[i], 1e-12) << "x[" << i << "]";
+
+        // it is the solution of the last system
+        Vector b, residual;
+        fill(b);
+        residual.resize(N);
+        matrices[2].mul(residual, actual);
+        for (int i=0; i<N; ++i)
+            EXPECT_NEAR(b[i], residual[i], 1e-10) << "b[" << i << "]";
+    }
+
+    void sameJMInvJtAsDefaultImplementation()
+    {
+        SparseMatrix<double> J;
+        fill(J);
+        const double fact = 0.5;
+
+        FullMatrix<double> expected(NbRows,NbRows), actual(NbRows,NbRows);
+        expected.clear();
+        actual.clear();
+
+        // each solver owns its system matrix
+        Solver::SPtr reference = core::objectmodel::New<Solver>();
+        Matrix* A = new Matrix;
+        fill(*A, 1.0);
+        reference->setSystemMatrix(A);
+        ASSERT_TRUE(reference->DefaultSolver::addJMInvJtLocal(A, &expected, &J, fact));
+
+        Solver::SPtr solver = core::objectmodel::New<Solver>();
+        A = new Matrix;
+        fill(*A, 1.0);
+        solver->setSystemMatrix(A);
+        solver->invertSystem();
+        ASSERT_TRUE(solver->addJMInvJtLocal(A, &actual, &J, fact));
+
+        for (int i=0; i<NbRows; ++i)
+            for (int j=0; j<NbRows; ++j)
+                EXPECT_NEAR(expected.element(i,j), actual.element(i,j), 1e-12) << "(" << i << "," << j << ")";
+
+        // the empty row of J gives an empty row and column
+        for (int i=0; i<NbRows; ++i)
+            EXPECT_EQ(0.0, actual.element(4,i));
+    }
+};
+
+TEST_F(SparseLDLSolver_test, supernodal)
+{
+    sameSolutionAsScalarFactorization();
+}
+
+TEST_F(SparseLDLSolver_test, supernodalParallel)
+{
+    TaskScheduler::getInstance().start(4);
+    sameSolutionAsScalarFactorization();
+}
+
+TEST_F(SparseLDLSolver_test, addJMInvJt)
+{
+    sameJMInvJtAsDefaultImplementation();
+}
+
+TEST_F(SparseLDLSolver_test, addJMInvJtParallel)
+{
+    TaskScheduler::getInstance().start(4);
+    sameJMInvJtAsDefaultImplementation();
+}
+
+} // namespace sofa
@@ -28,6 +28,7 @@
 #include <sofa/core/visual/VisualParams.h>
 #include <sofa/core/ObjectFactory.h>
 #include <sofa/helper/system/thread/CTime.h>
+#include <sofa/simulation/ParallelFor.h>
 #include <iostream>
 #include <math.h>
 
@@ -52,10 +53,20 @@ using std::endl;
 template<class TMatrix, class TVector>
 SparseCholeskySolver<TMatrix,TVector>::SparseCholeskySolver()
     : f_verbose( initData(&f_verbose,false,"verbose","Dump system state at each iteration") )
+    , d_parallel( initData(&d_parallel,false,"parallel","start the TaskScheduler threads, so that the rows of J are solved on several threads in addJMInvJt") )
     , S(NULL), N(NULL)
 {
 }
 
+template<class TMatrix, class TVector>
+void SparseCholeskySolver<TMatrix,TVector>::init()
+{
+    Inherit::init();
+
+    if (d_parallel.getValue())
+        simulation::TaskScheduler::getInstance().start();
+}
+
 template<class TMatrix, class TVector>
 SparseCholeskySolver<TMatrix,TVector>::~SparseCholeskySolver()
 {
@@ -136,6 +147,116 @@ void SparseCholeskySolver<TMatrix,TVector>::invert(Matrix& M)
     //sout << "SparseCholeskySolver: factorization complete, nnz = " << N->L->p[N->L->n] << sendl;
 }
 
+/// Forward substitution L^-1 of rows of the permuted dense J, each row being a right-hand side of its own.
+class CholeskyJacobianSolveFunctor
+{
+public:
+    CholeskyJacobianSolveFunctor(const cs * L, double * Jdense)
+        : L(L), Jdense(Jdense)
+    {
+    }
+
+    void operator()(std::size_t first, std::size_t last) const
+    {
+        for (std::size_t c = first; c < last; c++)
+            cs_lsolve(L, Jdense + c * L->n);
+    }
+
+protected:
+    const cs * L;
+    double * Jdense;
+};
+
+/// Upper triangle of (L^-1 P J^t)^t (L^-1 P J^t), one row of the result per row of J.
+class CholeskyJacobianProductFunctor
+{
+public:
+    CholeskyJacobianProductFunctor(const double * Jdense, int n, FullMatrix<double> & JMinvJt)
+        : Jdense(Jdense), n(n), JMinvJt(JMinvJt)
+    {
+    }
+
+    void operator()(std::size_t first, std::size_t last) const
+    {
+        const std::size_t m = (std::size_t) JMinvJt.rowSize();
+        for (std::size_t j = first; j < last; j++)
+        {
+            const double * lineJ = Jdense + j * n;
+            double * res = JMinvJt[j];
+            for (std::size_t i = j; i < m; i++)
+            {
+                const double * lineI = Jdense + i * n;
+                double acc = 0.0;
+                for (int k = 0; k < n; k++)
+                    acc += lineJ[k] * lineI[k];
+                res[i] = acc;
+            }
+        }
+    }
+
+protected:
+    const double * Jdense;
+    const int n;
+    FullMatrix<double> & JMinvJt;
+};
+
+/// J A^-1 J^t = (L^-1 P J^t)^t (L^-1 P J^t), so that only the forward substitutions are needed.
+///
+/// All the rows of J are solved as one dense block of right-hand sides
+/// instead of one solveSystem per row. The rows are distributed over the
+/// TaskScheduler threads when the "parallel" Data started them, and the result
+/// is then added in a fixed order.
+template<class TMatrix, class TVector>
+bool SparseCholeskySolver<TMatrix,TVector>::addJMInvJtLocal(TMatrix * M, ResMatrixType * result, const JMatrixType * J, double fact)
+{
+    if (J->rowSize()==0) return true;
+
+    if (this->currentGroup->needInvert)
+    {
+        this->invert(*M);
+        this->currentGroup->needInvert = false;
+    }
+    if (!N)
+    {
+        serr << "addJMInvJt: the system is not factorized" << sendl;
+        return false;
+    }
+
+    const int m = J->rowSize();
+    const int n = A.n;
+
+    Jdense.clear();
+    Jdense.resize(m*n);
+
+    // x = P*b for each row
+    for (typename JMatrixType::LineConstIterator jit = J->begin(), jitend = J->end(); jit != jitend; ++jit)
+    {
+        double * line = &Jdense[jit->first * n];
+        for (typename JMatrixType::LElementConstIterator it = jit->second.begin(), itend = jit->second.end(); it != itend; ++it)
+            line[S->Pinv ? S->Pinv[it->first] : it->first] = (double) it->second;
+    }
+
+    CholeskyJacobianSolveFunctor solveFunctor(N->L, &Jdense[0]);
+    simulation::parallelFor(0, m, solveFunctor);
+
+    // small chunks, as the rows of the upper triangle have decreasing costs
+    JMinvJt.resize(m,m);
+    CholeskyJacobianProductFunctor productFunctor(&Jdense[0], n, JMinvJt);
+    simulation::parallelFor(0, m, productFunctor, 4);
+
+    for (int j=0; j<m; j++)
+    {
+        const double * res = JMinvJt[j];
+        for (int i=j; i<m; i++)
+        {
+            result->add(j,i,res[i]*fact);
+            if (i!=j) result->add(i,j,res[i]*fact);
+        }
+    }
+
+    return true;
+}
+
 SOFA_DECL_CLASS(SparseCholeskySolver)
 
 int SparseCholeskySolverClass = core::RegisterObject("Direct linear solver based on Sparse Cholesky factorization, implemented with the CSPARSE library")
@@ -54,14 +54,20 @@ public:
 
     typedef TMatrix Matrix;
     typedef TVector Vector;
+    typedef typename Matrix::Real Real;
     typedef sofa::component::linearsolver::MatrixLinearSolver<TMatrix,TVector> Inherit;
+    typedef typename Inherit::ResMatrixType ResMatrixType;
+    typedef typename Inherit::JMatrixType JMatrixType;
 
     Data<bool> f_verbose;
+    Data<bool> d_parallel;
 
     SparseCholeskySolver();
     ~SparseCholeskySolver();
+    void init();
     void solve (Matrix& M, Vector& x, Vector& b);
     void invert(Matrix& M);
+    bool addJMInvJtLocal(TMatrix * M, ResMatrixType * result,const JMatrixType * J, double fact);
 
 public :
     cs A;
@@ -70,6 +76,8 @@ public :
     int * A_i;
     int * A_p;
     helper::vector<double> A_x,z_tmp,r_tmp,tmp;
+    helper::vector<double> Jdense;  ///< rows of L^-1 P J^t, computed in addJMInvJtLocal
+    FullMatrix<double> JMinvJt;
 
     void solveT(double * z, double * r);
     void solveT(float * z, float * r);
@@ -75,6 +75,8 @@ protected :
     SparseLDLSolver();
 
     FullMatrix<Real> Jminv,Jdense;
+    FullMatrix<double> JMinvJt;
+    helper::vector<int> firstCol;
     sofa::component::linearsolver::CompressedRowSparseMatrix<Real> Mfiltered;
 //    helper::vector<Real> line,res;
 };
@@ -79,16 +79,97 @@ void SparseLDLSolver<TMatrix,TVector,TThreadManager>::invert(Matrix& M) {
     numStep++;
 }
 
-/// Default implementation of Multiply the inverse of the system matrix by the transpose of the given matrix, and multiply the result with the given matrix J
+/// Forward substitution of rows of the permuted dense J with the L factor, and scaling by D^-1.
+///
+/// Each row is a right-hand side of its own, so rows can be solved on
+/// different threads. The substitution starts at the first non-zero entry of
+/// the row, the previous entries of L^-1 J^t staying zero.
+template<class Real>
+class LDLJacobianSolveFunctor
+{
+public :
+    LDLJacobianSolveFunctor(FullMatrix<Real> & Jdense,FullMatrix<Real> & Jminv,const int * firstCol,int n,const int * LT_colptr,const int * LT_rowind,const Real * LT_values,const Real * invD)
+    : Jdense(Jdense), Jminv(Jminv), firstCol(firstCol), n(n), LT_colptr(LT_colptr), LT_rowind(LT_rowind), LT_values(LT_values), invD(invD) {}
+
+    void operator()(std::size_t first, std::size_t last) const {
+        for (std::size_t c = first ; c < last ; c++) {
+            Real * line = Jdense[c];
+
+            for (int j = firstCol[c] ; j < n ; j++) {
+                for (int p = LT_colptr[j] ; p < LT_colptr[j+1] ; p++) {
+                    int col = LT_rowind[p];
+                    double val = LT_values[p];
+                    line[j] -= val * line[col];
+                }
+            }
+
+            Real * lineM = Jminv[c];
+            for (int i = 0 ; i < n ; i++) lineM[i] = line[i] * invD[i];
+        }
+    }
+
+protected :
+    FullMatrix<Real> & Jdense;
+    FullMatrix<Real> & Jminv;
+    const int * firstCol;
+    const int n;
+    const int * LT_colptr;
+    const int * LT_rowind;
+    const Real * LT_values;
+    const Real * invD;
+};
+
+/// Upper triangle of (L^-1 J^t)^t D^-1 (L^-1 J^t), one row of the result per row of J.
+template<class Real>
+class LDLJacobianProductFunctor
+{
+public :
+    LDLJacobianProductFunctor(const FullMatrix<Real> & Jdense,const FullMatrix<Real> & Jminv,FullMatrix<double> & JMinvJt,int n)
+    : Jdense(Jdense), Jminv(Jminv), JMinvJt(JMinvJt), n(n) {}
+
+    void operator()(std::size_t first, std::size_t last) const {
+        const std::size_t m = (std::size_t) JMinvJt.rowSize();
+        for (std::size_t j = first ; j < last ; j++) {
+            const Real * lineJ = Jminv[j];
+            double * res = JMinvJt[j];
+            for (std::size_t i = j ; i < m ; i++) {
+                const Real * lineI = Jdense[i];
+
+                double acc = 0.0;
+                for (int k = 0 ; k < n ; k++) {
+                    acc += lineJ[k] * lineI[k];
+                }
+                res[i] = acc;
+            }
+        }
+    }
+
+protected :
+    const FullMatrix<Real> & Jdense;
+    const FullMatrix<Real> & Jminv;
+    FullMatrix<double> & JMinvJt;
+    const int n;
+};
+
+/// Multiply the inverse of the system matrix by the transpose of the given matrix, and multiply the result with the given matrix J
+///
+/// All the rows of J are solved as one dense block of right-hand sides. The
+/// rows are distributed over the TaskScheduler threads when the "parallel"
+/// Data started them, and the result is then added in the same order as the
+/// sequential computation.
 template<class TMatrix, class TVector, class TThreadManager>
 bool SparseLDLSolver<TMatrix,TVector,TThreadManager>::addJMInvJtLocal(TMatrix * M, ResMatrixType * result,const JMatrixType * J, double fact) {
     if (J->rowSize()==0) return true;
 
     InvertData * data = (InvertData *) this->getMatrixInvertData(M);
+    const int m = J->rowSize();
+    const int n = data->n;
 
     Jdense.clear();
-    Jdense.resize(J->rowSize(),data->n);
-    Jminv.resize(J->rowSize(),data->n);
+    Jdense.resize(m,n);
+    Jminv.resize(m,n);
+    firstCol.clear();
+    firstCol.resize(m,n);
 
     for (typename SparseMatrix<Real>::LineConstIterator jit = J->begin() , jitend = J->end(); jit != jitend; ++jit) {
         int l = jit->first;
@@ -98,42 +179,24 @@ bool SparseLDLSolver<TMatrix,TVector,TThreadManager>::addJMInvJtLocal(TMatrix *
             double val = it->second;
 
             line[col] = val;
+            if (col < firstCol[l]) firstCol[l] = col;
         }
     }
 
-    //Solve the lower triangular system
-    for (unsigned c=0;c<(unsigned)J->rowSize();c++) {
-        Real * line = Jdense[c];
+    //Solve the lower triangular system and apply diagonal
+    LDLJacobianSolveFunctor<Real> solveFunctor(Jdense,Jminv,&firstCol[0],n,&data->LT_colptr[0],&data->LT_rowind[0],&data->LT_values[0],&data->invD[0]);
+    simulation::parallelFor(0,m,solveFunctor);
 
-        for (int j=0; j<data->n; j++) {
-            for (int p = data->LT_colptr[j] ; p<data->LT_colptr[j+1] ; p++) {
-                int col = data->LT_rowind[p];
-                double val = data->LT_values[p];
-                line[j] -= val * line[col];
-            }
-        }
-    }
-
-    //apply diagonal
-    for (unsigned j=0; j<(unsigned)J->rowSize(); j++) {
-        Real * lineD = Jdense[j];
-        Real * lineM = Jminv[j];
-        for (unsigned i=0;i<(unsigned)J->colSize();i++) {
-            lineM[i] = lineD[i] * data->invD[i];
-        }
-    }
+    // small chunks, as the rows of the upper triangle have decreasing costs
+    JMinvJt.resize(m,m);
+    LDLJacobianProductFunctor<Real> productFunctor(Jdense,Jminv,JMinvJt,n);
+    simulation::parallelFor(0,m,productFunctor,4);
 
-    for (unsigned j=0; j<(unsigned)J->rowSize(); j++) {
-        Real * lineJ = Jminv[j];
-        for (unsigned i=j;i<(unsigned)J->rowSize();i++) {
-            Real * lineI = Jdense[i];
-
-            double acc = 0.0;
-            for (unsigned k=0;k<(unsigned)J->colSize();k++) {
-                acc += lineJ[k] * lineI[k];
-            }
-            result->add(j,i,acc*fact);
-            if(i!=j) result->add(i,j,acc*fact);
+    for (int j=0; j<m; j++) {
+        const double * res = JMinvJt[j];
+        for (int i=j;i<m;i++) {
+            result->add(j,i,res[i]*fact);
+            if(i!=j) result->add(i,j,res[i]*fact);
         }
     }
 
@@ -28,6 +28,8 @@
 
 #include <sofa/core/behavior/LinearSolver.h>
 #include <SofaBaseLinearSolver/MatrixLinearSolver.h>
+#include <sofa/simulation/ParallelFor.h>
+#include <algorithm>
 
 extern "C" {
 #include <metis.h>
@@ -42,6 +44,34 @@ namespace component
 namespace linearsolver
 {
 
+/// Supernodal structure of a L factor, rebuilt only when the sparsity pattern changes.
+///
+/// A supernode is a range of consecutive columns [first,last) of L sharing the
+/// same pattern below their diagonal block, which is then dense. A supernode
+/// only receives updates from the supernodes of its subtree in the elimination
+/// tree, so the supernodes of a same level (height in the supernodal tree) can
+/// be factorized in parallel once the lower levels are done.
+class SupernodalLDLStructure
+{
+public :
+    helper::vector<int> begin;        ///< first column of each supernode, followed by n
+    helper::vector<int> levelBegin;   ///< index in order of the first supernode of each level, followed by the number of supernodes
+    helper::vector<int> order;        ///< supernodes sorted by level
+    helper::vector<int> updateBegin;  ///< index of the first update of each supernode, followed by the number of updates
+    helper::vector<int> updateSource; ///< supernode contributing to the update
+    helper::vector<int> updateFirst;  ///< first row of the source, counted below its diagonal block, in the columns of the target
+    helper::vector<int> updateLast;   ///< end of these rows
+
+    void clear() {
+        begin.clear(); levelBegin.clear(); order.clear();
+        updateBegin.clear(); updateSource.clear(); updateFirst.clear(); updateLast.clear();
+    }
+
+    bool empty() const { return begin.empty(); }
+
+    int size() const { return begin.empty() ? 0 : (int) begin.size() - 1; }
+};
+
 //defaut structure for a LDL factorization
 template<class VecInt,class VecReal>
 class SparseLDLImplInvertData : public MatrixInvertData {
@@ -51,6 +81,7 @@ public :
     VecInt perm, invperm;
     VecReal P_values,L_values,LT_values,invD;
     helper::vector<int> Parent;
+    SupernodalLDLStructure supernodes;
     bool new_factorization_needed;
 };
 
@@ -84,8 +115,9 @@ inline void CSPARSE_symbolic (int n,int * M_colptr,int * M_rowind,int * colptr,i
     for (int k = 0 ; k < n ; k++) colptr[k+1] = colptr[k] + Lnz[k] ;
 }
 
+/// Returns false if a zero pivot stopped the factorization
 template<class Real>
-inline void CSPARSE_numeric(int n,int * M_colptr,int * M_rowind,Real * M_values,int * colptr,int * rowind,Real * values,Real * D,int * perm,int * invperm,int * Parent, int * Flag, int * Lnz, int * Pattern, Real * Y)
+inline bool CSPARSE_numeric(int n,int * M_colptr,int * M_rowind,Real * M_values,int * colptr,int * rowind,Real * values,Real * D,int * perm,int * invperm,int * Parent, int * Flag, int * Lnz, int * Pattern, Real * Y)
 {
     Real yi, l_ki ;
     int i, p, kk, len, top ;
@@ -129,12 +161,9 @@ inline void CSPARSE_numeric(int n,int * M_colptr,int * M_rowind,Real * M_values,
             values[p] = l_ki ;
             Lnz[i]++ ;		    /* increment count of nonzeros in col i */
         }
-        if (D[k] == 0.0)
-        {
-            std::cerr << "SparseLDLSolver failure to factorize, D(k,k) is zero" << std::endl;
-            return;
-        }
+        if (D[k] == 0.0) return false;
     }
+    return true;
 }
 
 inline bool CSPARSE_need_symbolic_factorization(int s_M, int * M_colptr,int * M_rowind, int s_P, int * P_colptr,int * P_rowind) {
@@ -152,6 +181,206 @@ inline bool CSPARSE_need_symbolic_factorization(int s_M, int * M_colptr,int * M_
     return false;
 }
 
+/// Build the supernodes of the L factor given by its (row sorted) pattern colptr/rowind.
+inline void SUPERNODAL_symbolic(int n,const int * colptr,const int * rowind,SupernodalLDLStructure & s)
+{
+    s.clear();
+
+    helper::vector<int> super(n);
+    s.begin.push_back(0);
+    for (int j = 0 ; j < n ; j++)
+    {
+        if (j > 0)
+        {
+            /* column j-1 joins the supernode of j if j is its parent and they have the same pattern below j */
+            const int prev = colptr[j] - colptr[j-1];
+            if (prev == 0 || rowind[colptr[j-1]] != j || prev != colptr[j+1] - colptr[j] + 1) s.begin.push_back(j);
+        }
+        super[j] = (int) s.begin.size() - 1;
+    }
+    s.begin.push_back(n);
+    const int ns = s.size();
+
+    /* level of each supernode, children always have a lower index than their parent */
+    helper::vector<int> level(ns);
+    int nbLevels = 0;
+    for (int k = 0 ; k < ns ; k++)
+    {
+        const int last = s.begin[k+1] - 1;
+        if (colptr[last+1] > colptr[last])
+        {
+            const int parent = super[rowind[colptr[last]]];
+            level[parent] = std::max(level[parent], level[k] + 1);
+        }
+        nbLevels = std::max(nbLevels, level[k] + 1);
+    }
+
+    s.levelBegin.resize(nbLevels+1);
+    for (int k = 0 ; k < ns ; k++) s.levelBegin[level[k]+1]++;
+    for (int l = 0 ; l < nbLevels ; l++) s.levelBegin[l+1] += s.levelBegin[l];
+    helper::vector<int> pos(s.levelBegin.begin(), s.levelBegin.end()-1);
+    s.order.resize(ns);
+    for (int k = 0 ; k < ns ; k++) s.order[pos[level[k]]++] = k;
+
+    /* the rows below the diagonal block of a supernode falling in the columns of another one form a contiguous range */
+    s.updateBegin.resize(ns+1);
+    for (int pass = 0 ; pass < 2 ; pass++)
+    {
+        if (pass == 1)
+        {
+            for (int k = 0 ; k < ns ; k++) s.updateBegin[k+1] += s.updateBegin[k];
+            s.updateSource.resize(s.updateBegin[ns]);
+            s.updateFirst.resize(s.updateBegin[ns]);
+            s.updateLast.resize(s.updateBegin[ns]);
+            pos.assign(s.updateBegin.begin(), s.updateBegin.end()-1);
+        }
+        for (int k = 0 ; k < ns ; k++)
+        {
+            const int last = s.begin[k+1] - 1;
+            const int * tail = rowind + colptr[last];
+            const int m = colptr[last+1] - colptr[last];
+            for (int p = 0 ; p < m ; )
+            {
+                const int target = super[tail[p]];
+                int q = p + 1;
+                while (q < m && super[tail[q]] == target) q++;
+                if (pass == 0) s.updateBegin[target+1]++;
+                else
+                {
+                    const int u = pos[target]++;
+                    s.updateSource[u] = k;
+                    s.updateFirst[u] = p;
+                    s.updateLast[u] = q;
+                }
+                p = q;
+            }
+        }
+    }
+}
+
+/// Numeric LDL^T factorization of a list of supernodes, given the pattern of L computed for the same matrix pattern.
+///
+/// Each supernode gathers its entries of the permuted matrix, subtracts the
+/// dense outer products of the supernodes of its subtree, and then factorizes
+/// its dense panel. D is not inverted. All the supernodes of the lower levels
+/// must be factorized before. The operations of a supernode don't depend on
+/// how the supernodes are distributed, so the factor is the same whatever the
+/// number of threads.
+template<class Real>
+class SupernodalLDLNumericFunctor
+{
+public :
+    SupernodalLDLNumericFunctor(const SupernodalLDLStructure & s,const int * M_colptr,const int * M_rowind,const Real * M_values,const int * colptr,const int * rowind,Real * values,Real * D,const int * perm,const int * invperm)
+    : s(s), M_colptr(M_colptr), M_rowind(M_rowind), M_values(M_values), colptr(colptr), rowind(rowind), values(values), D(D), perm(perm), invperm(invperm) {}
+
+    void operator()(std::size_t first, std::size_t last) const {
+        helper::vector<Real> tmp;
+        helper::vector<int> rel;
+        for (std::size_t i = first ; i < last ; i++) factorize(s.order[i],tmp,rel);
+    }
+
+protected :
+    void factorize(int k,helper::vector<Real> & tmp,helper::vector<int> & rel) const {
+        const int f = s.begin[k];
+        const int l = s.begin[k+1];
+        const int w = l - f;
+        const int * tail = rowind + colptr[l-1];
+        const int m = colptr[l] - colptr[l-1];
+
+        /* gather the lower part of the permuted matrix */
+        for (int c = f ; c < l ; c++)
+        {
+            D[c] = 0.0;
+            for (int p = colptr[c] ; p < colptr[c+1] ; p++) values[p] = 0.0;
+        }
+        for (int c = f ; c < l ; c++)
+        {
+            const int kk = perm[c];
+            for (int p = M_colptr[kk] ; p < M_colptr[kk+1] ; p++)
+            {
+                const int i = invperm[M_rowind[p]];
+                if (i == c) D[c] += M_values[p];
+                else if (i > c)
+                {
+                    const int r = (i < l) ? i - f : w + (int) (std::lower_bound(tail,tail+m,i) - tail);
+                    values[colptr[c] + r - (c-f) - 1] += M_values[p];
+                }
+            }
+        }
+
+        /* updates from the supernodes of the subtree */
+        for (int u = s.updateBegin[k] ; u < s.updateBegin[k+1] ; u++)
+        {
+            const int d = s.updateSource[u];
+            const int fd = s.begin[d];
+            const int wd = s.begin[d+1] - fd;
+            const int * dtail = rowind + colptr[fd+wd-1];
+            const int md = colptr[fd+wd] - colptr[fd+wd-1];
+            const int first = s.updateFirst[u];
+            const int last = s.updateLast[u];
+
+            /* local row in the supernode k of each row of d */
+            rel.resize(md);
+            for (int i = first, q = 0 ; i < md ; i++)
+            {
+                const int r = dtail[i];
+                if (r < l) rel[i] = r - f;
+                else
+                {
+                    while (tail[q] < r) q++;
+                    rel[i] = w + q;
+                }
+            }
+
+            tmp.resize(md);
+            for (int j = first ; j < last ; j++)
+            {
+                for (int i = j ; i < md ; i++) tmp[i] = 0.0;
+                for (int c = 0 ; c < wd ; c++)
+                {
+                    const Real * Lc = values + colptr[fd+c] + (wd-1-c);
+                    const Real ljc = Lc[j] * D[fd+c];
+                    if (ljc == 0.0) continue;
+                    for (int i = j ; i < md ; i++) tmp[i] += Lc[i] * ljc;
+                }
+
+                const int jc = rel[j];
+                D[f+jc] -= tmp[j];
+                Real * Lj = values + colptr[f+jc];
+                for (int i = j+1 ; i < md ; i++) Lj[rel[i] - jc - 1] -= tmp[i];
+            }
+        }
+
+        /* dense factorization of the panel */
+        for (int c = f ; c < l ; c++)
+        {
+            Real * Lc = values + colptr[c];
+            const int len = colptr[c+1] - colptr[c];
+            for (int j = f ; j < c ; j++)
+            {
+                const Real * Lj = values + colptr[j] + (c-j-1);
+                const Real lcj = Lj[0];
+                const Real wj = lcj * D[j];
+                D[c] -= lcj * wj;
+                for (int q = 0 ; q < len ; q++) Lc[q] -= Lj[q+1] * wj;
+            }
+            if (D[c] == 0.0) continue;
+            for (int q = 0 ; q < len ; q++) Lc[q] /= D[c];
+        }
+    }
+
+    const SupernodalLDLStructure & s;
+    const int * M_colptr;
+    const int * M_rowind;
+    const Real * M_values;
+    const int * colptr;
+    const int * rowind;
+    Real * values;
+    Real * D;
+    const int * perm;
+    const int * invperm;
+};
+
 template<class TMatrix, class TVector, class TThreadManager>
 class SparseLDLSolverImpl : public sofa::component::linearsolver::MatrixLinearSolver<TMatrix,TVector,TThreadManager>
 {
@@ -167,7 +396,24 @@ public:
 
 protected :
 
-    SparseLDLSolverImpl() : Inherit() {}
+    SparseLDLSolverImpl()
+    : Inherit()
+    , d_supernodal( initData(&d_supernodal, false, "supernodal", "when the matrix pattern doesn't change, factorize it by dense supernodal blocks of columns sharing the same pattern") )
+    , d_parallel( initData(&d_parallel, false, "parallel", "start the TaskScheduler threads, so that independent supernodes are factorized, and the rows of J solved in addJMInvJt, on several threads") )
+    {}
+
+public :
+    Data<bool> d_supernodal;
+    Data<bool> d_parallel;
+
+    void init() {
+        Inherit::init();
+
+        if (d_parallel.getValue())
+            simulation::TaskScheduler::getInstance().start();
+    }
+
+protected :
 
     template<class VecInt,class VecReal>
     void solve_cpu(Real * x,const Real * b,SparseLDLImplInvertData<VecInt,VecReal> * data) {
@@ -278,7 +524,24 @@ protected :
     void LDL_numeric(int n,int * M_colptr,int * M_rowind,Real * M_values,int * colptr,int * rowind,Real * values,Real * D,int * perm,int * invperm,int * Parent) {
         Y.resize(n);
 
-        CSPARSE_numeric<Real>(n,M_colptr,M_rowind,M_values,colptr,rowind,values,D,perm,invperm,Parent,&Flag[0],&Lnz[0],&Pattern[0],&Y[0]);
+        if (!CSPARSE_numeric<Real>(n,M_colptr,M_rowind,M_values,colptr,rowind,values,D,perm,invperm,Parent,&Flag[0],&Lnz[0],&Pattern[0],&Y[0]))
+            msg_error(this) << "failure to factorize, D(k,k) is zero";
+    }
+
+    void LDL_supernodal_numeric(const SupernodalLDLStructure & s,int * M_colptr,int * M_rowind,Real * M_values,int * colptr,int * rowind,Real * values,Real * D,int * perm,int * invperm) {
+        SupernodalLDLNumericFunctor<Real> functor(s,M_colptr,M_rowind,M_values,colptr,rowind,values,D,perm,invperm);
+
+        for (unsigned l = 0 ; l + 1 < s.levelBegin.size() ; l++)
+            simulation::parallelFor(s.levelBegin[l],s.levelBegin[l+1],functor);
+
+        for (int k = 0 ; k < s.begin.back() ; k++)
+        {
+            if (D[k] == 0.0)
+            {
+                msg_error(this) << "failure to factorize, D(k,k) is zero";
+                return;
+            }
+        }
     }
 
     template<class VecInt,class VecReal>
@@ -320,6 +583,8 @@ protected :
             data->L_values.clear();data->L_values.fastResize(data->L_nnz);
             data->LT_rowind.clear();data->LT_rowind.fastResize(data->L_nnz);
             data->LT_values.clear();data->LT_values.fastResize(data->L_nnz);
+
+            data->supernodes.clear();
         }
 
         Real * D = &data->invD[0];
@@ -330,8 +595,17 @@ protected :
         int * tran_colptr = &data->LT_colptr[0];
         Real * tran_values = &data->LT_values[0];
 
-        //Numeric Factorization
-        LDL_numeric(data->n,M_colptr,M_rowind,M_values,colptr,rowind,values,D,&data->perm[0],&data->invperm[0],&data->Parent[0]);
+        //Numeric Factorization, the pattern of L is known once the scalar factorization has been done for this matrix pattern
+        if (d_supernodal.getValue() && !data->supernodes.empty()) {
+            LDL_supernodal_numeric(data->supernodes,M_colptr,M_rowind,M_values,colptr,rowind,values,D,&data->perm[0],&data->invperm[0]);
+        } else {
+            LDL_numeric(data->n,M_colptr,M_rowind,M_values,colptr,rowind,values,D,&data->perm[0],&data->invperm[0],&data->Parent[0]);
+
+            // the pattern of L is complete only if the factorization did not stop on a zero pivot
+            bool complete = true;
+            for (int i=0;i<data->n && complete;i++) complete = (Lnz[i] == colptr[i+1] - colptr[i]);
+            if (d_supernodal.getValue() && complete) SUPERNODAL_symbolic(data->n,colptr,rowind,data->supernodes);
+        }
 
         //inverse the diagonal
         for (int i=0;i<data->n;i++) D[i] = 1.0/D[i];